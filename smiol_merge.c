@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include "smiol.h"
+
+/*******************************************************************************
+ * SMIOL Merge - Merge the subfiles of a native file into a single file
+ *
+ * Usage: mpiexec -n <tasks> smiol_merge <subfiled file> <merged file>
+ *
+ * The merged file is a netCDF file where SMIOL is built with parallel-netCDF,
+ * or a native file without subfiles otherwise (see SMIOL_merge_subfiles).
+ *******************************************************************************/
+
+int main(int argc, char **argv)
+{
+	struct SMIOL_context *context = NULL;
+	int comm_rank;
+	int ierr;
+
+	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+		fprintf(stderr, "Error: MPI_Init failed...\n");
+		return 1;
+	}
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+
+	if (argc != 3) {
+		if (comm_rank == 0) {
+			fprintf(stderr, "Usage: %s <subfiled file> <merged file>\n", argv[0]);
+		}
+		MPI_Finalize();
+		return 1;
+	}
+
+	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
+	if (ierr != SMIOL_SUCCESS) {
+		if (comm_rank == 0) {
+			fprintf(stderr, "Error: SMIOL_init: %s\n", SMIOL_error_string(ierr));
+		}
+		MPI_Finalize();
+		return 1;
+	}
+
+	ierr = SMIOL_merge_subfiles(context, argv[1], argv[2]);
+	if (ierr != SMIOL_SUCCESS && comm_rank == 0) {
+		fprintf(stderr, "Error: merging %s into %s: %s\n", argv[1], argv[2],
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr));
+	}
+
+	SMIOL_finalize(&context);
+	MPI_Finalize();
+
+	return (ierr == SMIOL_SUCCESS) ? 0 : 1;
+}
@@ -4,6 +4,7 @@
 #include <math.h>
 #include "smiol.h"
 #include "smiol_utils.h"
+#include "smiol_native.h"
 
 /*******************************************************************************
  * SMIOL C Runner - Take SMIOL out for a run!
@@ -22,6 +23,9 @@ int test_utils(FILE *test_log);
 int test_io_decomp(FILE *test_log);
 int test_set_get_frame(FILE* test_log);
 int test_put_get_vars(FILE *test_log);
+int test_native_files(FILE *test_log);
+int test_null_files(FILE *test_log);
+int test_subfiles(FILE *test_log);
 int compare_decomps(struct SMIOL_decomp *decomp,
                     size_t n_comp_list, SMIOL_Offset *comp_list_correct,
                     size_t n_io_list, SMIOL_Offset *io_list_correct);
@@ -107,6 +111,7 @@ int main(int argc, char **argv)
 	int i;
 	float f;
 	int my_proc_id;
+	int thread_level;
 	SMIOL_Offset dimsize;
 	size_t n_compute_elements;
 	SMIOL_Offset *compute_elements;
@@ -119,8 +124,8 @@ int main(int argc, char **argv)
 	char **dimnames;
 	float *buf;
 
-	if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
-		fprintf(stderr, "Error: MPI_Init failed.\n");
+	if (MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_level) != MPI_SUCCESS) {
+		fprintf(stderr, "Error: MPI_Init_thread failed.\n");
 		return 1;
 	}
 
@@ -285,6 +290,39 @@ int main(int argc, char **argv)
 		fprintf(test_log, "%i tests FAILED!\n\n", ierr);
 	}
 
+	/*
+	 * Unit tests for the native file format
+	 */
+	ierr = test_native_files(test_log);
+	if (ierr == 0) {
+		fprintf(test_log, "All tests PASSED!\n\n");
+	}
+	else {
+		fprintf(test_log, "%i tests FAILED!\n\n", ierr);
+	}
+
+	/*
+	 * Unit tests for null files
+	 */
+	ierr = test_null_files(test_log);
+	if (ierr == 0) {
+		fprintf(test_log, "All tests PASSED!\n\n");
+	}
+	else {
+		fprintf(test_log, "%i tests FAILED!\n\n", ierr);
+	}
+
+	/*
+	 * Unit tests for subfiled native files
+	 */
+	ierr = test_subfiles(test_log);
+	if (ierr == 0) {
+		fprintf(test_log, "All tests PASSED!\n\n");
+	}
+	else {
+		fprintf(test_log, "%i tests FAILED!\n\n", ierr);
+	}
+
 
 
 	if ((ierr = SMIOL_init(MPI_COMM_WORLD, &context)) != SMIOL_SUCCESS) {
@@ -429,7 +467,7 @@ int main(int argc, char **argv)
 		return 1;
 	}
 	
-	if ((ierr = SMIOL_set_option()) != SMIOL_SUCCESS) {
+	if ((ierr = SMIOL_set_option(context, "striping_unit", "1048576")) != SMIOL_SUCCESS) {
 		fprintf(test_log, "ERROR: SMIOL_set_option: %s ",
 			SMIOL_error_string(ierr));
 		return 1;
@@ -651,6 +689,7 @@ int test_open_close(FILE *test_log)
 	fprintf(test_log, "Try to close a file that was never opened: ");
 	file = (struct SMIOL_file *)malloc(sizeof(struct SMIOL_file));
 	file->context = context;
+	file->backend = SMIOL_LIBRARY_PNETCDF;
 	ierr = SMIOL_close_file(&file);
 	free(file);
 	if (ierr == SMIOL_LIBRARY_ERROR) {
@@ -754,6 +793,203 @@ int test_open_close(FILE *test_log)
 		errcount++;
 	}
 
+	/* Header padding with a NULL context */
+	fprintf(test_log, "Set header padding with a NULL context: ");
+	ierr = SMIOL_set_header_padding(NULL, (size_t)4096, (size_t)0, (size_t)0, (size_t)0);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	/* Add an attribute after writing data to a file created with header padding */
+	fprintf(test_log, "Everything OK - Add an attribute after writing data to a padded file: ");
+	{
+		int values[4] = { 1, 2, 3, 4 };
+		int values_in[4] = { 0, 0, 0, 0 };
+		const char *dimnames[1] = { "nValues" };
+
+		ierr = SMIOL_set_header_padding(context, (size_t)4096, (size_t)512, (size_t)0, (size_t)512);
+		file = NULL;
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_open_file(context, "smiol_padded.nc", SMIOL_FILE_CREATE, &file);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_dim(file, "nValues", (SMIOL_Offset)4);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "values", SMIOL_INT32, 1, dimnames);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "values", NULL, values);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_att(file, NULL, "history", SMIOL_CHAR, "appended after data");
+		}
+		if (file != NULL) {
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_close_file(&file);
+			} else {
+				SMIOL_close_file(&file);
+			}
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_open_file(context, "smiol_padded.nc", SMIOL_FILE_READ, &file);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "values", NULL, values_in);
+			SMIOL_close_file(&file);
+		}
+		if (ierr != SMIOL_SUCCESS) {
+			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+			errcount++;
+#ifdef SMIOL_PNETCDF
+		} else if (memcmp(values, values_in, sizeof(values)) != 0) {
+			fprintf(test_log, "FAIL - values read from the file are not correct\n");
+			errcount++;
+#endif
+		} else {
+			fprintf(test_log, "PASS\n");
+		}
+	}
+
+	/* Options: hints are kept in the info object of the context */
+	fprintf(test_log, "Everything OK - Set MPI-IO and PnetCDF hints with SMIOL_set_option: ");
+	{
+		char hint[MPI_MAX_INFO_VAL + 1];
+		int flag = 0;
+
+		ierr = SMIOL_set_option(context, "cb_nodes", "2");
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_set_option(context, "romio_cb_write", "enable");
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_set_option(context, "nc_var_align_size", "4096");
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			MPI_Info_get(MPI_Info_f2c(context->finfo), "romio_cb_write",
+			             MPI_MAX_INFO_VAL, hint, &flag);
+		}
+		if (ierr == SMIOL_SUCCESS && flag && strcmp(hint, "enable") == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), hint was %sfound\n", SMIOL_error_string(ierr), flag ? "" : "not ");
+			errcount++;
+		}
+	}
+
+	fprintf(test_log, "Everything OK - Set SMIOL settings with SMIOL_set_option: ");
+	ierr = SMIOL_set_option(context, "read_mode", "bcast_node");
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_set_option(context, "small_var_bytes", "0");
+	}
+	if (ierr == SMIOL_SUCCESS && context->read_mode == SMIOL_READ_BCAST_NODE
+	    && context->small_var_bytes == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+	(void)SMIOL_set_read_mode(context, SMIOL_READ_BCAST);
+	(void)SMIOL_set_small_var_batching(context, (size_t)4096);
+
+	fprintf(test_log, "Set an unknown option: ");
+	ierr = SMIOL_set_option(context, "no_such_option", "1");
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	fprintf(test_log, "Set options with invalid values: ");
+	if (SMIOL_set_option(context, "cb_nodes", "0") == SMIOL_INVALID_ARGUMENT
+	    && SMIOL_set_option(context, "striping_unit", "1M") == SMIOL_INVALID_ARGUMENT
+	    && SMIOL_set_option(context, "romio_cb_write", "on") == SMIOL_INVALID_ARGUMENT
+	    && SMIOL_set_option(context, "read_mode", "") == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	fprintf(test_log, "Set an option with a NULL context: ");
+	ierr = SMIOL_set_option(NULL, "cb_nodes", "2");
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	/* File options override the context only for the one file */
+	fprintf(test_log, "Everything OK - Set file options with SMIOL_set_file_option: ");
+	file = NULL;
+	ierr = SMIOL_open_file(context, "smiol_file_options.nc", SMIOL_FILE_CREATE, &file);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_set_file_option(file, "read_mode", "all");
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_set_file_option(file, "header_free_bytes", "8192");
+	}
+	if (ierr == SMIOL_SUCCESS && file->read_mode == SMIOL_READ_ALL
+	    && context->read_mode == SMIOL_READ_BCAST
+	    && file->header_free_bytes == (size_t)8192 && file->pad_header) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	fprintf(test_log, "Set a hint for a single file: ");
+	ierr = SMIOL_set_file_option(file, "cb_nodes", "2");
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	if (file != NULL) {
+		SMIOL_close_file(&file);
+	}
+
+	/* In-place byte swapping is enabled unless disabled by a hint */
+	fprintf(test_log, "Everything OK - In-place byte swapping follows the nc_in_place_swap hint: ");
+	{
+		int expected = 0;
+		int swap_default = -1;
+		int swap_disabled = -1;
+#ifdef SMIOL_PNETCDF
+		int one = 1;
+
+		expected = (*(char *)&one == 1);
+#endif
+		ierr = SMIOL_open_file(context, "smiol_swap.nc", SMIOL_FILE_CREATE, &file);
+		if (ierr == SMIOL_SUCCESS) {
+			swap_default = file->in_place_swap;
+			ierr = SMIOL_close_file(&file);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_set_option(context, "nc_in_place_swap", "disable");
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_open_file(context, "smiol_swap.nc", SMIOL_FILE_WRITE, &file);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			swap_disabled = file->in_place_swap;
+			ierr = SMIOL_close_file(&file);
+		}
+		if (ierr == SMIOL_SUCCESS && swap_default == expected && swap_disabled == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), in-place swapping was %d by default and %d when disabled\n",
+			        SMIOL_error_string(ierr), swap_default, swap_disabled);
+			errcount++;
+		}
+	}
+
 	/* Free the SMIOL context */
 	ierr = SMIOL_finalize(&context);
 	if (ierr != SMIOL_SUCCESS || context != NULL) {
@@ -934,47 +1170,44 @@ int test_decomp(FILE *test_log)
 		errcount++;
 	}
 
-	/*
-	 * The following tests will only be run if there are exactly two MPI tasks.
-	 * In principle, as long as there are at least two MPI ranks in MPI_COMM_WORLD,
-	 * an intracommunicator with exactly two ranks could be created for these tests.
-	 */
-	if (comm_size == 2) {
+	/* Invalid I/O placement */
+	fprintf(test_log, "SMIOL_set_io_placement with an invalid placement: ");
+	ierr = SMIOL_set_io_placement(context, -1, 0);
+	if (ierr == SMIOL_INVALID_ARGUMENT && context->io_placement == SMIOL_IO_PLACEMENT_STRIDE) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned or placement was changed\n");
+		errcount++;
+	}
 
-		/* Odd/even compute, half/half I/O */
-		fprintf(test_log, "Odd/even compute, half/half I/O: ");
-		n_compute_elements = 4;
+	/* Node placement, one I/O task per node */
+	fprintf(test_log, "Node placement, one I/O task per node: ");
+	ierr = SMIOL_set_io_placement(context, SMIOL_IO_PLACEMENT_NODE, 1);
+	if (ierr == SMIOL_SUCCESS) {
+		n_compute_elements = 10;
 		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-
-		if (comm_rank == 0) {
-			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);    /* Odd elements */
-			}
-		} else {
-			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i);        /* Even elements */
-			}
+		for (i = 0; i < n_compute_elements; i++) {
+			compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_compute_elements + i);
 		}
-		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, 2, 1, &decomp);
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, comm_size, 1, &decomp);
+		free(compute_elements);
 		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-
-			/* The correct comp_list and io_list arrays, below, were verified manually */
-			if (comm_rank == 0) {
-				SMIOL_Offset comp_list_correct[] = { 2, 0, 2, 0, 1, 1, 2, 2, 3 };
-				SMIOL_Offset io_list_correct[] = { 2, 0, 2, 1, 3, 1, 2, 0, 2 };
-
-				ierr = compare_decomps(decomp, (size_t)9, comp_list_correct, (size_t)9, io_list_correct);
-			} else {
-				SMIOL_Offset comp_list_correct[] = { 2, 0, 2, 0, 1, 1, 2, 2, 3 };
-				SMIOL_Offset io_list_correct[] = { 2, 0, 2, 1, 3, 1, 2, 0, 2 };
-
-				ierr = compare_decomps(decomp, (size_t)9, comp_list_correct, (size_t)9, io_list_correct);
-			}
-
-			if (ierr == 0) {
+			int node_io[2], node_io_sum[2];
+			unsigned long total_count;
+			unsigned long my_count = (unsigned long)decomp->io_count;
+
+			/* Number of I/O tasks on this node, and whether node rank 0 is one of them */
+			node_io[0] = (decomp->io_count > 0) ? 1 : 0;
+			node_io[1] = (decomp->io_count > 0 && context->node_rank == 0) ? 1 : 0;
+			ierr = MPI_Allreduce(node_io, node_io_sum, 2, MPI_INT, MPI_SUM,
+			                     MPI_Comm_f2c(context->node_fcomm));
+			ierr |= MPI_Allreduce(&my_count, &total_count, 1, MPI_UNSIGNED_LONG, MPI_SUM,
+			                      MPI_COMM_WORLD);
+			if (ierr == MPI_SUCCESS && node_io_sum[0] == 1 && node_io_sum[1] == 1
+			    && total_count == (unsigned long)(comm_size * 10)) {
 				fprintf(test_log, "PASS\n");
 			} else {
-				fprintf(test_log, "FAIL - the decomp did not contain the expected values\n");
+				fprintf(test_log, "FAIL - expected one I/O task on node rank 0 and all elements covered\n");
 				errcount++;
 			}
 		} else {
@@ -982,49 +1215,55 @@ int test_decomp(FILE *test_log)
 			errcount++;
 		}
 
-		free(compute_elements);
-
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
 			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
 			errcount++;
 		}
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_set_io_placement did not return SMIOL_SUCCESS\n");
+		errcount++;
+	}
+
+	ierr = SMIOL_set_io_placement(context, SMIOL_IO_PLACEMENT_STRIDE, 0);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to restore stride I/O placement...\n");
+		return -1;
+	}
 
+	/* Invalid I/O alignment */
+	fprintf(test_log, "SMIOL_set_io_alignment with a zero element size: ");
+	ierr = SMIOL_set_io_alignment(context, 1024, 0);
+	if (ierr == SMIOL_INVALID_ARGUMENT && context->io_align_bytes == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned or alignment was changed\n");
+		errcount++;
+	}
 
-		/* Even/odd compute, all/nothing I/O */
-		fprintf(test_log, "Even/odd compute, all/nothing I/O: ");
-		n_compute_elements = 4;
+	/* Aligned I/O ranges for 80-byte elements on 1024-byte boundaries */
+	fprintf(test_log, "Aligned I/O ranges, 80-byte elements, 1024-byte alignment: ");
+	ierr = SMIOL_set_io_alignment(context, 1024, 80);
+	if (ierr == SMIOL_SUCCESS) {
+		n_compute_elements = 1000;
 		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-
-		if (comm_rank == 0) {
-			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i);        /* Even elements */
-			}
-		} else {
-			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);    /* Odd elements */
-			}
+		for (i = 0; i < n_compute_elements; i++) {
+			compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_compute_elements + i);
 		}
-		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, 1, 2, &decomp);
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, comm_size, 1, &decomp);
+		free(compute_elements);
 		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-
-			/* The correct comp_list and io_list arrays, below, were verified manually */
-			if (comm_rank == 0) {
-				SMIOL_Offset comp_list_correct[] = { 1, 0, 4, 0, 1, 2, 3 };
-				SMIOL_Offset io_list_correct[] = { 2, 0, 4, 0, 2, 4, 6, 1, 4, 1, 3, 5, 7 };
-
-				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)13, io_list_correct);
-			} else {
-				SMIOL_Offset comp_list_correct[] = { 1, 0, 4, 0, 1, 2, 3 };
-				SMIOL_Offset io_list_correct[] = { 0 };
-
-				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)1, io_list_correct);
-			}
-
-			if (ierr == 0) {
+			unsigned long total_count;
+			unsigned long my_count = (unsigned long)decomp->io_count;
+
+			ierr = MPI_Allreduce(&my_count, &total_count, 1, MPI_UNSIGNED_LONG, MPI_SUM,
+			                     MPI_COMM_WORLD);
+			if (ierr == MPI_SUCCESS && (decomp->io_start * 80) % 1024 == 0
+			    && total_count == (unsigned long)(comm_size * 1000)
+			    && decomp->io_imbalance >= 1.0) {
 				fprintf(test_log, "PASS\n");
 			} else {
-				fprintf(test_log, "FAIL - the decomp did not contain the expected values\n");
+				fprintf(test_log, "FAIL - io_start was not aligned, elements were not covered, or imbalance < 1\n");
 				errcount++;
 			}
 		} else {
@@ -1032,51 +1271,112 @@ int test_decomp(FILE *test_log)
 			errcount++;
 		}
 
-		free(compute_elements);
-
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
 			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
 			errcount++;
 		}
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_set_io_alignment did not return SMIOL_SUCCESS\n");
+		errcount++;
+	}
 
+	/* Invalid I/O partitioning */
+	fprintf(test_log, "SMIOL_set_io_partition with an invalid partitioning: ");
+	ierr = SMIOL_set_io_partition(context, -1);
+	if (ierr == SMIOL_INVALID_ARGUMENT && context->io_partition == SMIOL_IO_PARTITION_ELEMENTS) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned or partitioning was changed\n");
+		errcount++;
+	}
 
-		/* Nothing/all compute, all/nothing I/O */
-		fprintf(test_log, "Nothing/all compute, all/nothing I/O: ");
-		if (comm_rank == 0) {
-			n_compute_elements = 0;
-		} else {
-			n_compute_elements = 8;
-		}
+	/* Byte-balanced I/O ranges for a second element size */
+	fprintf(test_log, "Byte-balanced, aligned I/O ranges for an 8-byte element size: ");
+	ierr = SMIOL_set_io_partition(context, SMIOL_IO_PARTITION_BYTES);
+	ierr |= SMIOL_set_io_alignment(context, 1024, 80);
+	if (ierr == SMIOL_SUCCESS) {
+		n_compute_elements = 1000;
 		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-
-		if (comm_rank == 0) {
-			/* No compute elements */
-		} else {
-			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(n_compute_elements - 1 - i);    /* All compute elements */
-			}
+		for (i = 0; i < n_compute_elements; i++) {
+			compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_compute_elements + i);
 		}
-		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, 1, 2, &decomp);
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, comm_size, 1, &decomp);
+		free(compute_elements);
 		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-
-			/* The correct comp_list and io_list arrays, below, were verified manually */
-			if (comm_rank == 0) {
-				SMIOL_Offset comp_list_correct[] = { 0 };
-				SMIOL_Offset io_list_correct[] = { 1, 1, 8, 0, 1, 2, 3, 4, 5, 6, 7 };
-
-				ierr = compare_decomps(decomp, (size_t)1, comp_list_correct, (size_t)11, io_list_correct);
+			const struct SMIOL_decomp *sized = NULL;
+			const struct SMIOL_decomp *sized_again = NULL;
+			unsigned long total_count;
+			unsigned long my_count;
+
+			ierr = get_decomp_for_size(decomp, 8, &sized);
+			ierr |= get_decomp_for_size(decomp, 8, &sized_again);
+			if (ierr == SMIOL_SUCCESS && sized != NULL && sized != decomp && sized == sized_again) {
+				my_count = (unsigned long)sized->io_count;
+				ierr = MPI_Allreduce(&my_count, &total_count, 1, MPI_UNSIGNED_LONG, MPI_SUM,
+				                     MPI_COMM_WORLD);
+				if (ierr == MPI_SUCCESS && (sized->io_start * 8) % 1024 == 0
+				    && total_count == (unsigned long)(comm_size * 1000)
+				    && transfer_double(n_compute_elements, sized->io_count,
+				                       (struct SMIOL_decomp *)sized) == 0) {
+					fprintf(test_log, "PASS\n");
+				} else {
+					fprintf(test_log, "FAIL - sized ranges were not aligned, covering, or usable for transfers\n");
+					errcount++;
+				}
 			} else {
-				SMIOL_Offset comp_list_correct[] = { 1, 0, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
-				SMIOL_Offset io_list_correct[] = { 0 };
-
-				ierr = compare_decomps(decomp, (size_t)11, comp_list_correct, (size_t)1, io_list_correct);
+				fprintf(test_log, "FAIL - get_decomp_for_size did not return a distinct, cached decomp\n");
+				errcount++;
 			}
+		} else {
+			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
+			errcount++;
+		}
 
-			if (ierr == 0) {
+		ierr = SMIOL_free_decomp(&decomp);
+		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
+			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_set_io_partition or SMIOL_set_io_alignment did not return SMIOL_SUCCESS\n");
+		errcount++;
+	}
+
+	ierr = SMIOL_set_io_partition(context, SMIOL_IO_PARTITION_ELEMENTS);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to restore element I/O partitioning...\n");
+		return -1;
+	}
+
+	/* Auto-tuned I/O tasks with a calibration write, recorded in a cache file */
+	fprintf(test_log, "Auto-tuned I/O tasks with calibration and cache file: ");
+	if (comm_rank == 0) {
+		remove("smiol_autotune.cache");
+	}
+	MPI_Barrier(MPI_COMM_WORLD);
+	ierr = SMIOL_set_io_autotune(context, "smiol_autotune.cache", "smiol_autotune.scratch",
+	                             (size_t)65536);
+	if (ierr == SMIOL_SUCCESS) {
+		n_compute_elements = 1000;
+		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+		for (i = 0; i < n_compute_elements; i++) {
+			compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_compute_elements + i);
+		}
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements,
+		                           SMIOL_IO_TASKS_AUTO, 0, &decomp);
+		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+			unsigned long total_count;
+			unsigned long my_count = (unsigned long)decomp->io_count;
+
+			ierr = MPI_Allreduce(&my_count, &total_count, 1, MPI_UNSIGNED_LONG, MPI_SUM,
+			                     MPI_COMM_WORLD);
+			if (ierr == MPI_SUCCESS && total_count == (unsigned long)(comm_size * 1000)
+			    && context->auto_num_io_tasks >= 1 && context->auto_io_stride >= 1
+			    && context->auto_io_tasks_per_node >= 1 && context->auto_bandwidth > 0.0) {
 				fprintf(test_log, "PASS\n");
 			} else {
-				fprintf(test_log, "FAIL - the decomp did not contain the expected values\n");
+				fprintf(test_log, "FAIL - elements were not covered or auto-tuned values were not recorded\n");
 				errcount++;
 			}
 		} else {
@@ -1084,209 +1384,310 @@ int test_decomp(FILE *test_log)
 			errcount++;
 		}
 
-		free(compute_elements);
-
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
 			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
 			errcount++;
 		}
 
-	} else {
-		fprintf(test_log, "<<< Tests that require exactly 2 MPI tasks will not be run >>>\n");
-	}
+		/* A new context should reuse the cached settings without calibrating */
+		fprintf(test_log, "Auto-tuned I/O tasks reused from cache file: ");
+		{
+			struct SMIOL_context *context2 = NULL;
 
-	/* Free the SMIOL context */
-	ierr = SMIOL_finalize(&context);
-	if (ierr != SMIOL_SUCCESS || context != NULL) {
-		fprintf(test_log, "Failed to free SMIOL context...\n");
-		return -1;
-	}
+			ierr = SMIOL_init(MPI_COMM_WORLD, &context2);
+			if (ierr == SMIOL_SUCCESS) {
+				/* No scratch file, so any bandwidth must come from the cache */
+				ierr = SMIOL_set_io_autotune(context2, "smiol_autotune.cache", NULL, 0);
+			}
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_create_decomp(context2, n_compute_elements, compute_elements,
+				                           SMIOL_IO_TASKS_AUTO, 0, &decomp);
+			}
+			if (ierr == SMIOL_SUCCESS && decomp != NULL
+			    && context2->auto_io_tasks_per_node == context->auto_io_tasks_per_node
+			    && context2->auto_bandwidth == context->auto_bandwidth) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - cached auto-tuned values were not reused\n");
+				errcount++;
+			}
 
-	fflush(test_log);
-	ierr = MPI_Barrier(MPI_COMM_WORLD);
+			SMIOL_free_decomp(&decomp);
+			SMIOL_finalize(&context2);
+		}
 
-	fprintf(test_log, "\n");
+		/* Calibration should place its writers as node placement will */
+		fprintf(test_log, "Auto-tuned I/O tasks with calibration and node placement: ");
+		{
+			struct SMIOL_context *context2 = NULL;
 
-	return errcount;
-}
+			ierr = SMIOL_init(MPI_COMM_WORLD, &context2);
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_set_io_placement(context2, SMIOL_IO_PLACEMENT_NODE, 1);
+			}
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_set_io_autotune(context2, NULL, "smiol_autotune.scratch",
+				                             (size_t)65536);
+			}
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_create_decomp(context2, n_compute_elements, compute_elements,
+				                           SMIOL_IO_TASKS_AUTO, 0, &decomp);
+			}
+			if (ierr == SMIOL_SUCCESS && decomp != NULL
+			    && context2->auto_io_tasks_per_node >= 1
+			    && context2->auto_bandwidth > 0.0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - node placement calibration was unsuccessful\n");
+				errcount++;
+			}
 
-int test_build_exch(FILE *test_log)
-{
-	int ierr;
-	int errcount = 0;
-	int comm_rank;
-	int comm_size;
-	size_t i;
-	size_t n_compute_elements, n_io_elements;
-	SMIOL_Offset *compute_elements = NULL, *io_elements = NULL;
-	struct SMIOL_context *context = NULL;
-	struct SMIOL_decomp *decomp = NULL;
+			SMIOL_free_decomp(&decomp);
+			SMIOL_finalize(&context2);
+		}
+		free(compute_elements);
 
-	fprintf(test_log, "********************************************************************************\n");
-	fprintf(test_log, "************************* build_exchange unit tests ****************************\n");
-	fprintf(test_log, "\n");
+		/*
+		 * Halo copies are not counted as elements to read or write: too
+		 * few elements are owned to give a second I/O task a useful
+		 * amount of data, however many copies each task holds
+		 */
+		fprintf(test_log, "Auto-tuned I/O tasks for a decomp with many halo copies: ");
+		{
+			struct SMIOL_context *context2 = NULL;
+			size_t n_owned = 1000;
 
-	ierr = MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
-	if (ierr != MPI_SUCCESS) {
-		fprintf(test_log, "Failed to get MPI rank...\n");
-		return -1;
+			n_compute_elements = n_owned + 150000;
+			compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+			for (i = 0; i < n_compute_elements; i++) {
+				if (i < n_owned) {
+					compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_owned + i);
+				} else {
+					compute_elements[i] = (SMIOL_Offset)((size_t)((comm_rank + 1) % comm_size)
+					                                     * n_owned + i % n_owned);
+				}
+			}
+
+			ierr = SMIOL_init(MPI_COMM_WORLD, &context2);
+			if (ierr == SMIOL_SUCCESS) {
+				/* As many I/O tasks per node as tasks, without calibrating */
+				context2->auto_io_tasks_per_node = comm_size;
+				ierr = SMIOL_create_halo_decomp(context2, n_compute_elements, compute_elements,
+				                                n_owned, SMIOL_IO_TASKS_AUTO, 0, &decomp);
+			}
+			if (ierr == SMIOL_SUCCESS && decomp != NULL
+			    && context2->auto_num_io_tasks == 1) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - (%s), %d I/O tasks were chosen\n",
+				        SMIOL_error_string(ierr),
+				        (context2 != NULL) ? context2->auto_num_io_tasks : -1);
+				errcount++;
+			}
+
+			SMIOL_free_decomp(&decomp);
+			SMIOL_finalize(&context2);
+			free(compute_elements);
+		}
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_set_io_autotune did not return SMIOL_SUCCESS\n");
+		errcount++;
 	}
 
-	ierr = MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
-	if (ierr != MPI_SUCCESS) {
-		fprintf(test_log, "Failed to get MPI size...\n");
-		return -1;
+	MPI_Barrier(MPI_COMM_WORLD);
+	if (comm_rank == 0) {
+		remove("smiol_autotune.cache");
 	}
 
-	/* Create a SMIOL context for testing decomp routines */
-	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
-	if (ierr != SMIOL_SUCCESS || context == NULL) {
-		fprintf(test_log, "Failed to create SMIOL context...\n");
+	ierr = SMIOL_set_io_alignment(context, 0, 0);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to disable I/O alignment...\n");
 		return -1;
 	}
 
-	/* Test create decomp with io_elements and compute_elements == NULL and
-	 * n_io_elements and n_compute != 0 */
-	fprintf(test_log, "Testing build_exchange with NULL elements and n_elements != 0: ");
-	n_compute_elements = 1;
-	n_io_elements = 1;
-	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
-	if (ierr == SMIOL_INVALID_ARGUMENT && decomp == NULL) {
+	/* Invalid number of vertical blocks */
+	fprintf(test_log, "SMIOL_set_io_vertical_blocks with zero blocks: ");
+	ierr = SMIOL_set_io_vertical_blocks(context, 0);
+	if (ierr == SMIOL_INVALID_ARGUMENT && context->io_vertical_blocks == 1) {
 		fprintf(test_log, "PASS\n");
 	} else {
-		fprintf(test_log, "FAIL - Either SMIOL_INVALID_ARGUMENT was not returned or DECOMP was not NULL\n");
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned or blocks were changed\n");
 		errcount++;
 	}
 
-	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with NULL elements: ");
-	ierr = SMIOL_free_decomp(&decomp);
-	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "PASS\n");
-	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
-		errcount++;
-	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
-		errcount++;
-	}
+	/* Groups of two I/O tasks, each handling a block of five levels */
+	fprintf(test_log, "Vertical blocks of I/O, round-trip of a 2-d field: ");
+	ierr = SMIOL_set_io_vertical_blocks(context, 2);
+	if (ierr == SMIOL_SUCCESS) {
+		size_t n_levels = 5;
+		size_t level_start, level_count;
+		size_t k;
+		int fail = 0;
+		double *comp_field;
+		double *io_field;
+
+		n_compute_elements = 10;
+		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+		for (i = 0; i < n_compute_elements; i++) {
+			compute_elements[i] = (SMIOL_Offset)((size_t)((comm_rank + 1) % comm_size)
+			                                     * n_compute_elements + i);
+		}
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, comm_size, 1, &decomp);
+		if (ierr == SMIOL_SUCCESS && decomp != NULL
+		    && decomp->io_group_size == (comm_size >= 2 ? 2 : 1)) {
+			get_vertical_block(decomp->io_group_rank, decomp->io_group_size, n_levels,
+			                   &level_start, &level_count);
+
+			comp_field = malloc(sizeof(double) * n_compute_elements * n_levels);
+			io_field = malloc(sizeof(double) * (decomp->io_count * level_count + 1));
+			for (i = 0; i < n_compute_elements; i++) {
+				for (k = 0; k < n_levels; k++) {
+					comp_field[i * n_levels + k] = (double)(compute_elements[i] * 10 + (SMIOL_Offset)k);
+				}
+			}
 
+			ierr = transfer_field_2d(decomp, SMIOL_COMP_TO_IO, sizeof(double) * n_levels, n_levels,
+			                         comp_field, io_field);
+			fail |= (ierr != SMIOL_SUCCESS);
+			for (i = 0; i < decomp->io_count; i++) {
+				for (k = 0; k < level_count; k++) {
+					if (io_field[i * level_count + k]
+					    != (double)((decomp->io_start + i) * 10 + level_start + k)) {
+						fail = 1;
+					}
+					io_field[i * level_count + k] += 42.0;
+				}
+			}
 
-	/* Create and Free Decomp with elements == 0 */
-	fprintf(test_log, "Everything OK (build_exchange) with 0 elements: ");
-	n_compute_elements = 0;
-	n_io_elements = 0;
-	compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-	io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
-	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
-	if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-		fprintf(test_log, "PASS\n");
-	} else {
-		fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
-		errcount++;
-	}
-	free(compute_elements);
-	free(io_elements);
+			ierr = transfer_field_2d(decomp, SMIOL_IO_TO_COMP, sizeof(double) * n_levels, n_levels,
+			                         io_field, comp_field);
+			fail |= (ierr != SMIOL_SUCCESS);
 
-	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with 0 elements: ");
-	ierr = SMIOL_free_decomp(&decomp);
-	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "PASS\n");
-	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
-		errcount++;
-	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
+			/* Every task has compute elements to send */
+			ierr = transfer_field_2d(decomp, SMIOL_COMP_TO_IO, sizeof(double) * n_levels, n_levels,
+			                         NULL, io_field);
+			fail |= (ierr != SMIOL_INVALID_ARGUMENT);
+			for (i = 0; i < n_compute_elements; i++) {
+				for (k = 0; k < n_levels; k++) {
+					if (comp_field[i * n_levels + k]
+					    != (double)(compute_elements[i] * 10 + (SMIOL_Offset)k) + 42.0) {
+						fail = 1;
+					}
+				}
+			}
+			free(comp_field);
+			free(io_field);
+
+			if (!fail) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - levels were not transferred to and from their I/O tasks\n");
+				errcount++;
+			}
+		} else {
+			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or I/O groups were not formed\n");
+			errcount++;
+		}
+		free(compute_elements);
+
+		ierr = SMIOL_free_decomp(&decomp);
+		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
+			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_set_io_vertical_blocks did not return SMIOL_SUCCESS\n");
 		errcount++;
 	}
 
-	/* In case an error occured above, free the decomp to continue testing */
-	if (decomp != NULL) {
-		free(decomp);
-		decomp = NULL;
+	ierr = SMIOL_set_io_vertical_blocks(context, 1);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to disable vertical blocks of I/O...\n");
+		return -1;
 	}
 
-	/* Create and Free Decomp with elements == 1 */
-	fprintf(test_log, "Everything OK (build_exchange) with 1 elements: ");
+	/* More owned elements than compute elements */
+	fprintf(test_log, "SMIOL_create_halo_decomp with more owned than compute elements: ");
 	n_compute_elements = 1;
-	n_io_elements = 1;
 	compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-	io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
-	memset((void *)compute_elements, 0, sizeof(SMIOL_Offset) * n_compute_elements);
-	memset((void *)io_elements, 0, sizeof(SMIOL_Offset) * n_io_elements);
-	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
-	if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+	compute_elements[0] = (SMIOL_Offset)comm_rank;
+	ierr = SMIOL_create_halo_decomp(context, n_compute_elements, compute_elements, 2,
+	                                comm_size, 1, &decomp);
+	free(compute_elements);
+	if (ierr == SMIOL_INVALID_ARGUMENT && decomp == NULL) {
 		fprintf(test_log, "PASS\n");
 	} else {
-		fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned or decomp was not NULL\n");
 		errcount++;
 	}
-	free(compute_elements);
-	free(io_elements);
 
-	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with 1 elements: ");
-	ierr = SMIOL_free_decomp(&decomp);
-	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "PASS\n");
-	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
-		errcount++;
-	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
-		errcount++;
-	}
+	/* Owned elements with gaps, plus halo copies from this and the next task */
+	fprintf(test_log, "Halo decomp with gaps, write owned elements and fill all copies on read: ");
+	{
+		size_t n_owned = 4;
+		double *comp_field;
+		double *io_field;
+		int fail = 0;
 
-	if (decomp != NULL) {
-		free(decomp);
-		decomp = NULL;
-	}
+		n_compute_elements = n_owned + 3;
+		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+		for (i = 0; i < n_owned; i++) {
+			compute_elements[i] = (SMIOL_Offset)(3 * ((size_t)comm_rank * n_owned + i));
+		}
+		compute_elements[n_owned] = (SMIOL_Offset)(3 * ((size_t)((comm_rank + 1) % comm_size) * n_owned));
+		compute_elements[n_owned + 1] = compute_elements[n_owned] + 3;
+		compute_elements[n_owned + 2] = compute_elements[0];
 
-	/* Create and Free Decomp with large amount of elements */
-	fprintf(test_log, "Everything OK (build_exchange) with large amount of elements: ");
-	n_compute_elements = 1000000;
-	n_io_elements = 1000000;
-	compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-	io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
-	memset((void *)compute_elements, 0, sizeof(SMIOL_Offset) * n_compute_elements);
-	memset((void *)io_elements, 0, sizeof(SMIOL_Offset) * n_io_elements);
-	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
-	if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-		fprintf(test_log, "PASS\n");
-	} else {
-		fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
-		errcount++;
-	}
-	free(compute_elements);
-	free(io_elements);
+		ierr = SMIOL_create_halo_decomp(context, n_compute_elements, compute_elements, n_owned,
+		                                comm_size, 1, &decomp);
+		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+			comp_field = malloc(sizeof(double) * n_compute_elements);
+			io_field = malloc(sizeof(double) * (decomp->io_count + 1));
+			for (i = 0; i < n_compute_elements; i++) {
+				comp_field[i] = (i < n_owned) ? (double)compute_elements[i] * 2.0 : -1.0;
+			}
 
-	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with large amount of elements: ");
-	ierr = SMIOL_free_decomp(&decomp);
-	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "PASS\n");
-	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
-		errcount++;
-	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
-		errcount++;
-	}
+			ierr = transfer_field(decomp, SMIOL_COMP_TO_IO, sizeof(double), comp_field, io_field);
+			fail |= (ierr != SMIOL_SUCCESS);
+			fill_io_gaps(decomp, SMIOL_REAL64, sizeof(double), io_field);
+			for (i = 0; i < decomp->io_count; i++) {
+				size_t id = decomp->io_start + i;
 
-	if (decomp != NULL) {
-		free(decomp);
-		decomp = NULL;
-	}
+				if ((id % 3 == 0 && io_field[i] != (double)id * 2.0)
+				    || (id % 3 != 0 && io_field[i] != SMIOL_FILL_REAL64)) {
+					fail = 1;
+				}
+				io_field[i] += 1.0;
+			}
 
-	/* Free a decomp that has already been freed */
-	fprintf(test_log, "Everything OK (SMIOL_free_decomp) freeing a NULL decomp: ");
-	ierr = SMIOL_free_decomp(&decomp);
-	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "PASS\n");
-	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
-		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
-		errcount++;
-	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
-		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
-		errcount++;
+			ierr = transfer_field(decomp, SMIOL_IO_TO_COMP, sizeof(double), io_field, comp_field);
+			fail |= (ierr != SMIOL_SUCCESS);
+			for (i = 0; i < n_compute_elements; i++) {
+				if (comp_field[i] != (double)compute_elements[i] * 2.0 + 1.0) {
+					fail = 1;
+				}
+			}
+			free(comp_field);
+			free(io_field);
+
+			if (!fail) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - owned elements, gaps, or halo copies were not handled correctly\n");
+				errcount++;
+			}
+		} else {
+			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
+			errcount++;
+		}
+		free(compute_elements);
+
+		ierr = SMIOL_free_decomp(&decomp);
+		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
+			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
+			errcount++;
+		}
 	}
 
 	/*
@@ -1296,29 +1697,21 @@ int test_build_exch(FILE *test_log)
 	 */
 	if (comm_size == 2) {
 
-		/* Even/odd compute, half/half I/O */
-		fprintf(test_log, "Even/odd compute, half/half I/O: ");
+		/* Odd/even compute, half/half I/O */
+		fprintf(test_log, "Odd/even compute, half/half I/O: ");
 		n_compute_elements = 4;
-		n_io_elements = 4;
 		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
 
 		if (comm_rank == 0) {
 			for (i = 0; i < n_compute_elements; i++) {
 				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);    /* Odd elements */
 			}
-			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)i;                   /* First half of elements */
-			}
 		} else {
 			for (i = 0; i < n_compute_elements; i++) {
 				compute_elements[i] = (SMIOL_Offset)(2 * i);        /* Even elements */
 			}
-			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)(4 + i);             /* Second half of elements */
-			}
 		}
-		ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, 2, 1, &decomp);
 		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
 
 			/* The correct comp_list and io_list arrays, below, were verified manually */
@@ -1346,7 +1739,6 @@ int test_build_exch(FILE *test_log)
 		}
 
 		free(compute_elements);
-		free(io_elements);
 
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
@@ -1355,46 +1747,34 @@ int test_build_exch(FILE *test_log)
 		}
 
 
-		/* Even/odd compute, nothing/all I/O */
-		fprintf(test_log, "Even/odd compute, nothing/all I/O: ");
+		/* Even/odd compute, all/nothing I/O */
+		fprintf(test_log, "Even/odd compute, all/nothing I/O: ");
 		n_compute_elements = 4;
-		if (comm_rank == 0) {
-			n_io_elements = 0;
-		} else {
-			n_io_elements = 8;
-		}
 		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
 
 		if (comm_rank == 0) {
 			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);    /* Odd elements */
+				compute_elements[i] = (SMIOL_Offset)(2 * i);        /* Even elements */
 			}
-
-			/* No I/O elements */
 		} else {
 			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i);        /* Even elements */
-			}
-
-			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)i;                   /* All I/O elements */
+				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);    /* Odd elements */
 			}
 		}
-		ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, 1, 2, &decomp);
 		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
 
 			/* The correct comp_list and io_list arrays, below, were verified manually */
 			if (comm_rank == 0) {
-				SMIOL_Offset comp_list_correct[] = { 1, 1, 4, 0, 1, 2, 3 };
-				SMIOL_Offset io_list_correct[] = { 0 };
+				SMIOL_Offset comp_list_correct[] = { 1, 0, 4, 0, 1, 2, 3 };
+				SMIOL_Offset io_list_correct[] = { 2, 0, 4, 0, 2, 4, 6, 1, 4, 1, 3, 5, 7 };
 
-				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)1, io_list_correct);
+				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)13, io_list_correct);
 			} else {
-				SMIOL_Offset comp_list_correct[] = { 1, 1, 4, 0, 1, 2, 3 };
-				SMIOL_Offset io_list_correct[] = { 2, 0, 4, 1, 3, 5, 7, 1, 4, 0, 2, 4, 6 };
+				SMIOL_Offset comp_list_correct[] = { 1, 0, 4, 0, 1, 2, 3 };
+				SMIOL_Offset io_list_correct[] = { 0 };
 
-				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)13, io_list_correct);
+				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)1, io_list_correct);
 			}
 
 			if (ierr == 0) {
@@ -1407,8 +1787,8 @@ int test_build_exch(FILE *test_log)
 			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
 			errcount++;
 		}
+
 		free(compute_elements);
-		free(io_elements);
 
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
@@ -1417,45 +1797,36 @@ int test_build_exch(FILE *test_log)
 		}
 
 
-		/* All/nothing compute, nothing/all I/O */
-		fprintf(test_log, "All/nothing compute, nothing/all I/O: ");
+		/* Nothing/all compute, all/nothing I/O */
+		fprintf(test_log, "Nothing/all compute, all/nothing I/O: ");
 		if (comm_rank == 0) {
-			n_compute_elements = 8;
-			n_io_elements = 0;
-		} else {
 			n_compute_elements = 0;
-			n_io_elements = 8;
+		} else {
+			n_compute_elements = 8;
 		}
 		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
 
 		if (comm_rank == 0) {
+			/* No compute elements */
+		} else {
 			for (i = 0; i < n_compute_elements; i++) {
 				compute_elements[i] = (SMIOL_Offset)(n_compute_elements - 1 - i);    /* All compute elements */
 			}
-
-			/* No I/O elements */
-		} else {
-			/* No compute elements */
-
-			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)i;                   /* All I/O elements */
-			}
 		}
-		ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+		ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements, 1, 2, &decomp);
 		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
 
 			/* The correct comp_list and io_list arrays, below, were verified manually */
 			if (comm_rank == 0) {
-				SMIOL_Offset comp_list_correct[] = { 1, 1, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
-				SMIOL_Offset io_list_correct[] = { 0 };
-
-				ierr = compare_decomps(decomp, (size_t)11, comp_list_correct, (size_t)1, io_list_correct);
-			} else {
 				SMIOL_Offset comp_list_correct[] = { 0 };
-				SMIOL_Offset io_list_correct[] = { 1, 0, 8, 0, 1, 2, 3, 4, 5, 6, 7 };
+				SMIOL_Offset io_list_correct[] = { 1, 1, 8, 0, 1, 2, 3, 4, 5, 6, 7 };
 
 				ierr = compare_decomps(decomp, (size_t)1, comp_list_correct, (size_t)11, io_list_correct);
+			} else {
+				SMIOL_Offset comp_list_correct[] = { 1, 0, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+				SMIOL_Offset io_list_correct[] = { 0 };
+
+				ierr = compare_decomps(decomp, (size_t)11, comp_list_correct, (size_t)1, io_list_correct);
 			}
 
 			if (ierr == 0) {
@@ -1468,8 +1839,8 @@ int test_build_exch(FILE *test_log)
 			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
 			errcount++;
 		}
+
 		free(compute_elements);
-		free(io_elements);
 
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
@@ -1496,35 +1867,20 @@ int test_build_exch(FILE *test_log)
 	return errcount;
 }
 
-int test_transfer(FILE *test_log)
+int test_build_exch(FILE *test_log)
 {
 	int ierr;
 	int errcount = 0;
 	int comm_rank;
 	int comm_size;
-	int j;
 	size_t i;
 	size_t n_compute_elements, n_io_elements;
 	SMIOL_Offset *compute_elements = NULL, *io_elements = NULL;
 	struct SMIOL_context *context = NULL;
 	struct SMIOL_decomp *decomp = NULL;
 
-	/* Pointers to transfer tests for various element types */
-	int (*testfun[4])(size_t,size_t,struct SMIOL_decomp *) = {
-	    transfer_char,
-	    transfer_int,
-	    transfer_float,
-	    transfer_double };
-
-	/* Names of the element types tested by transfer test function */
-	const char *testname[4] = {
-	    "char",
-	    "int",
-	    "float",
-	    "double" };
-
 	fprintf(test_log, "********************************************************************************\n");
-	fprintf(test_log, "************************* transfer_field unit tests ****************************\n");
+	fprintf(test_log, "************************* build_exchange unit tests ****************************\n");
 	fprintf(test_log, "\n");
 
 	ierr = MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
@@ -1546,83 +1902,217 @@ int test_transfer(FILE *test_log)
 		return -1;
 	}
 
-	/*
-	 * The following tests will only be run if there are exactly two MPI
-	 * tasks. In principle, as long as there are at least two MPI ranks in
-	 * MPI_COMM_WORLD, an intracommunicator with exactly two ranks could be
-	 * created for these tests.
-	 */
-	if (comm_size != 2) {
-		fprintf(test_log, "<<< Tests that require exactly 2 MPI tasks will not be run >>>\n");
+	/* Test create decomp with io_elements and compute_elements == NULL and
+	 * n_io_elements and n_compute != 0 */
+	fprintf(test_log, "Testing build_exchange with NULL elements and n_elements != 0: ");
+	n_compute_elements = 1;
+	n_io_elements = 1;
+	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+	if (ierr == SMIOL_INVALID_ARGUMENT && decomp == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - Either SMIOL_INVALID_ARGUMENT was not returned or DECOMP was not NULL\n");
+		errcount++;
+	}
 
-		/* Free the SMIOL context */
-		ierr = SMIOL_finalize(&context);
-		if (ierr != SMIOL_SUCCESS || context != NULL) {
-			fprintf(test_log, "Failed to free SMIOL context...\n");
-			return -1;
-		}
+	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with NULL elements: ");
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
+		errcount++;
+	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
+		errcount++;
+	}
 
-		return 0;
+
+	/* Create and Free Decomp with elements == 0 */
+	fprintf(test_log, "Everything OK (build_exchange) with 0 elements: ");
+	n_compute_elements = 0;
+	n_io_elements = 0;
+	compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+	io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+	if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
+		errcount++;
 	}
+	free(compute_elements);
+	free(io_elements);
 
-	/* Iterate over different test element types and associated functions */
-	for (j = 0; j < 4; j++) {
+	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with 0 elements: ");
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
+		errcount++;
+	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
+		errcount++;
+	}
 
-		/* Even/odd compute, half/half I/O */
-		fprintf(test_log, "Even/odd compute, half/half I/O (%s): ", testname[j]);
-		n_compute_elements = 4;
-		n_io_elements = 4;
-		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
-		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+	/* In case an error occured above, free the decomp to continue testing */
+	if (decomp != NULL) {
+		free(decomp);
+		decomp = NULL;
+	}
 
-		if (comm_rank == 0) {
-			/* Odd elements */
-			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);
-			}
+	/* Create and Free Decomp with elements == 1 */
+	fprintf(test_log, "Everything OK (build_exchange) with 1 elements: ");
+	n_compute_elements = 1;
+	n_io_elements = 1;
+	compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+	io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+	memset((void *)compute_elements, 0, sizeof(SMIOL_Offset) * n_compute_elements);
+	memset((void *)io_elements, 0, sizeof(SMIOL_Offset) * n_io_elements);
+	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+	if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
+		errcount++;
+	}
+	free(compute_elements);
+	free(io_elements);
 
-			/* First half of elements */
-			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)i;
-			}
-		} else {
-			/* Even elements */
-			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i);
-			}
+	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with 1 elements: ");
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
+		errcount++;
+	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
+		errcount++;
+	}
 
-			/* Second half of elements */
+	if (decomp != NULL) {
+		free(decomp);
+		decomp = NULL;
+	}
+
+	/* Create and Free Decomp with large amount of elements */
+	fprintf(test_log, "Everything OK (build_exchange) with large amount of elements: ");
+	n_compute_elements = 1000000;
+	n_io_elements = 1000000;
+	compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+	io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+	memset((void *)compute_elements, 0, sizeof(SMIOL_Offset) * n_compute_elements);
+	memset((void *)io_elements, 0, sizeof(SMIOL_Offset) * n_io_elements);
+	ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+	if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
+		errcount++;
+	}
+	free(compute_elements);
+	free(io_elements);
+
+	fprintf(test_log, "Everything OK (SMIOL_free_decomp) with large amount of elements: ");
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
+		errcount++;
+	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
+		errcount++;
+	}
+
+	if (decomp != NULL) {
+		free(decomp);
+		decomp = NULL;
+	}
+
+	/* Free a decomp that has already been freed */
+	fprintf(test_log, "Everything OK (SMIOL_free_decomp) freeing a NULL decomp: ");
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr == SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else if (ierr == SMIOL_SUCCESS && decomp != NULL) {
+		fprintf(test_log, "FAIL - Returned SMIOL_SUCCESS but, decomp was not NULL\n");
+		errcount++;
+	} else if (ierr != SMIOL_SUCCESS && decomp == NULL) {
+		fprintf(test_log, "FAIL - decomp was NULL but did not returned SMIOL_SUCCESS\n");
+		errcount++;
+	}
+
+	/*
+	 * The following tests will only be run if there are exactly two MPI tasks.
+	 * In principle, as long as there are at least two MPI ranks in MPI_COMM_WORLD,
+	 * an intracommunicator with exactly two ranks could be created for these tests.
+	 */
+	if (comm_size == 2) {
+
+		/* Even/odd compute, half/half I/O */
+		fprintf(test_log, "Even/odd compute, half/half I/O: ");
+		n_compute_elements = 4;
+		n_io_elements = 4;
+		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+
+		if (comm_rank == 0) {
+			for (i = 0; i < n_compute_elements; i++) {
+				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);    /* Odd elements */
+			}
 			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)(4 + i);
+				io_elements[i] = (SMIOL_Offset)i;                   /* First half of elements */
+			}
+		} else {
+			for (i = 0; i < n_compute_elements; i++) {
+				compute_elements[i] = (SMIOL_Offset)(2 * i);        /* Even elements */
+			}
+			for (i = 0; i < n_io_elements; i++) {
+				io_elements[i] = (SMIOL_Offset)(4 + i);             /* Second half of elements */
 			}
 		}
-		ierr = build_exchange(context,
-		                      n_compute_elements, compute_elements,
-		                      n_io_elements, io_elements, &decomp);
-		if (ierr != SMIOL_SUCCESS || decomp == NULL) {
-			fprintf(test_log, "Failed to build exchange to test transfer_field...\n");
-			return -1;
-		}
+		ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
 
-		free(compute_elements);
-		free(io_elements);
+			/* The correct comp_list and io_list arrays, below, were verified manually */
+			if (comm_rank == 0) {
+				SMIOL_Offset comp_list_correct[] = { 2, 0, 2, 0, 1, 1, 2, 2, 3 };
+				SMIOL_Offset io_list_correct[] = { 2, 0, 2, 1, 3, 1, 2, 0, 2 };
 
-		if (testfun[j](n_compute_elements, n_io_elements, decomp) == 0) {
-			fprintf(test_log, "PASS\n");
+				ierr = compare_decomps(decomp, (size_t)9, comp_list_correct, (size_t)9, io_list_correct);
+			} else {
+				SMIOL_Offset comp_list_correct[] = { 2, 0, 2, 0, 1, 1, 2, 2, 3 };
+				SMIOL_Offset io_list_correct[] = { 2, 0, 2, 1, 3, 1, 2, 0, 2 };
+
+				ierr = compare_decomps(decomp, (size_t)9, comp_list_correct, (size_t)9, io_list_correct);
+			}
+
+			if (ierr == 0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - the decomp did not contain the expected values\n");
+				errcount++;
+			}
 		} else {
-			fprintf(test_log, "FAIL\n");
+			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
 			errcount++;
 		}
 
+		free(compute_elements);
+		free(io_elements);
+
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
-			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful...\n");
-			return -1;
+			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
+			errcount++;
 		}
 
 
 		/* Even/odd compute, nothing/all I/O */
-		fprintf(test_log, "Even/odd compute, nothing/all I/O (%s): ", testname[j]);
+		fprintf(test_log, "Even/odd compute, nothing/all I/O: ");
 		n_compute_elements = 4;
 		if (comm_rank == 0) {
 			n_io_elements = 0;
@@ -1633,40 +2123,48 @@ int test_transfer(FILE *test_log)
 		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
 
 		if (comm_rank == 0) {
-			/* Odd elements */
 			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);
+				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);    /* Odd elements */
 			}
 
 			/* No I/O elements */
 		} else {
-			/* Even elements */
 			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(2 * i);
+				compute_elements[i] = (SMIOL_Offset)(2 * i);        /* Even elements */
 			}
 
-			/* All I/O elements */
 			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)i;
+				io_elements[i] = (SMIOL_Offset)i;                   /* All I/O elements */
 			}
 		}
-		ierr = build_exchange(context,
-		                      n_compute_elements, compute_elements,
-		                      n_io_elements, io_elements, &decomp);
-		if (ierr != SMIOL_SUCCESS || decomp == NULL) {
-			fprintf(test_log, "Failed to build exchange to test transfer_field...\n");
-			return -1;
-		}
+		ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
 
-		free(compute_elements);
-		free(io_elements);
+			/* The correct comp_list and io_list arrays, below, were verified manually */
+			if (comm_rank == 0) {
+				SMIOL_Offset comp_list_correct[] = { 1, 1, 4, 0, 1, 2, 3 };
+				SMIOL_Offset io_list_correct[] = { 0 };
 
-		if (testfun[j](n_compute_elements, n_io_elements, decomp) == 0) {
-			fprintf(test_log, "PASS\n");
+				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)1, io_list_correct);
+			} else {
+				SMIOL_Offset comp_list_correct[] = { 1, 1, 4, 0, 1, 2, 3 };
+				SMIOL_Offset io_list_correct[] = { 2, 0, 4, 1, 3, 5, 7, 1, 4, 0, 2, 4, 6 };
+
+				ierr = compare_decomps(decomp, (size_t)7, comp_list_correct, (size_t)13, io_list_correct);
+			}
+
+			if (ierr == 0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - the decomp did not contain the expected values\n");
+				errcount++;
+			}
 		} else {
-			fprintf(test_log, "FAIL\n");
+			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
 			errcount++;
 		}
+		free(compute_elements);
+		free(io_elements);
 
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
@@ -1676,7 +2174,7 @@ int test_transfer(FILE *test_log)
 
 
 		/* All/nothing compute, nothing/all I/O */
-		fprintf(test_log, "All/nothing compute, nothing/all I/O (%s): ", testname[j]);
+		fprintf(test_log, "All/nothing compute, nothing/all I/O: ");
 		if (comm_rank == 0) {
 			n_compute_elements = 8;
 			n_io_elements = 0;
@@ -1688,37 +2186,46 @@ int test_transfer(FILE *test_log)
 		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
 
 		if (comm_rank == 0) {
-			/* All compute elements */
 			for (i = 0; i < n_compute_elements; i++) {
-				compute_elements[i] = (SMIOL_Offset)(n_compute_elements - 1 - i);
+				compute_elements[i] = (SMIOL_Offset)(n_compute_elements - 1 - i);    /* All compute elements */
 			}
 
 			/* No I/O elements */
 		} else {
 			/* No compute elements */
 
-			/* All I/O elements */
 			for (i = 0; i < n_io_elements; i++) {
-				io_elements[i] = (SMIOL_Offset)i;
+				io_elements[i] = (SMIOL_Offset)i;                   /* All I/O elements */
 			}
 		}
-		ierr = build_exchange(context,
-		                      n_compute_elements, compute_elements,
-		                      n_io_elements, io_elements, &decomp);
-		if (ierr != SMIOL_SUCCESS || decomp == NULL) {
-			fprintf(test_log, "Failed to build exchange to test transfer_field...\n");
-			return -1;
-		}
+		ierr = build_exchange(context, n_compute_elements, compute_elements, n_io_elements, io_elements, &decomp);
+		if (ierr == SMIOL_SUCCESS && decomp != NULL) {
 
-		free(compute_elements);
-		free(io_elements);
+			/* The correct comp_list and io_list arrays, below, were verified manually */
+			if (comm_rank == 0) {
+				SMIOL_Offset comp_list_correct[] = { 1, 1, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+				SMIOL_Offset io_list_correct[] = { 0 };
 
-		if (testfun[j](n_compute_elements, n_io_elements, decomp) == 0) {
-			fprintf(test_log, "PASS\n");
+				ierr = compare_decomps(decomp, (size_t)11, comp_list_correct, (size_t)1, io_list_correct);
+			} else {
+				SMIOL_Offset comp_list_correct[] = { 0 };
+				SMIOL_Offset io_list_correct[] = { 1, 0, 8, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+				ierr = compare_decomps(decomp, (size_t)1, comp_list_correct, (size_t)11, io_list_correct);
+			}
+
+			if (ierr == 0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - the decomp did not contain the expected values\n");
+				errcount++;
+			}
 		} else {
-			fprintf(test_log, "FAIL\n");
+			fprintf(test_log, "FAIL - SMIOL_SUCCESS was not returned or decomp was NULL\n");
 			errcount++;
 		}
+		free(compute_elements);
+		free(io_elements);
 
 		ierr = SMIOL_free_decomp(&decomp);
 		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
@@ -1726,6 +2233,8 @@ int test_transfer(FILE *test_log)
 			errcount++;
 		}
 
+	} else {
+		fprintf(test_log, "<<< Tests that require exactly 2 MPI tasks will not be run >>>\n");
 	}
 
 	/* Free the SMIOL context */
@@ -1743,31 +2252,278 @@ int test_transfer(FILE *test_log)
 	return errcount;
 }
 
-int test_dimensions(FILE *test_log)
+int test_transfer(FILE *test_log)
 {
 	int ierr;
-	int errcount;
-	int is_unlimited;
-	SMIOL_Offset dimsize;
-	struct SMIOL_context *context;
-	struct SMIOL_file *file;
-	SMIOL_Offset expected_dimsize;
+	int errcount = 0;
+	int comm_rank;
+	int comm_size;
+	int j;
+	size_t i;
+	size_t n_compute_elements, n_io_elements;
+	SMIOL_Offset *compute_elements = NULL, *io_elements = NULL;
+	struct SMIOL_context *context = NULL;
+	struct SMIOL_decomp *decomp = NULL;
+
+	/* Pointers to transfer tests for various element types */
+	int (*testfun[4])(size_t,size_t,struct SMIOL_decomp *) = {
+	    transfer_char,
+	    transfer_int,
+	    transfer_float,
+	    transfer_double };
+
+	/* Names of the element types tested by transfer test function */
+	const char *testname[4] = {
+	    "char",
+	    "int",
+	    "float",
+	    "double" };
 
 	fprintf(test_log, "********************************************************************************\n");
-	fprintf(test_log, "************ SMIOL_define_dim / SMIOL_inquire_dim ******************************\n");
+	fprintf(test_log, "************************* transfer_field unit tests ****************************\n");
 	fprintf(test_log, "\n");
 
-	errcount = 0;
-
-	/* Create a SMIOL context for testing dimension routines */
-	context = NULL;
-	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
-	if (ierr != SMIOL_SUCCESS || context == NULL) {
-		fprintf(test_log, "Failed to create SMIOL context...\n");
+	ierr = MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+	if (ierr != MPI_SUCCESS) {
+		fprintf(test_log, "Failed to get MPI rank...\n");
 		return -1;
 	}
 
-	/* Create a SMIOL file for testing dimension routines */
+	ierr = MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+	if (ierr != MPI_SUCCESS) {
+		fprintf(test_log, "Failed to get MPI size...\n");
+		return -1;
+	}
+
+	/* Create a SMIOL context for testing decomp routines */
+	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
+	if (ierr != SMIOL_SUCCESS || context == NULL) {
+		fprintf(test_log, "Failed to create SMIOL context...\n");
+		return -1;
+	}
+
+	/*
+	 * The following tests will only be run if there are exactly two MPI
+	 * tasks. In principle, as long as there are at least two MPI ranks in
+	 * MPI_COMM_WORLD, an intracommunicator with exactly two ranks could be
+	 * created for these tests.
+	 */
+	if (comm_size != 2) {
+		fprintf(test_log, "<<< Tests that require exactly 2 MPI tasks will not be run >>>\n");
+
+		/* Free the SMIOL context */
+		ierr = SMIOL_finalize(&context);
+		if (ierr != SMIOL_SUCCESS || context != NULL) {
+			fprintf(test_log, "Failed to free SMIOL context...\n");
+			return -1;
+		}
+
+		return 0;
+	}
+
+	/* Iterate over different test element types and associated functions */
+	for (j = 0; j < 4; j++) {
+
+		/* Even/odd compute, half/half I/O */
+		fprintf(test_log, "Even/odd compute, half/half I/O (%s): ", testname[j]);
+		n_compute_elements = 4;
+		n_io_elements = 4;
+		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+
+		if (comm_rank == 0) {
+			/* Odd elements */
+			for (i = 0; i < n_compute_elements; i++) {
+				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);
+			}
+
+			/* First half of elements */
+			for (i = 0; i < n_io_elements; i++) {
+				io_elements[i] = (SMIOL_Offset)i;
+			}
+		} else {
+			/* Even elements */
+			for (i = 0; i < n_compute_elements; i++) {
+				compute_elements[i] = (SMIOL_Offset)(2 * i);
+			}
+
+			/* Second half of elements */
+			for (i = 0; i < n_io_elements; i++) {
+				io_elements[i] = (SMIOL_Offset)(4 + i);
+			}
+		}
+		ierr = build_exchange(context,
+		                      n_compute_elements, compute_elements,
+		                      n_io_elements, io_elements, &decomp);
+		if (ierr != SMIOL_SUCCESS || decomp == NULL) {
+			fprintf(test_log, "Failed to build exchange to test transfer_field...\n");
+			return -1;
+		}
+
+		free(compute_elements);
+		free(io_elements);
+
+		if (testfun[j](n_compute_elements, n_io_elements, decomp) == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL\n");
+			errcount++;
+		}
+
+		ierr = SMIOL_free_decomp(&decomp);
+		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
+			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful...\n");
+			return -1;
+		}
+
+
+		/* Even/odd compute, nothing/all I/O */
+		fprintf(test_log, "Even/odd compute, nothing/all I/O (%s): ", testname[j]);
+		n_compute_elements = 4;
+		if (comm_rank == 0) {
+			n_io_elements = 0;
+		} else {
+			n_io_elements = 8;
+		}
+		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+
+		if (comm_rank == 0) {
+			/* Odd elements */
+			for (i = 0; i < n_compute_elements; i++) {
+				compute_elements[i] = (SMIOL_Offset)(2 * i + 1);
+			}
+
+			/* No I/O elements */
+		} else {
+			/* Even elements */
+			for (i = 0; i < n_compute_elements; i++) {
+				compute_elements[i] = (SMIOL_Offset)(2 * i);
+			}
+
+			/* All I/O elements */
+			for (i = 0; i < n_io_elements; i++) {
+				io_elements[i] = (SMIOL_Offset)i;
+			}
+		}
+		ierr = build_exchange(context,
+		                      n_compute_elements, compute_elements,
+		                      n_io_elements, io_elements, &decomp);
+		if (ierr != SMIOL_SUCCESS || decomp == NULL) {
+			fprintf(test_log, "Failed to build exchange to test transfer_field...\n");
+			return -1;
+		}
+
+		free(compute_elements);
+		free(io_elements);
+
+		if (testfun[j](n_compute_elements, n_io_elements, decomp) == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL\n");
+			errcount++;
+		}
+
+		ierr = SMIOL_free_decomp(&decomp);
+		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
+			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
+			errcount++;
+		}
+
+
+		/* All/nothing compute, nothing/all I/O */
+		fprintf(test_log, "All/nothing compute, nothing/all I/O (%s): ", testname[j]);
+		if (comm_rank == 0) {
+			n_compute_elements = 8;
+			n_io_elements = 0;
+		} else {
+			n_compute_elements = 0;
+			n_io_elements = 8;
+		}
+		compute_elements = malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+		io_elements = malloc(sizeof(SMIOL_Offset) * n_io_elements);
+
+		if (comm_rank == 0) {
+			/* All compute elements */
+			for (i = 0; i < n_compute_elements; i++) {
+				compute_elements[i] = (SMIOL_Offset)(n_compute_elements - 1 - i);
+			}
+
+			/* No I/O elements */
+		} else {
+			/* No compute elements */
+
+			/* All I/O elements */
+			for (i = 0; i < n_io_elements; i++) {
+				io_elements[i] = (SMIOL_Offset)i;
+			}
+		}
+		ierr = build_exchange(context,
+		                      n_compute_elements, compute_elements,
+		                      n_io_elements, io_elements, &decomp);
+		if (ierr != SMIOL_SUCCESS || decomp == NULL) {
+			fprintf(test_log, "Failed to build exchange to test transfer_field...\n");
+			return -1;
+		}
+
+		free(compute_elements);
+		free(io_elements);
+
+		if (testfun[j](n_compute_elements, n_io_elements, decomp) == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL\n");
+			errcount++;
+		}
+
+		ierr = SMIOL_free_decomp(&decomp);
+		if (ierr != SMIOL_SUCCESS || decomp != NULL) {
+			fprintf(test_log, "After previous unit test, SMIOL_free_decomp was unsuccessful: FAIL\n");
+			errcount++;
+		}
+
+	}
+
+	/* Free the SMIOL context */
+	ierr = SMIOL_finalize(&context);
+	if (ierr != SMIOL_SUCCESS || context != NULL) {
+		fprintf(test_log, "Failed to free SMIOL context...\n");
+		return -1;
+	}
+
+	fflush(test_log);
+	ierr = MPI_Barrier(MPI_COMM_WORLD);
+
+	fprintf(test_log, "\n");
+
+	return errcount;
+}
+
+int test_dimensions(FILE *test_log)
+{
+	int ierr;
+	int errcount;
+	int is_unlimited;
+	SMIOL_Offset dimsize;
+	struct SMIOL_context *context;
+	struct SMIOL_file *file;
+	SMIOL_Offset expected_dimsize;
+
+	fprintf(test_log, "********************************************************************************\n");
+	fprintf(test_log, "************ SMIOL_define_dim / SMIOL_inquire_dim ******************************\n");
+	fprintf(test_log, "\n");
+
+	errcount = 0;
+
+	/* Create a SMIOL context for testing dimension routines */
+	context = NULL;
+	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
+	if (ierr != SMIOL_SUCCESS || context == NULL) {
+		fprintf(test_log, "Failed to create SMIOL context...\n");
+		return -1;
+	}
+
+	/* Create a SMIOL file for testing dimension routines */
 	file = NULL;
 	ierr = SMIOL_open_file(context, "test_dims.nc", SMIOL_FILE_CREATE, &file);
 	if (ierr != SMIOL_SUCCESS || file == NULL) {
@@ -3033,6 +3789,8 @@ int test_file_sync(FILE *test_log)
 	int errcount;
 	struct SMIOL_context *context = NULL;
 	struct SMIOL_file *file = NULL;
+	struct SMIOL_decomp *decomp = NULL;
+	int file_library;
 
 	fprintf(test_log, "********************************************************************************\n");
 	fprintf(test_log, "************************ SMIOL_sync_file unit tests ****************************\n");
@@ -3140,26 +3898,400 @@ int test_file_sync(FILE *test_log)
 	}
 
 
-#ifdef SMIOL_PNETCDF
-	/* Testing a file that was never opened */
-	fprintf(test_log, "Try to sync a file that was never opened: ");
-	file = (struct SMIOL_file *)malloc(sizeof(struct SMIOL_file));
-	file->context = context;
-	file->state = -42;	// Erroneous, currently unused, state
-	ierr = SMIOL_sync_file(file);
-	if (ierr == SMIOL_LIBRARY_ERROR && file != NULL) {
-		fprintf(test_log, "PASS (%s)\n",
-			SMIOL_lib_error_string(context));
-	} else {
-		fprintf(test_log, "FAIL - expected error code of SMIOL_LIBRARY_ERROR not returned, or file was not NULL\n");
-		errcount++;
+	/* Testing deferred writes, which are completed by SMIOL_flush_file */
+	ierr = SMIOL_open_file(context, "smiol_deferred_file.nc", (SMIOL_FILE_CREATE | SMIOL_FILE_DEFERRED), &file);
+	if (ierr != SMIOL_SUCCESS || file == NULL) {
+		fprintf(test_log, "Failed to open `smiol_deferred_file.nc with SMIOL_FILE_DEFERRED\n");
+		return -1;
 	}
-	free(file);
-#endif
 
-	/* Testing SMIOL_sync_file with a NULL file pointer*/
-	file = NULL;
-	fprintf(test_log, "Testing SMIOL_sync_file with a NULL file pointer: ");
+	fprintf(test_log, "Everything OK (SMIOL_flush_file) with deferred writes: ");
+	{
+		const char *dimnames[1] = { "nDeferred" };
+		int values[4] = { 1, 2, 3, 4 };
+		int n_posted = -1;
+
+		/* Disable batching of small variables, which would otherwise
+		 * handle these writes */
+		ierr = SMIOL_set_small_var_batching(context, 0);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_dim(file, "nDeferred", (SMIOL_Offset)4);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "deferred_var", SMIOL_INT32, 1, dimnames);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "deferred_var2", SMIOL_INT32, 1, dimnames);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "deferred_var", NULL, values);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			values[0] = -1;
+			ierr = SMIOL_put_var(file, "deferred_var2", NULL, values);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			n_posted = file->n_pending;
+			ierr = SMIOL_flush_file(file);
+		}
+		if (ierr == SMIOL_SUCCESS && n_posted == 2 && file->n_pending == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d writes were posted\n", SMIOL_error_string(ierr), n_posted);
+			errcount++;
+		}
+	}
+
+	/* Deferred writes still pending are completed when the file is closed */
+	fprintf(test_log, "Everything OK (SMIOL_close_file) with pending deferred writes: ");
+	{
+		int values[4] = { 5, 6, 7, 8 };
+
+		ierr = SMIOL_put_var(file, "deferred_var", NULL, values);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_close_file(&file);
+		}
+		if (ierr == SMIOL_SUCCESS && file == NULL) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+			errcount++;
+		}
+	}
+
+	/* The handle of a closed file is NULL, and closing it again does nothing */
+	fprintf(test_log, "Everything OK (SMIOL_close_file) with a NULL file handle: ");
+	ierr = SMIOL_close_file(&file);
+	if (ierr == SMIOL_SUCCESS && file == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* Testing batched writes of small non-decomposed variables */
+	ierr = SMIOL_set_small_var_batching(context, (size_t)64);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to enable batching of small variables\n");
+		return -1;
+	}
+
+	/* Batched writes are spread over the I/O tasks of the last decomp, every other task */
+	{
+		SMIOL_Offset element;
+
+		element = (SMIOL_Offset)context->comm_rank;
+		ierr = SMIOL_create_decomp(context, (size_t)1, &element,
+		                           (context->comm_size + 1) / 2, 2, &decomp);
+		if (ierr != SMIOL_SUCCESS || decomp == NULL) {
+			fprintf(test_log, "Failed to create decomp...\n");
+			return -1;
+		}
+	}
+
+	/* The values written are read back from a native file */
+	file_library = context->file_library;
+	ierr = SMIOL_set_option(context, "file_library", "native");
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_open_file(context, "smiol_batched_file.nc", SMIOL_FILE_CREATE, &file);
+	}
+	if (ierr != SMIOL_SUCCESS || file == NULL) {
+		fprintf(test_log, "Failed to open `smiol_batched_file.nc\n");
+		return -1;
+	}
+
+	fprintf(test_log, "Everything OK (SMIOL_flush_file) with batched small variables: ");
+	{
+		const char *dimnames[1] = { "nBatched" };
+		char varname[32];
+		int values[4];
+		int n_posted = 0;
+		int n_total = -1;
+		int max_posted = -1;
+		int n_bad = 0;
+		int n_io_tasks = (context->comm_size + 1) / 2;
+		int n_vars = 5;
+		int j, k;
+
+		/* Only the values of MPI rank 0 are written */
+		for (j = 0; j < 4; j++) {
+			values[j] = context->comm_rank * 10 + j + 1;
+		}
+
+		ierr = SMIOL_define_dim(file, "nBatched", (SMIOL_Offset)4);
+		for (k = 0; ierr == SMIOL_SUCCESS && k < n_vars; k++) {
+			snprintf(varname, sizeof(varname), "batched_var%d", k);
+			ierr = SMIOL_define_var(file, varname, SMIOL_INT32, 1, dimnames);
+		}
+		for (k = 0; ierr == SMIOL_SUCCESS && k < n_vars; k++) {
+			snprintf(varname, sizeof(varname), "batched_var%d", k);
+			ierr = SMIOL_put_var(file, varname, NULL, values);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			n_posted = file->n_pending;
+			if (context->comm_rank % 2 != 0 && n_posted != 0) {
+				n_bad++;
+			}
+			MPI_Allreduce(&n_posted, &n_total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+			MPI_Allreduce(&n_posted, &max_posted, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+			ierr = SMIOL_flush_file(file);
+		}
+		for (k = 0; ierr == SMIOL_SUCCESS && k < n_vars; k++) {
+			snprintf(varname, sizeof(varname), "batched_var%d", k);
+			for (j = 0; j < 4; j++) {
+				values[j] = -1;
+			}
+			ierr = SMIOL_get_var(file, varname, NULL, values);
+			for (j = 0; j < 4; j++) {
+				if (values[j] != j + 1) {
+					n_bad++;
+				}
+			}
+		}
+
+		/* Each write is posted by exactly one I/O task, spread round-robin */
+		if (ierr == SMIOL_SUCCESS && n_total == n_vars && file->n_pending == 0
+		    && max_posted == (n_vars + n_io_tasks - 1) / n_io_tasks && n_bad == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d writes were posted, at most %d by one task, %d values were not correct\n",
+			        SMIOL_error_string(ierr), n_total, max_posted, n_bad);
+			errcount++;
+		}
+	}
+
+	/* Every task rejects a batched write without a buffer on MPI rank 0 */
+	fprintf(test_log, "Batched write of a small variable with a NULL buffer on MPI rank 0: ");
+	{
+		int values[4] = { 1, 2, 3, 4 };
+		int n_invalid = 0;
+
+		ierr = SMIOL_put_var(file, "batched_var0", NULL,
+		                     (context->comm_rank == 0) ? NULL : values);
+		if (ierr == SMIOL_INVALID_ARGUMENT) {
+			n_invalid = 1;
+		}
+		MPI_Allreduce(MPI_IN_PLACE, &n_invalid, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+		if (n_invalid == context->comm_size && file->n_pending == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was returned by %d of %d tasks\n",
+			        n_invalid, context->comm_size);
+			errcount++;
+		}
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close 'smiol_batched_file.nc'\n");
+		return -1;
+	}
+
+	context->file_library = file_library;
+
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr != SMIOL_SUCCESS || decomp != NULL) {
+		fprintf(test_log, "Failed to free decomp...\n");
+		return -1;
+	}
+
+	/* Testing a define-phase journal, applied at the first inquiry */
+	ierr = SMIOL_open_file(context, "smiol_journal_file.nc", (SMIOL_FILE_CREATE | SMIOL_FILE_JOURNAL), &file);
+	if (ierr != SMIOL_SUCCESS || file == NULL) {
+		fprintf(test_log, "Failed to open `smiol_journal_file.nc with SMIOL_FILE_JOURNAL\n");
+		return -1;
+	}
+
+	fprintf(test_log, "Everything OK (SMIOL_inquire_var) with journaled definitions: ");
+	{
+		const char *dimnames[1] = { "nJournal" };
+		int values[4] = { 1, 2, 3, 4 };
+		int version = 7;
+		int n_journaled = 0;
+		int ndims = -1;
+		struct SMIOL_define_entry *entry;
+
+		ierr = SMIOL_define_dim(file, "nJournal", (SMIOL_Offset)4);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "journal_var", SMIOL_INT32, 1, dimnames);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_att(file, "journal_var", "version", SMIOL_INT32, &version);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_att(file, NULL, "title", SMIOL_CHAR, "journaled");
+		}
+		for (entry = file->journal_head; entry != NULL; entry = entry->next) {
+			n_journaled++;
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_inquire_var(file, "journal_var", NULL, &ndims, NULL);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "journal_var", NULL, values);
+		}
+#ifdef SMIOL_PNETCDF
+		if (ierr == SMIOL_SUCCESS && ndims != 1) {
+			ierr = SMIOL_LIBRARY_ERROR;
+		}
+#endif
+		if (ierr == SMIOL_SUCCESS && n_journaled == 4 && file->journal_head == NULL) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d definitions were journaled\n",
+			        SMIOL_error_string(ierr), n_journaled);
+			errcount++;
+		}
+	}
+
+	/* Invalid types are rejected when a definition is journaled */
+	fprintf(test_log, "Journal an attribute with an invalid type: ");
+	{
+		int value = 1;
+
+		ierr = SMIOL_define_att(file, NULL, "bad_type", SMIOL_UNKNOWN_VAR_TYPE, &value);
+		if (ierr == SMIOL_INVALID_ARGUMENT && file->journal_head == NULL) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - Expected error code SMIOL_INVALID_ARGUMENT not returned\n");
+			errcount++;
+		}
+	}
+
+	/* Journaled definitions are applied when the file is closed */
+	fprintf(test_log, "Everything OK (SMIOL_close_file) with journaled definitions: ");
+	ierr = SMIOL_define_att(file, NULL, "history", SMIOL_CHAR, "closed with a journal");
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_close_file(&file);
+	}
+	if (ierr == SMIOL_SUCCESS && file == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* No journal is applied for a file that has already been closed */
+	fprintf(test_log, "Everything OK (SMIOL_close_file) with a closed journaled file: ");
+	ierr = SMIOL_close_file(&file);
+	if (ierr == SMIOL_SUCCESS && file == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* Testing a file created with SMIOL_FILE_NOFILL */
+	ierr = SMIOL_open_file(context, "smiol_nofill_file.nc", (SMIOL_FILE_CREATE | SMIOL_FILE_NOFILL), &file);
+	if (ierr != SMIOL_SUCCESS || file == NULL) {
+		fprintf(test_log, "Failed to open `smiol_nofill_file.nc with SMIOL_FILE_NOFILL\n");
+		return -1;
+	}
+
+	fprintf(test_log, "Everything OK (SMIOL_open_file) with SMIOL_FILE_NOFILL: ");
+	if (file->nofill) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - the file was not opened in no-fill mode\n");
+		errcount++;
+	}
+
+	fprintf(test_log, "Everything OK (SMIOL_define_var_fill): ");
+	{
+		const char *dimnames[1] = { "nFill" };
+		float fill_value = -999.0f;
+		float values[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+		ierr = SMIOL_define_dim(file, "nFill", (SMIOL_Offset)4);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "filled_var", SMIOL_REAL32, 1, dimnames);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "unfilled_var", SMIOL_REAL32, 1, dimnames);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var_fill(file, "filled_var", SMIOL_FILL, &fill_value);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var_fill(file, "unfilled_var", SMIOL_NOFILL, NULL);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "unfilled_var", NULL, values);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+			errcount++;
+		}
+	}
+
+	fprintf(test_log, "Define the fill of a variable with an invalid fill mode: ");
+	ierr = SMIOL_define_var_fill(file, "filled_var", SMIOL_FILE_NOFILL, NULL);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - Expected error code SMIOL_INVALID_ARGUMENT not returned\n");
+		errcount++;
+	}
+
+	fprintf(test_log, "Define the fill of a variable with a NULL variable name: ");
+	ierr = SMIOL_define_var_fill(file, NULL, SMIOL_FILL, NULL);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - Expected error code SMIOL_INVALID_ARGUMENT not returned\n");
+		errcount++;
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close 'smiol_nofill_file.nc'\n");
+		return -1;
+	}
+
+	fprintf(test_log, "Set small variable batching with a NULL context: ");
+	ierr = SMIOL_set_small_var_batching(NULL, (size_t)64);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - Expected error code SMIOL_INVALID_ARGUMENT not returned\n");
+		errcount++;
+	}
+
+	/* Testing SMIOL_flush_file with a NULL file pointer */
+	fprintf(test_log, "Testing SMIOL_flush_file with a NULL file pointer: ");
+	ierr = SMIOL_flush_file(NULL);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - Expected error code SMIOL_INVALID_ARGUMENT not returned\n");
+		errcount++;
+	}
+
+#ifdef SMIOL_PNETCDF
+	/* Testing a file that was never opened */
+	fprintf(test_log, "Try to sync a file that was never opened: ");
+	file = (struct SMIOL_file *)malloc(sizeof(struct SMIOL_file));
+	file->context = context;
+	file->state = -42;	// Erroneous, currently unused, state
+	file->backend = SMIOL_LIBRARY_PNETCDF;
+	file->n_pending = 0;
+	file->journal_head = NULL;
+	ierr = SMIOL_sync_file(file);
+	if (ierr == SMIOL_LIBRARY_ERROR && file != NULL) {
+		fprintf(test_log, "PASS (%s)\n",
+			SMIOL_lib_error_string(context));
+	} else {
+		fprintf(test_log, "FAIL - expected error code of SMIOL_LIBRARY_ERROR not returned, or file was not NULL\n");
+		errcount++;
+	}
+	free(file);
+#endif
+
+	/* Testing SMIOL_sync_file with a NULL file pointer*/
+	file = NULL;
+	fprintf(test_log, "Testing SMIOL_sync_file with a NULL file pointer: ");
 	ierr = SMIOL_sync_file(file);
 	if (ierr == SMIOL_INVALID_ARGUMENT && file == NULL) {
 		fprintf(test_log, "PASS\n");
@@ -3408,6 +4540,34 @@ int test_utils(FILE *test_log)
 		free(arr);
 	}
 
+	/* Testing transpose_frames, and that a second transpose restores the array */
+	fprintf(test_log, "Testing transpose_frames on a 3x4 array of pairs: ");
+	{
+		int in[24], mid[24], out[24];
+		int n_wrong = 0;
+		size_t k;
+
+		for (i = 0; i < 24; i++) {
+			in[i] = (int)i;
+		}
+		transpose_frames(3, 4, 2 * sizeof(int), in, mid);
+		transpose_frames(4, 3, 2 * sizeof(int), mid, out);
+		for (i = 0; i < 3; i++) {
+			for (k = 0; k < 4; k++) {
+				if (mid[(k * 3 + i) * 2] != in[(i * 4 + k) * 2]
+				    || mid[(k * 3 + i) * 2 + 1] != in[(i * 4 + k) * 2 + 1]) {
+					n_wrong++;
+				}
+			}
+		}
+		if (n_wrong == 0 && memcmp(in, out, sizeof(in)) == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - elements were not in the expected order\n");
+			errcount++;
+		}
+	}
+
 	fflush(test_log);
 	if (MPI_Barrier(MPI_COMM_WORLD) != MPI_SUCCESS) {
 		fprintf(stderr, "Error: MPI_Barrier failed.\n");
@@ -3681,16 +4841,69 @@ int test_io_decomp(FILE *test_log)
 		errcount++;
 	}
 
-	/* Test more than 2^32 I/O elements */
-	fprintf(test_log, "Test more than 2^32 I/O elements: ");
+	/* Test blocks of levels for a group of three I/O tasks and seven levels */
+	fprintf(test_log, "Test vertical blocks, three I/O tasks and seven levels: ");
+	{
+		size_t level_start, level_count;
+		size_t next_level = 0;
+		size_t level_count_correct[] = { 2, 2, 3 };
+		int group_rank;
+
+		ierr = 0;
+		for (group_rank = 0; group_rank < 3; group_rank++) {
+			get_vertical_block(group_rank, 3, 7, &level_start, &level_count);
+			if (level_start != next_level || level_count != level_count_correct[group_rank]) {
+				ierr = 1;
+			}
+			next_level = level_start + level_count;
+		}
+		get_vertical_block(-1, 3, 7, &level_start, &level_count);
+		if (level_count != 0) {
+			ierr = 1;
+		}
+	}
+	if (ierr == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - Blocks of levels were not contiguous and balanced\n");
+		errcount++;
+	}
+
+	/* Test node placement of I/O tasks, three nodes of four tasks, five I/O tasks */
+	fprintf(test_log, "Test node placement, three nodes of four tasks, five I/O tasks: ");
 	ierr = 0;
-	comm_size = 16;
-	n_io_elements = 65536000002;
-	for (comm_rank = 0; comm_rank < comm_size; comm_rank++) {
-		ierr |= get_io_elements(comm_rank,
-		                        comm_size/2, 2,       /* n_io_tasks, io_stride */
-		                        n_io_elements,
-		                        &io_start[comm_rank], &io_count[comm_rank]);
+	comm_size = 12;
+	n_io_elements = 103;
+	{
+		int node, node_rank, n_node_io, slot, io_rank;
+		int node_io_correct[] = { 2, 2, 1 };
+		int io_node_ranks_correct[] = { 0, 2, 0, 2, 0 };
+
+		io_rank = 0;
+		for (node = 0; node < 3; node++) {
+			n_node_io = get_node_io_tasks(node, 3, 4, 5, 0);
+			if (n_node_io != node_io_correct[node]) {
+				ierr = 1;
+			}
+			for (node_rank = 0; node_rank < 4; node_rank++) {
+				comm_rank = node * 4 + node_rank;
+				slot = get_node_io_slot(node_rank, 4, n_node_io);
+				if (slot >= 0) {
+					if (io_rank >= 5 || node_rank != io_node_ranks_correct[io_rank]) {
+						ierr = 1;
+					}
+					ierr |= get_io_range(io_rank, 5, n_io_elements,
+					                     &io_start[comm_rank], &io_count[comm_rank]);
+					io_rank++;
+				} else {
+					ierr |= get_io_range(-1, 5, n_io_elements,
+					                     &io_start[comm_rank], &io_count[comm_rank]);
+				}
+			}
+		}
+		if (io_rank != 5) {
+			ierr = 1;
+		}
 	}
 	if (ierr == 0) {
 		if (elements_covered(comm_size, io_start, io_count) == n_io_elements) {
@@ -3700,11 +4913,142 @@ int test_io_decomp(FILE *test_log)
 			errcount++;
 		}
 	} else {
-		fprintf(test_log, "FAIL - Non-zero return code for at least one rank\n");
+		fprintf(test_log, "FAIL - I/O tasks were not placed as expected\n");
 		errcount++;
 	}
 
-	fflush(test_log);
+	/* Test node placement with more I/O tasks per node than tasks on a node */
+	fprintf(test_log, "Test node placement, more I/O tasks per node than tasks: ");
+	if (get_node_io_tasks(1, 2, 3, 0, 8) == 3
+	    && get_node_io_slot(0, 3, 3) == 0
+	    && get_node_io_slot(1, 3, 3) == 1
+	    && get_node_io_slot(2, 3, 3) == 2) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - Expected every task on the node to be an I/O task\n");
+		errcount++;
+	}
+
+	/* Test balanced I/O ranges, remainder spread over I/O tasks */
+	fprintf(test_log, "Test balanced I/O ranges, remainder spread over I/O tasks: ");
+	ierr = 0;
+	comm_size = 4;
+	n_io_elements = 103;
+	for (comm_rank = 0; comm_rank < comm_size; comm_rank++) {
+		ierr |= get_io_range_balanced(comm_rank, comm_size, n_io_elements,
+		                              &io_start[comm_rank], &io_count[comm_rank]);
+		if (io_count[comm_rank] != 25 && io_count[comm_rank] != 26) {
+			ierr = 1;
+		}
+	}
+	if (ierr == 0) {
+		if (elements_covered(comm_size, io_start, io_count) == n_io_elements) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - Not all I/O elements covered by decomp\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - Non-zero return code or unbalanced io_count for at least one rank\n");
+		errcount++;
+	}
+
+	/* Test aligned I/O ranges, element size divides alignment */
+	fprintf(test_log, "Test aligned I/O ranges, element size divides alignment: ");
+	ierr = 0;
+	comm_size = 3;
+	n_io_elements = 1000;
+	for (comm_rank = 0; comm_rank < comm_size; comm_rank++) {
+		ierr |= get_io_range_aligned(comm_rank, comm_size, n_io_elements,
+		                             8, 1024,  /* element_size, align_bytes */
+		                             &io_start[comm_rank], &io_count[comm_rank]);
+		if ((io_start[comm_rank] * 8) % 1024 != 0) {
+			ierr = 1;
+		}
+	}
+	if (ierr == 0) {
+		if (elements_covered(comm_size, io_start, io_count) == n_io_elements) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - Not all I/O elements covered by decomp\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - Non-zero return code or unaligned io_start for at least one rank\n");
+		errcount++;
+	}
+
+	/* Test aligned I/O ranges, element size does not divide alignment */
+	fprintf(test_log, "Test aligned I/O ranges, element size does not divide alignment: ");
+	ierr = 0;
+	comm_size = 7;
+	n_io_elements = 12345;
+	for (comm_rank = 0; comm_rank < comm_size; comm_rank++) {
+		ierr |= get_io_range_aligned(comm_rank, comm_size, n_io_elements,
+		                             12, 64,  /* element_size, align_bytes */
+		                             &io_start[comm_rank], &io_count[comm_rank]);
+		if ((io_start[comm_rank] * 12) % 64 != 0) {
+			ierr = 1;
+		}
+	}
+	if (ierr == 0) {
+		if (elements_covered(comm_size, io_start, io_count) == n_io_elements) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - Not all I/O elements covered by decomp\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - Non-zero return code or unaligned io_start for at least one rank\n");
+		errcount++;
+	}
+
+	/* Test aligned I/O ranges with fewer aligned units than I/O tasks */
+	fprintf(test_log, "Test aligned I/O ranges, fewer aligned units than I/O tasks: ");
+	ierr = 0;
+	comm_size = 8;
+	n_io_elements = 300;
+	for (comm_rank = 0; comm_rank < comm_size; comm_rank++) {
+		ierr |= get_io_range_aligned(comm_rank, comm_size, n_io_elements,
+		                             4, 400,  /* element_size, align_bytes */
+		                             &io_start[comm_rank], &io_count[comm_rank]);
+	}
+	if (ierr == 0) {
+		if (elements_covered(comm_size, io_start, io_count) == n_io_elements) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - Not all I/O elements covered by decomp\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - Non-zero return code for at least one rank\n");
+		errcount++;
+	}
+
+	/* Test more than 2^32 I/O elements */
+	fprintf(test_log, "Test more than 2^32 I/O elements: ");
+	ierr = 0;
+	comm_size = 16;
+	n_io_elements = 65536000002;
+	for (comm_rank = 0; comm_rank < comm_size; comm_rank++) {
+		ierr |= get_io_elements(comm_rank,
+		                        comm_size/2, 2,       /* n_io_tasks, io_stride */
+		                        n_io_elements,
+		                        &io_start[comm_rank], &io_count[comm_rank]);
+	}
+	if (ierr == 0) {
+		if (elements_covered(comm_size, io_start, io_count) == n_io_elements) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - Not all I/O elements covered by decomp\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - Non-zero return code for at least one rank\n");
+		errcount++;
+	}
+
+	fflush(test_log);
 	fprintf(test_log, "\n");
 
 	return errcount;
@@ -4178,6 +5522,44 @@ int test_put_get_vars(FILE *test_log)
 		errcount++;
 	}
 
+	/* Reuse and invalidation of cached variable metadata */
+	fprintf(test_log, "Cached variable metadata are reused, and dropped when a dimension is defined: ");
+	{
+		struct SMIOL_var_meta *meta_before = NULL;
+		struct SMIOL_var_meta *meta_after = NULL;
+		struct SMIOL_var_meta *v;
+		int n_found = 0;
+
+		for (i = 0; file->var_meta != NULL && i < SMIOL_VAR_META_BUCKETS; i++) {
+			for (v = file->var_meta[i]; v != NULL; v = v->next) {
+				if (strcmp(v->varname, "seconds_since_epoch") == 0) {
+					meta_before = v;
+				}
+			}
+		}
+
+		ierr = SMIOL_put_var(file, "seconds_since_epoch", NULL, &timestamp);
+		for (i = 0; ierr == SMIOL_SUCCESS && file->var_meta != NULL && i < SMIOL_VAR_META_BUCKETS; i++) {
+			for (v = file->var_meta[i]; v != NULL; v = v->next) {
+				if (strcmp(v->varname, "seconds_since_epoch") == 0) {
+					meta_after = v;
+					n_found++;
+				}
+			}
+		}
+
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_dim(file, "nMetaTest", (SMIOL_Offset)2);
+		}
+		if (ierr == SMIOL_SUCCESS && meta_before != NULL && meta_after == meta_before
+		    && n_found == 1 && file->var_meta == NULL) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - metadata were not cached once or were not dropped\n");
+			errcount++;
+		}
+	}
+
 	ierr = SMIOL_set_frame(file, (SMIOL_Offset)1);
 	if (ierr != SMIOL_SUCCESS) {
 		fprintf(test_log, "Failed to advance frame in file...\n");
@@ -4227,6 +5609,78 @@ int test_put_get_vars(FILE *test_log)
 		errcount++;
 	}
 
+	/* Reuse of I/O plans across writes of a variable with a record dimension */
+	fprintf(test_log, "I/O plans are reused across writes, with the record index of the current frame: ");
+	{
+		struct SMIOL_var_meta *v;
+		struct SMIOL_var_meta *meta = NULL;
+		struct SMIOL_io_plan *plan_before = NULL;
+		struct SMIOL_io_plan *p;
+		int n_plans = 0;
+
+		for (i = 0; file->var_meta != NULL && i < SMIOL_VAR_META_BUCKETS; i++) {
+			for (v = file->var_meta[i]; v != NULL; v = v->next) {
+				if (strcmp(v->varname, "pbl_mask") == 0) {
+					meta = v;
+				}
+			}
+		}
+		if (meta != NULL) {
+			plan_before = meta->plans;
+		}
+
+		ierr = SMIOL_put_var(file, "pbl_mask", NULL, pbl_mask);
+		if (meta != NULL) {
+			for (p = meta->plans; p != NULL; p = p->next) {
+				n_plans++;
+			}
+		}
+
+		if (ierr == SMIOL_SUCCESS && plan_before != NULL && meta->plans == plan_before
+		    && n_plans == 1 && (!plan_before->has_record_dim || plan_before->start[0] == 1)) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - plan was not reused or has the wrong record index\n");
+			errcount++;
+		}
+	}
+
+	/* Variable handles */
+	fprintf(test_log, "Write a variable through a variable handle that survives a definition: ");
+	{
+		struct SMIOL_var *var_h = NULL;
+		struct SMIOL_var *var_h2 = NULL;
+
+		ierr = SMIOL_inquire_var_handle(file, "pbl_mask", &var_h);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var_h(var_h, NULL, pbl_mask);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_dim(file, "nHandleTest", (SMIOL_Offset)3);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var_h(var_h, NULL, pbl_mask);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_inquire_var_handle(file, "pbl_mask", &var_h2);
+		}
+		if (ierr == SMIOL_SUCCESS && var_h != NULL && var_h2 == var_h) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+			errcount++;
+		}
+	}
+
+	fprintf(test_log, "Put with a NULL variable handle: ");
+	ierr = SMIOL_put_var_h(NULL, NULL, pbl_mask);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
 	ierr = SMIOL_set_frame(file, (SMIOL_Offset)2);
 	if (ierr != SMIOL_SUCCESS) {
 		fprintf(test_log, "Failed to advance frame in file...\n");
@@ -4276,6 +5730,81 @@ int test_put_get_vars(FILE *test_log)
 		errcount++;
 	}
 
+	ierr = SMIOL_set_frame(file, (SMIOL_Offset)3);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to advance frame in file...\n");
+		return -1;
+	}
+
+	if (valid_comm_size) {
+		/* Write frames 3 and 4 of a decomposed variable with one call */
+		fprintf(test_log, "Write frames 3 and 4 of a decomposed variable with a record dimension: ");
+		{
+			float *frames;
+
+			frames = malloc(sizeof(float) * n_compute_elements * (size_t)nVertLevels * 2);
+			for (i = 0; i < n_compute_elements * 2; i++) {
+				for (j = 0; j < (size_t)nVertLevels; j++) {
+					/* Frame * 10000 + global element * 10 + level */
+					frames[i*(size_t)nVertLevels + j] = (float)((3 + i / n_compute_elements) * 10000
+					                                    + (size_t)(comm_rank * (nCells / comm_size)) * 10
+					                                    + (i % n_compute_elements) * 10 + j);
+				}
+			}
+			ierr = SMIOL_put_var_frames(file, "foo", decomp, (SMIOL_Offset)2, frames);
+			if (ierr == SMIOL_SUCCESS) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+				errcount++;
+			}
+			free(frames);
+		}
+	}
+
+	/* Write frames 3 and 4 of a non-decomposed variable with one call */
+	fprintf(test_log, "Write frames 3 and 4 of a non-decomposed variable with a record dimension: ");
+	{
+		int masks[20];
+
+		for (i = 0; i < 20; i++) {
+			masks[i] = (int)i;
+		}
+		ierr = SMIOL_put_var_frames(file, "pbl_mask", NULL, (SMIOL_Offset)2, masks);
+		if (ierr == SMIOL_SUCCESS) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+			errcount++;
+		}
+	}
+
+#ifdef SMIOL_PNETCDF
+	/* Several frames of a variable with no record dimension cannot be written */
+	fprintf(test_log, "Write two frames of a variable with no record dimension: ");
+	{
+		double two_coeffs[20];
+
+		memset(two_coeffs, 0, sizeof(two_coeffs));
+		ierr = SMIOL_put_var_frames(file, "coeffs", NULL, (SMIOL_Offset)2, two_coeffs);
+		if (ierr == SMIOL_INVALID_ARGUMENT) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+			errcount++;
+		}
+	}
+#endif
+
+	fprintf(test_log, "Write zero frames of a variable: ");
+	ierr = SMIOL_put_var_frames(file, "pbl_mask", NULL, (SMIOL_Offset)0, pbl_mask);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
 	free(id_string);
 	free(foo);
 	free(coeffs);
@@ -4342,6 +5871,28 @@ int test_put_get_vars(FILE *test_log)
 		return -1;
 	}
 
+	/* Read frames of record variables ahead, so that the frame-by-frame reads below use read-aheads */
+	fprintf(test_log, "Turn on read-ahead of frames for record variables: ");
+	ierr = SMIOL_set_prefetch(file, "foo", 1);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_set_prefetch(file, "pbl_mask", 1);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	fprintf(test_log, "Turn on read-ahead with a NULL file: ");
+	ierr = SMIOL_set_prefetch(NULL, "foo", 1);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
 	/* Supply a NULL file argument */
 	fprintf(test_log, "Supply a NULL file argument to SMIOL_get_var: ");
 	ierr = SMIOL_get_var(NULL, "foo", decomp, foo);
@@ -4440,6 +5991,50 @@ int test_put_get_vars(FILE *test_log)
 		errcount++;
 	}
 
+	/* Read a non-decomposed variable with each read mode */
+	{
+		int modes[3] = { SMIOL_READ_ALL, SMIOL_READ_BCAST, SMIOL_READ_BCAST_NODE };
+		const char *mode_names[3] = { "SMIOL_READ_ALL", "SMIOL_READ_BCAST", "SMIOL_READ_BCAST_NODE" };
+		int m;
+
+		for (m = 0; m < 3; m++) {
+			fprintf(test_log, "Read a non-decomposed variable with %s: ", mode_names[m]);
+
+			/* Values that differ on every task before the read */
+			for (i = 0; i < (size_t)nVertLevels; i++) {
+				coeffs[i] = (double)(context->comm_rank + 1);
+			}
+
+			ierr = SMIOL_set_read_mode(context, modes[m]);
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_get_var(file, "coeffs", NULL, coeffs);
+			}
+#ifdef SMIOL_PNETCDF
+			if (ierr == SMIOL_SUCCESS
+			    && memcmp(coeffs, coeffs_valid, sizeof(double) * (size_t)nVertLevels) == 0) {
+#else
+			if (ierr == SMIOL_SUCCESS) {
+#endif
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - (%s) or values read were not correct\n",
+				        SMIOL_error_string(ierr));
+				errcount++;
+			}
+		}
+
+		fprintf(test_log, "Set an invalid read mode: ");
+		ierr = SMIOL_set_read_mode(context, SMIOL_IO_PLACEMENT_NODE);
+		if (ierr == SMIOL_INVALID_ARGUMENT && context->read_mode == SMIOL_READ_BCAST_NODE) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned, or the mode changed\n");
+			errcount++;
+		}
+
+		(void)SMIOL_set_read_mode(context, SMIOL_READ_BCAST);
+	}
+
 	/* Read a decomposed variable with no record dimension */
 	fprintf(test_log, "Read a decomposed variable with no record dimension: ");
 	memset((void *)id_string, 0, sizeof(char) * (size_t)strLen);
@@ -4492,251 +6087,1915 @@ int test_put_get_vars(FILE *test_log)
 			errcount++;
 		}
 	}
-
-	/* Read frame 0 of a non-decomposed variable with a record dimension */
-	fprintf(test_log, "Read frame 0 of a non-decomposed variable with a record dimension: ");
-	memset((void *)pbl_mask, 0, sizeof(int) * (size_t)nVertLevels);
-	ierr = SMIOL_get_var(file, "pbl_mask", NULL, pbl_mask);
+
+	/* Read frame 0 of a non-decomposed variable with a record dimension */
+	fprintf(test_log, "Read frame 0 of a non-decomposed variable with a record dimension: ");
+	memset((void *)pbl_mask, 0, sizeof(int) * (size_t)nVertLevels);
+	ierr = SMIOL_get_var(file, "pbl_mask", NULL, pbl_mask);
+	if (ierr == SMIOL_SUCCESS) {
+		/* Set validation array */
+#ifdef SMIOL_PNETCDF
+		pbl_mask_valid[0] = 1;
+		for (i = 1; i < (size_t)nVertLevels; i++) {
+			pbl_mask_valid[i] = 0;
+		}
+#else
+		memset((void *)pbl_mask_valid, 0, sizeof(int) * (size_t)nVertLevels);
+#endif
+
+		/* Check correctness of read data */
+		if (memcmp(pbl_mask, pbl_mask_valid, sizeof(int) * (size_t)nVertLevels) == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - values read from the file are not correct\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* Read frame 0 of a 0-d variable with a record dimension */
+	fprintf(test_log, "Read frame 0 of a 0-d variable with a record dimension: ");
+	timestamp = 0.0;
+	ierr = SMIOL_get_var(file, "seconds_since_epoch", NULL, &timestamp);
+	if (ierr == SMIOL_SUCCESS) {
+		/* Set validation array */
+#ifdef SMIOL_PNETCDF
+		timestamp_valid = 1594253412.75;
+#else
+		timestamp_valid = 0.0;
+#endif
+
+		/* Check correctness of read data */
+		if (timestamp == timestamp_valid) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - values read from the file are not correct\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	ierr = SMIOL_set_frame(file, (SMIOL_Offset)1);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to advance frame in file...\n");
+		return -1;
+	}
+
+	if (valid_comm_size) {
+		/* Read frame 1 of a decomposed variable with a record dimension */
+		fprintf(test_log, "Read frame 1 of a decomposed variable with a record dimension: ");
+		memset((void *)foo, 0, sizeof(float) * n_compute_elements * (size_t)nVertLevels);
+		ierr = SMIOL_get_var(file, "foo", decomp, foo);
+		if (ierr == SMIOL_SUCCESS) {
+			/* Update validation array from previous frame */
+#ifdef SMIOL_PNETCDF
+			for (i = 0; i < n_compute_elements; i++) {
+				for (j = 0; j < (size_t)nVertLevels; j++) {
+					foo_valid[i*(size_t)nVertLevels + j] *= (float)10.0;
+				}
+			}
+#endif
+
+			/* Check correctness of read data */
+			if (memcmp(foo, foo_valid, sizeof(float) * n_compute_elements * (size_t)nVertLevels) == 0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - values read from the file are not correct\n");
+				errcount++;
+			}
+		} else {
+			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+			errcount++;
+		}
+	}
+
+	/* Read frame 1 of a non-decomposed variable with a record dimension */
+	fprintf(test_log, "Read frame 1 of a non-decomposed variable with a record dimension: ");
+	memset((void *)pbl_mask, 0, sizeof(int) * (size_t)nVertLevels);
+	ierr = SMIOL_get_var(file, "pbl_mask", NULL, pbl_mask);
+	if (ierr == SMIOL_SUCCESS) {
+		/* Update validation array from previous frame */
+#ifdef SMIOL_PNETCDF
+		pbl_mask_valid[1] = 1;
+		pbl_mask_valid[2] = 1;
+		pbl_mask_valid[3] = 1;
+#endif
+
+		/* Check correctness of read data */
+		if (memcmp(pbl_mask, pbl_mask_valid, sizeof(int) * (size_t)nVertLevels) == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - values read from the file are not correct\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* Read frame 1 of a 0-d variable with a record dimension */
+	fprintf(test_log, "Read frame 1 of a 0-d variable with a record dimension: ");
+	timestamp = 0.0;
+	ierr = SMIOL_get_var(file, "seconds_since_epoch", NULL, &timestamp);
+	if (ierr == SMIOL_SUCCESS) {
+		/* Update validation array from previous frame */
+#ifdef SMIOL_PNETCDF
+		timestamp_valid = 1594253412.875;
+#endif
+
+		/* Check correctness of read data */
+		if (timestamp == timestamp_valid) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - values read from the file are not correct\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	ierr = SMIOL_set_frame(file, (SMIOL_Offset)2);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to advance frame in file...\n");
+		return -1;
+	}
+
+	if (valid_comm_size) {
+		/* Read frame 2 of a decomposed variable with a record dimension */
+		fprintf(test_log, "Read frame 2 of a decomposed variable with a record dimension: ");
+		memset((void *)foo, 0, sizeof(float) * n_compute_elements * (size_t)nVertLevels);
+		ierr = SMIOL_get_var(file, "foo", decomp, foo);
+		if (ierr == SMIOL_SUCCESS) {
+			/* Update validation array from previous frame */
+#ifdef SMIOL_PNETCDF
+			for (i = 0; i < n_compute_elements; i++) {
+				for (j = 0; j < (size_t)nVertLevels; j++) {
+					foo_valid[i*(size_t)nVertLevels + j] *= (float)-1.0;
+				}
+			}
+#endif
+
+			/* Check correctness of read data */
+			if (memcmp(foo, foo_valid, sizeof(float) * n_compute_elements * (size_t)nVertLevels) == 0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - values read from the file are not correct\n");
+				errcount++;
+			}
+		} else {
+			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+			errcount++;
+		}
+	}
+
+#ifdef SMIOL_PNETCDF
+	if (valid_comm_size) {
+		/* Read one level of frames 1 and 2 of a decomposed variable */
+		fprintf(test_log, "Read a subset of levels and frames of a decomposed variable: ");
+		{
+			SMIOL_Offset sub_start[1] = { 2 };
+			SMIOL_Offset sub_count[1] = { 1 };
+			float *sub;
+			float expected;
+			int n_wrong = 0;
+
+			sub = malloc(sizeof(float) * n_compute_elements * 2);
+			ierr = SMIOL_get_var_subset(file, "foo", decomp, (SMIOL_Offset)1, (SMIOL_Offset)2,
+			                            sub_start, sub_count, sub);
+			if (ierr == SMIOL_SUCCESS) {
+				for (i = 0; i < n_compute_elements; i++) {
+					/* Frame 2 values are those of frame 1 times -1 */
+					expected = foo_valid[i*(size_t)nVertLevels + 2];
+					if (sub[i] != -expected || sub[n_compute_elements + i] != expected) {
+						n_wrong++;
+					}
+				}
+			}
+			if (ierr == SMIOL_SUCCESS && n_wrong == 0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+				        SMIOL_error_string(ierr), n_wrong);
+				errcount++;
+			}
+			free(sub);
+		}
+
+		/* Selections outside the variable are rejected */
+		fprintf(test_log, "Read a subset that extends past the end of a dimension: ");
+		{
+			SMIOL_Offset sub_start[1];
+			SMIOL_Offset sub_count[1] = { 2 };
+
+			sub_start[0] = (SMIOL_Offset)nVertLevels - 1;
+			ierr = SMIOL_get_var_subset(file, "foo", decomp, (SMIOL_Offset)0, (SMIOL_Offset)1,
+			                            sub_start, sub_count, foo);
+			if (ierr == SMIOL_INVALID_ARGUMENT) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+				errcount++;
+			}
+		}
+	}
+#endif
+
+	fprintf(test_log, "Read a subset with a NULL file: ");
+	ierr = SMIOL_get_var_subset(NULL, "foo", decomp, (SMIOL_Offset)0, (SMIOL_Offset)1,
+	                            NULL, NULL, foo);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	ierr = SMIOL_set_frame(file, (SMIOL_Offset)3);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to advance frame in file...\n");
+		return -1;
+	}
+
+	if (valid_comm_size) {
+		/* Read frames 3 and 4 of a decomposed variable with one call */
+		fprintf(test_log, "Read frames 3 and 4 of a decomposed variable with a record dimension: ");
+		{
+			float *frames;
+			float expected;
+			int n_wrong = 0;
+
+			frames = malloc(sizeof(float) * n_compute_elements * (size_t)nVertLevels * 2);
+			memset((void *)frames, 0, sizeof(float) * n_compute_elements * (size_t)nVertLevels * 2);
+			ierr = SMIOL_get_var_frames(file, "foo", decomp, (SMIOL_Offset)2, frames);
+			if (ierr == SMIOL_SUCCESS) {
+				for (i = 0; i < n_compute_elements * 2; i++) {
+					for (j = 0; j < (size_t)nVertLevels; j++) {
+#ifdef SMIOL_PNETCDF
+						/* Element i of this task is global element comm_rank + comm_size * i */
+						expected = (float)((3 + i / n_compute_elements) * 10000
+						                   + (size_t)(comm_rank + comm_size * (SMIOL_Offset)(i % n_compute_elements)) * 10
+						                   + j);
+#else
+						expected = (float)0.0;
+#endif
+						if (frames[i*(size_t)nVertLevels + j] != expected) {
+							n_wrong++;
+						}
+					}
+				}
+			}
+			if (ierr == SMIOL_SUCCESS && n_wrong == 0) {
+				fprintf(test_log, "PASS\n");
+			} else {
+				fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+				        SMIOL_error_string(ierr), n_wrong);
+				errcount++;
+			}
+			free(frames);
+		}
+	}
+
+	/* Read frames 3 and 4 of a non-decomposed variable with one call */
+	fprintf(test_log, "Read frames 3 and 4 of a non-decomposed variable with a record dimension: ");
+	{
+		int masks[20];
+		int n_wrong = 0;
+
+		memset(masks, 0, sizeof(masks));
+		ierr = SMIOL_get_var_frames(file, "pbl_mask", NULL, (SMIOL_Offset)2, masks);
+#ifdef SMIOL_PNETCDF
+		for (i = 0; i < 20; i++) {
+			if (masks[i] != (int)i) {
+				n_wrong++;
+			}
+		}
+#endif
+		if (ierr == SMIOL_SUCCESS && n_wrong == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+			        SMIOL_error_string(ierr), n_wrong);
+			errcount++;
+		}
+	}
+
+	fprintf(test_log, "Read frames with a NULL file: ");
+	ierr = SMIOL_get_var_frames(NULL, "foo", decomp, (SMIOL_Offset)2, foo);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	ierr = SMIOL_set_frame(file, (SMIOL_Offset)2);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to set frame in file...\n");
+		return -1;
+	}
+
+	/* Read frame 2 of a non-decomposed variable with a record dimension */
+	fprintf(test_log, "Read frame 2 of a non-decomposed variable with a record dimension: ");
+	memset((void *)pbl_mask, 0, sizeof(int) * (size_t)nVertLevels);
+	ierr = SMIOL_get_var(file, "pbl_mask", NULL, pbl_mask);
+	if (ierr == SMIOL_SUCCESS) {
+		/* Update validation array from previous frame */
+#ifdef SMIOL_PNETCDF
+		pbl_mask_valid[4] = 1;
+		pbl_mask_valid[5] = 1;
+		pbl_mask_valid[6] = 1;
+#endif
+
+		/* Check correctness of read data */
+		if (memcmp(pbl_mask, pbl_mask_valid, sizeof(int) * (size_t)nVertLevels) == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - values read from the file are not correct\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* Read frame 2 of a 0-d variable with a record dimension */
+	fprintf(test_log, "Read frame 2 of a 0-d variable with a record dimension: ");
+	timestamp = 0.0;
+	ierr = SMIOL_get_var(file, "seconds_since_epoch", NULL, &timestamp);
+	if (ierr == SMIOL_SUCCESS) {
+		/* Update validation array from previous frame */
+#ifdef SMIOL_PNETCDF
+		timestamp_valid = 1594253413.0;
+#endif
+
+		/* Check correctness of read data */
+		if (timestamp == timestamp_valid) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - values read from the file are not correct\n");
+			errcount++;
+		}
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	free(id_string);
+	free(id_string_valid);
+	free(foo);
+	free(foo_valid);
+	free(coeffs);
+	free(coeffs_valid);
+	free(pbl_mask);
+	free(pbl_mask_valid);
+
+	/* Close the SMIOL file */
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close SMIOL file...\n");
+		return -1;
+	}
+
+	/*
+	 * Frames served from a read-ahead hold the values of that frame, and a
+	 * read-ahead is not used once a write or a change of frame makes it
+	 * stale. Only parallel-netCDF files are read ahead; without it, the
+	 * same reads are checked with a native file, which reads every frame
+	 * when asked for it.
+	 */
+	{
+		const char *pf_dimnames[2] = { "Time", "nPf" };
+		int pf[4];
+		int f;
+		int n_wrong;
+		int file_library;
+
+		file_library = context->file_library;
+#ifndef SMIOL_PNETCDF
+		ierr = SMIOL_set_option(context, "file_library", "native");
+		if (ierr != SMIOL_SUCCESS) {
+			fprintf(test_log, "Failed to select the native file library\n");
+			return -1;
+		}
+#endif
+
+		ierr = SMIOL_open_file(context, "smiol_prefetch_file.nc", SMIOL_FILE_CREATE, &file);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_dim(file, "Time", (SMIOL_Offset)-1);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_dim(file, "nPf", (SMIOL_Offset)4);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "pf", SMIOL_INT32, 2, pf_dimnames);
+		}
+		for (f = 0; f < 3 && ierr == SMIOL_SUCCESS; f++) {
+			for (i = 0; i < 4; i++) {
+				pf[i] = f * 10 + (int)i;
+			}
+			ierr = SMIOL_set_frame(file, (SMIOL_Offset)f);
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_put_var(file, "pf", NULL, pf);
+			}
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_close_file(&file);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_open_file(context, "smiol_prefetch_file.nc", SMIOL_FILE_WRITE, &file);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_set_prefetch(file, "pf", 1);
+		}
+		if (ierr != SMIOL_SUCCESS || file == NULL) {
+			fprintf(test_log, "Failed to create 'smiol_prefetch_file.nc'\n");
+			return -1;
+		}
+
+		/* Reading frame 0 reads frame 1 ahead */
+		fprintf(test_log, "Everything OK - Read the next frame from a read-ahead: ");
+		n_wrong = 0;
+		for (f = 0; f < 2 && ierr == SMIOL_SUCCESS; f++) {
+			memset(pf, 0, sizeof(pf));
+			ierr = SMIOL_set_frame(file, (SMIOL_Offset)f);
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_get_var(file, "pf", NULL, pf);
+			}
+			for (i = 0; i < 4; i++) {
+				if (pf[i] != f * 10 + (int)i) {
+					n_wrong++;
+				}
+			}
+		}
+		if (ierr == SMIOL_SUCCESS && n_wrong == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+			        SMIOL_error_string(ierr), n_wrong);
+			errcount++;
+		}
+
+		/* Frame 2 has been read ahead, and is then overwritten */
+		fprintf(test_log, "Everything OK - Read a frame written after it was read ahead: ");
+		for (i = 0; i < 4; i++) {
+			pf[i] = -100 - (int)i;
+		}
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)2);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "pf", NULL, pf);
+		}
+		memset(pf, 0, sizeof(pf));
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "pf", NULL, pf);
+		}
+		n_wrong = 0;
+		for (i = 0; i < 4; i++) {
+			if (pf[i] != -100 - (int)i) {
+				n_wrong++;
+			}
+		}
+		if (ierr == SMIOL_SUCCESS && n_wrong == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+			        SMIOL_error_string(ierr), n_wrong);
+			errcount++;
+		}
+
+		/* Frame 1 is read ahead, but frame 0 is read next */
+		fprintf(test_log, "Everything OK - Read another frame than the one read ahead: ");
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)0);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "pf", NULL, pf);
+		}
+		memset(pf, 0, sizeof(pf));
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_set_frame(file, (SMIOL_Offset)0);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "pf", NULL, pf);
+		}
+		n_wrong = 0;
+		for (i = 0; i < 4; i++) {
+			if (pf[i] != (int)i) {
+				n_wrong++;
+			}
+		}
+		if (ierr == SMIOL_SUCCESS && n_wrong == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+			        SMIOL_error_string(ierr), n_wrong);
+			errcount++;
+		}
+
+		ierr = SMIOL_close_file(&file);
+		if (ierr != SMIOL_SUCCESS || file != NULL) {
+			fprintf(test_log, "Failed to close 'smiol_prefetch_file.nc'\n");
+			return -1;
+		}
+
+		context->file_library = file_library;
+	}
+
+	if (!valid_comm_size) {
+		fprintf(test_log, "<<< Some tests that require the number of MPI tasks to divide 120 were not run >>>\n");
+	}
+
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to free decomp...\n");
+		return -1;
+	}
+
+	ierr = SMIOL_free_decomp(&decomp2);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to free decomp2...\n");
+		return -1;
+	}
+
+	/* Free the SMIOL context */
+	ierr = SMIOL_finalize(&context);
+	if (ierr != SMIOL_SUCCESS || context != NULL) {
+		fprintf(test_log, "Failed to free SMIOL context...\n");
+		return -1;
+	}
+
+	fflush(test_log);
+	ierr = MPI_Barrier(MPI_COMM_WORLD);
+
+	fprintf(test_log, "\n");
+
+	return errcount;
+}
+
+int test_native_files(FILE *test_log)
+{
+	int errcount;
+	int ierr;
+	int comm_rank, comm_size;
+	int is_unlimited;
+	int vartype;
+	int ndims;
+	int n_bad;
+	size_t i, k;
+	size_t n_compute_elements;
+	SMIOL_Offset *compute_elements;
+	SMIOL_Offset nCells, nLevels;
+	SMIOL_Offset dimsize;
+	SMIOL_Offset att_len;
+	struct SMIOL_context *context;
+	struct SMIOL_decomp *decomp;
+	struct SMIOL_file *file;
+	const char *dimnames[3];
+	char title[32];
+	double *theta;
+	int *mask;
+	float *late;
+	float vers;
+	float units;
+#ifdef SMIOL_IO_URING
+	int uring_used;
+#endif
+
+	fprintf(test_log, "********************************************************************************\n");
+	fprintf(test_log, "****************************** Native file format ******************************\n");
+	fprintf(test_log, "\n");
+
+	errcount = 0;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+	context = NULL;
+	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
+	if (ierr != SMIOL_SUCCESS || context == NULL) {
+		fprintf(test_log, "Failed to create SMIOL context...\n");
+		return -1;
+	}
+
+	/* Each task computes 10 cells, and every task is an I/O task */
+	n_compute_elements = 10;
+	nCells = (SMIOL_Offset)(n_compute_elements * (size_t)comm_size);
+	nLevels = 3;
+	compute_elements = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+	for (i = 0; i < n_compute_elements; i++) {
+		compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_compute_elements + i);
+	}
+	decomp = NULL;
+	ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements,
+	                           comm_size, 1, &decomp);
+	if (ierr != SMIOL_SUCCESS || decomp == NULL) {
+		fprintf(test_log, "Failed to create decomp...\n");
+		return -1;
+	}
+
+	theta = (double *)malloc(sizeof(double) * n_compute_elements * (size_t)nLevels);
+	mask = (int *)malloc(sizeof(int) * n_compute_elements);
+	late = (float *)malloc(sizeof(float) * n_compute_elements);
+
+	fprintf(test_log, "Select the file library with an invalid value: ");
+	ierr = SMIOL_set_option(context, "file_library", "hdf5");
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+#ifndef SMIOL_PNETCDF
+	fprintf(test_log, "Select the pnetcdf file library without PnetCDF support: ");
+	ierr = SMIOL_set_option(context, "file_library", "pnetcdf");
+	if (ierr == SMIOL_INVALID_ARGUMENT && context->file_library == SMIOL_LIBRARY_UNKNOWN) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+#endif
+
+	fprintf(test_log, "Everything OK - Select the native file library: ");
+	ierr = SMIOL_set_option(context, "file_library", "native");
+	if (ierr == SMIOL_SUCCESS && context->file_library == SMIOL_LIBRARY_NATIVE) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* Create a file with dimensions, variables, and attributes */
+	fprintf(test_log, "Everything OK - Create a native file and define its contents: ");
+	file = NULL;
+	ierr = SMIOL_open_file(context, "smiol_native_c.smiol", SMIOL_FILE_CREATE, &file);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "Time", (SMIOL_Offset)-1);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "nCells", nCells);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "nLevels", nLevels);
+	}
+	dimnames[0] = "Time";
+	dimnames[1] = "nCells";
+	dimnames[2] = "nLevels";
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "theta", SMIOL_REAL64, 3, dimnames);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "mask", SMIOL_INT32, 1, &dimnames[1]);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "vers", SMIOL_REAL32, 0, NULL);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_att(file, NULL, "title", SMIOL_CHAR, "native test");
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		units = 273.15f;
+		ierr = SMIOL_define_att(file, "theta", "offset", SMIOL_REAL32, &units);
+	}
+	if (ierr == SMIOL_SUCCESS && file->backend == SMIOL_LIBRARY_NATIVE) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+		        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	fprintf(test_log, "Define a zero-length dimension in a native file: ");
+	ierr = SMIOL_define_dim(file, "nZero", (SMIOL_Offset)0);
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	fprintf(test_log, "Define a second unlimited dimension in a native file: ");
+	ierr = SMIOL_define_dim(file, "Time2", (SMIOL_Offset)-1);
+	if (ierr == SMIOL_LIBRARY_ERROR) {
+		fprintf(test_log, "PASS (%s)\n", SMIOL_lib_error_string(context));
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_LIBRARY_ERROR was not returned\n");
+		errcount++;
+	}
+
+	/* Write decomposed, non-decomposed, and record variables */
+	fprintf(test_log, "Everything OK - Write variables and two frames to a native file: ");
+	for (i = 0; i < n_compute_elements; i++) {
+		mask[i] = (int)(compute_elements[i] * 2);
+	}
+	vers = 2.5f;
+	ierr = SMIOL_put_var(file, "mask", decomp, mask);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "vers", NULL, &vers);
+	}
+	for (k = 0; k < 2 && ierr == SMIOL_SUCCESS; k++) {
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			theta[i] = (double)compute_elements[i / (size_t)nLevels] * 100.0
+			           + (double)(i % (size_t)nLevels) + 1000.0 * (double)k;
+		}
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "theta", decomp, theta);
+		}
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, &is_unlimited);
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize == 2 && is_unlimited) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+		        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* Defining a variable after data are written moves the records */
+	fprintf(test_log, "Everything OK - Define and write a variable after writing data: ");
+	ierr = SMIOL_define_var(file, "late", SMIOL_REAL32, 1, &dimnames[1]);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_att(file, "late", "long_name",
+		                        SMIOL_CHAR, "a variable defined after data were written");
+	}
+	for (i = 0; i < n_compute_elements; i++) {
+		late[i] = (float)compute_elements[i] + 0.5f;
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "late", decomp, late);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+		        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close native file...\n");
+		return -1;
+	}
+
+	/* Re-open the file for reading, and check everything that was written */
+	fprintf(test_log, "Everything OK - Read dimensions and attributes of a native file: ");
+	ierr = SMIOL_open_file(context, "smiol_native_c.smiol", SMIOL_FILE_READ, &file);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, &is_unlimited);
+	}
+	if (ierr == SMIOL_SUCCESS && (dimsize != 2 || !is_unlimited)) {
+		ierr = SMIOL_INVALID_ARGUMENT;
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_var(file, "theta", &vartype, &ndims, NULL);
+	}
+	if (ierr == SMIOL_SUCCESS && (vartype != SMIOL_REAL64 || ndims != 3)) {
+		ierr = SMIOL_INVALID_ARGUMENT;
+	}
+	memset(title, 0, sizeof(title));
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_att(file, NULL, "title", &vartype, &att_len, title);
+	}
+	if (ierr == SMIOL_SUCCESS && (vartype != SMIOL_CHAR || att_len != 11
+	                              || strcmp(title, "native test") != 0)) {
+		ierr = SMIOL_INVALID_ARGUMENT;
+	}
+	units = 0.0f;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_att(file, "theta", "offset", NULL, NULL, &units);
+	}
+	if (ierr == SMIOL_SUCCESS && units == 273.15f) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+		        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	fprintf(test_log, "Everything OK - Read variables and frames of a native file: ");
+	n_bad = 0;
+	memset(mask, 0, sizeof(int) * n_compute_elements);
+	memset(late, 0, sizeof(float) * n_compute_elements);
+	vers = 0.0f;
+	ierr = SMIOL_get_var(file, "mask", decomp, mask);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_get_var(file, "vers", NULL, &vers);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_get_var(file, "late", decomp, late);
+	}
+	for (i = 0; i < n_compute_elements; i++) {
+		if (mask[i] != (int)(compute_elements[i] * 2)
+		    || late[i] != (float)compute_elements[i] + 0.5f) {
+			n_bad++;
+		}
+	}
+	if (vers != 2.5f) {
+		n_bad++;
+	}
+	for (k = 0; k < 2 && ierr == SMIOL_SUCCESS; k++) {
+		memset(theta, 0, sizeof(double) * n_compute_elements * (size_t)nLevels);
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "theta", decomp, theta);
+		}
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			if (theta[i] != (double)compute_elements[i / (size_t)nLevels] * 100.0
+			                + (double)(i % (size_t)nLevels) + 1000.0 * (double)k) {
+				n_bad++;
+			}
+		}
+	}
+	if (ierr == SMIOL_SUCCESS && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad);
+		errcount++;
+	}
+
+	fprintf(test_log, "Define a dimension in a native file opened read-only: ");
+	ierr = SMIOL_define_dim(file, "nNew", (SMIOL_Offset)4);
+	if (ierr == SMIOL_LIBRARY_ERROR) {
+		fprintf(test_log, "PASS (%s)\n", SMIOL_lib_error_string(context));
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_LIBRARY_ERROR was not returned\n");
+		errcount++;
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close native file...\n");
+		return -1;
+	}
+
+	/* Deferred writes are independent, and records agreed on when flushed */
+	fprintf(test_log, "Everything OK - Append a frame with deferred writes to a native file: ");
+	ierr = SMIOL_open_file(context, "smiol_native_c.smiol",
+	                       (SMIOL_FILE_WRITE | SMIOL_FILE_DEFERRED), &file);
+	for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+		theta[i] = -(double)i;
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)2);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "theta", decomp, theta);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_flush_file(file);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		memset(theta, 0, sizeof(double) * n_compute_elements * (size_t)nLevels);
+		ierr = SMIOL_get_var(file, "theta", decomp, theta);
+	}
+	n_bad = 0;
+	for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+		if (theta[i] != -(double)i) {
+			n_bad++;
+		}
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize == 3 && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad);
+		errcount++;
+	}
+
+	/* Writes still draining to the file are completed when it is closed */
+	fprintf(test_log, "Everything OK - Close a native file with writes still pending: ");
+	for (k = 3; k < 5 && ierr == SMIOL_SUCCESS; k++) {
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			theta[i] = (double)k * 10000.0 + (double)i;
+		}
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "theta", decomp, theta);
+		}
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_close_file(&file);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_open_file(context, "smiol_native_c.smiol", SMIOL_FILE_READ, &file);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+	}
+	n_bad = 0;
+	for (k = 3; k < 5 && ierr == SMIOL_SUCCESS; k++) {
+		memset(theta, 0, sizeof(double) * n_compute_elements * (size_t)nLevels);
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "theta", decomp, theta);
+		}
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			if (theta[i] != (double)k * 10000.0 + (double)i) {
+				n_bad++;
+			}
+		}
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize == 5 && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad);
+		errcount++;
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close native file...\n");
+		return -1;
+	}
+
+	/* More writes are pending than an I/O task has queued at once */
+	fprintf(test_log, "Everything OK - Post many deferred writes to a native file: ");
+	ierr = SMIOL_open_file(context, "smiol_native_c.smiol",
+	                       (SMIOL_FILE_WRITE | SMIOL_FILE_DEFERRED), &file);
+	for (k = 5; k < 105 && ierr == SMIOL_SUCCESS; k++) {
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			theta[i] = (double)k * 10000.0 - (double)i;
+		}
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "theta", decomp, theta);
+		}
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_flush_file(file);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+	}
+	n_bad = 0;
+	for (k = 5; k < 105 && ierr == SMIOL_SUCCESS; k++) {
+		memset(theta, 0, sizeof(double) * n_compute_elements * (size_t)nLevels);
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "theta", decomp, theta);
+		}
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			if (theta[i] != (double)k * 10000.0 - (double)i) {
+				n_bad++;
+			}
+		}
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize == 105 && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad);
+		errcount++;
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close native file...\n");
+		return -1;
+	}
+
+	/*
+	 * A small variable is written independently by one task, and is still
+	 * being written when a decomposed variable is written collectively
+	 */
+	fprintf(test_log, "Everything OK - Write a small variable, then a decomposed variable to a native file: ");
+	ierr = SMIOL_open_file(context, "smiol_native_c.smiol", SMIOL_FILE_WRITE, &file);
+	vers = 7.25f;
+	for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+		theta[i] = 3.0 * (double)i + 0.5;
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)105);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "vers", NULL, &vers);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "theta", decomp, theta);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		memset(theta, 0, sizeof(double) * n_compute_elements * (size_t)nLevels);
+		ierr = SMIOL_get_var(file, "theta", decomp, theta);
+	}
+	vers = 0.0f;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_get_var(file, "vers", NULL, &vers);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+	}
+	n_bad = 0;
+	for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+		if (theta[i] != 3.0 * (double)i + 0.5) {
+			n_bad++;
+		}
+	}
+	if (vers != 7.25f) {
+		n_bad++;
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize == 106 && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad);
+		errcount++;
+	}
+
+	/* Every read mode gives every task the same non-decomposed subset */
+	fprintf(test_log, "Everything OK - Read a non-decomposed subset in each read mode: ");
+	{
+		const int read_modes[3] = { SMIOL_READ_ALL, SMIOL_READ_BCAST, SMIOL_READ_BCAST_NODE };
+		SMIOL_Offset sub_start[2];
+		SMIOL_Offset sub_count[2] = { 2, 2 };
+		double sub[4];
+		double expected;
+		size_t c, l;
+		int n;
+
+		sub_start[0] = nCells - 2;
+		sub_start[1] = 1;
+		n_bad = 0;
+		ierr = SMIOL_SUCCESS;
+		for (n = 0; n < 3 && ierr == SMIOL_SUCCESS; n++) {
+			ierr = SMIOL_set_read_mode(context, read_modes[n]);
+			memset(sub, 0, sizeof(sub));
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_get_var_subset(file, "theta", NULL, (SMIOL_Offset)105,
+				                            (SMIOL_Offset)1, sub_start, sub_count, sub);
+			}
+			for (c = 0; c < 2; c++) {
+				for (l = 0; l < 2; l++) {
+					expected = 3.0 * (double)((n_compute_elements - 2 + c) * (size_t)nLevels
+					                          + 1 + l) + 0.5;
+					if (sub[c * 2 + l] != expected) {
+						n_bad++;
+					}
+				}
+			}
+		}
+		if (SMIOL_set_read_mode(context, SMIOL_READ_BCAST) != SMIOL_SUCCESS) {
+			fprintf(test_log, "Failed to restore the read mode...\n");
+			return -1;
+		}
+		if (ierr == SMIOL_SUCCESS && n_bad == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+			        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+			        : SMIOL_error_string(ierr), n_bad);
+			errcount++;
+		}
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close native file...\n");
+		return -1;
+	}
+
+#ifdef SMIOL_IO_URING
+	/*
+	 * A small variable written by each task in turn through its io_uring is
+	 * still in the ring when a decomposed variable is written collectively
+	 */
+	fprintf(test_log, "Everything OK - Write a small variable through an io_uring between decomposed writes: ");
+	ierr = SMIOL_open_file(context, "smiol_native_c.smiol", SMIOL_FILE_WRITE, &file);
+	uring_used = 0;
+	n_bad = 0;
+	for (k = 106; k < 110 && ierr == SMIOL_SUCCESS; k++) {
+		vers = (float)k + 0.25f;
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			theta[i] = (double)k * 100.0 + (double)i;
+		}
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "vers", NULL, &vers);
+		}
+		if (ierr == SMIOL_SUCCESS && file->native->uring != NULL) {
+			uring_used = 1;
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "theta", decomp, theta);
+		}
+
+		/* The collective write must have completed the write in the ring */
+		if (ierr == SMIOL_SUCCESS) {
+			int n_writes;
+
+			native_inq_writes(file->native, &n_writes);
+			if (n_writes != 0) {
+				n_bad++;
+			}
+		}
+	}
+	for (k = 106; k < 110 && ierr == SMIOL_SUCCESS; k++) {
+		memset(theta, 0, sizeof(double) * n_compute_elements * (size_t)nLevels);
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "theta", decomp, theta);
+		}
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			if (theta[i] != (double)k * 100.0 + (double)i) {
+				n_bad++;
+			}
+		}
+	}
+	vers = 0.0f;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_get_var(file, "vers", NULL, &vers);
+	}
+	if (vers != 109.25f) {
+		n_bad++;
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+	}
+	if (MPI_Allreduce(MPI_IN_PLACE, &uring_used, 1, MPI_INT, MPI_MAX,
+	                  MPI_COMM_WORLD) != MPI_SUCCESS) {
+		ierr = SMIOL_MPI_ERROR;
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize == 110 && n_bad == 0 && uring_used) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %d values or pending writes were not correct, io_uring %s\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad, uring_used ? "used" : "not used");
+		errcount++;
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close native file...\n");
+		return -1;
+	}
+#endif
+
+	/* Names may be as long as NATIVE_MAX_NAME characters, but no longer */
+	fprintf(test_log, "Everything OK - Write and read a variable with a dimension of the longest name: ");
+	{
+		char long_name[NATIVE_MAX_NAME + 2];
+		const char *long_dimnames[1];
+		int long_var[2] = { 17, 19 };
+
+		memset(long_name, 'd', NATIVE_MAX_NAME);
+		long_name[NATIVE_MAX_NAME] = '\0';
+		long_dimnames[0] = long_name;
+		ierr = SMIOL_open_file(context, "smiol_native_c.smiol", SMIOL_FILE_WRITE, &file);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_dim(file, long_name, (SMIOL_Offset)2);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_var(file, "long_dim_var", SMIOL_INT32, 1, long_dimnames);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "long_dim_var", NULL, long_var);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			long_var[0] = 0;
+			long_var[1] = 0;
+			ierr = SMIOL_get_var(file, "long_dim_var", NULL, long_var);
+		}
+		if (ierr == SMIOL_SUCCESS && long_var[0] == 17 && long_var[1] == 19) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+			        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
+			errcount++;
+		}
+
+		fprintf(test_log, "Define a dimension with a name longer than NATIVE_MAX_NAME: ");
+		long_name[NATIVE_MAX_NAME] = 'd';
+		long_name[NATIVE_MAX_NAME + 1] = '\0';
+		ierr = SMIOL_define_dim(file, long_name, (SMIOL_Offset)2);
+		if (ierr == SMIOL_LIBRARY_ERROR && context->lib_ierr == NATIVE_EBADNAME) {
+			fprintf(test_log, "PASS (%s)\n", SMIOL_lib_error_string(context));
+		} else {
+			fprintf(test_log, "FAIL - SMIOL_LIBRARY_ERROR was not returned\n");
+			errcount++;
+		}
+
+		ierr = SMIOL_close_file(&file);
+		if (ierr != SMIOL_SUCCESS || file != NULL) {
+			fprintf(test_log, "Failed to close native file...\n");
+			return -1;
+		}
+	}
+
+	fprintf(test_log, "Open a file with both SMIOL_FILE_STAGED and SMIOL_FILE_DEFERRED: ");
+	ierr = SMIOL_open_file(context, "smiol_native_c.smiol",
+	                       SMIOL_FILE_WRITE | SMIOL_FILE_STAGED | SMIOL_FILE_DEFERRED, &file);
+	if (ierr == SMIOL_INVALID_ARGUMENT && file == NULL) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned, or file was not NULL\n");
+		errcount++;
+		if (file != NULL) {
+			SMIOL_close_file(&file);
+		}
+	}
+
+	/*
+	 * With a store that holds little more than two writes of theta, staged
+	 * writes of several frames wait for the drain thread as they go
+	 */
+	fprintf(test_log, "Everything OK - Stage writes of several frames, then define and read: ");
+	{
+		int thread_level;
+		int k_att;
+
+		ierr = SMIOL_set_option(context, "stage_bytes", "600");
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_open_file(context, "smiol_native_c.smiol",
+			                       SMIOL_FILE_WRITE | SMIOL_FILE_STAGED, &file);
+		}
+		n_bad = 0;
+		MPI_Query_thread(&thread_level);
+		if (ierr == SMIOL_SUCCESS
+		    && (file->stage != NULL) != (thread_level == MPI_THREAD_MULTIPLE)) {
+			n_bad++;
+		}
+		for (k = 110; k < 120 && ierr == SMIOL_SUCCESS; k++) {
+			vers = (float)k + 0.5f;
+			for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+				theta[i] = (double)k * 1000.0 + (double)i;
+			}
+			ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_put_var(file, "theta", decomp, theta);
+			}
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_put_var(file, "vers", NULL, &vers);
+			}
+
+			/* The caller may reuse its buffers as soon as a write returns */
+			memset(theta, 0, sizeof(double) * n_compute_elements * (size_t)nLevels);
+		}
+		k_att = 120;
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_define_att(file, "theta", "frames", SMIOL_INT32, &k_att);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_flush_file(file);
+		}
+		for (k = 110; k < 120 && ierr == SMIOL_SUCCESS; k++) {
+			ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+			if (ierr == SMIOL_SUCCESS) {
+				ierr = SMIOL_get_var(file, "theta", decomp, theta);
+			}
+			for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+				if (theta[i] != (double)k * 1000.0 + (double)i) {
+					n_bad++;
+				}
+			}
+		}
+		vers = 0.0f;
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "vers", NULL, &vers);
+		}
+		if (vers != 119.5f) {
+			n_bad++;
+		}
+		k_att = 0;
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_inquire_att(file, "theta", "frames", NULL, NULL, &k_att);
+		}
+		if (k_att != 120) {
+			n_bad++;
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+		}
+		if (ierr == SMIOL_SUCCESS && dimsize == 120 && n_bad == 0) {
+			fprintf(test_log, "PASS\n");
+		} else {
+			fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+			        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+			        : SMIOL_error_string(ierr), n_bad);
+			errcount++;
+		}
+
+		ierr = SMIOL_close_file(&file);
+		if (ierr != SMIOL_SUCCESS || file != NULL) {
+			fprintf(test_log, "Failed to close native file...\n");
+			return -1;
+		}
+	}
+
+	fprintf(test_log, "Open a file that is not a native file: ");
+	ierr = SMIOL_open_file(context, "smiol.0000.test", SMIOL_FILE_READ, &file);
+	if (ierr == SMIOL_LIBRARY_ERROR && file == NULL) {
+		fprintf(test_log, "PASS (%s)\n", SMIOL_lib_error_string(context));
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_LIBRARY_ERROR was not returned, or file was not NULL\n");
+		errcount++;
+		if (file != NULL) {
+			SMIOL_close_file(&file);
+		}
+	}
+
+	free(theta);
+	free(mask);
+	free(late);
+	free(compute_elements);
+
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to free decomp...\n");
+		return -1;
+	}
+
+	ierr = SMIOL_finalize(&context);
+	if (ierr != SMIOL_SUCCESS || context != NULL) {
+		fprintf(test_log, "Failed to free SMIOL context...\n");
+		return -1;
+	}
+
+	fflush(test_log);
+	ierr = MPI_Barrier(MPI_COMM_WORLD);
+
+	fprintf(test_log, "\n");
+
+	return errcount;
+}
+
+int test_null_files(FILE *test_log)
+{
+	int errcount;
+	int ierr;
+	int comm_rank, comm_size;
+	int n_bad;
+	size_t i, k;
+	size_t n_compute_elements;
+	SMIOL_Offset *compute_elements;
+	SMIOL_Offset nCells, nLevels;
+	SMIOL_Offset dimsize;
+	SMIOL_Offset bytes;
+	long long local_bytes, total_bytes;
+	struct SMIOL_context *context;
+	struct SMIOL_decomp *decomp;
+	struct SMIOL_file *file;
+	const char *dimnames[3];
+	double *theta;
+	int *mask;
+	float vers;
+
+	fprintf(test_log, "********************************************************************************\n");
+	fprintf(test_log, "********************************** Null files **********************************\n");
+	fprintf(test_log, "\n");
+
+	errcount = 0;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+	context = NULL;
+	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
+	if (ierr != SMIOL_SUCCESS || context == NULL) {
+		fprintf(test_log, "Failed to create SMIOL context...\n");
+		return -1;
+	}
+
+	/* Each task computes 10 cells, and only the first task is an I/O task */
+	n_compute_elements = 10;
+	nCells = (SMIOL_Offset)(n_compute_elements * (size_t)comm_size);
+	nLevels = 3;
+	compute_elements = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+	for (i = 0; i < n_compute_elements; i++) {
+		compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_compute_elements + i);
+	}
+	decomp = NULL;
+	ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements,
+	                           1, 1, &decomp);
+	if (ierr != SMIOL_SUCCESS || decomp == NULL) {
+		fprintf(test_log, "Failed to create decomp...\n");
+		return -1;
+	}
+
+	theta = (double *)malloc(sizeof(double) * n_compute_elements * (size_t)nLevels);
+	mask = (int *)malloc(sizeof(int) * n_compute_elements);
+
+	fprintf(test_log, "Everything OK - Write variables to a file opened with SMIOL_FILE_NULL: ");
+	file = NULL;
+	ierr = SMIOL_open_file(context, "smiol_null_c.nc",
+	                       (SMIOL_FILE_CREATE | SMIOL_FILE_NULL), &file);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "Time", (SMIOL_Offset)-1);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "nCells", nCells);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "nLevels", nLevels);
+	}
+	dimnames[0] = "Time";
+	dimnames[1] = "nCells";
+	dimnames[2] = "nLevels";
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "theta", SMIOL_REAL64, 3, dimnames);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "mask", SMIOL_INT32, 1, &dimnames[1]);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "vers", SMIOL_REAL32, 0, NULL);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_att(file, NULL, "title", SMIOL_CHAR, "null test");
+	}
+	for (i = 0; i < n_compute_elements; i++) {
+		mask[i] = (int)compute_elements[i];
+	}
+	for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+		theta[i] = (double)i;
+	}
+	vers = 1.0f;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "mask", decomp, mask);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "vers", NULL, &vers);
+	}
+	for (k = 0; k < 2 && ierr == SMIOL_SUCCESS; k++) {
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "theta", decomp, theta);
+		}
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize == 2) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+		        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	/* All values, and only the values, reach the one I/O task */
+	fprintf(test_log, "Everything OK - Count the bytes written to a null file: ");
+	bytes = 0;
+	ierr = SMIOL_inquire_bytes_written(file, &bytes);
+	local_bytes = (long long)bytes;
+	MPI_Allreduce(&local_bytes, &total_bytes, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+	if (ierr == SMIOL_SUCCESS
+	    && (comm_rank == 0 || bytes == 0)
+	    && total_bytes == (long long)(nCells * 4 + 2 * nCells * nLevels * 8 + 4)) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %lld bytes were counted\n",
+		        SMIOL_error_string(ierr), total_bytes);
+		errcount++;
+	}
+
+	fprintf(test_log, "Everything OK - Read from a null file: ");
+	n_bad = 0;
+	for (i = 0; i < n_compute_elements; i++) {
+		mask[i] = -1;
+	}
+	ierr = SMIOL_set_frame(file, (SMIOL_Offset)1);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_get_var(file, "mask", decomp, mask);
+	}
+	for (i = 0; i < n_compute_elements; i++) {
+		if (mask[i] != 0) {
+			n_bad++;
+		}
+	}
+	if (ierr == SMIOL_SUCCESS && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s), %d values were not zero\n",
+		        SMIOL_error_string(ierr), n_bad);
+		errcount++;
+	}
+
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close null file...\n");
+		return -1;
+	}
+
+	fprintf(test_log, "Everything OK - Select the null file library: ");
+	ierr = SMIOL_set_option(context, "file_library", "null");
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_open_file(context, "smiol_null_c.nc", SMIOL_FILE_CREATE, &file);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "nCells", nCells);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "mask", SMIOL_INT32, 1, &dimnames[1]);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "mask", decomp, mask);
+	}
+	bytes = 0;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_bytes_written(file, &bytes);
+	}
+	if (ierr == SMIOL_SUCCESS && bytes == ((comm_rank == 0) ? nCells * 4 : 0)) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		errcount++;
+	}
+
+	if (file != NULL) {
+		ierr = SMIOL_close_file(&file);
+		if (ierr != SMIOL_SUCCESS || file != NULL) {
+			fprintf(test_log, "Failed to close null file...\n");
+			return -1;
+		}
+	}
+
+	fprintf(test_log, "Count the bytes written with a NULL bytes argument: ");
+	ierr = SMIOL_open_file(context, "smiol_null_c.nc", SMIOL_FILE_CREATE, &file);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_bytes_written(file, NULL);
+		SMIOL_close_file(&file);
+	}
+	if (ierr == SMIOL_INVALID_ARGUMENT) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	free(theta);
+	free(mask);
+	free(compute_elements);
+
+	ierr = SMIOL_free_decomp(&decomp);
+	if (ierr != SMIOL_SUCCESS) {
+		fprintf(test_log, "Failed to free decomp...\n");
+		return -1;
+	}
+
+	ierr = SMIOL_finalize(&context);
+	if (ierr != SMIOL_SUCCESS || context != NULL) {
+		fprintf(test_log, "Failed to free SMIOL context...\n");
+		return -1;
+	}
+
+	fflush(test_log);
+	ierr = MPI_Barrier(MPI_COMM_WORLD);
+
+	fprintf(test_log, "\n");
+
+	return errcount;
+}
+
+int test_subfiles(FILE *test_log)
+{
+	int errcount;
+	int ierr;
+	int comm_rank, comm_size;
+	int n_bad;
+	size_t i, k;
+	size_t n_compute_elements;
+	SMIOL_Offset *compute_elements;
+	SMIOL_Offset *read_elements;
+	SMIOL_Offset nCells, nLevels;
+	SMIOL_Offset dimsize;
+	SMIOL_Offset att_len;
+	struct SMIOL_context *context;
+	struct SMIOL_decomp *decomp;
+	struct SMIOL_decomp *read_decomp;
+	struct SMIOL_file *file;
+	const char *dimnames[3];
+	char title[32];
+	const double levels[3] = { 850.0, 500.0, 250.0 };
+	double merged_levels[3];
+	double *theta;
+	int *mask;
+	float vers;
+	FILE *subfile;
+
+	fprintf(test_log, "********************************************************************************\n");
+	fprintf(test_log, "*********************************** Subfiles ***********************************\n");
+	fprintf(test_log, "\n");
+
+	errcount = 0;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+	context = NULL;
+	ierr = SMIOL_init(MPI_COMM_WORLD, &context);
+	if (ierr != SMIOL_SUCCESS || context == NULL) {
+		fprintf(test_log, "Failed to create SMIOL context...\n");
+		return -1;
+	}
+
+	/*
+	 * Files are written with every task an I/O task, and read back with
+	 * one I/O task and each task holding a different set of elements
+	 */
+	n_compute_elements = 7;
+	nCells = (SMIOL_Offset)(n_compute_elements * (size_t)comm_size);
+	nLevels = 2;
+	compute_elements = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+	read_elements = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * n_compute_elements);
+	for (i = 0; i < n_compute_elements; i++) {
+		compute_elements[i] = (SMIOL_Offset)((size_t)comm_rank * n_compute_elements + i);
+		read_elements[i] = nCells - 1 - compute_elements[i];
+	}
+	decomp = NULL;
+	ierr = SMIOL_create_decomp(context, n_compute_elements, compute_elements,
+	                           comm_size, 1, &decomp);
+	if (ierr != SMIOL_SUCCESS || decomp == NULL) {
+		fprintf(test_log, "Failed to create decomp...\n");
+		return -1;
+	}
+	read_decomp = NULL;
+	ierr = SMIOL_create_decomp(context, n_compute_elements, read_elements,
+	                           1, 1, &read_decomp);
+	if (ierr != SMIOL_SUCCESS || read_decomp == NULL) {
+		fprintf(test_log, "Failed to create decomp...\n");
+		return -1;
+	}
+
+	theta = (double *)malloc(sizeof(double) * n_compute_elements * (size_t)nLevels);
+	mask = (int *)malloc(sizeof(int) * n_compute_elements);
+
+	fprintf(test_log, "Set the number of subfiles to an invalid value: ");
+	ierr = SMIOL_set_option(context, "subfiles", "-1");
+	if (ierr == SMIOL_INVALID_ARGUMENT && context->n_subfiles == 0) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_INVALID_ARGUMENT was not returned\n");
+		errcount++;
+	}
+
+	fprintf(test_log, "Everything OK - Write a native file to two subfiles: ");
+	ierr = SMIOL_set_option(context, "file_library", "native");
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_set_option(context, "subfiles", "2");
+	}
+	file = NULL;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_open_file(context, "smiol_subfiles_c.smiol", SMIOL_FILE_CREATE, &file);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "Time", (SMIOL_Offset)-1);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "nCells", nCells);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_dim(file, "nLevels", nLevels);
+	}
+	dimnames[0] = "Time";
+	dimnames[1] = "nCells";
+	dimnames[2] = "nLevels";
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "theta", SMIOL_REAL64, 3, dimnames);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "mask", SMIOL_INT32, 1, &dimnames[1]);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_var(file, "vers", SMIOL_REAL32, 0, NULL);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_define_att(file, NULL, "title", SMIOL_CHAR, "subfile test");
+	}
+
+	/* An attribute with several values can only be defined through the native library */
+	if (ierr == SMIOL_SUCCESS) {
+		int theta_id;
+
+		if (native_inq_varid(file->native, "theta", &theta_id) != NATIVE_NOERR
+		    || native_put_att(file->native, theta_id, "levels", SMIOL_REAL64,
+		                      (size_t)3, levels) != NATIVE_NOERR) {
+			ierr = SMIOL_LIBRARY_ERROR;
+		}
+	}
+	for (i = 0; i < n_compute_elements; i++) {
+		mask[i] = (int)compute_elements[i] + 1;
+	}
+	vers = 3.5f;
 	if (ierr == SMIOL_SUCCESS) {
-		/* Set validation array */
-#ifdef SMIOL_PNETCDF
-		pbl_mask_valid[0] = 1;
-		for (i = 1; i < (size_t)nVertLevels; i++) {
-			pbl_mask_valid[i] = 0;
+		ierr = SMIOL_put_var(file, "mask", decomp, mask);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_put_var(file, "vers", NULL, &vers);
+	}
+	for (k = 0; k < 3 && ierr == SMIOL_SUCCESS; k++) {
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			theta[i] = (double)compute_elements[i / (size_t)nLevels] * 10.0
+			           + (double)(i % (size_t)nLevels) + 1000.0 * (double)k;
 		}
-#else
-		memset((void *)pbl_mask_valid, 0, sizeof(int) * (size_t)nVertLevels);
-#endif
-
-		/* Check correctness of read data */
-		if (memcmp(pbl_mask, pbl_mask_valid, sizeof(int) * (size_t)nVertLevels) == 0) {
-			fprintf(test_log, "PASS\n");
-		} else {
-			fprintf(test_log, "FAIL - values read from the file are not correct\n");
-			errcount++;
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(file, "theta", decomp, theta);
 		}
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		fprintf(test_log, "PASS\n");
 	} else {
-		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+		        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
 		errcount++;
 	}
 
-	/* Read frame 0 of a 0-d variable with a record dimension */
-	fprintf(test_log, "Read frame 0 of a 0-d variable with a record dimension: ");
-	timestamp = 0.0;
-	ierr = SMIOL_get_var(file, "seconds_since_epoch", NULL, &timestamp);
-	if (ierr == SMIOL_SUCCESS) {
-		/* Set validation array */
-#ifdef SMIOL_PNETCDF
-		timestamp_valid = 1594253412.75;
-#else
-		timestamp_valid = 0.0;
-#endif
-
-		/* Check correctness of read data */
-		if (timestamp == timestamp_valid) {
-			fprintf(test_log, "PASS\n");
-		} else {
-			fprintf(test_log, "FAIL - values read from the file are not correct\n");
-			errcount++;
-		}
+	fprintf(test_log, "Define a variable in a subfiled file after writing data: ");
+	ierr = SMIOL_define_var(file, "late", SMIOL_INT32, 1, &dimnames[1]);
+	if (ierr == SMIOL_LIBRARY_ERROR) {
+		fprintf(test_log, "PASS (%s)\n", SMIOL_lib_error_string(context));
 	} else {
-		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		fprintf(test_log, "FAIL - SMIOL_LIBRARY_ERROR was not returned\n");
 		errcount++;
 	}
 
-	ierr = SMIOL_set_frame(file, (SMIOL_Offset)1);
-	if (ierr != SMIOL_SUCCESS) {
-		fprintf(test_log, "Failed to advance frame in file...\n");
+	ierr = SMIOL_close_file(&file);
+	if (ierr != SMIOL_SUCCESS || file != NULL) {
+		fprintf(test_log, "Failed to close subfiled file...\n");
 		return -1;
 	}
 
-	if (valid_comm_size) {
-		/* Read frame 1 of a decomposed variable with a record dimension */
-		fprintf(test_log, "Read frame 1 of a decomposed variable with a record dimension: ");
-		memset((void *)foo, 0, sizeof(float) * n_compute_elements * (size_t)nVertLevels);
-		ierr = SMIOL_get_var(file, "foo", decomp, foo);
-		if (ierr == SMIOL_SUCCESS) {
-			/* Update validation array from previous frame */
-#ifdef SMIOL_PNETCDF
-			for (i = 0; i < n_compute_elements; i++) {
-				for (j = 0; j < (size_t)nVertLevels; j++) {
-					foo_valid[i*(size_t)nVertLevels + j] *= (float)10.0;
-				}
-			}
-#endif
+	fprintf(test_log, "Everything OK - Subfiles exist for the file: ");
+	subfile = fopen("smiol_subfiles_c.smiol.0001", "r");
+	if (subfile != NULL) {
+		fclose(subfile);
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - smiol_subfiles_c.smiol.0001 was not found\n");
+		errcount++;
+	}
 
-			/* Check correctness of read data */
-			if (memcmp(foo, foo_valid, sizeof(float) * n_compute_elements * (size_t)nVertLevels) == 0) {
-				fprintf(test_log, "PASS\n");
-			} else {
-				fprintf(test_log, "FAIL - values read from the file are not correct\n");
-				errcount++;
-			}
-		} else {
-			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
-			errcount++;
+	/* Reading needs neither the subfiles option nor the same decomp */
+	fprintf(test_log, "Everything OK - Read a subfiled file with another decomp: ");
+	ierr = SMIOL_set_option(context, "subfiles", "0");
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_open_file(context, "smiol_subfiles_c.smiol", SMIOL_FILE_READ, &file);
+	}
+	n_bad = 0;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_get_var(file, "mask", read_decomp, mask);
+	}
+	for (i = 0; i < n_compute_elements; i++) {
+		if (mask[i] != (int)read_elements[i] + 1) {
+			n_bad++;
 		}
 	}
-
-	/* Read frame 1 of a non-decomposed variable with a record dimension */
-	fprintf(test_log, "Read frame 1 of a non-decomposed variable with a record dimension: ");
-	memset((void *)pbl_mask, 0, sizeof(int) * (size_t)nVertLevels);
-	ierr = SMIOL_get_var(file, "pbl_mask", NULL, pbl_mask);
+	vers = 0.0f;
 	if (ierr == SMIOL_SUCCESS) {
-		/* Update validation array from previous frame */
-#ifdef SMIOL_PNETCDF
-		pbl_mask_valid[1] = 1;
-		pbl_mask_valid[2] = 1;
-		pbl_mask_valid[3] = 1;
-#endif
-
-		/* Check correctness of read data */
-		if (memcmp(pbl_mask, pbl_mask_valid, sizeof(int) * (size_t)nVertLevels) == 0) {
-			fprintf(test_log, "PASS\n");
-		} else {
-			fprintf(test_log, "FAIL - values read from the file are not correct\n");
-			errcount++;
+		ierr = SMIOL_get_var(file, "vers", NULL, &vers);
+	}
+	if (vers != 3.5f) {
+		n_bad++;
+	}
+	for (k = 0; k < 3 && ierr == SMIOL_SUCCESS; k++) {
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)k);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(file, "theta", read_decomp, theta);
+		}
+		for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+			if (theta[i] != (double)read_elements[i / (size_t)nLevels] * 10.0
+			                + (double)(i % (size_t)nLevels) + 1000.0 * (double)k) {
+				n_bad++;
+			}
 		}
+	}
+	if (ierr == SMIOL_SUCCESS && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
 	} else {
-		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad);
 		errcount++;
 	}
 
-	/* Read frame 1 of a 0-d variable with a record dimension */
-	fprintf(test_log, "Read frame 1 of a 0-d variable with a record dimension: ");
-	timestamp = 0.0;
-	ierr = SMIOL_get_var(file, "seconds_since_epoch", NULL, &timestamp);
-	if (ierr == SMIOL_SUCCESS) {
-		/* Update validation array from previous frame */
-#ifdef SMIOL_PNETCDF
-		timestamp_valid = 1594253412.875;
-#endif
-
-		/* Check correctness of read data */
-		if (timestamp == timestamp_valid) {
-			fprintf(test_log, "PASS\n");
-		} else {
-			fprintf(test_log, "FAIL - values read from the file are not correct\n");
-			errcount++;
+	if (file != NULL) {
+		ierr = SMIOL_close_file(&file);
+		if (ierr != SMIOL_SUCCESS || file != NULL) {
+			fprintf(test_log, "Failed to close subfiled file...\n");
+			return -1;
 		}
-	} else {
-		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
-		errcount++;
 	}
 
-	ierr = SMIOL_set_frame(file, (SMIOL_Offset)2);
-	if (ierr != SMIOL_SUCCESS) {
-		fprintf(test_log, "Failed to advance frame in file...\n");
-		return -1;
+	fprintf(test_log, "Everything OK - Merge subfiles into a single file: ");
+	ierr = SMIOL_merge_subfiles(context, "smiol_subfiles_c.smiol", "smiol_merged_c.nc");
+	if (ierr == SMIOL_SUCCESS && context->file_library == SMIOL_LIBRARY_NATIVE) {
+		fprintf(test_log, "PASS\n");
+	} else {
+		fprintf(test_log, "FAIL - (%s)\n", (ierr == SMIOL_LIBRARY_ERROR) ?
+		        SMIOL_lib_error_string(context) : SMIOL_error_string(ierr));
+		errcount++;
 	}
 
-	if (valid_comm_size) {
-		/* Read frame 2 of a decomposed variable with a record dimension */
-		fprintf(test_log, "Read frame 2 of a decomposed variable with a record dimension: ");
-		memset((void *)foo, 0, sizeof(float) * n_compute_elements * (size_t)nVertLevels);
-		ierr = SMIOL_get_var(file, "foo", decomp, foo);
-		if (ierr == SMIOL_SUCCESS) {
-			/* Update validation array from previous frame */
+	/* The merged file is a netCDF file where PnetCDF is available */
+	fprintf(test_log, "Everything OK - Read the merged file: ");
 #ifdef SMIOL_PNETCDF
-			for (i = 0; i < n_compute_elements; i++) {
-				for (j = 0; j < (size_t)nVertLevels; j++) {
-					foo_valid[i*(size_t)nVertLevels + j] *= (float)-1.0;
-				}
-			}
+	ierr = SMIOL_set_option(context, "file_library", "pnetcdf");
 #endif
-
-			/* Check correctness of read data */
-			if (memcmp(foo, foo_valid, sizeof(float) * n_compute_elements * (size_t)nVertLevels) == 0) {
-				fprintf(test_log, "PASS\n");
-			} else {
-				fprintf(test_log, "FAIL - values read from the file are not correct\n");
-				errcount++;
-			}
-		} else {
-			fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
-			errcount++;
+	file = NULL;
+	ierr = SMIOL_open_file(context, "smiol_merged_c.nc", SMIOL_FILE_READ, &file);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_dim(file, "Time", &dimsize, NULL);
+	}
+	if (ierr == SMIOL_SUCCESS && dimsize != 3) {
+		ierr = SMIOL_INVALID_ARGUMENT;
+	}
+	memset(title, 0, sizeof(title));
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_att(file, NULL, "title", NULL, NULL, title);
+	}
+	if (ierr == SMIOL_SUCCESS && strcmp(title, "subfile test") != 0) {
+		ierr = SMIOL_INVALID_ARGUMENT;
+	}
+	n_bad = 0;
+	memset(merged_levels, 0, sizeof(merged_levels));
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_att(file, "theta", "levels", NULL, &att_len, merged_levels);
+	}
+	if (ierr == SMIOL_SUCCESS && att_len != 3) {
+		n_bad++;
+	}
+	for (i = 0; i < 3; i++) {
+		if (merged_levels[i] != levels[i]) {
+			n_bad++;
 		}
 	}
-
-	/* Read frame 2 of a non-decomposed variable with a record dimension */
-	fprintf(test_log, "Read frame 2 of a non-decomposed variable with a record dimension: ");
-	memset((void *)pbl_mask, 0, sizeof(int) * (size_t)nVertLevels);
-	ierr = SMIOL_get_var(file, "pbl_mask", NULL, pbl_mask);
 	if (ierr == SMIOL_SUCCESS) {
-		/* Update validation array from previous frame */
-#ifdef SMIOL_PNETCDF
-		pbl_mask_valid[4] = 1;
-		pbl_mask_valid[5] = 1;
-		pbl_mask_valid[6] = 1;
-#endif
-
-		/* Check correctness of read data */
-		if (memcmp(pbl_mask, pbl_mask_valid, sizeof(int) * (size_t)nVertLevels) == 0) {
-			fprintf(test_log, "PASS\n");
-		} else {
-			fprintf(test_log, "FAIL - values read from the file are not correct\n");
-			errcount++;
+		ierr = SMIOL_get_var(file, "mask", read_decomp, mask);
+	}
+	for (i = 0; i < n_compute_elements; i++) {
+		if (mask[i] != (int)read_elements[i] + 1) {
+			n_bad++;
 		}
-	} else {
-		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
-		errcount++;
 	}
-
-	/* Read frame 2 of a 0-d variable with a record dimension */
-	fprintf(test_log, "Read frame 2 of a 0-d variable with a record dimension: ");
-	timestamp = 0.0;
-	ierr = SMIOL_get_var(file, "seconds_since_epoch", NULL, &timestamp);
 	if (ierr == SMIOL_SUCCESS) {
-		/* Update validation array from previous frame */
-#ifdef SMIOL_PNETCDF
-		timestamp_valid = 1594253413.0;
-#endif
-
-		/* Check correctness of read data */
-		if (timestamp == timestamp_valid) {
-			fprintf(test_log, "PASS\n");
-		} else {
-			fprintf(test_log, "FAIL - values read from the file are not correct\n");
-			errcount++;
+		ierr = SMIOL_set_frame(file, (SMIOL_Offset)2);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_get_var(file, "theta", decomp, theta);
+	}
+	for (i = 0; i < n_compute_elements * (size_t)nLevels; i++) {
+		if (theta[i] != (double)compute_elements[i / (size_t)nLevels] * 10.0
+		                + (double)(i % (size_t)nLevels) + 2000.0) {
+			n_bad++;
 		}
+	}
+	if (ierr == SMIOL_SUCCESS && n_bad == 0) {
+		fprintf(test_log, "PASS\n");
 	} else {
-		fprintf(test_log, "FAIL - (%s)\n", SMIOL_error_string(ierr));
+		fprintf(test_log, "FAIL - (%s), %d values were not correct\n",
+		        (ierr == SMIOL_LIBRARY_ERROR) ? SMIOL_lib_error_string(context)
+		        : SMIOL_error_string(ierr), n_bad);
 		errcount++;
 	}
 
-	free(id_string);
-	free(id_string_valid);
-	free(foo);
-	free(foo_valid);
-	free(coeffs);
-	free(coeffs_valid);
-	free(pbl_mask);
-	free(pbl_mask_valid);
-
-	/* Close the SMIOL file */
-	ierr = SMIOL_close_file(&file);
-	if (ierr != SMIOL_SUCCESS || file != NULL) {
-		fprintf(test_log, "Failed to close SMIOL file...\n");
-		return -1;
+	if (file != NULL) {
+		ierr = SMIOL_close_file(&file);
+		if (ierr != SMIOL_SUCCESS || file != NULL) {
+			fprintf(test_log, "Failed to close merged file...\n");
+			return -1;
+		}
 	}
 
-	if (!valid_comm_size) {
-		fprintf(test_log, "<<< Some tests that require the number of MPI tasks to divide 120 were not run >>>\n");
+	fprintf(test_log, "Merge a file that does not exist: ");
+	ierr = SMIOL_merge_subfiles(context, "smiol_no_such_file.smiol", "smiol_merged_c.nc");
+	if (ierr == SMIOL_LIBRARY_ERROR) {
+		fprintf(test_log, "PASS (%s)\n", SMIOL_lib_error_string(context));
+	} else {
+		fprintf(test_log, "FAIL - SMIOL_LIBRARY_ERROR was not returned\n");
+		errcount++;
 	}
 
+	free(theta);
+	free(mask);
+	free(compute_elements);
+	free(read_elements);
+
 	ierr = SMIOL_free_decomp(&decomp);
-	if (ierr != SMIOL_SUCCESS) {
-		fprintf(test_log, "Failed to free decomp...\n");
-		return -1;
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_free_decomp(&read_decomp);
 	}
-
-	ierr = SMIOL_free_decomp(&decomp2);
 	if (ierr != SMIOL_SUCCESS) {
-		fprintf(test_log, "Failed to free decomp2...\n");
+		fprintf(test_log, "Failed to free decomp...\n");
 		return -1;
 	}
 
-	/* Free the SMIOL context */
 	ierr = SMIOL_finalize(&context);
 	if (ierr != SMIOL_SUCCESS || context != NULL) {
 		fprintf(test_log, "Failed to free SMIOL context...\n");
@@ -4746,6 +8005,13 @@ int test_put_get_vars(FILE *test_log)
 	fflush(test_log);
 	ierr = MPI_Barrier(MPI_COMM_WORLD);
 
+	if (comm_rank == 0) {
+		remove("smiol_subfiles_c.smiol");
+		remove("smiol_subfiles_c.smiol.0000");
+		remove("smiol_subfiles_c.smiol.0001");
+		remove("smiol_merged_c.nc");
+	}
+
 	fprintf(test_log, "\n");
 
 	return errcount;
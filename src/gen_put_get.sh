@@ -219,6 +219,346 @@ EOF
 }
 
 
+################################################################################
+#
+# gen_put_get_var_h
+#
+# Generate a function body for a specific "SMIOLf_put/get_var_h" function
+# Required variables are those of gen_put_get_var, as well as those set by
+# gen_put_get_var for the same d, io, and type:
+#  c_loc_invocation, char_copyin, char_copyout, dummy_buf_decl, char_buf_decl
+#
+################################################################################
+gen_put_get_var_h()
+{
+    if [ "${io}" = "put" ]; then
+        brief="Writes a ${d}-d ${type} variable to a file given a variable handle."
+        details="    !>  Identical to SMIOLf_put_var, except that the file and variable are given
+    !>  by a handle obtained from SMIOLf_inquire_var_handle, so that no variable
+    !>  name needs to be converted or looked up.
+    !>
+    !>  If the variable has been successfully written to the file, SMIOL_SUCCESS will
+    !>  be returned. Otherwise, an error code indicating the nature of the failure
+    !>  will be returned."
+    else
+        brief="Reads a ${d}-d ${type} variable from a file given a variable handle."
+        details="    !>  Identical to SMIOLf_get_var, except that the file and variable are given
+    !>  by a handle obtained from SMIOLf_inquire_var_handle, so that no variable
+    !>  name needs to be converted or looked up.
+    !>
+    !>  If the variable has been successfully read from the file, SMIOL_SUCCESS will
+    !>  be returned. Otherwise, an error code indicating the nature of the failure
+    !>  will be returned."
+    fi
+
+    if [ "${kind}" = "c_char" ]; then
+        i_decl="
+        integer :: i"
+    else
+        i_decl=""
+    fi
+
+    cat >> ${filename} << EOF
+    !-----------------------------------------------------------------------
+    !  routine SMIOLf_${io}_var_h_${d}d_${type}
+    !
+    !> \brief ${brief}
+    !> \details
+${details}
+    !
+    !-----------------------------------------------------------------------
+    function SMIOLf_${io}_var_h_${d}d_${type}(var, decomp, buf) result(ierr)
+
+        use iso_c_binding, only : ${kind}, c_char, c_loc, c_ptr, c_null_ptr
+
+        implicit none
+
+        ! Arguments
+        type(SMIOLf_var), target :: var
+        type(SMIOLf_decomp), pointer :: decomp
+${dummy_buf_decl}
+
+        ! Return status code
+        integer :: ierr
+
+        ! Local variables${i_decl}
+        type (c_ptr) :: c_var
+        type (c_ptr) :: c_decomp
+        type (c_ptr) :: c_buf
+${char_buf_decl}
+
+        c_var = c_loc(var)
+
+        if (associated(decomp)) then
+            c_decomp = c_loc(decomp)
+        else
+            c_decomp = c_null_ptr
+        end if
+
+        if (associated(buf)) then
+${char_copyin}
+${c_loc_invocation}
+        else
+            c_buf = c_null_ptr
+        end if
+
+        ierr = SMIOL_${io}_var_h(c_var, c_decomp, c_buf)
+
+${char_copyout}
+
+    end function SMIOLf_${io}_var_h_${d}d_${type}
+
+
+EOF
+}
+
+
+################################################################################
+#
+# gen_put_get_var_frames
+#
+# Generate a function body for a specific "SMIOLf_put_var_frames" or
+# "SMIOLf_get_var_frames" function
+# Required variables are those of gen_put_get_var, as well as those set by
+# gen_put_get_var for the same d, type, and io:
+#  c_loc_invocation, dummy_buf_decl
+#
+################################################################################
+gen_put_get_var_frames()
+{
+    if [ "${io}" = "put" ]; then
+        brief="Writes several frames of a variable to a file from a ${d}-d ${type} array."
+        details="    !>  Like SMIOLf_put_var, but writes the n_frames frames beginning with the
+    !>  current frame of the file with a single exchange and a single write. The
+    !>  frames are stored one after another in buf, so buf typically has one more
+    !>  dimension than the buffer that would be passed to SMIOLf_put_var, with the
+    !>  frame as its last dimension.
+    !>
+    !>  If the frames have been successfully written to the file, SMIOL_SUCCESS will
+    !>  be returned. Otherwise, an error code indicating the nature of the failure
+    !>  will be returned."
+    else
+        brief="Reads several frames of a variable from a file into a ${d}-d ${type} array."
+        details="    !>  Like SMIOLf_get_var, but reads the n_frames frames beginning with the
+    !>  current frame of the file with a single read and a single exchange. The
+    !>  frames are stored one after another in buf, so buf typically has one more
+    !>  dimension than the buffer that would be passed to SMIOLf_get_var, with the
+    !>  frame as its last dimension.
+    !>
+    !>  If the frames have been successfully read from the file, SMIOL_SUCCESS will
+    !>  be returned. Otherwise, an error code indicating the nature of the failure
+    !>  will be returned."
+    fi
+
+    cat >> ${filename} << EOF
+    !-----------------------------------------------------------------------
+    !  routine SMIOLf_${io}_var_frames_${d}d_${type}
+    !
+    !> \brief ${brief}
+    !> \details
+${details}
+    !
+    !-----------------------------------------------------------------------
+    function SMIOLf_${io}_var_frames_${d}d_${type}(file, varname, decomp, n_frames, buf) result(ierr)
+
+        use iso_c_binding, only : ${kind}, c_char, c_loc, c_ptr, c_null_ptr, c_null_char
+
+        implicit none
+
+        ! Arguments
+        type(SMIOLf_file), target :: file
+        character(len=*), intent(in) :: varname
+        type(SMIOLf_decomp), pointer :: decomp
+        integer(kind=SMIOL_offset_kind), intent(in) :: n_frames
+${dummy_buf_decl}
+
+        ! Return status code
+        integer :: ierr
+
+        ! Local variables
+        integer :: i
+        character(kind=c_char), dimension(:), pointer :: c_varname
+        type (c_ptr) :: c_file
+        type (c_ptr) :: c_decomp
+        type (c_ptr) :: c_buf
+
+        interface
+            function SMIOL_${io}_var_frames(file, varname, decomp, n_frames, buf) result(ierr) &
+                                           bind(C, name='SMIOL_${io}_var_frames')
+                use iso_c_binding, only : c_ptr, c_char, c_int
+                import SMIOL_offset_kind
+                type (c_ptr), value :: file
+                character (kind=c_char), dimension(*) :: varname
+                type (c_ptr), value :: decomp
+                integer (kind=SMIOL_offset_kind), value :: n_frames
+                type (c_ptr), value :: buf
+                integer (kind=c_int) :: ierr
+            end function
+        end interface
+
+        c_file = c_loc(file)
+
+        if (associated(decomp)) then
+            c_decomp = c_loc(decomp)
+        else
+            c_decomp = c_null_ptr
+        end if
+
+        !
+        ! Convert variable name string
+        !
+        allocate(c_varname(len_trim(varname) + 1))
+        do i=1,len_trim(varname)
+            c_varname(i) = varname(i:i)
+        end do
+        c_varname(i) = c_null_char
+
+        if (associated(buf)) then
+${c_loc_invocation}
+        else
+            c_buf = c_null_ptr
+        end if
+
+        ierr = SMIOL_${io}_var_frames(c_file, c_varname, c_decomp, n_frames, c_buf)
+
+        deallocate(c_varname)
+
+    end function SMIOLf_${io}_var_frames_${d}d_${type}
+
+
+EOF
+}
+
+
+################################################################################
+#
+# gen_get_var_subset
+#
+# Generate a function body for a specific "SMIOLf_get_var_subset" function
+# Required variables are those of gen_put_get_var, as well as those set by
+# gen_put_get_var for the same d and type with io = get:
+#  c_loc_invocation, dummy_buf_decl
+#
+################################################################################
+gen_get_var_subset()
+{
+    cat >> ${filename} << EOF
+    !-----------------------------------------------------------------------
+    !  routine SMIOLf_get_var_subset_${d}d_${type}
+    !
+    !> \brief Reads part of a ${d}-d ${type} variable from a file.
+    !> \details
+    !>  Like SMIOLf_get_var, but reads only the selection given by start and
+    !>  count in the dimensions that are neither the decomposed dimension nor
+    !>  the record dimension, and for variables with a record dimension, the
+    !>  n_frames frames beginning with first_frame. The start and count arrays
+    !>  are given in Fortran order, fastest-varying dimension first, and start
+    !>  values begin at 1. Frames are stored one after another in buf.
+    !>
+    !>  If the subset has been successfully read from the file, SMIOL_SUCCESS will
+    !>  be returned. Otherwise, an error code indicating the nature of the failure
+    !>  will be returned.
+    !
+    !-----------------------------------------------------------------------
+    function SMIOLf_get_var_subset_${d}d_${type}(file, varname, decomp, first_frame, n_frames, &
+                                               start, count, buf) result(ierr)
+
+        use iso_c_binding, only : ${kind}, c_char, c_loc, c_ptr, c_null_ptr, c_null_char
+
+        implicit none
+
+        ! Arguments
+        type(SMIOLf_file), target :: file
+        character(len=*), intent(in) :: varname
+        type(SMIOLf_decomp), pointer :: decomp
+        integer(kind=SMIOL_offset_kind), intent(in) :: first_frame
+        integer(kind=SMIOL_offset_kind), intent(in) :: n_frames
+        integer(kind=SMIOL_offset_kind), dimension(:), intent(in) :: start
+        integer(kind=SMIOL_offset_kind), dimension(:), intent(in) :: count
+${dummy_buf_decl}
+
+        ! Return status code
+        integer :: ierr
+
+        ! Local variables
+        integer :: i, n
+        character(kind=c_char), dimension(:), pointer :: c_varname
+        integer(kind=SMIOL_offset_kind), dimension(:), allocatable, target :: c_start
+        integer(kind=SMIOL_offset_kind), dimension(:), allocatable, target :: c_count
+        type (c_ptr) :: c_file
+        type (c_ptr) :: c_decomp
+        type (c_ptr) :: c_buf
+
+        interface
+            function SMIOL_get_var_subset(file, varname, decomp, first_frame, n_frames, &
+                                          start, count, buf) result(ierr) bind(C, name='SMIOL_get_var_subset')
+                use iso_c_binding, only : c_ptr, c_char, c_int
+                import SMIOL_offset_kind
+                type (c_ptr), value :: file
+                character (kind=c_char), dimension(*) :: varname
+                type (c_ptr), value :: decomp
+                integer (kind=SMIOL_offset_kind), value :: first_frame
+                integer (kind=SMIOL_offset_kind), value :: n_frames
+                type (c_ptr), value :: start
+                type (c_ptr), value :: count
+                type (c_ptr), value :: buf
+                integer (kind=c_int) :: ierr
+            end function
+        end interface
+
+        if (size(start) /= size(count)) then
+            ierr = SMIOL_INVALID_ARGUMENT
+            return
+        end if
+
+        c_file = c_loc(file)
+
+        if (associated(decomp)) then
+            c_decomp = c_loc(decomp)
+        else
+            c_decomp = c_null_ptr
+        end if
+
+        !
+        ! Reverse the selection into C order, with start values beginning at 0
+        !
+        n = size(start)
+        allocate(c_start(n + 1))
+        allocate(c_count(n + 1))
+        do i=1,n
+            c_start(i) = start(n - i + 1) - 1
+            c_count(i) = count(n - i + 1)
+        end do
+
+        !
+        ! Convert variable name string
+        !
+        allocate(c_varname(len_trim(varname) + 1))
+        do i=1,len_trim(varname)
+            c_varname(i) = varname(i:i)
+        end do
+        c_varname(i) = c_null_char
+
+        if (associated(buf)) then
+${c_loc_invocation}
+        else
+            c_buf = c_null_ptr
+        end if
+
+        ierr = SMIOL_get_var_subset(c_file, c_varname, c_decomp, first_frame, n_frames, &
+                                    c_loc(c_start), c_loc(c_count), c_buf)
+
+        deallocate(c_varname)
+        deallocate(c_start)
+        deallocate(c_count)
+
+    end function SMIOLf_get_var_subset_${d}d_${type}
+
+
+EOF
+}
+
+
 ################################################################################
 #
 # gen_c_loc
@@ -402,8 +742,19 @@ for d in 0 1 2 3 4 5; do
 
         for io in put get; do
             gen_put_get_var
+            gen_put_get_var_h
+
+            # Several frames of character variables are not supported
+            if [ "${type}" != "char" ]; then
+                gen_put_get_var_frames
+            fi
         done
 
+        # Subsets of character variables are not supported
+        if [ "${type}" != "char" ]; then
+            gen_get_var_subset
+        fi
+
     done
 
 done
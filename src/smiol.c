@@ -1,9 +1,11 @@
+#include <ctype.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include "smiol.h"
 #include "smiol_utils.h"
+#include "smiol_native.h"
 
 #ifdef SMIOL_PNETCDF
 #include "pnetcdf.h"
@@ -14,13 +16,144 @@
 #define START_COUNT_READ 0
 #define START_COUNT_WRITE 1
 
+#define DEFINE_DIM 0
+#define DEFINE_VAR 1
+#define DEFINE_ATT 2
+
+#define OPTION_HINT                0  /* Hint for the file library, passed in an MPI_Info object */
+#define OPTION_SMALL_VAR_BYTES     1
+#define OPTION_READ_MODE           2
+#define OPTION_HEADER_FREE_BYTES   3
+#define OPTION_VAR_ALIGN_BYTES     4
+#define OPTION_VAR_FREE_BYTES      5
+#define OPTION_RECORD_ALIGN_BYTES  6
+#define OPTION_IO_PLACEMENT        7
+#define OPTION_IO_TASKS_PER_NODE   8
+#define OPTION_IO_PARTITION        9
+#define OPTION_IO_VERTICAL_BLOCKS 10
+#define OPTION_IO_ALIGN_BYTES     11
+#define OPTION_IO_ALIGN_ELEMENT_SIZE 12
+#define OPTION_FILE_LIBRARY       13
+#define OPTION_SUBFILES           14
+#define OPTION_STAGE_BYTES        15
+
+#define OPTION_TYPE_INT  0  /* Positive integer */
+#define OPTION_TYPE_SIZE 1  /* Non-negative size in bytes or count */
+#define OPTION_TYPE_ENUM 2  /* One of a list of keywords */
+
+/*
+ * Options that may be set with SMIOL_set_option, SMIOL_set_file_option, or
+ * environment variables; hints are passed to the file library unchanged once
+ * their values have been checked
+ */
+const struct SMIOL_option smiol_options[] = {
+	{ "cb_nodes",              OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "cb_buffer_size",        OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "striping_factor",       OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "striping_unit",         OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "romio_cb_write",        OPTION_HINT,               OPTION_TYPE_ENUM, "enable|disable|automatic" },
+	{ "romio_cb_read",         OPTION_HINT,               OPTION_TYPE_ENUM, "enable|disable|automatic" },
+	{ "romio_ds_write",        OPTION_HINT,               OPTION_TYPE_ENUM, "enable|disable|automatic" },
+	{ "romio_ds_read",         OPTION_HINT,               OPTION_TYPE_ENUM, "enable|disable|automatic" },
+	{ "nc_header_align_size",  OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "nc_var_align_size",     OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "nc_record_align_size",  OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "nc_in_place_swap",      OPTION_HINT,               OPTION_TYPE_ENUM, "enable|disable|auto" },
+	{ "nc_num_subfiles",       OPTION_HINT,               OPTION_TYPE_INT,  NULL },
+	{ "small_var_bytes",       OPTION_SMALL_VAR_BYTES,    OPTION_TYPE_SIZE, NULL },
+	{ "read_mode",             OPTION_READ_MODE,          OPTION_TYPE_ENUM, "all|bcast|bcast_node" },
+	{ "header_free_bytes",     OPTION_HEADER_FREE_BYTES,  OPTION_TYPE_SIZE, NULL },
+	{ "var_align_bytes",       OPTION_VAR_ALIGN_BYTES,    OPTION_TYPE_SIZE, NULL },
+	{ "var_free_bytes",        OPTION_VAR_FREE_BYTES,     OPTION_TYPE_SIZE, NULL },
+	{ "record_align_bytes",    OPTION_RECORD_ALIGN_BYTES, OPTION_TYPE_SIZE, NULL },
+	{ "io_placement",          OPTION_IO_PLACEMENT,       OPTION_TYPE_ENUM, "stride|node" },
+	{ "io_tasks_per_node",     OPTION_IO_TASKS_PER_NODE,  OPTION_TYPE_SIZE, NULL },
+	{ "io_partition",          OPTION_IO_PARTITION,       OPTION_TYPE_ENUM, "elements|bytes" },
+	{ "io_vertical_blocks",    OPTION_IO_VERTICAL_BLOCKS, OPTION_TYPE_INT,  NULL },
+	{ "io_align_element_size", OPTION_IO_ALIGN_ELEMENT_SIZE, OPTION_TYPE_SIZE, NULL },
+	{ "io_align_bytes",        OPTION_IO_ALIGN_BYTES,     OPTION_TYPE_SIZE, NULL },
+	{ "file_library",          OPTION_FILE_LIBRARY,       OPTION_TYPE_ENUM, "pnetcdf|native|null" },
+	{ "subfiles",              OPTION_SUBFILES,           OPTION_TYPE_SIZE, NULL },
+	{ "stage_bytes",           OPTION_STAGE_BYTES,        OPTION_TYPE_SIZE, NULL },
+	{ NULL,                    0,                         0,                NULL }
+};
+
 /*
  * Local functions
  */
 int build_start_count(struct SMIOL_file *file, const char *varname,
                       const struct SMIOL_decomp *decomp,
                       int write_or_read, size_t *element_size, int *ndims,
-                      size_t **start, size_t **count);
+                      size_t **start, size_t **count,
+                      const struct SMIOL_decomp **io_decomp,
+                      size_t *io_element_size, size_t *n_levels);
+int create_decomp(struct SMIOL_context *context,
+                  size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                  size_t n_owned_elements, int halo,
+                  int num_io_tasks, int io_stride,
+                  struct SMIOL_decomp **decomp);
+int lookup_var(struct SMIOL_file *file, const char *varname,
+               struct SMIOL_var_meta **var);
+void free_var_meta(struct SMIOL_file *file);
+int get_plan(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+             const struct SMIOL_decomp *decomp, int write_or_read,
+             struct SMIOL_io_plan **plan);
+int get_staging_buf(struct SMIOL_file *file, size_t size, void **buf);
+int write_var(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+              const struct SMIOL_decomp *decomp, const void *buf);
+int read_var(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+             const struct SMIOL_decomp *decomp, void *buf);
+int write_frames(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                 const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                 const void *buf);
+int read_frames(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                void *buf);
+int resolve_var_handle(struct SMIOL_var *var);
+void free_var_handles(struct SMIOL_file *file);
+int add_pending_write(struct SMIOL_file *file, int request, void *buf);
+int batch_small_write(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                      const struct SMIOL_io_plan *plan, const void *buf);
+int start_stage(struct SMIOL_file *file, MPI_Comm *comm);
+void stop_stage(struct SMIOL_file *file);
+void free_stage(struct SMIOL_stage *stage);
+void free_stage_entry(struct SMIOL_stage_entry *entry);
+int stage_write(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                const struct SMIOL_io_plan *plan,
+                const struct SMIOL_decomp *decomp, const void *buf);
+int wait_stage(struct SMIOL_file *file);
+void *drain_stage(void *arg);
+int bcast_bytes(void *buf, size_t size, MPI_Comm comm);
+int enddef_file(struct SMIOL_file *file);
+int redef_file(struct SMIOL_file *file);
+#ifdef SMIOL_PNETCDF
+int get_open_info(struct SMIOL_context *context, MPI_Info *info,
+                  int *in_place_swap);
+#endif
+int protect_user_buf(struct SMIOL_file *file, const struct SMIOL_io_plan *plan,
+                     const void *buf, size_t size, const void **buf_p);
+int journal_definition(struct SMIOL_file *file, int kind, const char *name,
+                       const char *varname, int type, SMIOL_Offset dimsize,
+                       int ndims, const char **dimnames, const void *value);
+int apply_journal(struct SMIOL_file *file);
+void free_define_entry(struct SMIOL_define_entry *entry);
+void free_journal(struct SMIOL_file *file);
+const struct SMIOL_option *find_option(const char *name);
+int parse_option(const struct SMIOL_option *option, const char *value,
+                 size_t *size_value);
+int set_option(struct SMIOL_context *context, struct SMIOL_file *file,
+               const struct SMIOL_option *option, const char *value);
+void set_env_options(struct SMIOL_context *context);
+int prefetch_next_frame(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                        struct SMIOL_io_plan *plan, MPI_Comm bcast_comm);
+int drop_prefetch(struct SMIOL_file *file, struct SMIOL_var_meta *var);
+int drop_prefetches(struct SMIOL_file *file);
+int put_att(struct SMIOL_file *file, const char *varname, const char *att_name,
+            int att_type, size_t len, const void *att);
+int merge_atts(struct SMIOL_file *out, const char *varname, int natts,
+               const struct SMIOL_native_att *atts);
+int merge_var_data(struct SMIOL_file *in, struct SMIOL_file *out, int varid,
+                   struct SMIOL_decomp **decomp, SMIOL_Offset *decomp_len);
 
 
 /********************************************************************************
@@ -50,6 +183,16 @@ int SMIOL_fortran_init(MPI_Fint comm, struct SMIOL_context **context)
  * files may be read and written. At present, the only input argument is an MPI
  * communicator.
  *
+ * The tasks in the communicator are also grouped by the node on which they
+ * run, so that I/O tasks may later be placed according to the node layout
+ * (see SMIOL_set_io_placement).
+ *
+ * Options may be given by environment variables named SMIOL_ followed by the
+ * name of an option in upper case (e.g., SMIOL_CB_NODES or
+ * SMIOL_SMALL_VAR_BYTES), which are applied as if by SMIOL_set_option; the
+ * values of such variables should be the same on all tasks, and variables
+ * with invalid values are ignored.
+ *
  * Upon successful return the context argument points to a valid SMIOL context;
  * otherwise, it is NULL and an error code other than MPI_SUCCESS is returned.
  *
@@ -60,6 +203,11 @@ int SMIOL_fortran_init(MPI_Fint comm, struct SMIOL_context **context)
 int SMIOL_init(MPI_Comm comm, struct SMIOL_context **context)
 {
 	MPI_Comm smiol_comm;
+	MPI_Comm node_comm;
+	MPI_Comm leader_comm;
+	MPI_Info info;
+	int node_info[2];
+	int ierr;
 
 	/*
 	 * Before dereferencing context below, ensure that the pointer
@@ -116,6 +264,116 @@ int SMIOL_init(MPI_Comm comm, struct SMIOL_context **context)
 		return SMIOL_MPI_ERROR;
 	}
 
+	/*
+	 * Discover which tasks share a node, and number the nodes in order
+	 * of the lowest-ranked task on each node
+	 */
+	if (MPI_Comm_split_type(smiol_comm, MPI_COMM_TYPE_SHARED,
+	                        (*context)->comm_rank, MPI_INFO_NULL,
+	                        &node_comm) != MPI_SUCCESS) {
+		MPI_Comm_free(&smiol_comm);
+		free((*context));
+		(*context) = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+	(*context)->node_fcomm = MPI_Comm_c2f(node_comm);
+
+	if (MPI_Comm_size(node_comm, &((*context)->node_size)) != MPI_SUCCESS
+	    || MPI_Comm_rank(node_comm, &((*context)->node_rank)) != MPI_SUCCESS) {
+		MPI_Comm_free(&node_comm);
+		MPI_Comm_free(&smiol_comm);
+		free((*context));
+		(*context) = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+
+	if (MPI_Comm_split(smiol_comm,
+	                   ((*context)->node_rank == 0) ? 0 : MPI_UNDEFINED,
+	                   (*context)->comm_rank, &leader_comm) != MPI_SUCCESS) {
+		MPI_Comm_free(&node_comm);
+		MPI_Comm_free(&smiol_comm);
+		free((*context));
+		(*context) = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+
+	node_info[0] = 0;
+	node_info[1] = 0;
+	if (leader_comm != MPI_COMM_NULL) {
+		ierr = MPI_Comm_rank(leader_comm, &node_info[0]);
+		if (ierr == MPI_SUCCESS) {
+			ierr = MPI_Comm_size(leader_comm, &node_info[1]);
+		}
+		MPI_Comm_free(&leader_comm);
+		if (ierr != MPI_SUCCESS) {
+			MPI_Comm_free(&node_comm);
+			MPI_Comm_free(&smiol_comm);
+			free((*context));
+			(*context) = NULL;
+			return SMIOL_MPI_ERROR;
+		}
+	}
+
+	if (MPI_Bcast((void *)node_info, 2, MPI_INT, 0, node_comm) != MPI_SUCCESS) {
+		MPI_Comm_free(&node_comm);
+		MPI_Comm_free(&smiol_comm);
+		free((*context));
+		(*context) = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+	(*context)->node_id = node_info[0];
+	(*context)->num_nodes = node_info[1];
+
+	(*context)->io_placement = SMIOL_IO_PLACEMENT_STRIDE;
+	(*context)->io_tasks_per_node = 0;
+
+	(*context)->io_align_bytes = 0;
+	(*context)->io_align_element_size = 0;
+	(*context)->io_partition = SMIOL_IO_PARTITION_ELEMENTS;
+	(*context)->io_vertical_blocks = 1;
+
+	(*context)->autotune_cache = NULL;
+	(*context)->autotune_scratch = NULL;
+	(*context)->autotune_bytes = SMIOL_AUTO_DEFAULT_BYTES;
+	(*context)->auto_io_tasks_per_node = 0;
+	(*context)->auto_num_io_tasks = 0;
+	(*context)->auto_io_stride = 0;
+	(*context)->auto_bandwidth = 0.0;
+
+	(*context)->n_decomps = 0;
+	(*context)->n_io_ranks = 0;
+	(*context)->io_ranks = NULL;
+	(*context)->small_var_bytes = SMIOL_SMALL_VAR_DEFAULT_BYTES;
+	(*context)->read_mode = SMIOL_READ_BCAST;
+
+	(*context)->header_free_bytes = SMIOL_HEADER_DEFAULT_FREE_BYTES;
+	(*context)->var_align_bytes = 0;
+	(*context)->var_free_bytes = 0;
+	(*context)->record_align_bytes = 0;
+
+#ifdef SMIOL_PNETCDF
+	(*context)->file_library = SMIOL_LIBRARY_PNETCDF;
+#else
+	(*context)->file_library = SMIOL_LIBRARY_UNKNOWN;
+#endif
+	(*context)->n_subfiles = 0;
+	(*context)->stage_bytes = SMIOL_STAGE_DEFAULT_BYTES;
+
+	/*
+	 * Hints for files opened in the context, and options given by
+	 * environment variables
+	 */
+	if (MPI_Info_create(&info) != MPI_SUCCESS) {
+		MPI_Comm_free(&node_comm);
+		MPI_Comm_free(&smiol_comm);
+		free((*context));
+		(*context) = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+	(*context)->finfo = MPI_Info_c2f(info);
+
+	set_env_options(*context);
+
 	return SMIOL_SUCCESS;
 }
 
@@ -134,6 +392,8 @@ int SMIOL_init(MPI_Comm comm, struct SMIOL_context **context)
 int SMIOL_finalize(struct SMIOL_context **context)
 {
 	MPI_Comm smiol_comm;
+	MPI_Comm node_comm;
+	MPI_Info info;
 
 	/*
 	 * If the pointer to the context pointer is NULL, assume we have nothing
@@ -147,6 +407,24 @@ int SMIOL_finalize(struct SMIOL_context **context)
 		return SMIOL_SUCCESS;
 	}
 
+	free((*context)->autotune_cache);
+	free((*context)->autotune_scratch);
+	free((*context)->io_ranks);
+
+	info = MPI_Info_f2c((*context)->finfo);
+	if (MPI_Info_free(&info) != MPI_SUCCESS) {
+		free((*context));
+		(*context) = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+
+	node_comm = MPI_Comm_f2c((*context)->node_fcomm);
+	if (MPI_Comm_free(&node_comm) != MPI_SUCCESS) {
+		free((*context));
+		(*context) = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+
 	smiol_comm = MPI_Comm_f2c((*context)->fcomm);
 	if (MPI_Comm_free(&smiol_comm) != MPI_SUCCESS) {
 		free((*context));
@@ -185,6 +463,60 @@ int SMIOL_inquire(void)
  * Depending on the specified file mode, creates or opens the file specified
  * by filename within the provided SMIOL context.
  *
+ * If SMIOL_FILE_DEFERRED is combined with SMIOL_FILE_CREATE or SMIOL_FILE_WRITE,
+ * writes to the file are only posted by SMIOL_put_var, and are completed
+ * together by SMIOL_flush_file, SMIOL_sync_file, or SMIOL_close_file.
+ * SMIOL_put_var returns as soon as the data have been gathered on the I/O
+ * tasks into memory owned by SMIOL. For files of the native library, each
+ * I/O task then immediately starts writing its data with nonblocking MPI-IO,
+ * or, where SMIOL is built with SMIOL_IO_URING on Linux, through an io_uring,
+ * so that the data drain to the file while the caller computes; for PnetCDF
+ * files, the data are only written when the writes are completed.
+ *
+ * If SMIOL_FILE_STAGED is combined with SMIOL_FILE_CREATE or SMIOL_FILE_WRITE,
+ * writes to the file of any library are staged: SMIOL_put_var gathers the data
+ * on the I/O tasks into a store in the memory of each task, and returns at
+ * once, and a drain thread of each task then writes the data in the store to
+ * the file, in the order in which they were staged, while the caller computes.
+ * SMIOL_flush_file, SMIOL_sync_file, and SMIOL_close_file wait for all staged
+ * writes to be written, and return any error in writing them; so does any
+ * routine that inquires about, defines, or reads from the file, since the file
+ * library is only used by the drain thread until the store is empty. A write
+ * waits for the drain thread when the store already holds more than the
+ * stage_bytes option (see SMIOL_set_option). The file library is called from
+ * the drain thread while the caller makes its own MPI calls, so staging needs
+ * MPI to have been initialized with MPI_THREAD_MULTIPLE, and parallel-netCDF
+ * to have been built thread-safe if other files are used while staged writes
+ * drain; if MPI does not provide MPI_THREAD_MULTIPLE, the file is written as
+ * if SMIOL_FILE_STAGED had not been given. SMIOL_FILE_STAGED cannot be
+ * combined with SMIOL_FILE_DEFERRED.
+ *
+ * If SMIOL_FILE_JOURNAL is combined with SMIOL_FILE_CREATE or SMIOL_FILE_WRITE,
+ * dimensions, variables, and attributes defined in the file are only recorded
+ * by SMIOL, and are defined in the file together, in the order in which they
+ * were recorded, at the next inquiry, data access, SMIOL_sync_file, or
+ * SMIOL_close_file. Errors in recorded definitions are then returned by the
+ * routine that applies them.
+ *
+ * If SMIOL_FILE_NOFILL is combined with SMIOL_FILE_CREATE or SMIOL_FILE_WRITE,
+ * variables defined in the file are not pre-filled with fill values, which
+ * avoids writing every variable twice when all of its values will be written
+ * anyway; fill values may still be enabled for individual variables with
+ * SMIOL_define_var_fill.
+ *
+ * If SMIOL_FILE_NULL is combined with any of the modes above, no file is
+ * opened or created, and the filename is ignored. The file starts out empty
+ * and accepts definitions and writes like a new file, and every put still
+ * exchanges its field between compute and I/O tasks, but the values reaching
+ * the I/O tasks are counted (see SMIOL_inquire_bytes_written) and discarded,
+ * and reads return zeros. This measures the cost of SMIOL itself, without any
+ * file system time.
+ *
+ * Files are opened with the hints set for the context (see SMIOL_set_option).
+ * Unless the nc_in_place_swap hint has been set, in-place byte swapping is
+ * enabled, since the file library is only given buffers owned by SMIOL to
+ * write from, and caller buffers are never modified.
+ *
  * Upon successful completion, SMIOL_SUCCESS is returned, and the file handle
  * argument will point to a valid file handle and the current frame for the
  * file will be set to zero. Otherwise, the file handle is NULL and an error
@@ -193,8 +525,11 @@ int SMIOL_inquire(void)
  ********************************************************************************/
 int SMIOL_open_file(struct SMIOL_context *context, const char *filename, int mode, struct SMIOL_file **file)
 {
-#ifdef SMIOL_PNETCDF
 	int ierr;
+	MPI_Comm comm;
+#ifdef SMIOL_PNETCDF
+	int in_place_swap;
+	MPI_Info info;
 #endif
 
 	/*
@@ -222,12 +557,129 @@ int SMIOL_open_file(struct SMIOL_context *context, const char *filename, int mod
 	 */
 	(*file)->context = context;
 	(*file)->frame = (SMIOL_Offset) 0;
+	(*file)->var_meta = NULL;
+	(*file)->staging_buf = NULL;
+	(*file)->staging_size = 0;
+	(*file)->meta_epoch = 0;
+	(*file)->var_handles = NULL;
+	(*file)->deferred = ((mode & SMIOL_FILE_DEFERRED) != 0);
+	(*file)->n_pending = 0;
+	(*file)->max_pending = 0;
+	(*file)->pending_reqs = NULL;
+	(*file)->pending_bufs = NULL;
+	(*file)->flush_needed = 0;
+	(*file)->next_small_owner = 0;
+	(*file)->pad_header = ((mode & SMIOL_FILE_CREATE) != 0);
+	(*file)->journal = ((mode & SMIOL_FILE_JOURNAL) != 0);
+	(*file)->journal_head = NULL;
+	(*file)->journal_tail = NULL;
+	(*file)->small_var_bytes = (size_t)-1;
+	(*file)->read_mode = 0;
+	(*file)->header_free_bytes = context->header_free_bytes;
+	(*file)->var_align_bytes = context->var_align_bytes;
+	(*file)->var_free_bytes = context->var_free_bytes;
+	(*file)->record_align_bytes = context->record_align_bytes;
+	(*file)->in_place_swap = 0;
+	(*file)->nofill = ((mode & SMIOL_FILE_NOFILL) != 0);
+	(*file)->backend = context->file_library;
+	(*file)->native = NULL;
+	(*file)->stage = NULL;
+
+	/*
+	 * Staged files are opened by the file library with a communicator of
+	 * their own, on which the drain thread writes while the caller goes on
+	 */
+	comm = MPI_Comm_f2c(context->fcomm);
+	if ((mode & SMIOL_FILE_STAGED) && (mode & (SMIOL_FILE_CREATE | SMIOL_FILE_WRITE))) {
+		if (mode & SMIOL_FILE_DEFERRED) {
+			free((*file));
+			(*file) = NULL;
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		if ((ierr = start_stage(*file, &comm)) != SMIOL_SUCCESS) {
+			free((*file));
+			(*file) = NULL;
+			return ierr;
+		}
+	}
+
+	/*
+	 * Null files are native files with nothing behind them
+	 */
+	if (context->file_library == SMIOL_LIBRARY_NULL || (mode & SMIOL_FILE_NULL)) {
+		if (!(mode & (SMIOL_FILE_CREATE | SMIOL_FILE_WRITE | SMIOL_FILE_READ))) {
+			stop_stage(*file);
+			free((*file));
+			(*file) = NULL;
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		(*file)->backend = SMIOL_LIBRARY_NATIVE;
+		ierr = native_create_null(comm, &((*file)->native));
+		if (ierr != NATIVE_NOERR) {
+			stop_stage(*file);
+			free((*file));
+			(*file) = NULL;
+			context->lib_type = SMIOL_LIBRARY_NATIVE;
+			context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+
+		return SMIOL_SUCCESS;
+	}
+
+	/*
+	 * Native files are opened with the hints of the context unchanged, and
+	 * are never pre-filled, so that SMIOL_FILE_NOFILL has no effect
+	 */
+	if ((*file)->backend == SMIOL_LIBRARY_NATIVE) {
+		if (mode & SMIOL_FILE_CREATE) {
+			ierr = native_create(comm, filename,
+			                     MPI_Info_f2c(context->finfo), context->n_subfiles,
+			                     &((*file)->native));
+		} else if (mode & (SMIOL_FILE_WRITE | SMIOL_FILE_READ)) {
+			ierr = native_open(comm, filename,
+			                   ((mode & SMIOL_FILE_WRITE) != 0),
+			                   MPI_Info_f2c(context->finfo), &((*file)->native));
+		} else {
+			stop_stage(*file);
+			free((*file));
+			(*file) = NULL;
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		if (ierr != NATIVE_NOERR) {
+			stop_stage(*file);
+			free((*file));
+			(*file) = NULL;
+			context->lib_type = SMIOL_LIBRARY_NATIVE;
+			context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+
+		return SMIOL_SUCCESS;
+	}
+
+#ifdef SMIOL_PNETCDF
+	/*
+	 * SMIOL only writes from buffers that it owns (see protect_user_buf),
+	 * so the file library may byte-swap them in place rather than copying
+	 */
+	if ((ierr = get_open_info(context, &info, &in_place_swap)) != SMIOL_SUCCESS) {
+		stop_stage(*file);
+		free((*file));
+		(*file) = NULL;
+		return ierr;
+	}
+	(*file)->in_place_swap = in_place_swap;
+#endif
 
 	if (mode & SMIOL_FILE_CREATE) {
 #ifdef SMIOL_PNETCDF
-		if ((ierr = ncmpi_create(MPI_Comm_f2c(context->fcomm), filename,
-					(NC_64BIT_DATA | NC_CLOBBER), MPI_INFO_NULL,
-					&((*file)->ncidp))) != NC_NOERR) {
+		ierr = ncmpi_create(comm, filename,
+		                    (NC_64BIT_DATA | NC_CLOBBER), info,
+		                    &((*file)->ncidp));
+		MPI_Info_free(&info);
+		if (ierr != NC_NOERR) {
+			stop_stage(*file);
 			free((*file));
 			(*file) = NULL;
 			context->lib_type = SMIOL_LIBRARY_PNETCDF;
@@ -236,12 +688,29 @@ int SMIOL_open_file(struct SMIOL_context *context, const char *filename, int mod
 		} else {
 			(*file)->state = PNETCDF_DEFINE_MODE;
 		}
+
+		if ((*file)->nofill) {
+			int old_mode;
+
+			if ((ierr = ncmpi_set_fill((*file)->ncidp, NC_NOFILL, &old_mode)) != NC_NOERR) {
+				ncmpi_close((*file)->ncidp);
+				stop_stage(*file);
+				free((*file));
+				(*file) = NULL;
+				context->lib_type = SMIOL_LIBRARY_PNETCDF;
+				context->lib_ierr = ierr;
+				return SMIOL_LIBRARY_ERROR;
+			}
+		}
 #endif
 	}
 	else if (mode & SMIOL_FILE_WRITE) {
 #ifdef SMIOL_PNETCDF
-		if ((ierr = ncmpi_open(MPI_Comm_f2c(context->fcomm), filename,
-				NC_WRITE, MPI_INFO_NULL, &((*file)->ncidp))) != NC_NOERR) {
+		ierr = ncmpi_open(comm, filename,
+		                  NC_WRITE, info, &((*file)->ncidp));
+		MPI_Info_free(&info);
+		if (ierr != NC_NOERR) {
+			stop_stage(*file);
 			free((*file));
 			(*file) = NULL;
 			context->lib_type = SMIOL_LIBRARY_PNETCDF;
@@ -254,8 +723,10 @@ int SMIOL_open_file(struct SMIOL_context *context, const char *filename, int mod
 	}
 	else if (mode & SMIOL_FILE_READ) {
 #ifdef SMIOL_PNETCDF
-		if ((ierr = ncmpi_open(MPI_Comm_f2c(context->fcomm), filename,
-				NC_NOWRITE, MPI_INFO_NULL, &((*file)->ncidp))) != NC_NOERR) {
+		ierr = ncmpi_open(comm, filename,
+		                  NC_NOWRITE, info, &((*file)->ncidp));
+		MPI_Info_free(&info);
+		if (ierr != NC_NOERR) {
 			free((*file));
 			(*file) = NULL;
 			context->lib_type = SMIOL_LIBRARY_PNETCDF;
@@ -267,6 +738,10 @@ int SMIOL_open_file(struct SMIOL_context *context, const char *filename, int mod
 #endif
 	}
 	else {
+#ifdef SMIOL_PNETCDF
+		MPI_Info_free(&info);
+#endif
+		stop_stage(*file);
 		free((*file));
 		(*file) = NULL;
 		return SMIOL_INVALID_ARGUMENT;
@@ -290,32 +765,196 @@ int SMIOL_open_file(struct SMIOL_context *context, const char *filename, int mod
  ********************************************************************************/
 int SMIOL_close_file(struct SMIOL_file **file)
 {
-#ifdef SMIOL_PNETCDF
 	int ierr;
-#endif
+	int journal_ierr;
+	int flush_ierr;
+	int prefetch_ierr;
 
 	/*
-	 * If the pointer to the file pointer is NULL, assume we have nothing
-	 * to do and declare success
+	 * If the pointer to the file pointer is NULL, or the file pointer is
+	 * NULL, assume we have nothing to do and declare success
 	 */
-	if (file == NULL) {
+	if (file == NULL || *file == NULL) {
 		return SMIOL_SUCCESS;
 	}
 
+	/*
+	 * Apply any journaled definitions, and complete any deferred writes and
+	 * read-aheads; the file is closed even if this fails, in which case the
+	 * first error is returned
+	 */
+	journal_ierr = apply_journal(*file);
+	if (journal_ierr == SMIOL_SUCCESS) {
+		journal_ierr = enddef_file(*file);
+	}
+	flush_ierr = SMIOL_flush_file(*file);
+	prefetch_ierr = drop_prefetches(*file);
+	if (flush_ierr == SMIOL_SUCCESS) {
+		flush_ierr = prefetch_ierr;
+	}
+	if (journal_ierr != SMIOL_SUCCESS) {
+		flush_ierr = journal_ierr;
+	}
+	free((*file)->pending_reqs);
+	free((*file)->pending_bufs);
+
+	free_var_meta(*file);
+	free_var_handles(*file);
+	free((*file)->staging_buf);
+
+	/*
+	 * The drain thread is stopped, and the communicator of a staged file
+	 * freed, once the file library has closed the file
+	 */
+	if ((*file)->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = native_close(&((*file)->native))) != NATIVE_NOERR) {
+			((*file)->context)->lib_type = SMIOL_LIBRARY_NATIVE;
+			((*file)->context)->lib_ierr = ierr;
+			stop_stage(*file);
+			free((*file));
+			(*file) = NULL;
+			return SMIOL_LIBRARY_ERROR;
+		}
+		stop_stage(*file);
+		free((*file));
+		(*file) = NULL;
+		return flush_ierr;
+	}
+
 #ifdef SMIOL_PNETCDF
 	if ((ierr = ncmpi_close((*file)->ncidp)) != NC_NOERR) {
 		((*file)->context)->lib_type = SMIOL_LIBRARY_PNETCDF;
 		((*file)->context)->lib_ierr = ierr;
+		stop_stage(*file);
 		free((*file));
 		(*file) = NULL;
 		return SMIOL_LIBRARY_ERROR;
 	}
 #endif
 
+	stop_stage(*file);
 	free((*file));
 	(*file) = NULL;
 
-	return SMIOL_SUCCESS;
+	return flush_ierr;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_merge_subfiles
+ *
+ * Merges a subfiled native file into a single file.
+ *
+ * Given a context and the name of a native file whose data are held in
+ * subfiles (see the subfiles option of SMIOL_set_option), creates a file named
+ * out_filename with the same dimensions, variables, attributes, and data in a
+ * single file: a netCDF file where SMIOL is built with parallel-netCDF, or a
+ * native file without subfiles otherwise. Data are copied one variable and one
+ * frame at a time, with the elements of each variable divided evenly among all
+ * tasks in the context. Attributes are copied with all of their values.
+ *
+ * The file library and subfiles options of the context are unchanged when this
+ * routine returns. This routine must be called by all tasks in the context.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned.
+ *
+ ********************************************************************************/
+int SMIOL_merge_subfiles(struct SMIOL_context *context, const char *filename,
+                         const char *out_filename)
+{
+	struct SMIOL_file *in = NULL;
+	struct SMIOL_file *out = NULL;
+	struct SMIOL_native *nf;
+	struct SMIOL_native_var *var;
+	struct SMIOL_decomp *decomp = NULL;
+	SMIOL_Offset decomp_len = 0;
+	const char **dimnames = NULL;
+	int file_library;
+	int n_subfiles;
+	int ierr;
+	int ierr2;
+	int i, j;
+
+	if (context == NULL || filename == NULL || out_filename == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Open the input with the native library, and create the output with
+	 * the best library available and no subfiles
+	 */
+	file_library = context->file_library;
+	n_subfiles = context->n_subfiles;
+
+	context->file_library = SMIOL_LIBRARY_NATIVE;
+	ierr = SMIOL_open_file(context, filename, SMIOL_FILE_READ, &in);
+	if (ierr == SMIOL_SUCCESS) {
+#ifdef SMIOL_PNETCDF
+		context->file_library = SMIOL_LIBRARY_PNETCDF;
+#endif
+		context->n_subfiles = 0;
+		ierr = SMIOL_open_file(context, out_filename, SMIOL_FILE_CREATE, &out);
+	}
+
+	context->file_library = file_library;
+	context->n_subfiles = n_subfiles;
+
+	if (ierr != SMIOL_SUCCESS) {
+		if (in != NULL) {
+			SMIOL_close_file(&in);
+		}
+		return ierr;
+	}
+
+	/*
+	 * Copy definitions
+	 */
+	nf = in->native;
+	for (i = 0; i < nf->ndims && ierr == SMIOL_SUCCESS; i++) {
+		ierr = SMIOL_define_dim(out, nf->dims[i].name, nf->dims[i].len);
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = merge_atts(out, NULL, nf->ngatts, nf->gatts);
+	}
+	for (i = 0; i < nf->nvars && ierr == SMIOL_SUCCESS; i++) {
+		var = &nf->vars[i];
+		dimnames = (const char **)malloc(sizeof(const char *) * (size_t)(var->ndims + 1));
+		if (dimnames == NULL) {
+			ierr = SMIOL_MALLOC_FAILURE;
+			break;
+		}
+		for (j = 0; j < var->ndims; j++) {
+			dimnames[j] = nf->dims[var->dimids[j]].name;
+		}
+		ierr = SMIOL_define_var(out, var->name, var->type, var->ndims, dimnames);
+		free(dimnames);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = merge_atts(out, var->name, var->natts, var->atts);
+		}
+	}
+
+	/*
+	 * Copy data
+	 */
+	for (i = 0; i < nf->nvars && ierr == SMIOL_SUCCESS; i++) {
+		ierr = merge_var_data(in, out, i, &decomp, &decomp_len);
+	}
+
+	if (decomp != NULL) {
+		SMIOL_free_decomp(&decomp);
+	}
+
+	ierr2 = SMIOL_close_file(&out);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = ierr2;
+	}
+	ierr2 = SMIOL_close_file(&in);
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = ierr2;
+	}
+
+	return ierr;
 }
 
 
@@ -335,9 +974,9 @@ int SMIOL_close_file(struct SMIOL_file **file)
  ********************************************************************************/
 int SMIOL_define_dim(struct SMIOL_file *file, const char *dimname, SMIOL_Offset dimsize)
 {
-#ifdef SMIOL_PNETCDF
 	int dimidp;
 	int ierr;
+#ifdef SMIOL_PNETCDF
 	MPI_Offset len;
 #endif
 
@@ -355,6 +994,37 @@ int SMIOL_define_dim(struct SMIOL_file *file, const char *dimname, SMIOL_Offset
 		return SMIOL_INVALID_ARGUMENT;
 	}
 
+	/*
+	 * For files with a define-phase journal, only record the dimension
+	 */
+	if (file->journal) {
+		return journal_definition(file, DEFINE_DIM, dimname, NULL, 0, dimsize,
+		                          0, NULL, NULL);
+	}
+
+	/*
+	 * The file library is not used while the drain thread may be using it
+	 */
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if (dimsize == (SMIOL_Offset)0) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+		if ((ierr = native_def_dim(file->native, dimname, dimsize, &dimidp)) != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+		free_var_meta(file);
+		return SMIOL_SUCCESS;
+	}
+
 #ifdef SMIOL_PNETCDF
 	/*
 	 * The parallel-netCDF library does not permit zero-length dimensions
@@ -376,13 +1046,8 @@ int SMIOL_define_dim(struct SMIOL_file *file, const char *dimname, SMIOL_Offset
 	/*
 	 * If the file is in data mode, then switch it to define mode
 	 */
-	if (file->state == PNETCDF_DATA_MODE) {
-		if ((ierr = ncmpi_redef(file->ncidp)) != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
-			return SMIOL_LIBRARY_ERROR;
-		}
-		file->state = PNETCDF_DEFINE_MODE;
+	if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
+		return ierr;
 	}
 
 	if ((ierr = ncmpi_def_dim(file->ncidp, dimname, len, &dimidp)) != NC_NOERR) {
@@ -392,6 +1057,11 @@ int SMIOL_define_dim(struct SMIOL_file *file, const char *dimname, SMIOL_Offset
 	}
 #endif
 
+	/*
+	 * Cached variable metadata may no longer be valid
+	 */
+	free_var_meta(file);
+
 	return SMIOL_SUCCESS;
 }
 
@@ -420,9 +1090,9 @@ int SMIOL_define_dim(struct SMIOL_file *file, const char *dimname, SMIOL_Offset
 int SMIOL_inquire_dim(struct SMIOL_file *file, const char *dimname,
                       SMIOL_Offset *dimsize, int *is_unlimited)
 {
-#ifdef SMIOL_PNETCDF
-	int dimidp;
 	int ierr;
+	int dimidp;
+#ifdef SMIOL_PNETCDF
 	MPI_Offset len;
 #endif
 	/*
@@ -446,6 +1116,20 @@ int SMIOL_inquire_dim(struct SMIOL_file *file, const char *dimname,
 		return SMIOL_INVALID_ARGUMENT;
 	}
 
+	/*
+	 * Apply any journaled definitions before inquiring about the file
+	 */
+	if ((ierr = apply_journal(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * The file library is not used while the drain thread may be using it
+	 */
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
 	if (dimsize != NULL) {
 		(*dimsize) = (SMIOL_Offset)0;   /* Default dimension size if no library provides a value */
 	}
@@ -454,11 +1138,27 @@ int SMIOL_inquire_dim(struct SMIOL_file *file, const char *dimname,
 		(*is_unlimited) = 0; /* Return 0 if no library provides a value */
 	}
 
-#ifdef SMIOL_PNETCDF
-	if ((ierr = ncmpi_inq_dimid(file->ncidp, dimname, &dimidp)) != NC_NOERR) {
-		(*dimsize) = (SMIOL_Offset)(-1);  /* TODO: should there be a well-defined invalid size? */
-		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-		file->context->lib_ierr = ierr;
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = native_inq_dimid(file->native, dimname, &dimidp)) != NATIVE_NOERR
+		    || (ierr = native_inq_dim(file->native, dimidp, NULL, dimsize)) != NATIVE_NOERR) {
+			if (dimsize != NULL) {
+				(*dimsize) = (SMIOL_Offset)(-1);
+			}
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+		if (is_unlimited != NULL) {
+			(*is_unlimited) = (dimidp == file->native->unlimdimid);
+		}
+		return SMIOL_SUCCESS;
+	}
+
+#ifdef SMIOL_PNETCDF
+	if ((ierr = ncmpi_inq_dimid(file->ncidp, dimname, &dimidp)) != NC_NOERR) {
+		(*dimsize) = (SMIOL_Offset)(-1);  /* TODO: should there be a well-defined invalid size? */
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
 		return SMIOL_LIBRARY_ERROR;
 	}
 
@@ -518,12 +1218,12 @@ int SMIOL_inquire_dim(struct SMIOL_file *file, const char *dimname,
  ********************************************************************************/
 int SMIOL_define_var(struct SMIOL_file *file, const char *varname, int vartype, int ndims, const char **dimnames)
 {
-#ifdef SMIOL_PNETCDF
 	int *dimids;
 	int ierr;
 	int i;
-	nc_type xtype;
 	int varidp;
+#ifdef SMIOL_PNETCDF
+	nc_type xtype;
 #endif
 
 	/*
@@ -551,6 +1251,55 @@ int SMIOL_define_var(struct SMIOL_file *file, const char *varname, int vartype,
 		return SMIOL_INVALID_ARGUMENT;
 	}
 
+	/*
+	 * For files with a define-phase journal, only record the variable
+	 */
+	if (file->journal) {
+		return journal_definition(file, DEFINE_VAR, varname, NULL, vartype,
+		                          (SMIOL_Offset)0, ndims, dimnames, NULL);
+	}
+
+	/*
+	 * The file library is not used while the drain thread may be using it
+	 */
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if (vartype != SMIOL_REAL32 && vartype != SMIOL_REAL64
+		    && vartype != SMIOL_INT32 && vartype != SMIOL_CHAR) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+
+		dimids = (int *)malloc(sizeof(int) * (size_t)(ndims + 1));
+		if (dimids == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+
+		ierr = NATIVE_NOERR;
+		for (i = 0; i < ndims && ierr == NATIVE_NOERR; i++) {
+			ierr = native_inq_dimid(file->native, dimnames[i], &dimids[i]);
+		}
+		if (ierr == NATIVE_NOERR) {
+			if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
+				free(dimids);
+				return ierr;
+			}
+			ierr = native_def_var(file->native, varname, vartype, ndims,
+			                      dimids, &varidp);
+		}
+		free(dimids);
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+
+		free_var_meta(file);
+		return SMIOL_SUCCESS;
+	}
+
 #ifdef SMIOL_PNETCDF
 	dimids = (int *)malloc(sizeof(int) * (size_t)ndims);
 	if (dimids == NULL) {
@@ -593,13 +1342,9 @@ int SMIOL_define_var(struct SMIOL_file *file, const char *varname, int vartype,
 	/*
 	 * If the file is in data mode, then switch it to define mode
 	 */
-	if (file->state == PNETCDF_DATA_MODE) {
-		if ((ierr = ncmpi_redef(file->ncidp)) != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
-			return SMIOL_LIBRARY_ERROR;
-		}
-		file->state = PNETCDF_DEFINE_MODE;
+	if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
+		free(dimids);
+		return ierr;
 	}
 
 	/*
@@ -615,6 +1360,11 @@ int SMIOL_define_var(struct SMIOL_file *file, const char *varname, int vartype,
 	free(dimids);
 #endif
 
+	/*
+	 * Cached variable metadata may no longer be valid
+	 */
+	free_var_meta(file);
+
 	return SMIOL_SUCCESS;
 }
 
@@ -641,13 +1391,13 @@ int SMIOL_define_var(struct SMIOL_file *file, const char *varname, int vartype,
  ********************************************************************************/
 int SMIOL_inquire_var(struct SMIOL_file *file, const char *varname, int *vartype, int *ndims, char **dimnames)
 {
-#ifdef SMIOL_PNETCDF
+	int ierr;
 	int *dimids;
 	int varidp;
-	int ierr;
 	int i;
-	int xtypep;
 	int ndimsp;
+#ifdef SMIOL_PNETCDF
+	int xtypep;
 #endif
 
 	/*
@@ -671,6 +1421,20 @@ int SMIOL_inquire_var(struct SMIOL_file *file, const char *varname, int *vartype
 		return SMIOL_SUCCESS;
 	}
 
+	/*
+	 * Apply any journaled definitions before inquiring about the file
+	 */
+	if ((ierr = apply_journal(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * The file library is not used while the drain thread may be using it
+	 */
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
 	/*
 	 * Provide default values for output arguments in case
 	 * no library-specific below is active
@@ -682,6 +1446,39 @@ int SMIOL_inquire_var(struct SMIOL_file *file, const char *varname, int *vartype
 		*ndims = 0;
 	}
 
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = native_inq_varid(file->native, varname, &varidp)) != NATIVE_NOERR
+		    || (ierr = native_inq_var(file->native, varidp, vartype, &ndimsp, NULL)) != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+
+		if (ndims != NULL) {
+			*ndims = ndimsp;
+		}
+
+		if (dimnames != NULL) {
+			dimids = (int *)malloc(sizeof(int) * (size_t)(ndimsp + 1));
+			if (dimids == NULL) {
+				return SMIOL_MALLOC_FAILURE;
+			}
+			native_inq_var(file->native, varidp, NULL, NULL, dimids);
+
+			for (i = 0; i < ndimsp; i++) {
+				if (dimnames[i] == NULL) {
+					free(dimids);
+					return SMIOL_INVALID_ARGUMENT;
+				}
+				native_inq_dim(file->native, dimids[i], dimnames[i], NULL);
+			}
+
+			free(dimids);
+		}
+
+		return SMIOL_SUCCESS;
+	}
+
 #ifdef SMIOL_PNETCDF
 	/*
 	 * Get variable ID
@@ -777,188 +1574,158 @@ int SMIOL_inquire_var(struct SMIOL_file *file, const char *varname, int *vartype
 
 /********************************************************************************
  *
- * SMIOL_put_var
- *
- * Writes a variable to a file.
+ * SMIOL_define_var_fill
  *
- * Given a pointer to a SMIOL file that was previously opened with write access
- * and the name of a variable previously defined in the file with a call to
- * SMIOL_define_var, this routine will write the contents of buf to the variable
- * according to the decomposition described by decomp.
+ * Sets whether a variable is pre-filled, and with which fill value.
  *
- * If decomp is not NULL, the variable is assumed to be decomposed across MPI
- * ranks, and all ranks with non-zero-sized partitions of the variable must
- * provide a valid buffer. For decomposed variables, all MPI ranks must provide
- * a non-NULL decomp, regardless of whether a rank has a non-zero-sized
- * partition of the variable.
+ * Given a pointer to a SMIOL file opened with SMIOL_FILE_CREATE or
+ * SMIOL_FILE_WRITE and the name of a variable defined in the file, sets
+ * whether the parts of the variable that are never written hold a fill value
+ * (fill_mode is SMIOL_FILL) or are left undefined (fill_mode is SMIOL_NOFILL),
+ * overriding the fill mode of the file (see SMIOL_FILE_NOFILL).
  *
- * If the variable is not decomposed -- that is, all ranks store identical
- * values for the entire variable -- all MPI ranks must provide a NULL pointer
- * for the decomp argument. As currently implemented, this routine will write
- * the buffer for MPI rank 0 to the variable; however, this behavior should not
- * be relied on.
+ * If fill_mode is SMIOL_FILL and fill_value is not NULL, fill_value points to a
+ * single value of the type of the variable, which is stored as the
+ * _FillValue attribute of the variable; otherwise, the default fill value of
+ * the file library for the type of the variable is used. Fill settings must
+ * be given before any values of the variable are written. For files opened
+ * with SMIOL_FILE_JOURNAL, any journaled definitions are applied first.
  *
- * If the variable has been successfully written to the file, SMIOL_SUCCESS will
- * be returned. Otherwise, an error code indicating the nature of the failure
- * will be returned.
+ * Upon successful completion, SMIOL_SUCCESS is returned; otherwise, an error
+ * code is returned.
  *
  ********************************************************************************/
-int SMIOL_put_var(struct SMIOL_file *file, const char *varname,
-                  const struct SMIOL_decomp *decomp, const void *buf)
+int SMIOL_define_var_fill(struct SMIOL_file *file, const char *varname,
+                          int fill_mode, const void *fill_value)
 {
 	int ierr;
-	int ndims;
-	size_t element_size;
-	void *out_buf = NULL;
-	size_t *start;
-	size_t *count;
+	int varidp;
+	int vartype;
 
 	/*
-	 * Basic checks on arguments
+	 * Check validity of arguments
 	 */
 	if (file == NULL || varname == NULL) {
 		return SMIOL_INVALID_ARGUMENT;
 	}
 
+	if (fill_mode != SMIOL_FILL && fill_mode != SMIOL_NOFILL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
 	/*
-	 * Work out the start[] and count[] arrays for writing this variable
-	 * in parallel
+	 * The variable itself may still be journaled
 	 */
-	ierr = build_start_count(file, varname, decomp,
-	                         START_COUNT_WRITE, &element_size, &ndims,
-	                         &start, &count);
-	if (ierr != SMIOL_SUCCESS) {
+	if ((ierr = apply_journal(file)) != SMIOL_SUCCESS) {
 		return ierr;
 	}
 
 	/*
-	 * Communicate elements of this field from MPI ranks that compute those
-	 * elements to MPI ranks that write those elements. This only needs to
-	 * be done for decomposed variables.
+	 * The file library is not used while the drain thread may be using it
 	 */
-	if (decomp) {
-		out_buf = malloc(element_size * decomp->io_count);
-		if (out_buf == NULL) {
-			free(start);
-			free(count);
-
-			return SMIOL_MALLOC_FAILURE;
-		}
-
-		ierr = transfer_field(decomp, SMIOL_COMP_TO_IO,
-		                      element_size, buf, out_buf);
-		if (ierr != SMIOL_SUCCESS) {
-			free(start);
-			free(count);
-			free(out_buf);
-			return ierr;
-		}
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
 	}
 
 	/*
-	 * Write out_buf
+	 * Native files are never pre-filled, and values never written are read
+	 * as zero; a fill value is only recorded as the _FillValue attribute
 	 */
-#ifdef SMIOL_PNETCDF
-	{
-		int j;
-		int varidp;
-		const void *buf_p;
-		MPI_Offset *mpi_start;
-		MPI_Offset *mpi_count;
-
-		if (file->state == PNETCDF_DEFINE_MODE) {
-			if ((ierr = ncmpi_enddef(file->ncidp)) != NC_NOERR) {
-				file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-				file->context->lib_ierr = ierr;
-
-				if (decomp) {
-					free(out_buf);
-				}
-				free(start);
-				free(count);
-
-				return SMIOL_LIBRARY_ERROR;
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = native_inq_varid(file->native, varname, &varidp)) == NATIVE_NOERR
+		    && fill_mode == SMIOL_FILL && fill_value != NULL) {
+			native_inq_var(file->native, varidp, &vartype, NULL, NULL);
+			if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
+				return ierr;
 			}
-			file->state = PNETCDF_DATA_MODE;
+			ierr = native_put_att(file->native, varidp, "_FillValue",
+			                      vartype, 1, fill_value);
 		}
-
-		ierr = ncmpi_inq_varid(file->ncidp, varname, &varidp);
-		if (ierr != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
 			file->context->lib_ierr = ierr;
-
-			if (decomp) {
-				free(out_buf);
-			}
-			free(start);
-			free(count);
-
 			return SMIOL_LIBRARY_ERROR;
 		}
+		return SMIOL_SUCCESS;
+	}
 
-		if (decomp) {
-			buf_p = out_buf;
-		} else {
-			buf_p = buf;
-		}
-
-		mpi_start = malloc(sizeof(MPI_Offset) * (size_t)ndims);
-		if (mpi_start == NULL) {
-			free(start);
-			free(count);
-
-			return SMIOL_MALLOC_FAILURE;
-		}
-
-		mpi_count = malloc(sizeof(MPI_Offset) * (size_t)ndims);
-		if (mpi_count == NULL) {
-			free(start);
-			free(count);
-			free(mpi_start);
-
-			return SMIOL_MALLOC_FAILURE;
-		}
-
-		for (j = 0; j < ndims; j++) {
-			mpi_start[j] = (MPI_Offset)start[j];
-			mpi_count[j] = (MPI_Offset)count[j];
-		}
+#ifdef SMIOL_PNETCDF
+	if ((ierr = ncmpi_inq_varid(file->ncidp, varname, &varidp)) != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
 
-		ierr = ncmpi_put_vara_all(file->ncidp,
-		                          varidp,
-		                          mpi_start, mpi_count,
-		                          buf_p,
-		                          0, MPI_DATATYPE_NULL);
+	/*
+	 * If the file is in data mode, then switch it to define mode
+	 */
+	if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
 
-		free(mpi_start);
-		free(mpi_count);
+	ierr = ncmpi_def_var_fill(file->ncidp, varidp,
+	                          (fill_mode == SMIOL_NOFILL) ? 1 : 0,
+	                          (fill_mode == SMIOL_NOFILL) ? NULL : fill_value);
+	if (ierr != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
+#endif
 
-		if (ierr != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
+	return SMIOL_SUCCESS;
+}
 
-			if (decomp) {
-				free(out_buf);
-			}
-			free(start);
-			free(count);
 
-			return SMIOL_LIBRARY_ERROR;
-		}
-	}
-#endif
+/********************************************************************************
+ *
+ * SMIOL_put_var
+ *
+ * Writes a variable to a file.
+ *
+ * Given a pointer to a SMIOL file that was previously opened with write access
+ * and the name of a variable previously defined in the file with a call to
+ * SMIOL_define_var, this routine will write the contents of buf to the variable
+ * according to the decomposition described by decomp.
+ *
+ * If decomp is not NULL, the variable is assumed to be decomposed across MPI
+ * ranks, and all ranks with non-zero-sized partitions of the variable must
+ * provide a valid buffer. For decomposed variables, all MPI ranks must provide
+ * a non-NULL decomp, regardless of whether a rank has a non-zero-sized
+ * partition of the variable.
+ *
+ * If the variable is not decomposed -- that is, all ranks store identical
+ * values for the entire variable -- all MPI ranks must provide a NULL pointer
+ * for the decomp argument. The buffer of MPI rank 0 is written to the
+ * variable, so MPI rank 0 must provide a valid buffer for a variable with a
+ * non-zero size, while other ranks may provide a NULL buf. For batched writes
+ * of small variables (see SMIOL_set_small_var_batching), a NULL buf on MPI
+ * rank 0 is rejected on all ranks with SMIOL_INVALID_ARGUMENT.
+ *
+ * If the variable has been successfully written to the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int SMIOL_put_var(struct SMIOL_file *file, const char *varname,
+                  const struct SMIOL_decomp *decomp, const void *buf)
+{
+	int ierr;
+	struct SMIOL_var_meta *var;
 
 	/*
-	 * Free up memory before returning
+	 * Basic checks on arguments
 	 */
-	if (decomp) {
-		free(out_buf);
+	if (file == NULL || varname == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
 	}
 
-	free(start);
-	free(count);
+	ierr = lookup_var(file, varname, &var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
 
-	return SMIOL_SUCCESS;
+	return write_var(file, var, decomp, buf);
 }
 
 
@@ -991,11 +1758,7 @@ int SMIOL_get_var(struct SMIOL_file *file, const char *varname,
                   const struct SMIOL_decomp *decomp, void *buf)
 {
 	int ierr;
-	int ndims;
-	size_t element_size;
-	void *in_buf = NULL;
-	size_t *start;
-	size_t *count;
+	struct SMIOL_var_meta *var;
 
 	/*
 	 * Basic checks on arguments
@@ -1004,261 +1767,4223 @@ int SMIOL_get_var(struct SMIOL_file *file, const char *varname,
 		return SMIOL_INVALID_ARGUMENT;
 	}
 
-	/*
-	 * Work out the start[] and count[] arrays for reading this variable
-	 * in parallel
-	 */
-	ierr = build_start_count(file, varname, decomp,
-	                         START_COUNT_READ, &element_size, &ndims,
-	                         &start, &count);
+	ierr = lookup_var(file, varname, &var);
 	if (ierr != SMIOL_SUCCESS) {
 		return ierr;
 	}
 
+	return read_var(file, var, decomp, buf);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_put_var_frames
+ *
+ * Writes several consecutive frames of a variable to a file.
+ *
+ * Like SMIOL_put_var, but for a variable with a record dimension, writes the
+ * n_frames frames beginning with the current frame of the file, with all frames
+ * exchanged between compute and I/O tasks together and written in a single
+ * call to the file library. The frames are stored one after another in buf,
+ * each frame holding what would be passed to SMIOL_put_var for that frame.
+ * The current frame of the file is not changed.
+ *
+ * Writes of several frames are completed before this routine returns, even
+ * for files opened with SMIOL_FILE_DEFERRED.
+ *
+ * If the frames have been successfully written to the file, SMIOL_SUCCESS will
+ * be returned. If the variable has no record dimension and n_frames is greater
+ * than one, or if n_frames is less than one, SMIOL_INVALID_ARGUMENT will be
+ * returned. Otherwise, an error code indicating the nature of the failure will
+ * be returned.
+ *
+ ********************************************************************************/
+int SMIOL_put_var_frames(struct SMIOL_file *file, const char *varname,
+                         const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                         const void *buf)
+{
+	int ierr;
+	struct SMIOL_var_meta *var;
+
 	/*
-	 * If this variable is decomposed, allocate a buffer into which
-	 * the variable will be read using the I/O decomposition; later,
-	 * elements this buffer will be transferred to MPI ranks that compute
-	 * on those elements
+	 * Basic checks on arguments
+	 */
+	if (file == NULL || varname == NULL || n_frames < 1) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	ierr = lookup_var(file, varname, &var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	return write_frames(file, var, decomp, n_frames, buf);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_get_var_frames
+ *
+ * Reads several consecutive frames of a variable from a file.
+ *
+ * Like SMIOL_get_var, but for a variable with a record dimension, reads the
+ * n_frames frames beginning with the current frame of the file in a single
+ * call to the file library, with all frames exchanged between I/O and compute
+ * tasks together. The frames are stored one after another in buf, each frame
+ * holding what SMIOL_get_var would return for that frame. The current frame of
+ * the file is not changed.
+ *
+ * If the frames have been successfully read from the file, SMIOL_SUCCESS will
+ * be returned. If the variable has no record dimension and n_frames is greater
+ * than one, or if n_frames is less than one, SMIOL_INVALID_ARGUMENT will be
+ * returned. Otherwise, an error code indicating the nature of the failure will
+ * be returned.
+ *
+ ********************************************************************************/
+int SMIOL_get_var_frames(struct SMIOL_file *file, const char *varname,
+                         const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                         void *buf)
+{
+	int ierr;
+	struct SMIOL_var_meta *var;
+
+	/*
+	 * Basic checks on arguments
+	 */
+	if (file == NULL || varname == NULL || n_frames < 1) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	ierr = lookup_var(file, varname, &var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	return read_frames(file, var, decomp, n_frames, buf);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_prefetch
+ *
+ * Turns read-ahead of the next frame of a variable on or off.
+ *
+ * Given a pointer to a SMIOL file and the name of a variable with a record
+ * dimension, sets whether, after each read of a frame of the variable with
+ * SMIOL_get_var, the next frame is read ahead with a non-blocking read. If the
+ * next call reads that frame with the same decomp, only the read-ahead needs to
+ * be completed before values are exchanged with compute tasks, so reading
+ * frame after frame overlaps file access with the caller's work. Read-ahead
+ * stops at the last frame in the file, and is turned off again if dimensions
+ * or variables are later defined in the file.
+ *
+ * This routine must be called by all tasks in the context of the file.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int SMIOL_set_prefetch(struct SMIOL_file *file, const char *varname, int enable)
+{
+	int ierr;
+	struct SMIOL_var_meta *var;
+
+	/*
+	 * Basic checks on arguments
+	 */
+	if (file == NULL || varname == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	ierr = lookup_var(file, varname, &var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	var->prefetch = (enable != 0);
+
+	if (!var->prefetch) {
+		return drop_prefetch(file, var);
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_get_var_subset
+ *
+ * Reads part of a variable from a file.
+ *
+ * Like SMIOL_get_var, reads a variable according to the decomposition described
+ * by decomp (or as a non-decomposed variable if decomp is NULL), but reads only
+ * the hyperslab given by start and count, and, for a variable with a record
+ * dimension, the n_frames frames beginning with first_frame rather than the
+ * current frame of the file; for variables with no record dimension, first_frame
+ * and n_frames are ignored.
+ *
+ * The start and count arrays give the selection in each dimension that is
+ * neither the record dimension nor the decomposed dimension, from slowest- to
+ * fastest-varying; they may be NULL if there are no such dimensions. For
+ * decomposed variables, every compute element is read with the selection; for
+ * example, count = {1} with start = {k} reads level k of a field
+ * foo[nCells][nVertLevels].
+ *
+ * Frames are stored one after another in buf, each frame holding the selected
+ * values of every compute element (or of the entire variable, if not
+ * decomposed). The selection is passed to the file library, so only the
+ * selected parts of the variable are read from the file. Non-decomposed
+ * variables are read according to the read mode of the file or its context
+ * (see SMIOL_set_read_mode), as by SMIOL_get_var.
+ *
+ * If the subset has been successfully read from the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int SMIOL_get_var_subset(struct SMIOL_file *file, const char *varname,
+                         const struct SMIOL_decomp *decomp,
+                         SMIOL_Offset first_frame, SMIOL_Offset n_frames,
+                         const SMIOL_Offset *start, const SMIOL_Offset *count,
+                         void *buf)
+{
+	struct SMIOL_var_meta *var;
+	const struct SMIOL_decomp *io_decomp = NULL;
+	MPI_Offset *fstart;
+	MPI_Offset *fcount;
+	size_t element_size;
+	size_t io_element_size;
+	size_t n_levels = 1;
+	size_t level_start = 0;
+	size_t level_count = 1;
+	size_t frames;
+	size_t f;
+	void *in_buf = NULL;
+	MPI_Comm bcast_comm = MPI_COMM_NULL;
+	int bcast_rank = 0;
+	int read_mode;
+	int first_sel;
+	int decomp_dim = -1;
+	int i, k;
+	int ierr;
+
+
+	/*
+	 * Basic checks on arguments
+	 */
+	if (file == NULL || varname == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Deferred writes must complete before the file is read
+	 */
+	ierr = SMIOL_flush_file(file);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	ierr = lookup_var(file, varname, &var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	frames = 1;
+	if (var->has_unlimited_dim) {
+		if (first_frame < 0 || n_frames < 1) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		frames = (size_t)n_frames;
+	}
+
+	/*
+	 * Dimensions selected by start and count follow the record dimension
+	 * and the decomposed dimension
 	 */
+	first_sel = var->has_unlimited_dim ? 1 : 0;
 	if (decomp) {
-		in_buf = malloc(element_size * decomp->io_count);
-		if (in_buf == NULL) {
-			free(start);
-			free(count);
+		decomp_dim = first_sel;
+		first_sel++;
+	}
+	if (first_sel > var->ndims) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+	if (first_sel < var->ndims && (start == NULL || count == NULL)) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
 
-			return SMIOL_MALLOC_FAILURE;
+	element_size = 1;
+	switch (var->vartype) {
+		case SMIOL_REAL32:
+			element_size = sizeof(float);
+			break;
+		case SMIOL_REAL64:
+			element_size = sizeof(double);
+			break;
+		case SMIOL_INT32:
+			element_size = sizeof(int);
+			break;
+		case SMIOL_CHAR:
+			element_size = sizeof(char);
+			break;
+	}
+
+	for (i = first_sel; i < var->ndims; i++) {
+		k = i - first_sel;
+		if (start[k] < 0 || count[k] < 0 || start[k] + count[k] > var->dimsizes[i]) {
+			return SMIOL_INVALID_ARGUMENT;
 		}
+		element_size *= (size_t)count[k];
+	}
 
-#ifndef SMIOL_PNETCDF
-		/*
-		 * If no file library provides values for the memory pointed to
-		 * by in_buf, the transfer_field call later will transfer
-		 * garbage to the output buffer; to avoid returning
-		 * non-deterministic values to the caller in this case,
-		 * initialize in_buf.
-		 */
-		memset(in_buf, 0, element_size * decomp->io_count);
-		
-#endif
+	fstart = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(var->ndims + 1));
+	fcount = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(var->ndims + 1));
+	if (fstart == NULL || fcount == NULL) {
+		free(fstart);
+		free(fcount);
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	if (var->has_unlimited_dim) {
+		fstart[0] = (MPI_Offset)first_frame;
+		fcount[0] = (MPI_Offset)n_frames;
+	}
+	for (i = first_sel; i < var->ndims; i++) {
+		fstart[i] = (MPI_Offset)start[i - first_sel];
+		fcount[i] = (MPI_Offset)count[i - first_sel];
 	}
 
 	/*
-	 * Read in_buf
+	 * For decomposed variables, read the I/O range of this task for the
+	 * element size of the selection, with members of I/O groups reading
+	 * their block of the first selected dimension
 	 */
-#ifdef SMIOL_PNETCDF
-	{
-		int j;
-		int varidp;
-		void *buf_p;
-		MPI_Offset *mpi_start;
-		MPI_Offset *mpi_count;
+	io_element_size = element_size;
+	if (decomp) {
+		ierr = get_decomp_for_size(decomp, element_size, &io_decomp);
+		if (ierr != SMIOL_SUCCESS) {
+			free(fstart);
+			free(fcount);
+			return ierr;
+		}
 
-		if (file->state == PNETCDF_DEFINE_MODE) {
-			if ((ierr = ncmpi_enddef(file->ncidp)) != NC_NOERR) {
-				file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-				file->context->lib_ierr = ierr;
+		fstart[decomp_dim] = (MPI_Offset)io_decomp->io_start;
+		fcount[decomp_dim] = (MPI_Offset)io_decomp->io_count;
 
-				if (decomp) {
-					free(in_buf);
-				}
-				free(start);
-				free(count);
+		if (first_sel < var->ndims) {
+			n_levels = (size_t)count[0];
+		}
+		if (io_decomp->io_group_size > 1 && n_levels > 0) {
+			get_vertical_block(io_decomp->io_group_rank,
+			                   io_decomp->io_group_size, n_levels,
+			                   &level_start, &level_count);
+			io_element_size = element_size / n_levels * level_count;
+			if (first_sel < var->ndims) {
+				fstart[first_sel] = (MPI_Offset)(start[0] + (SMIOL_Offset)level_start);
+				fcount[first_sel] = (MPI_Offset)level_count;
+			}
+			if (level_count == 0) {
+				fcount[decomp_dim] = 0;
+			}
+		}
 
-				return SMIOL_LIBRARY_ERROR;
+		ierr = get_staging_buf(file, io_element_size * io_decomp->io_count * frames,
+		                       &in_buf);
+		if (ierr != SMIOL_SUCCESS) {
+			free(fstart);
+			free(fcount);
+			return ierr;
+		}
+		if (file->backend == SMIOL_LIBRARY_UNKNOWN) {
+			memset(in_buf, 0, io_element_size * io_decomp->io_count * frames);
+		}
+	}
+
+	/*
+	 * As in read_var, a non-decomposed variable may be read by only one
+	 * task overall or one task per node, with the values then broadcast to
+	 * the other tasks, which take part in the collective read without
+	 * reading anything
+	 */
+	if (!decomp) {
+		read_mode = (file->read_mode != 0) ? file->read_mode : file->context->read_mode;
+		if (read_mode == SMIOL_READ_BCAST) {
+			bcast_comm = MPI_Comm_f2c(file->context->fcomm);
+		} else if (read_mode == SMIOL_READ_BCAST_NODE) {
+			bcast_comm = MPI_Comm_f2c(file->context->node_fcomm);
+		}
+		if (bcast_comm != MPI_COMM_NULL) {
+			MPI_Comm_rank(bcast_comm, &bcast_rank);
+		}
+		if (bcast_rank != 0) {
+			for (i = 0; i < var->ndims; i++) {
+				fcount[i] = 0;
 			}
-			file->state = PNETCDF_DATA_MODE;
 		}
 
-		ierr = ncmpi_inq_varid(file->ncidp, varname, &varidp);
+		if (file->backend == SMIOL_LIBRARY_UNKNOWN && buf != NULL) {
+			memset(buf, 0, element_size * frames);
+		}
+	}
+
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			free(fstart);
+			free(fcount);
+			return ierr;
+		}
+
+		ierr = native_get_vara_all(file->native, var->varid, fstart, fcount,
+		                           decomp ? in_buf : buf);
+		if (ierr != NATIVE_NOERR) {
+			free(fstart);
+			free(fcount);
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#ifdef SMIOL_PNETCDF
+	else {
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			free(fstart);
+			free(fcount);
+			return ierr;
+		}
+
+		ierr = ncmpi_get_vara_all(file->ncidp, var->varid, fstart, fcount,
+		                          decomp ? in_buf : buf,
+		                          0, MPI_DATATYPE_NULL);
 		if (ierr != NC_NOERR) {
+			free(fstart);
+			free(fcount);
 			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
 			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#endif
 
-			if (decomp) {
-				free(in_buf);
-			}
-			free(start);
-			free(count);
+	free(fstart);
+	free(fcount);
 
-			return SMIOL_LIBRARY_ERROR;
+	/*
+	 * Transfer each frame read by I/O tasks to the compute tasks
+	 */
+	if (decomp) {
+		for (f = 0; f < frames; f++) {
+			const char *frame_in = (const char *)in_buf
+			                       + f * io_element_size * io_decomp->io_count;
+			char *frame_out = (buf == NULL) ? NULL :
+			                  (char *)buf + f * element_size * decomp->n_compute_elements;
+
+			if (io_decomp->io_group_size > 1) {
+				ierr = transfer_field_2d(io_decomp, SMIOL_IO_TO_COMP,
+				                         element_size, n_levels,
+				                         frame_in, frame_out);
+			} else {
+				ierr = transfer_field(io_decomp, SMIOL_IO_TO_COMP,
+				                      element_size, frame_in, frame_out);
+			}
+			if (ierr != SMIOL_SUCCESS) {
+				return ierr;
+			}
+		}
+	} else if (bcast_comm != MPI_COMM_NULL) {
+		ierr = bcast_bytes(buf, element_size * frames, bcast_comm);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
 		}
+	}
 
-		if (decomp) {
-			buf_p = in_buf;
-		} else {
-			buf_p = buf;
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_inquire_var_handle
+ *
+ * Returns a handle for a variable in a file.
+ *
+ * Given a pointer to a SMIOL file and the name of a variable defined in the
+ * file, returns in var a handle that may be passed to SMIOL_put_var_h and
+ * SMIOL_get_var_h in place of the file and variable name. Handles are owned by
+ * the file, remain valid if further dimensions or variables are defined, and
+ * are freed when the file is closed; repeated inquiries for the same variable
+ * return the same handle.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned
+ * and var is set to NULL.
+ *
+ ********************************************************************************/
+int SMIOL_inquire_var_handle(struct SMIOL_file *file, const char *varname,
+                             struct SMIOL_var **var)
+{
+	struct SMIOL_var *h;
+	struct SMIOL_var_meta *meta;
+	int ierr;
+
+
+	/*
+	 * Basic checks on arguments
+	 */
+	if (var == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	*var = NULL;
+
+	if (file == NULL || varname == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	for (h = file->var_handles; h != NULL; h = h->next) {
+		if (strcmp(h->varname, varname) == 0) {
+			*var = h;
+			return SMIOL_SUCCESS;
 		}
+	}
+
+	/*
+	 * Looking up the variable also checks that it exists in the file
+	 */
+	ierr = lookup_var(file, varname, &meta);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	h = (struct SMIOL_var *)malloc(sizeof(struct SMIOL_var));
+	if (h == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	h->varname = (char *)malloc(strlen(varname) + 1);
+	if (h->varname == NULL) {
+		free(h);
+		return SMIOL_MALLOC_FAILURE;
+	}
+	strcpy(h->varname, varname);
+
+	h->file = file;
+	h->meta = meta;
+	h->meta_epoch = file->meta_epoch;
+	h->next = file->var_handles;
+	file->var_handles = h;
+
+	*var = h;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_put_var_h
+ *
+ * Writes a variable to a file given a handle for the variable.
+ *
+ * Identical to SMIOL_put_var, except that the file and variable are given by
+ * a handle obtained from SMIOL_inquire_var_handle, so that no lookup of the
+ * variable by name is needed.
+ *
+ * If the variable has been successfully written to the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int SMIOL_put_var_h(struct SMIOL_var *var, const struct SMIOL_decomp *decomp,
+                    const void *buf)
+{
+	int ierr;
+
+	if (var == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	ierr = resolve_var_handle(var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	return write_var(var->file, var->meta, decomp, buf);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_get_var_h
+ *
+ * Reads a variable from a file given a handle for the variable.
+ *
+ * Identical to SMIOL_get_var, except that the file and variable are given by
+ * a handle obtained from SMIOL_inquire_var_handle, so that no lookup of the
+ * variable by name is needed.
+ *
+ * If the variable has been successfully read from the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int SMIOL_get_var_h(struct SMIOL_var *var, const struct SMIOL_decomp *decomp,
+                    void *buf)
+{
+	int ierr;
+
+	if (var == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	ierr = resolve_var_handle(var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	return read_var(var->file, var->meta, decomp, buf);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_define_att
+ *
+ * Defines a new attribute in a file.
+ *
+ * Defines a new attribute for a variable if varname is not NULL,
+ * or a global attribute otherwise. The type of the attribute must be one
+ * of SMIOL_REAL32, SMIOL_REAL64, SMIOL_INT32, or SMIOL_CHAR.
+ *
+ * If the attribute has been successfully defined for the variable or file,
+ * SMIOL_SUCCESS is returned.
+ *
+ ********************************************************************************/
+int SMIOL_define_att(struct SMIOL_file *file, const char *varname,
+                     const char *att_name, int att_type, const void *att)
+{
+	int ierr;
+
+	/*
+	 * Check validity of arguments
+	 */
+	if (file == NULL || att_name == NULL || att == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Checks for valid attribute type are handled in library-specific
+	 * code in put_att
+	 */
+
+	/*
+	 * For files with a define-phase journal, only record the attribute
+	 */
+	if (file->journal) {
+		return journal_definition(file, DEFINE_ATT, att_name, varname, att_type,
+		                          (SMIOL_Offset)0, 0, NULL, att);
+	}
+
+	/*
+	 * The file library is not used while the drain thread may be using it
+	 */
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	return put_att(file, varname, att_name, att_type,
+	               (att_type == SMIOL_CHAR) ? strlen(att) : 1, att);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_inquire_att
+ *
+ * Inquires about an attribute in a file.
+ *
+ * Inquires about a variable attribute if varname is not NULL, or a global
+ * attribute otherwise.
+ *
+ * If the requested attribute is found, SMIOL_SUCCESS is returned and the memory
+ * pointed to by the att argument will contain the attribute value.
+ *
+ * For character string attributes, no bytes beyond the length of the attribute
+ * in the file will be modified in the att argument, and no '\0' character will
+ * be added. Therefore, calling code may benefit from initializing character
+ * strings before calling this routine.
+ *
+ * If SMIOL was not compiled with support for any file library, the att_type
+ * output argument will always be set to SMIOL_UNKNOWN_VAR_TYPE, and the att_len
+ * output argument will always be set to -1; the value of the att output
+ * argument will be unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_inquire_att(struct SMIOL_file *file, const char *varname,                                                                  
+                      const char *att_name, int *att_type,
+                      SMIOL_Offset *att_len, void *att)
+{
+	int ierr;
+	int varidp;
+#ifdef SMIOL_PNETCDF
+	nc_type xtypep;
+	MPI_Offset lenp;
+#endif
+
+	/*
+	 * Check validity of arguments
+	 */
+	if (file == NULL || att_name == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Apply any journaled definitions before inquiring about the file
+	 */
+	if ((ierr = apply_journal(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * The file library is not used while the drain thread may be using it
+	 */
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * Set output arguments in case no library sets them later
+	 */
+	if (att_len != NULL) {
+		*att_len = (SMIOL_Offset)-1;
+	}
+
+	if (att_type != NULL) {
+		*att_type = SMIOL_UNKNOWN_VAR_TYPE;
+	}
+
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		size_t len;
+
+		ierr = NATIVE_NOERR;
+		varidp = NATIVE_GLOBAL;
+		if (varname != NULL) {
+			ierr = native_inq_varid(file->native, varname, &varidp);
+		}
+		if (ierr == NATIVE_NOERR) {
+			ierr = native_inq_att(file->native, varidp, att_name, att_type, &len);
+		}
+		if (ierr == NATIVE_NOERR && att != NULL) {
+			ierr = native_get_att(file->native, varidp, att_name, att);
+		}
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+		if (att_len != NULL) {
+			*att_len = (SMIOL_Offset)len;
+		}
+		return SMIOL_SUCCESS;
+	}
+
+#ifdef SMIOL_PNETCDF
+	/*
+	 * If varname was provided, get the variable ID; else, the inquiry is
+	 * is for a global attribute not associated with a specific variable
+	 */
+	if (varname != NULL) {
+		ierr = ncmpi_inq_varid(file->ncidp, varname, &varidp);
+		if (ierr != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	} else {
+		varidp = NC_GLOBAL;
+	}
+
+	/*
+	 * Inquire about attribute type and length
+	 */
+	if (att_type != NULL || att_len != NULL) {
+		ierr = ncmpi_inq_att(file->ncidp, varidp, att_name,
+		                     &xtypep, &lenp);
+		if (ierr != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+
+		if (att_type != NULL) {
+			/* Convert parallel-netCDF type to SMIOL type */
+			switch (xtypep) {
+				case NC_FLOAT:
+					*att_type = SMIOL_REAL32;
+					break;
+				case NC_DOUBLE:
+					*att_type = SMIOL_REAL64;
+					break;
+				case NC_INT:
+					*att_type = SMIOL_INT32;
+					break;
+				case NC_CHAR:
+					*att_type = SMIOL_CHAR;
+					break;
+				default:
+					*att_type = SMIOL_UNKNOWN_VAR_TYPE;
+			}
+		}
+
+		if (att_len != NULL) {
+			*att_len = lenp;
+		}
+	}
+
+
+	/*
+	 * Inquire about attribute value if requested
+	 */
+	if (att != NULL) {
+		ierr = ncmpi_get_att(file->ncidp, varidp, att_name, att);
+		if (ierr != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#endif
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_sync_file
+ *
+ * Forces all in-memory data to be flushed to disk.
+ *
+ * Upon success, all in-memory data for the file associatd with the file
+ * handle will be flushed to the file system and SMIOL_SUCCESS will be
+ * returned; otherwise, an error code is returned.
+ *
+ ********************************************************************************/
+int SMIOL_sync_file(struct SMIOL_file *file)
+{
+	int ierr;
+
+	/*
+	 * Check that file is valid
+	 */
+	if (file == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Apply any journaled definitions and complete any deferred writes
+	 * before syncing
+	 */
+	if ((ierr = apply_journal(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	if ((ierr = SMIOL_flush_file(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+		if ((ierr = native_sync(file->native)) != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+		return SMIOL_SUCCESS;
+	}
+
+#ifdef SMIOL_PNETCDF
+	/*
+	 * If the file is in define mode then switch it into data mode
+	 */
+	if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	if ((ierr = ncmpi_sync(file->ncidp)) != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
+#endif
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_flush_file
+ *
+ * Completes all deferred writes to a file.
+ *
+ * Waits in a single collective call for all writes posted by SMIOL_put_var
+ * since the last flush -- all writes to a file opened with SMIOL_FILE_DEFERRED,
+ * and batched writes of small non-decomposed variables (see
+ * SMIOL_set_small_var_batching) -- and frees the buffers holding the data of
+ * those writes. For a file opened with SMIOL_FILE_STAGED, it first waits for
+ * the drain thread to write all staged writes. If there are no such writes,
+ * this routine has no effect. Like SMIOL_put_var, this routine must be called
+ * by all MPI ranks in the file's context.
+ *
+ * Upon successful completion, SMIOL_SUCCESS is returned; otherwise, an error
+ * code is returned.
+ *
+ ********************************************************************************/
+int SMIOL_flush_file(struct SMIOL_file *file)
+{
+	int i;
+	struct SMIOL_var_meta *v;
+	int stage_ierr;
+	int native_ierr = NATIVE_NOERR;
+#ifdef SMIOL_PNETCDF
+	int ierr = NC_NOERR;
+	int *statuses;
+#endif
+
+	/*
+	 * Check that file is valid
+	 */
+	if (file == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Staged writes are complete once the drain thread has written them
+	 */
+	if ((stage_ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return stage_ierr;
+	}
+
+	/*
+	 * Whether a flush is needed is the same on all tasks, even though
+	 * batched writes of small variables are posted by only one task
+	 */
+	if (!file->flush_needed) {
+		return SMIOL_SUCCESS;
+	}
+
+	/*
+	 * Writes to native files have been draining to the file since they
+	 * were posted, and only need to be waited for before the number of
+	 * records in the file is agreed on
+	 */
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		native_ierr = native_wait_all(file->native);
+	}
+#ifdef SMIOL_PNETCDF
+	else {
+		statuses = (int *)malloc(sizeof(int) * (size_t)(file->n_pending + 1));
+		if (statuses == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+
+		ierr = ncmpi_wait_all(file->ncidp, file->n_pending, file->pending_reqs, statuses);
+		if (ierr == NC_NOERR) {
+			for (i = 0; i < file->n_pending; i++) {
+				if (statuses[i] != NC_NOERR) {
+					ierr = statuses[i];
+					break;
+				}
+			}
+		}
+		free(statuses);
+	}
+#endif
+
+	for (i = 0; i < file->n_pending; i++) {
+		free(file->pending_bufs[i]);
+	}
+	file->n_pending = 0;
+	file->flush_needed = 0;
+
+	if (file->var_meta != NULL) {
+		for (i = 0; i < SMIOL_VAR_META_BUCKETS; i++) {
+			for (v = file->var_meta[i]; v != NULL; v = v->next) {
+				v->pending = 0;
+			}
+		}
+	}
+
+	if (native_ierr != NATIVE_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+		file->context->lib_ierr = native_ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
+
+#ifdef SMIOL_PNETCDF
+	if (ierr != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
+#endif
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_error_string
+ *
+ * Returns an error string for a specified error code.
+ *
+ * Returns an error string corresponding to a SMIOL error code. If the error code is
+ * SMIOL_LIBRARY_ERROR and a valid SMIOL context is available, the SMIOL_lib_error_string
+ * function should be called instead. The error string is null-terminated, but it
+ * does not contain a newline character.
+ *
+ ********************************************************************************/
+const char *SMIOL_error_string(int errno)
+{
+	switch (errno) {
+	case SMIOL_SUCCESS:
+		return "Success!";
+	case SMIOL_MALLOC_FAILURE:
+		return "malloc returned a null pointer";
+	case SMIOL_INVALID_ARGUMENT:
+		return "invalid subroutine argument";
+	case SMIOL_MPI_ERROR:
+		return "internal MPI call failed";
+	case SMIOL_FORTRAN_ERROR:
+		return "Fortran wrapper detected an inconsistency in C return values";
+	case SMIOL_LIBRARY_ERROR:
+		return "bad return code from a library call";
+	case SMIOL_WRONG_ARG_TYPE:
+		return "argument is of the wrong type";
+	case SMIOL_INSUFFICIENT_ARG:
+		return "argument is of insufficient size";
+	default:
+		return "Unknown error";
+	}
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_lib_error_string
+ *
+ * Returns an error string for a third-party library called by SMIOL.
+ *
+ * Returns an error string corresponding to an error that was generated by
+ * a third-party library that was called by SMIOL. The library that was the source
+ * of the error, as well as the library-specific error code, are retrieved from
+ * a SMIOL context. If successive library calls resulted in errors, only the error
+ * string for the last of these errors will be returned. The error string is
+ * null-terminated, but it does not contain a newline character.
+ *
+ ********************************************************************************/
+const char *SMIOL_lib_error_string(struct SMIOL_context *context)
+{
+	if (context == NULL) {
+		return "SMIOL_context argument is a NULL pointer";
+	}
+
+	switch (context->lib_type) {
+#ifdef SMIOL_PNETCDF
+	case SMIOL_LIBRARY_PNETCDF:
+		return ncmpi_strerror(context->lib_ierr);
+#endif
+	case SMIOL_LIBRARY_NATIVE:
+		return native_strerror(context->lib_ierr);
+	default:
+		return "Could not find matching library for the source of the error";
+	}
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_option
+ *
+ * Sets an option for files and decompositions in a context.
+ *
+ * Sets the option with the given name to the given value, both of which are
+ * null-terminated strings. Options are of three kinds:
+ *
+ *   - MPI-IO and parallel-netCDF hints (cb_nodes, cb_buffer_size,
+ *     striping_factor, striping_unit, romio_cb_write, romio_cb_read,
+ *     romio_ds_write, romio_ds_read, nc_header_align_size, nc_var_align_size,
+ *     nc_record_align_size, nc_in_place_swap, and nc_num_subfiles, which
+ *     enables subfiling where parallel-netCDF was built to support it),
+ *     which are passed to the file library for all files opened in the
+ *     context after this call;
+ *
+ *   - file settings (small_var_bytes, read_mode, header_free_bytes,
+ *     var_align_bytes, var_free_bytes, and record_align_bytes), as set by
+ *     SMIOL_set_small_var_batching, SMIOL_set_read_mode, and
+ *     SMIOL_set_header_padding, which may also be set for a single file
+ *     with SMIOL_set_file_option; and
+ *
+ *   - decomposition settings (io_placement, io_tasks_per_node, io_partition,
+ *     io_vertical_blocks, io_align_element_size, and io_align_bytes), as set by
+ *     SMIOL_set_io_placement, SMIOL_set_io_partition,
+ *     SMIOL_set_io_vertical_blocks, and SMIOL_set_io_alignment.
+ *
+ * In addition, file_library selects the library with which files are opened in
+ * the context after this call: "pnetcdf" (the default, where SMIOL is built
+ * with parallel-netCDF) or "native", a format written directly with MPI-IO,
+ * whose files can only be read by SMIOL; or "null", with which every file is
+ * opened as if with SMIOL_FILE_NULL. The subfiles option gives the number of
+ * subfiles among which the data of native files created after this call are
+ * divided (0, the default, for none); each I/O task then writes its part of a
+ * decomposed variable to the subfiles for its range of elements, which is a
+ * single subfile of its own when there are as many I/O tasks as subfiles.
+ * Subfiled files are read transparently with any decomposition, and may be
+ * merged into a single file with SMIOL_merge_subfiles. The stage_bytes option
+ * gives the most bytes of staged writes that each task holds for a file opened
+ * with SMIOL_FILE_STAGED after this call (256 MiB by default) before a write
+ * waits for earlier writes to be drained to the file.
+ *
+ * Numeric values are given in decimal, and keyword values (for example,
+ * "enable" or "bcast_node") in lower case. Options may also be given by
+ * environment variables when the context is initialized (see SMIOL_init).
+ *
+ * Upon success, SMIOL_SUCCESS is returned. If the option is unknown or the
+ * value is not valid for the option, SMIOL_INVALID_ARGUMENT is returned and
+ * the context is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_option(struct SMIOL_context *context, const char *name,
+                     const char *value)
+{
+	const struct SMIOL_option *option;
+
+	if (context == NULL || name == NULL || value == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	option = find_option(name);
+	if (option == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	return set_option(context, NULL, option, value);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_file_option
+ *
+ * Sets an option for a single open file.
+ *
+ * Sets one of the file settings described in SMIOL_set_option (small_var_bytes,
+ * read_mode, header_free_bytes, var_align_bytes, var_free_bytes, or
+ * record_align_bytes) for the given file only, overriding the setting of the
+ * context of the file. Setting any of the header padding options also causes
+ * padding to be applied the next time that the file leaves define mode, even
+ * if the file was opened with SMIOL_FILE_WRITE, so that room can be made once
+ * before many attributes or variables are added to an existing file.
+ *
+ * Hints and decomposition settings cannot be set for a single file.
+ *
+ * Upon success, SMIOL_SUCCESS is returned. If the option is unknown, cannot be
+ * set for a file, or the value is not valid for the option,
+ * SMIOL_INVALID_ARGUMENT is returned and the file is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_file_option(struct SMIOL_file *file, const char *name,
+                          const char *value)
+{
+	const struct SMIOL_option *option;
+
+	if (file == NULL || name == NULL || value == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	option = find_option(name);
+	if (option == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	return set_option(file->context, file, option, value);
+}
+
+/********************************************************************************
+ *
+ * SMIOL_set_frame
+ *
+ * Set the frame for the unlimited dimension for an open file
+ *
+ * For an open SMIOL file handle, set the frame for the unlimited dimension.
+ * After setting the frame for a file, writing to a variable that is
+ * dimensioned by the unlimited dimension will write to the last set frame,
+ * overwriting any current data that maybe present in that frame.
+ *
+ * SMIOL_SUCCESS will be returned if the frame is successfully set otherwise an
+ * error will return.
+ *
+ ********************************************************************************/
+int SMIOL_set_frame(struct SMIOL_file *file, SMIOL_Offset frame)
+{
+	if (file == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+	file->frame = frame;
+	return SMIOL_SUCCESS;
+}
+
+/********************************************************************************
+ *
+ * SMIOL_get_frame
+ *
+ * Return the current frame of an open file
+ *
+ * Get the current frame of an open file. Upon success, SMIOL_SUCCESS will be
+ * returned, otherwise an error will be returned.
+ *
+ ********************************************************************************/
+int SMIOL_get_frame(struct SMIOL_file *file, SMIOL_Offset *frame)
+{
+	if (file == NULL || frame == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+	*frame = file->frame;
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_inquire_bytes_written
+ *
+ * Returns the number of bytes of values written to a file by this task
+ *
+ * Given a file opened with the native or null file library (see
+ * SMIOL_set_option and SMIOL_FILE_NULL), returns in bytes the number of bytes
+ * of variable values that the calling task has written to the file since it
+ * was opened, or, for null files, would have written. Headers and values
+ * written by other tasks are not counted. For staged files, this routine first
+ * waits for all staged writes to be written.
+ *
+ * Upon success, SMIOL_SUCCESS is returned. If the file was opened with another
+ * library, SMIOL_INVALID_ARGUMENT is returned.
+ *
+ ********************************************************************************/
+int SMIOL_inquire_bytes_written(struct SMIOL_file *file, SMIOL_Offset *bytes)
+{
+	int ierr;
+
+	if (file == NULL || bytes == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (file->backend != SMIOL_LIBRARY_NATIVE) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	*bytes = (SMIOL_Offset)file->native->bytes_written;
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_io_placement
+ *
+ * Selects how I/O tasks are chosen for decompositions created in a context.
+ *
+ * With SMIOL_IO_PLACEMENT_STRIDE (the default), every io_stride-th task in the
+ * context communicator is an I/O task, up to num_io_tasks tasks, as given to
+ * SMIOL_create_decomp.
+ *
+ * With SMIOL_IO_PLACEMENT_NODE, I/O tasks are spread evenly across the nodes
+ * spanned by the context, and within each node they are spread evenly across
+ * the node-local ranks; the io_stride argument to SMIOL_create_decomp is then
+ * ignored. If io_tasks_per_node is greater than zero, each node has that many
+ * I/O tasks (or as many tasks as the node has, if fewer), and num_io_tasks is
+ * ignored as well; otherwise, the num_io_tasks given to SMIOL_create_decomp
+ * are divided among nodes, with the first nodes taking any remainder. I/O
+ * ranges are assigned in node order so that each node reads or writes one
+ * contiguous part of a variable.
+ *
+ * The placement affects only decompositions that are created after this
+ * routine is called. Upon success, SMIOL_SUCCESS is returned; otherwise, an
+ * error code is returned and the context is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_io_placement(struct SMIOL_context *context, int placement,
+                           int io_tasks_per_node)
+{
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (placement != SMIOL_IO_PLACEMENT_STRIDE
+	    && placement != SMIOL_IO_PLACEMENT_NODE) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (io_tasks_per_node < 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	context->io_placement = placement;
+	context->io_tasks_per_node = io_tasks_per_node;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_io_alignment
+ *
+ * Sets the alignment of I/O range boundaries for decompositions in a context.
+ *
+ * For decompositions created after this routine is called, the boundaries
+ * between the I/O ranges of consecutive I/O tasks are placed at byte offsets
+ * from the start of a variable that are multiples of align_bytes -- typically
+ * the file system stripe or block size -- assuming that each decomposed
+ * element of a variable occupies element_size bytes. For example, a variable
+ * double foo[nCells][nVertLevels] decomposed over nCells has an element size
+ * of sizeof(double) * nVertLevels.
+ *
+ * Aligned ranges may be less evenly sized than unaligned ones; the resulting
+ * imbalance is reported in the io_imbalance member of each decomposition.
+ * An align_bytes of zero disables alignment.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned and the context is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_io_alignment(struct SMIOL_context *context, size_t align_bytes,
+                           size_t element_size)
+{
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (align_bytes > 0 && element_size == 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	context->io_align_bytes = align_bytes;
+	context->io_align_element_size = element_size;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_io_partition
+ *
+ * Selects how elements are divided among I/O tasks in a context.
+ *
+ * With SMIOL_IO_PARTITION_ELEMENTS (the default), elements are divided evenly
+ * among I/O tasks, with any remainder assigned to the last I/O task.
+ *
+ * With SMIOL_IO_PARTITION_BYTES, the remainder is instead spread over I/O tasks
+ * so that no I/O task has more than one element more than any other. If an
+ * I/O alignment has also been set with SMIOL_set_io_alignment, the aligned I/O
+ * ranges of a decomposition are built for the actual size in bytes of each
+ * element of a variable as it is first read or written with the decomposition,
+ * rather than for the nominal element size given to SMIOL_set_io_alignment,
+ * so that the bytes read or written by each I/O task are balanced and aligned
+ * for every variable.
+ *
+ * The partitioning applies to decompositions created after this routine is
+ * called. Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned and the context is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_io_partition(struct SMIOL_context *context, int partition)
+{
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (partition != SMIOL_IO_PARTITION_ELEMENTS
+	    && partition != SMIOL_IO_PARTITION_BYTES) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	context->io_partition = partition;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_io_autotune
+ *
+ * Configures the auto-tuning of I/O task counts in a context.
+ *
+ * When SMIOL_create_decomp is called with num_io_tasks set to
+ * SMIOL_IO_TASKS_AUTO, the number of I/O tasks and the stride between them
+ * are chosen from the communicator size, node layout, and global number of
+ * elements, together with a number of I/O tasks per node that is determined
+ * once per context (see autotune_io_tasks for details).
+ *
+ * The cache_filename argument names a file in which the number of I/O tasks
+ * per node and the measured bandwidth are recorded for each node layout, so
+ * that later runs with the same layout can reuse them without calibrating
+ * again. The scratch_filename argument names a file to which short
+ * calibration writes of calibration_bytes bytes in total are made; it should
+ * be on the file system to which output will be written, and it is deleted
+ * after calibration. A NULL or empty filename disables recording or
+ * calibration, respectively, and a calibration_bytes of zero selects
+ * a default size.
+ *
+ * Calling this routine discards any number of I/O tasks per node already
+ * determined for the context. Upon success, SMIOL_SUCCESS is returned;
+ * otherwise, an error code is returned.
+ *
+ ********************************************************************************/
+int SMIOL_set_io_autotune(struct SMIOL_context *context,
+                          const char *cache_filename, const char *scratch_filename,
+                          size_t calibration_bytes)
+{
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (calibration_bytes > ((size_t)1 << 30)) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	free(context->autotune_cache);
+	context->autotune_cache = NULL;
+	free(context->autotune_scratch);
+	context->autotune_scratch = NULL;
+
+	if (cache_filename != NULL && cache_filename[0] != '\0') {
+		context->autotune_cache = malloc(strlen(cache_filename) + 1);
+		if (context->autotune_cache == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+		strcpy(context->autotune_cache, cache_filename);
+	}
+
+	if (scratch_filename != NULL && scratch_filename[0] != '\0') {
+		context->autotune_scratch = malloc(strlen(scratch_filename) + 1);
+		if (context->autotune_scratch == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+		strcpy(context->autotune_scratch, scratch_filename);
+	}
+
+	context->autotune_bytes = (calibration_bytes > 0) ? calibration_bytes
+	                                                  : SMIOL_AUTO_DEFAULT_BYTES;
+	context->auto_io_tasks_per_node = 0;
+	context->auto_bandwidth = 0.0;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_io_vertical_blocks
+ *
+ * Sets the number of I/O tasks that split the levels of each element.
+ *
+ * For decompositions created after this routine is called, consecutive I/O
+ * tasks are gathered into groups of n_blocks I/O tasks. Elements are divided
+ * among the groups rather than among individual I/O tasks, and each member of
+ * a group reads or writes one block of the first dimension inside the
+ * decomposed dimension of a variable (e.g., one block of vertical levels), so
+ * that more I/O tasks can take part in reading or writing without each range
+ * of elements becoming very small. Variables with no such inner dimension are
+ * handled entirely by the last member of each group.
+ *
+ * The default n_blocks of one disables the grouping. Any I/O tasks beyond the
+ * last full group of a decomposition are left idle. Upon success,
+ * SMIOL_SUCCESS is returned; otherwise, an error code is returned and the
+ * context is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_io_vertical_blocks(struct SMIOL_context *context, int n_blocks)
+{
+	if (context == NULL || n_blocks < 1) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	context->io_vertical_blocks = n_blocks;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_small_var_batching
+ *
+ * Sets the largest non-decomposed variable whose writes are batched.
+ *
+ * Writes of non-decomposed variables of at most max_bytes bytes are not done
+ * with a collective write of their own in which only MPI rank 0 takes part.
+ * Instead, the value on MPI rank 0 is sent to one task, which posts the write;
+ * tasks are chosen round-robin among the I/O tasks of the last decomp created
+ * in the context (or MPI rank 0 is chosen if there is no such decomp). All
+ * such writes are completed together in one collective call when the file is
+ * flushed, synced, closed, read, or switched back to define mode.
+ *
+ * A max_bytes of zero disables batching; by default, variables of up to
+ * SMIOL_SMALL_VAR_DEFAULT_BYTES bytes are batched. Upon success, SMIOL_SUCCESS
+ * is returned; otherwise, an error code is returned.
+ *
+ ********************************************************************************/
+int SMIOL_set_small_var_batching(struct SMIOL_context *context, size_t max_bytes)
+{
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	context->small_var_bytes = max_bytes;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_read_mode
+ *
+ * Sets how non-decomposed variables are read.
+ *
+ * With SMIOL_READ_ALL, every task reads non-decomposed variables from the file.
+ * With SMIOL_READ_BCAST, the default, only MPI rank 0 reads them, and the values
+ * are broadcast to all other tasks; with SMIOL_READ_BCAST_NODE, the first task
+ * on each node reads them, and the values are broadcast to the other tasks on
+ * the node. The mode does not change the values returned to callers, only which
+ * tasks access the file system.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned
+ * and the context is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_read_mode(struct SMIOL_context *context, int mode)
+{
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (mode != SMIOL_READ_ALL && mode != SMIOL_READ_BCAST
+	    && mode != SMIOL_READ_BCAST_NODE) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	context->read_mode = mode;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_set_header_padding
+ *
+ * Sets the free space and alignment given to the header and data sections of
+ * files created in a context.
+ *
+ * Files created after this call leave header_free_bytes of free space after
+ * their header, and var_free_bytes of free space after their fixed-size
+ * variables, the first time that they leave define mode. Attributes, dimensions,
+ * and variables may later be added to such files, including files re-opened
+ * with SMIOL_FILE_WRITE, without moving any data as long as the header still
+ * fits in its free space. The var_align_bytes and record_align_bytes arguments
+ * give the alignment of the start of the fixed-size and record variable
+ * sections; zero selects the default alignment of the file library.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned
+ * and the context is unchanged.
+ *
+ ********************************************************************************/
+int SMIOL_set_header_padding(struct SMIOL_context *context,
+                             size_t header_free_bytes, size_t var_align_bytes,
+                             size_t var_free_bytes, size_t record_align_bytes)
+{
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	context->header_free_bytes = header_free_bytes;
+	context->var_align_bytes = var_align_bytes;
+	context->var_free_bytes = var_free_bytes;
+	context->record_align_bytes = record_align_bytes;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * SMIOL_create_decomp
+ *
+ * Creates a mapping between compute elements and I/O elements.
+ *
+ * Given arrays of global element IDs that each task computes, the number of I/O
+ * tasks, and the stride between I/O tasks, this routine works out a mapping of
+ * elements between compute and I/O tasks.
+ *
+ * If num_io_tasks is SMIOL_IO_TASKS_AUTO, the number of I/O tasks and the
+ * stride between them are chosen automatically (see SMIOL_set_io_autotune),
+ * and the io_stride argument is ignored; the chosen values are recorded in the
+ * auto_num_io_tasks and auto_io_stride members of the context.
+ *
+ * If all input arguments are determined to be valid and if the routine is
+ * successful in working out a mapping, the decomp pointer is allocated and
+ * given valid contents, and SMIOL_SUCCESS is returned; otherwise a non-success
+ * error code is returned and the decomp pointer is NULL.
+ *
+ *******************************************************************************/
+int SMIOL_create_decomp(struct SMIOL_context *context,
+                        size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                        int num_io_tasks, int io_stride,
+                        struct SMIOL_decomp **decomp)
+{
+	return create_decomp(context, n_compute_elements, compute_elements,
+	                     n_compute_elements, 0, num_io_tasks, io_stride,
+	                     decomp);
+}
+
+
+/*******************************************************************************
+ *
+ * SMIOL_create_halo_decomp
+ *
+ * Creates a mapping between compute elements, including halos, and I/O elements.
+ *
+ * Like SMIOL_create_decomp, but the compute elements of each task may include
+ * copies of elements that are owned by other tasks, or by the same task, such
+ * as halo elements. The first n_owned_elements entries of compute_elements are
+ * the elements owned by this task, each of which must be owned by exactly one
+ * task; any remaining entries are copies. When a variable is written with the
+ * decomp, only owned elements are written, and when a variable is read, every
+ * owned element and every copy is filled, so that fields may be read and
+ * written directly from and into halo-padded arrays.
+ *
+ * The global IDs of owned elements need not cover all IDs from zero through
+ * the largest global ID. Elements in such gaps are written with the default
+ * netCDF fill value for the type of the variable, and are skipped when read.
+ *
+ * If all input arguments are determined to be valid and if the routine is
+ * successful in working out a mapping, the decomp pointer is allocated and
+ * given valid contents, and SMIOL_SUCCESS is returned; otherwise a non-success
+ * error code is returned and the decomp pointer is NULL.
+ *
+ *******************************************************************************/
+int SMIOL_create_halo_decomp(struct SMIOL_context *context,
+                             size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                             size_t n_owned_elements,
+                             int num_io_tasks, int io_stride,
+                             struct SMIOL_decomp **decomp)
+{
+	if (n_owned_elements > n_compute_elements) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	return create_decomp(context, n_compute_elements, compute_elements,
+	                     n_owned_elements, 1, num_io_tasks, io_stride,
+	                     decomp);
+}
+
+
+/********************************************************************************
+ *
+ * SMIOL_free_decomp
+ *
+ * Frees a mapping between compute elements and I/O elements.
+ *
+ * Free all memory of a SMIOL_decomp, including any I/O ranges built for
+ * particular element sizes, and returns SMIOL_SUCCESS. If decomp
+ * points to NULL, then do nothing and return SMIOL_SUCCESS. After this routine
+ * is called, no other SMIOL routines should use the freed SMIOL_decomp.
+ *
+ ********************************************************************************/
+int SMIOL_free_decomp(struct SMIOL_decomp **decomp)
+{
+	if ((*decomp) == NULL) {
+		return SMIOL_SUCCESS;
+	}
+
+	while ((*decomp)->next_size != NULL) {
+		struct SMIOL_decomp *d = (*decomp)->next_size;
+
+		(*decomp)->next_size = d->next_size;
+		free(d->comp_list);
+		free(d->io_list);
+		free(d->io_task_ranks);
+		free(d->rank_io);
+		free(d->fill_comp_list);
+		free(d->fill_io_list);
+		free(d->io_gap_list);
+		free(d);
+	}
+
+	free((*decomp)->compute_elements);
+	free((*decomp)->comp_list);
+	free((*decomp)->io_list);
+	free((*decomp)->io_task_ranks);
+	free((*decomp)->rank_io);
+	free((*decomp)->fill_comp_list);
+	free((*decomp)->fill_io_list);
+	free((*decomp)->io_gap_list);
+	free((*decomp));
+	*decomp = NULL;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * build_start_count
+ *
+ * Constructs start[] and count[] arrays for parallel I/O operations
+ *
+ * Given a pointer to a SMIOL file that was previously opened, the name of
+ * a variable in that file, and a SMIOL decomp, this function returns three
+ * items that may be used when reading or writing the variable in parallel:
+ *
+ * 1) The size of each "element" of the variable, where an element is defined as
+ *    a contiguous memory range associated with the slowest-varying, non-record
+ *    dimension of the variable; for example, a variable
+ *    float foo[nCells][nVertLevels] would have an element size of
+ *    sizeof(float) * nVertLevels if nCells were a decomposed dimension.
+ *
+ *    For non-decomposed variables, the element size is the size of one record
+ *    of the entire variable.
+ *
+ * 2) The number of dimensions for the variable, including any unlimited/record
+ *    dimension.
+ *
+ * 3) The start[] and count[] arrays (each with size ndims) to be read or written
+ *    by an MPI rank using the I/O decomposition described in decomp.
+ *
+ * If the decomp argument is NULL, the variable is to be read or written as
+ * a non-decomposed variable; typically, only MPI rank 0 will write
+ * the non-decomposed variable, and all MPI ranks will read the non-decomposed
+ * variable.
+ *
+ * Depending on the value of the write_or_read argument -- either START_COUNT_READ
+ * or START_COUNT_WRITE -- the count[] values will be set so that all ranks will
+ * read the variable, or only rank 0 will write the variable.
+ *
+ * For decomposed variables, io_decomp is set to the decomp whose I/O ranges
+ * should be used for the element size of the variable (see get_decomp_for_size),
+ * which is also the decomp that should be used to transfer the variable between
+ * compute and I/O tasks; for non-decomposed variables, io_decomp is set to NULL.
+ *
+ * The n_levels argument is set to the size of the first dimension inside the
+ * decomposed dimension, or one if there is no such dimension, and
+ * io_element_size is set to the size of each element as read or written by
+ * this MPI rank. If the I/O tasks of io_decomp are gathered into groups (see
+ * SMIOL_set_io_vertical_blocks), start[] and count[] for that inner dimension
+ * are set to the block of levels handled by this MPI rank, and io_element_size
+ * covers only that block; otherwise, io_element_size equals element_size.
+ *
+ ********************************************************************************/
+int build_start_count(struct SMIOL_file *file, const char *varname,
+                      const struct SMIOL_decomp *decomp,
+                      int write_or_read, size_t *element_size, int *ndims,
+                      size_t **start, size_t **count,
+                      const struct SMIOL_decomp **io_decomp,
+                      size_t *io_element_size, size_t *n_levels)
+{
+	int i;
+	int ierr;
+	int decomp_dim = -1;
+	int vartype;
+	const SMIOL_Offset *dimsizes;
+	int has_unlimited_dim;
+	struct SMIOL_var_meta *var;
+
+	/*
+	 * Figure out type of the variable, as well as its dimensions, from
+	 * the metadata cached with the file
+	 */
+	ierr = lookup_var(file, varname, &var);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	vartype = var->vartype;
+	*ndims = var->ndims;
+	dimsizes = var->dimsizes;
+	has_unlimited_dim = var->has_unlimited_dim;
+
+	/*
+	 * Set basic size of each element in the field
+	 */
+	*element_size = 1;
+	switch (vartype) {
+		case SMIOL_REAL32:
+			*element_size = sizeof(float);
+			break;
+		case SMIOL_REAL64:
+			*element_size = sizeof(double);
+			break;
+		case SMIOL_INT32:
+			*element_size = sizeof(int);
+			break;
+		case SMIOL_CHAR:
+			*element_size = sizeof(char);
+			break;
+	}
+
+	*start = malloc(sizeof(size_t) * (size_t)(*ndims));
+        if (*start == NULL) {
+		ierr = SMIOL_MALLOC_FAILURE;
+		return ierr;
+	}
+
+	*count = malloc(sizeof(size_t) * (size_t)(*ndims));
+        if (*count == NULL) {
+		free(*start);
+		ierr = SMIOL_MALLOC_FAILURE;
+		return ierr;
+	}
+
+	/*
+	 * Build start/count description of the part of the variable to be
+	 * read or written. Simultaneously, compute the product of all
+	 * non-unlimited, non-decomposed dimension sizes, scaled by the basic
+	 * element size to get the effective size of each element to be read or
+	 * written
+	 */
+	for (i = 0; i < *ndims; i++) {
+		(*start)[i] = (size_t)0;
+		(*count)[i] = (size_t)dimsizes[i];
+
+		/*
+		 * If variable has an unlimited dimension, set start to current
+		 * frame and count to one
+		 */
+		if (has_unlimited_dim && i == 0) {
+			(*start)[i] = (size_t)file->frame;
+			(*count)[i] = (size_t)1;
+		}
+
+		/*
+		 * If variable is decomposed, set the slowest-varying,
+		 * non-record dimension start and count based on values from
+		 * the decomp structure
+		 */
+		if (decomp) {
+			if ((!has_unlimited_dim && i == 0) ||
+			    (has_unlimited_dim && i == 1)) {
+				(*start)[i] = decomp->io_start;
+				(*count)[i] = decomp->io_count;
+				decomp_dim = i;
+			} else {
+				*element_size *= (*count)[i];
+			}
+		} else {
+			*element_size *= (*count)[i];
+		}
+
+		if (write_or_read == START_COUNT_WRITE) {
+			/*
+			 * If the variable is not decomposed, only MPI rank 0
+			 * will have non-zero count values so that all MPI ranks
+			 * do no try to write the same offsets
+			 */
+			if (!decomp && file->context->comm_rank != 0) {
+				(*count)[i] = 0;
+			}
+		}
+	}
+
+	/*
+	 * If the I/O ranges of the decomp depend on the element size, use the
+	 * ranges for the element size of this variable
+	 */
+	*io_decomp = decomp;
+	if (decomp) {
+		ierr = get_decomp_for_size(decomp, *element_size, io_decomp);
+		if (ierr != SMIOL_SUCCESS) {
+			free(*start);
+			free(*count);
+			return ierr;
+		}
+		if (decomp_dim >= 0) {
+			(*start)[decomp_dim] = (*io_decomp)->io_start;
+			(*count)[decomp_dim] = (*io_decomp)->io_count;
+		}
+	}
+
+	/*
+	 * For decomps whose I/O tasks are gathered into groups, each member
+	 * of a group handles only its block of the first inner dimension
+	 */
+	*n_levels = 1;
+	*io_element_size = *element_size;
+	if (decomp && decomp_dim >= 0 && decomp_dim + 1 < *ndims) {
+		*n_levels = (*count)[decomp_dim + 1];
+	}
+	if (decomp && (*io_decomp)->io_group_size > 1 && *n_levels > 0) {
+		size_t level_start;
+		size_t level_count;
+
+		get_vertical_block((*io_decomp)->io_group_rank,
+		                   (*io_decomp)->io_group_size, *n_levels,
+		                   &level_start, &level_count);
+		*io_element_size = *element_size / *n_levels * level_count;
+
+		if (decomp_dim >= 0 && decomp_dim + 1 < *ndims) {
+			(*start)[decomp_dim + 1] = level_start;
+			(*count)[decomp_dim + 1] = level_count;
+		}
+		if (level_count == 0 && decomp_dim >= 0) {
+			(*count)[decomp_dim] = 0;
+		}
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * create_decomp
+ *
+ * Creates a mapping between compute elements and I/O elements.
+ *
+ * This routine implements both SMIOL_create_decomp and SMIOL_create_halo_decomp;
+ * if halo is zero, all compute elements are owned by the calling task and
+ * n_owned_elements is ignored.
+ *
+ ********************************************************************************/
+int create_decomp(struct SMIOL_context *context,
+                  size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                  size_t n_owned_elements, int halo,
+                  int num_io_tasks, int io_stride,
+                  struct SMIOL_decomp **decomp)
+{
+	size_t i;
+	int io_rank, n_io_tasks;
+	int *all_io_ranks;
+	int r;
+	int ierr;
+
+
+	/*
+	 * Minimal check on the validity of arguments
+	 */
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (compute_elements == NULL && n_compute_elements != 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * Choose the number of I/O tasks and the stride between them if
+	 * requested
+	 */
+	if (num_io_tasks == SMIOL_IO_TASKS_AUTO) {
+		ierr = autotune_io_tasks(context, n_compute_elements,
+		                         compute_elements, halo,
+		                         &num_io_tasks, &io_stride);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	/*
+	 * Determine which tasks are I/O tasks, and the index of this task
+	 * among them
+	 */
+	if (context->io_placement == SMIOL_IO_PLACEMENT_NODE) {
+		ierr = get_node_io_rank(context, num_io_tasks,
+		                        &io_rank, &n_io_tasks);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	} else {
+		if (io_stride <= 0) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		io_rank = (context->comm_rank % io_stride == 0) ?
+		          context->comm_rank / io_stride : -1;
+		n_io_tasks = num_io_tasks;
+	}
+
+	/*
+	 * Determine the contiguous range of elements to be read/written by
+	 * this MPI task, and build the mapping between compute tasks and
+	 * I/O tasks
+	 */
+	ierr = build_io_decomp(context, n_compute_elements, compute_elements,
+	                       n_owned_elements, halo,
+	                       context->io_partition, io_rank, n_io_tasks,
+	                       context->io_vertical_blocks,
+	                       context->io_align_element_size,
+	                       context->io_align_bytes, decomp);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	(*decomp)->n_compute_elements = n_compute_elements;
+
+	/*
+	 * Record the ranks of the I/O tasks of this decomp with the context,
+	 * so that batched writes of small non-decomposed variables are spread
+	 * over the tasks that perform I/O
+	 */
+	all_io_ranks = (int *)malloc(sizeof(int) * (size_t)context->comm_size);
+	if (all_io_ranks == NULL) {
+		SMIOL_free_decomp(decomp);
+		return SMIOL_MALLOC_FAILURE;
+	}
+	if (MPI_Allgather((const void *)&io_rank, 1, MPI_INT,
+	                  (void *)all_io_ranks, 1, MPI_INT,
+	                  MPI_Comm_f2c(context->fcomm)) != MPI_SUCCESS) {
+		free(all_io_ranks);
+		SMIOL_free_decomp(decomp);
+		return SMIOL_MPI_ERROR;
+	}
+	context->n_io_ranks = 0;
+	for (r = 0; r < context->comm_size; r++) {
+		if (all_io_ranks[r] >= 0) {
+			all_io_ranks[context->n_io_ranks++] = r;
+		}
+	}
+	free(context->io_ranks);
+	context->io_ranks = all_io_ranks;
+
+	/*
+	 * If I/O ranges depend on the element size, retain a copy of the
+	 * compute elements so that ranges for other element sizes can be
+	 * built as variables with those element sizes are read or written
+	 */
+	if ((*decomp)->element_size > 0) {
+		if (n_compute_elements > 0) {
+			(*decomp)->compute_elements = (SMIOL_Offset *)malloc(
+			                sizeof(SMIOL_Offset) * n_compute_elements);
+			if ((*decomp)->compute_elements == NULL) {
+				SMIOL_free_decomp(decomp);
+				return SMIOL_MALLOC_FAILURE;
+			}
+			for (i = 0; i < n_compute_elements; i++) {
+				(*decomp)->compute_elements[i] = compute_elements[i];
+			}
+		}
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * lookup_var
+ *
+ * Returns cached metadata for a variable in a file
+ *
+ * Given a pointer to a SMIOL file and the name of a variable in that file,
+ * returns in var a pointer to the metadata of the variable that is cached with
+ * the file: its library-specific ID, its type, the number and sizes of its
+ * dimensions, and whether its first dimension is the unlimited dimension. The
+ * size of the unlimited dimension, which may grow as records are written, is
+ * that at the time the metadata were cached and should not be relied on.
+ *
+ * Metadata are kept in a hash table keyed by variable name. If the variable is
+ * not found in the table, its metadata are obtained with SMIOL_inquire_var and
+ * SMIOL_inquire_dim and added to the table; the table is emptied whenever a
+ * dimension or variable is defined in the file (see free_var_meta).
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned and var is unchanged.
+ *
+ ********************************************************************************/
+int lookup_var(struct SMIOL_file *file, const char *varname,
+               struct SMIOL_var_meta **var)
+{
+	unsigned long hash;
+	const char *c;
+	char **dimnames;
+	size_t name_size;
+	struct SMIOL_var_meta *v;
+	int ierr;
+	int i;
+
+
+	/*
+	 * Journaled definitions may change the variable, so apply them first
+	 */
+	if ((ierr = apply_journal(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * Hash the variable name and search the bucket for the variable
+	 */
+	hash = 5381;
+	for (c = varname; *c != '\0'; c++) {
+		hash = hash * 33 + (unsigned long)(unsigned char)(*c);
+	}
+	hash = hash % SMIOL_VAR_META_BUCKETS;
+
+	if (file->var_meta == NULL) {
+		file->var_meta = (struct SMIOL_var_meta **)calloc(SMIOL_VAR_META_BUCKETS,
+		                                     sizeof(struct SMIOL_var_meta *));
+		if (file->var_meta == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+	}
+
+	for (v = file->var_meta[hash]; v != NULL; v = v->next) {
+		if (strcmp(v->varname, varname) == 0) {
+			*var = v;
+			return SMIOL_SUCCESS;
+		}
+	}
+
+	/*
+	 * Not found, so inquire about the variable and its dimensions
+	 */
+	v = (struct SMIOL_var_meta *)malloc(sizeof(struct SMIOL_var_meta));
+	if (v == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+	v->varname = NULL;
+	v->dimsizes = NULL;
+	v->varid = -1;
+	v->has_unlimited_dim = 0;
+	v->plans = NULL;
+	v->pending = 0;
+	v->pending_frame = 0;
+	v->prefetch = 0;
+	v->prefetch_req = -1;
+	v->prefetch_decomp_id = 0;
+	v->prefetch_frame = 0;
+	v->prefetch_buf = NULL;
+	v->prefetch_size = 0;
+
+	ierr = SMIOL_inquire_var(file, varname, &v->vartype, &v->ndims, NULL);
+	if (ierr != SMIOL_SUCCESS) {
+		free(v);
+		return ierr;
+	}
+
+	v->varname = (char *)malloc(strlen(varname) + 1);
+	v->dimsizes = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset)
+	                                     * (size_t)(v->ndims + 1));
+	dimnames = (char **)malloc(sizeof(char *) * (size_t)(v->ndims + 1));
+	if (v->varname == NULL || v->dimsizes == NULL || dimnames == NULL) {
+		free(v->varname);
+		free(v->dimsizes);
+		free(dimnames);
+		free(v);
+		return SMIOL_MALLOC_FAILURE;
+	}
+	strcpy(v->varname, varname);
+
+	/*
+	 * Dimension names are no longer than the longest name allowed by the
+	 * file libraries
+	 */
+	name_size = (size_t)NATIVE_MAX_NAME + 1;
+#ifdef SMIOL_PNETCDF
+	if ((size_t)NC_MAX_NAME + 1 > name_size) {
+		name_size = (size_t)NC_MAX_NAME + 1;
+	}
+#endif
+	for (i = 0; i < v->ndims; i++) {
+		dimnames[i] = NULL;
+	}
+	for (i = 0; i < v->ndims; i++) {
+		dimnames[i] = (char *)malloc(sizeof(char) * name_size);
+		if (dimnames[i] == NULL) {
+			ierr = SMIOL_MALLOC_FAILURE;
+			break;
+		}
+	}
+	if (ierr == SMIOL_SUCCESS) {
+		ierr = SMIOL_inquire_var(file, varname, NULL, NULL, dimnames);
+	}
+
+	/*
+	 * It is assumed that only the first dimension can be an unlimited
+	 * dimension
+	 */
+	for (i = 0; i < v->ndims && ierr == SMIOL_SUCCESS; i++) {
+		ierr = SMIOL_inquire_dim(file, dimnames[i], &v->dimsizes[i],
+		                         (i == 0) ? &v->has_unlimited_dim : NULL);
+	}
+
+	if (ierr == SMIOL_SUCCESS && file->backend == SMIOL_LIBRARY_NATIVE) {
+		native_inq_varid(file->native, varname, &v->varid);
+	}
+#ifdef SMIOL_PNETCDF
+	else if (ierr == SMIOL_SUCCESS) {
+		int nc_ierr;
+
+		if ((nc_ierr = ncmpi_inq_varid(file->ncidp, varname, &v->varid)) != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = nc_ierr;
+			ierr = SMIOL_LIBRARY_ERROR;
+		}
+	}
+#endif
+
+	for (i = 0; i < v->ndims; i++) {
+		free(dimnames[i]);
+	}
+	free(dimnames);
+
+	if (ierr != SMIOL_SUCCESS) {
+		free(v->varname);
+		free(v->dimsizes);
+		free(v);
+		return ierr;
+	}
+
+	v->next = file->var_meta[hash];
+	file->var_meta[hash] = v;
+
+	*var = v;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * free_var_meta
+ *
+ * Frees all variable metadata cached with a file
+ *
+ * Frees the hash table of variable metadata of a file, including the I/O plans
+ * of each variable, after which metadata will again be obtained from the file
+ * as variables are looked up with lookup_var.
+ *
+ ********************************************************************************/
+void free_var_meta(struct SMIOL_file *file)
+{
+	struct SMIOL_var_meta *v;
+	int i;
+
+	if (file->var_meta == NULL) {
+		return;
+	}
+
+	file->meta_epoch++;
+
+	for (i = 0; i < SMIOL_VAR_META_BUCKETS; i++) {
+		while (file->var_meta[i] != NULL) {
+			v = file->var_meta[i];
+			file->var_meta[i] = v->next;
+			while (v->plans != NULL) {
+				struct SMIOL_io_plan *p = v->plans;
+
+				v->plans = p->next;
+				free(p->start);
+				free(p->count);
+				free(p->zero_count);
+				free(p);
+			}
+			free(v->prefetch_buf);
+			free(v->varname);
+			free(v->dimsizes);
+			free(v);
+		}
+	}
+
+	free(file->var_meta);
+	file->var_meta = NULL;
+}
+
+
+/********************************************************************************
+ *
+ * get_plan
+ *
+ * Returns the I/O plan for reading or writing a variable with a decomp
+ *
+ * Given a pointer to a SMIOL file, the cached metadata of a variable in that
+ * file (see lookup_var), a decomp (or NULL for a non-decomposed variable), and
+ * either START_COUNT_READ or START_COUNT_WRITE, returns in plan the information
+ * needed to read or write the variable: the start[] and count[] arrays as
+ * MPI_Offset values, the element sizes and number of levels (see
+ * build_start_count), the decomp to be used to transfer the variable, and the
+ * size of the staging buffer for I/O.
+ *
+ * Plans are kept with the metadata of each variable, keyed by the ID of the
+ * decomp and the direction of I/O, and are built with build_start_count when
+ * first needed. For variables with a record dimension, the record index in
+ * start[] is set to the current frame of the file on every call.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int get_plan(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+             const struct SMIOL_decomp *decomp, int write_or_read,
+             struct SMIOL_io_plan **plan)
+{
+	struct SMIOL_io_plan *p;
+	size_t *start;
+	size_t *count;
+	int decomp_id;
+	int ierr;
+	int j;
+
+
+	decomp_id = (decomp != NULL) ? decomp->id : 0;
+
+	for (p = var->plans; p != NULL; p = p->next) {
+		if (p->decomp_id == decomp_id && p->write_or_read == write_or_read) {
+			break;
+		}
+	}
+
+	/*
+	 * If no plan was found, build one
+	 */
+	if (p == NULL) {
+		p = (struct SMIOL_io_plan *)malloc(sizeof(struct SMIOL_io_plan));
+		if (p == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+
+		ierr = build_start_count(file, var->varname, decomp,
+		                         write_or_read, &p->element_size, &p->ndims,
+		                         &start, &count, &p->io_decomp,
+		                         &p->io_element_size, &p->n_levels);
+		if (ierr != SMIOL_SUCCESS) {
+			free(p);
+			return ierr;
+		}
+
+		p->start = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(p->ndims + 1));
+		p->count = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(p->ndims + 1));
+		p->zero_count = (MPI_Offset *)calloc((size_t)(p->ndims + 1), sizeof(MPI_Offset));
+		if (p->start == NULL || p->count == NULL || p->zero_count == NULL) {
+			free(p->start);
+			free(p->count);
+			free(p->zero_count);
+			free(p);
+			free(start);
+			free(count);
+			return SMIOL_MALLOC_FAILURE;
+		}
+
+		for (j = 0; j < p->ndims; j++) {
+			p->start[j] = (MPI_Offset)start[j];
+			p->count[j] = (MPI_Offset)count[j];
+		}
+		free(start);
+		free(count);
+
+		p->decomp_id = decomp_id;
+		p->write_or_read = write_or_read;
+		p->has_record_dim = (var->has_unlimited_dim && p->ndims > 0);
+		p->io_bytes = 0;
+		if (decomp != NULL) {
+			p->io_bytes = p->io_element_size * p->io_decomp->io_count;
+		}
+
+		p->next = var->plans;
+		var->plans = p;
+	}
+
+	/*
+	 * Only the record index changes from one frame to the next
+	 */
+	if (p->has_record_dim) {
+		p->start[0] = (MPI_Offset)file->frame;
+	}
+
+	*plan = p;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * get_staging_buf
+ *
+ * Returns a staging buffer of at least a given size for a file
+ *
+ * Given a pointer to a SMIOL file and a size in bytes, returns in buf a buffer
+ * of at least that size. The buffer is kept with the file and reused by later
+ * reads and writes, growing as needed, until the file is closed.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int get_staging_buf(struct SMIOL_file *file, size_t size, void **buf)
+{
+	void *new_buf;
+
+	if (size > file->staging_size || file->staging_buf == NULL) {
+		new_buf = malloc(size + 1);
+		if (new_buf == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+		free(file->staging_buf);
+		file->staging_buf = new_buf;
+		file->staging_size = size;
+	}
+
+	*buf = file->staging_buf;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * write_var
+ *
+ * Writes a variable, given its cached metadata, to a file
+ *
+ * Implements SMIOL_put_var and SMIOL_put_var_h once the metadata of the
+ * variable have been found with lookup_var or through a variable handle.
+ *
+ * If the variable has been successfully written to the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int write_var(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+              const struct SMIOL_decomp *decomp, const void *buf)
+{
+	int ierr;
+	void *out_buf = NULL;
+	struct SMIOL_io_plan *plan;
+	const struct SMIOL_decomp *io_decomp;
+	size_t small_var_bytes;
+
+	/*
+	 * Get the plan, with start[] and count[] arrays, for writing this
+	 * variable in parallel with this decomp
+	 */
+	ierr = get_plan(file, var, decomp, START_COUNT_WRITE, &plan);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	io_decomp = plan->io_decomp;
+
+	/*
+	 * Writes to files with a staging store are drained to the file by its
+	 * drain thread
+	 */
+	if (file->stage != NULL) {
+		return stage_write(file, var, plan, decomp, buf);
+	}
+
+	/*
+	 * A read-ahead of this variable may no longer match the file
+	 */
+	if (var->prefetch_req != -1) {
+		ierr = drop_prefetch(file, var);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	/*
+	 * Posted writes of the same part of a variable could complete in any
+	 * order, so complete an earlier write of this variable (or of this
+	 * record of it) before posting another
+	 */
+	if (var->pending && (!plan->has_record_dim || var->pending_frame == file->frame)) {
+		ierr = SMIOL_flush_file(file);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	/*
+	 * Small non-decomposed variables are written by one task, chosen
+	 * round-robin, when the file is next flushed
+	 */
+	small_var_bytes = file->small_var_bytes;
+	if (small_var_bytes == (size_t)-1) {
+		small_var_bytes = file->context->small_var_bytes;
+	}
+	if (!decomp && plan->element_size <= small_var_bytes) {
+		return batch_small_write(file, var, plan, buf);
+	}
+
+	/*
+	 * Communicate elements of this field from MPI ranks that compute those
+	 * elements to MPI ranks that write those elements. This only needs to
+	 * be done for decomposed variables.
+	 */
+	if (decomp) {
+		/*
+		 * Deferred writes need a buffer of their own that lives until
+		 * the file is flushed
+		 */
+		if (file->deferred) {
+			out_buf = malloc(plan->io_bytes + 1);
+			if (out_buf == NULL) {
+				return SMIOL_MALLOC_FAILURE;
+			}
+		} else {
+			ierr = get_staging_buf(file, plan->io_bytes, &out_buf);
+			if (ierr != SMIOL_SUCCESS) {
+				return ierr;
+			}
+		}
+
+		if (io_decomp->io_group_size > 1) {
+			ierr = transfer_field_2d(io_decomp, SMIOL_COMP_TO_IO,
+			                         plan->element_size, plan->n_levels,
+			                         buf, out_buf);
+		} else {
+			ierr = transfer_field(io_decomp, SMIOL_COMP_TO_IO,
+			                      plan->element_size, buf, out_buf);
+		}
+		if (ierr != SMIOL_SUCCESS) {
+			if (file->deferred) {
+				free(out_buf);
+			}
+			return ierr;
+		}
+
+		/*
+		 * For decomps with halos, elements owned by no task are
+		 * written with the fill value for the type of the variable
+		 */
+		if (io_decomp->io_gap_list != NULL && io_decomp->io_gap_list[0] > 0) {
+			fill_io_gaps(io_decomp, var->vartype, plan->io_element_size,
+			             out_buf);
+		}
+	} else if (file->deferred && buf != NULL) {
+		/*
+		 * The caller may reuse buf as soon as this routine returns, so a
+		 * deferred write of a non-decomposed variable needs a copy
+		 */
+		out_buf = malloc(plan->element_size);
+		if (out_buf == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+		memcpy(out_buf, buf, plan->element_size);
+	}
+
+	/*
+	 * For deferred writes, the write is only posted; it is completed by
+	 * SMIOL_flush_file
+	 */
+	if (file->deferred) {
+		int request = -1;
+
+		if (file->backend == SMIOL_LIBRARY_NATIVE) {
+			if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+				free(out_buf);
+				return ierr;
+			}
+
+			ierr = native_iput_vara(file->native, var->varid,
+			                        plan->start, plan->count, out_buf);
+			if (ierr != NATIVE_NOERR) {
+				free(out_buf);
+				file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+				file->context->lib_ierr = ierr;
+				return SMIOL_LIBRARY_ERROR;
+			}
+		}
+#ifdef SMIOL_PNETCDF
+		else {
+			if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+				free(out_buf);
+				return ierr;
+			}
+
+			ierr = ncmpi_iput_vara(file->ncidp, var->varid,
+			                       plan->start, plan->count,
+			                       out_buf, 0, MPI_DATATYPE_NULL, &request);
+			if (ierr != NC_NOERR) {
+				free(out_buf);
+				file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+				file->context->lib_ierr = ierr;
+				return SMIOL_LIBRARY_ERROR;
+			}
+		}
+#endif
+
+		ierr = add_pending_write(file, request, out_buf);
+		if (ierr != SMIOL_SUCCESS) {
+			free(out_buf);
+			return ierr;
+		}
+		file->flush_needed = 1;
+		var->pending = 1;
+		var->pending_frame = file->frame;
+
+		return SMIOL_SUCCESS;
+	}
+
+	/*
+	 * Write out_buf; native files never modify the buffers written
+	 */
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		ierr = native_put_vara_all(file->native, var->varid,
+		                           plan->start, plan->count,
+		                           decomp ? out_buf : buf);
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#ifdef SMIOL_PNETCDF
+	else {
+		const void *buf_p;
+
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		if (decomp) {
+			buf_p = out_buf;
+		} else {
+			ierr = protect_user_buf(file, plan, buf, plan->element_size, &buf_p);
+			if (ierr != SMIOL_SUCCESS) {
+				return ierr;
+			}
+		}
+
+		ierr = ncmpi_put_vara_all(file->ncidp,
+		                          var->varid,
+		                          plan->start, plan->count,
+		                          buf_p,
+		                          0, MPI_DATATYPE_NULL);
+		if (ierr != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#endif
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * read_var
+ *
+ * Reads a variable, given its cached metadata, from a file
+ *
+ * Implements SMIOL_get_var and SMIOL_get_var_h once the metadata of the
+ * variable have been found with lookup_var or through a variable handle.
+ *
+ * If the variable has been successfully read from the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int read_var(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+             const struct SMIOL_decomp *decomp, void *buf)
+{
+	int ierr;
+	void *in_buf = NULL;
+	struct SMIOL_io_plan *plan;
+	const struct SMIOL_decomp *io_decomp;
+	struct SMIOL_context *context = file->context;
+	MPI_Comm bcast_comm = MPI_COMM_NULL;
+	int read_mode;
+
+	/*
+	 * Deferred writes must complete before the file is read
+	 */
+	ierr = SMIOL_flush_file(file);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * Get the plan, with start[] and count[] arrays, for reading this
+	 * variable in parallel with this decomp
+	 */
+	ierr = get_plan(file, var, decomp, START_COUNT_READ, &plan);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	io_decomp = plan->io_decomp;
+
+	/*
+	 * A read-ahead of any frame other than this one, or with another
+	 * decomp, is of no use
+	 */
+	if (var->prefetch_req != -1
+	    && (!plan->has_record_dim || var->prefetch_frame != file->frame
+	        || var->prefetch_decomp_id != plan->decomp_id)) {
+		ierr = drop_prefetch(file, var);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	/*
+	 * If this variable is decomposed, get a buffer into which
+	 * the variable will be read using the I/O decomposition; later,
+	 * elements this buffer will be transferred to MPI ranks that compute
+	 * on those elements
+	 */
+	if (decomp) {
+		ierr = get_staging_buf(file, plan->io_bytes, &in_buf);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		/*
+		 * If no file library provides values for the memory pointed to
+		 * by in_buf, the transfer_field call later will transfer
+		 * garbage to the output buffer; to avoid returning
+		 * non-deterministic values to the caller in this case,
+		 * initialize in_buf.
+		 */
+		if (file->backend == SMIOL_LIBRARY_UNKNOWN) {
+			memset(in_buf, 0, plan->io_bytes);
+		}
+	}
+
+	/*
+	 * If this variable is not decomposed, depending on the read mode of the
+	 * file or its context, only one task overall or one task per node may
+	 * read it, with the values then broadcast to the other tasks
+	 */
+	if (!decomp) {
+		read_mode = (file->read_mode != 0) ? file->read_mode : context->read_mode;
+		if (read_mode == SMIOL_READ_BCAST) {
+			bcast_comm = MPI_Comm_f2c(context->fcomm);
+		} else if (read_mode == SMIOL_READ_BCAST_NODE) {
+			bcast_comm = MPI_Comm_f2c(context->node_fcomm);
+		}
+	}
+
+	/*
+	 * Read in_buf
+	 */
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		int bcast_rank = 0;
+
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		if (bcast_comm != MPI_COMM_NULL) {
+			MPI_Comm_rank(bcast_comm, &bcast_rank);
+		}
+
+		ierr = native_get_vara_all(file->native, var->varid, plan->start,
+		                           (bcast_rank == 0) ? plan->count : plan->zero_count,
+		                           decomp ? in_buf : buf);
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#ifdef SMIOL_PNETCDF
+	else {
+		void *buf_p;
+		int bcast_rank = 0;
+
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		if (decomp) {
+			buf_p = in_buf;
+		} else {
+			buf_p = buf;
+		}
+
+		/*
+		 * Tasks that receive the variable by broadcast take part in the
+		 * collective read without reading anything
+		 */
+		if (bcast_comm != MPI_COMM_NULL) {
+			MPI_Comm_rank(bcast_comm, &bcast_rank);
+		}
+
+		if (var->prefetch_req != -1) {
+			/*
+			 * This frame has been read ahead; only the read-ahead
+			 * needs to be completed
+			 */
+			int status;
+
+			ierr = ncmpi_wait_all(file->ncidp, 1, &var->prefetch_req, &status);
+			var->prefetch_req = -1;
+			if (ierr == NC_NOERR) {
+				ierr = status;
+			}
+			if (ierr != NC_NOERR) {
+				file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+				file->context->lib_ierr = ierr;
+				return SMIOL_LIBRARY_ERROR;
+			}
+
+			if (decomp) {
+				in_buf = var->prefetch_buf;
+			} else if (bcast_rank == 0) {
+				memcpy(buf, var->prefetch_buf, plan->element_size);
+			}
+		} else {
+			ierr = ncmpi_get_vara_all(file->ncidp,
+			                          var->varid,
+			                          plan->start,
+			                          (bcast_rank == 0) ? plan->count : plan->zero_count,
+			                          buf_p,
+			                          0, MPI_DATATYPE_NULL);
+			if (ierr != NC_NOERR) {
+				file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+				file->context->lib_ierr = ierr;
+				return SMIOL_LIBRARY_ERROR;
+			}
+		}
+	}
+#endif
+
+	/*
+	 * Communicate elements of this field from MPI ranks that read those
+	 * elements to MPI ranks that compute those elements. This only needs to
+	 * be done for decomposed variables.
+	 */
+	if (decomp) {
+		if (io_decomp->io_group_size > 1) {
+			ierr = transfer_field_2d(io_decomp, SMIOL_IO_TO_COMP,
+			                         plan->element_size, plan->n_levels,
+			                         in_buf, buf);
+		} else {
+			ierr = transfer_field(io_decomp, SMIOL_IO_TO_COMP,
+			                      plan->element_size, in_buf, buf);
+		}
+
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	} else if (bcast_comm != MPI_COMM_NULL) {
+		ierr = bcast_bytes(buf, plan->element_size, bcast_comm);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	/*
+	 * Start reading the next frame, which can then proceed while the
+	 * caller works with this one
+	 */
+	if (var->prefetch && plan->has_record_dim) {
+		return prefetch_next_frame(file, var, plan, bcast_comm);
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * write_frames
+ *
+ * Writes several consecutive frames of a variable, given its cached metadata
+ *
+ * Implements SMIOL_put_var_frames. A single frame is simply written with
+ * write_var. Otherwise, for decomposed variables, the frames in buf are first
+ * rearranged so that all frames of each compute element are adjacent, allowing
+ * every frame to be sent to I/O tasks in one exchange with an element n_frames
+ * times larger; I/O tasks then restore the frame-by-frame order of the file
+ * before writing all frames at once. For decomps with groups of I/O tasks,
+ * which split each element by levels, frames are exchanged one at a time.
+ *
+ * If the frames have been successfully written to the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int write_frames(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                 const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                 const void *buf)
+{
+	int ierr;
+	size_t k;
+	size_t nf;
+	size_t comp_bytes;
+	void *out_buf = NULL;
+	void *comp_buf;
+	void *io_buf;
+	struct SMIOL_io_plan *plan;
+	const struct SMIOL_decomp *io_decomp;
+
+	if (n_frames < 1) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (n_frames == 1) {
+		return write_var(file, var, decomp, buf);
+	}
+
+	/*
+	 * Several frames are written directly, once any staged writes have
+	 * been written
+	 */
+	if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * Get the plan, with start[] and count[] arrays, for writing one frame
+	 * of this variable in parallel with this decomp
+	 */
+	ierr = get_plan(file, var, decomp, START_COUNT_WRITE, &plan);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	io_decomp = plan->io_decomp;
+
+	if (file->backend != SMIOL_LIBRARY_UNKNOWN && !plan->has_record_dim) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	/*
+	 * A read-ahead of this variable may no longer match the file
+	 */
+	if (var->prefetch_req != -1) {
+		ierr = drop_prefetch(file, var);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	/*
+	 * Posted writes of this variable may cover any of the frames written
+	 * here, so complete them first
+	 */
+	if (var->pending) {
+		ierr = SMIOL_flush_file(file);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	nf = (size_t)n_frames;
+
+	if (decomp) {
+		comp_bytes = plan->element_size * decomp->n_compute_elements;
+
+		ierr = get_staging_buf(file, plan->io_bytes * nf, &out_buf);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		if (io_decomp->io_group_size > 1) {
+			for (k = 0; k < nf; k++) {
+				ierr = transfer_field_2d(io_decomp, SMIOL_COMP_TO_IO,
+				                         plan->element_size, plan->n_levels,
+				                         (buf != NULL) ? (const char *)buf + k * comp_bytes : NULL,
+				                         (char *)out_buf + k * plan->io_bytes);
+				if (ierr != SMIOL_SUCCESS) {
+					return ierr;
+				}
+			}
+		} else {
+			comp_buf = malloc(comp_bytes * nf + 1);
+			io_buf = malloc(plan->io_bytes * nf + 1);
+			if (comp_buf == NULL || io_buf == NULL) {
+				free(comp_buf);
+				free(io_buf);
+				return SMIOL_MALLOC_FAILURE;
+			}
+
+			if (buf != NULL) {
+				transpose_frames(nf, decomp->n_compute_elements,
+				                 plan->element_size, buf, comp_buf);
+			}
+
+			ierr = transfer_field(io_decomp, SMIOL_COMP_TO_IO,
+			                      plan->element_size * nf, comp_buf, io_buf);
+			free(comp_buf);
+			if (ierr != SMIOL_SUCCESS) {
+				free(io_buf);
+				return ierr;
+			}
+
+			transpose_frames(io_decomp->io_count, nf, plan->element_size,
+			                 io_buf, out_buf);
+			free(io_buf);
+		}
+
+		/*
+		 * For decomps with halos, elements owned by no task are
+		 * written with the fill value for the type of the variable
+		 */
+		if (io_decomp->io_gap_list != NULL && io_decomp->io_gap_list[0] > 0) {
+			for (k = 0; k < nf; k++) {
+				fill_io_gaps(io_decomp, var->vartype, plan->io_element_size,
+				             (char *)out_buf + k * plan->io_bytes);
+			}
+		}
+	}
+
+	/*
+	 * Write out_buf, with the record count of the plan temporarily set to
+	 * the number of frames
+	 */
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		plan->count[0] = (MPI_Offset)n_frames;
+		ierr = native_put_vara_all(file->native, var->varid,
+		                           plan->start, plan->count,
+		                           decomp ? out_buf : buf);
+		plan->count[0] = 1;
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#ifdef SMIOL_PNETCDF
+	else {
+		const void *buf_p;
+
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		if (decomp) {
+			buf_p = out_buf;
+		} else {
+			ierr = protect_user_buf(file, plan, buf, plan->element_size * nf, &buf_p);
+			if (ierr != SMIOL_SUCCESS) {
+				return ierr;
+			}
+		}
+
+		plan->count[0] = (MPI_Offset)n_frames;
+		ierr = ncmpi_put_vara_all(file->ncidp,
+		                          var->varid,
+		                          plan->start, plan->count,
+		                          buf_p,
+		                          0, MPI_DATATYPE_NULL);
+		plan->count[0] = 1;
+		if (ierr != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#endif
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * read_frames
+ *
+ * Reads several consecutive frames of a variable, given its cached metadata
+ *
+ * Implements SMIOL_get_var_frames. A single frame is simply read with
+ * read_var. Otherwise, all frames are read at once, and for decomposed
+ * variables, I/O tasks rearrange the frames so that all frames of each element
+ * are adjacent before sending every frame to compute tasks in one exchange,
+ * after which compute tasks restore the frame-by-frame order in buf. For
+ * decomps with groups of I/O tasks, frames are exchanged one at a time.
+ *
+ * If the frames have been successfully read from the file, SMIOL_SUCCESS will
+ * be returned. Otherwise, an error code indicating the nature of the failure
+ * will be returned.
+ *
+ ********************************************************************************/
+int read_frames(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                void *buf)
+{
+	int ierr;
+	size_t k;
+	size_t nf;
+	size_t comp_bytes;
+	void *in_buf = NULL;
+	void *comp_buf;
+	void *io_buf;
+	struct SMIOL_io_plan *plan;
+	const struct SMIOL_decomp *io_decomp;
+	struct SMIOL_context *context = file->context;
+	MPI_Comm bcast_comm = MPI_COMM_NULL;
+	int read_mode;
+
+	if (n_frames < 1) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (n_frames == 1) {
+		return read_var(file, var, decomp, buf);
+	}
+
+	/*
+	 * Deferred writes must complete before the file is read
+	 */
+	ierr = SMIOL_flush_file(file);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * Get the plan, with start[] and count[] arrays, for reading one frame
+	 * of this variable in parallel with this decomp
+	 */
+	ierr = get_plan(file, var, decomp, START_COUNT_READ, &plan);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	io_decomp = plan->io_decomp;
+
+	if (file->backend != SMIOL_LIBRARY_UNKNOWN && !plan->has_record_dim) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	nf = (size_t)n_frames;
+
+	if (decomp) {
+		ierr = get_staging_buf(file, plan->io_bytes * nf, &in_buf);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		/*
+		 * If no file library provides values for in_buf, initialize it
+		 * so that deterministic values are returned to the caller
+		 */
+		if (file->backend == SMIOL_LIBRARY_UNKNOWN) {
+			memset(in_buf, 0, plan->io_bytes * nf);
+		}
+	} else {
+		read_mode = (file->read_mode != 0) ? file->read_mode : context->read_mode;
+		if (read_mode == SMIOL_READ_BCAST) {
+			bcast_comm = MPI_Comm_f2c(context->fcomm);
+		} else if (read_mode == SMIOL_READ_BCAST_NODE) {
+			bcast_comm = MPI_Comm_f2c(context->node_fcomm);
+		}
+	}
+
+	/*
+	 * Read in_buf, with the record count of the plan temporarily set to
+	 * the number of frames
+	 */
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		int bcast_rank = 0;
+
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		if (bcast_comm != MPI_COMM_NULL) {
+			MPI_Comm_rank(bcast_comm, &bcast_rank);
+		}
+
+		plan->count[0] = (MPI_Offset)n_frames;
+		ierr = native_get_vara_all(file->native, var->varid, plan->start,
+		                           (bcast_rank == 0) ? plan->count : plan->zero_count,
+		                           decomp ? in_buf : buf);
+		plan->count[0] = 1;
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#ifdef SMIOL_PNETCDF
+	else {
+		void *buf_p;
+		int bcast_rank = 0;
+
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+
+		if (decomp) {
+			buf_p = in_buf;
+		} else {
+			buf_p = buf;
+		}
+
+		if (bcast_comm != MPI_COMM_NULL) {
+			MPI_Comm_rank(bcast_comm, &bcast_rank);
+		}
+
+		plan->count[0] = (MPI_Offset)n_frames;
+		ierr = ncmpi_get_vara_all(file->ncidp,
+		                          var->varid,
+		                          plan->start,
+		                          (bcast_rank == 0) ? plan->count : plan->zero_count,
+		                          buf_p,
+		                          0, MPI_DATATYPE_NULL);
+		plan->count[0] = 1;
+		if (ierr != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
+		}
+	}
+#endif
+
+	if (decomp) {
+		comp_bytes = plan->element_size * decomp->n_compute_elements;
+
+		if (io_decomp->io_group_size > 1) {
+			for (k = 0; k < nf; k++) {
+				ierr = transfer_field_2d(io_decomp, SMIOL_IO_TO_COMP,
+				                         plan->element_size, plan->n_levels,
+				                         (char *)in_buf + k * plan->io_bytes,
+				                         (buf != NULL) ? (char *)buf + k * comp_bytes : NULL);
+				if (ierr != SMIOL_SUCCESS) {
+					return ierr;
+				}
+			}
+		} else {
+			comp_buf = malloc(comp_bytes * nf + 1);
+			io_buf = malloc(plan->io_bytes * nf + 1);
+			if (comp_buf == NULL || io_buf == NULL) {
+				free(comp_buf);
+				free(io_buf);
+				return SMIOL_MALLOC_FAILURE;
+			}
+
+			transpose_frames(nf, io_decomp->io_count, plan->element_size,
+			                 in_buf, io_buf);
+
+			ierr = transfer_field(io_decomp, SMIOL_IO_TO_COMP,
+			                      plan->element_size * nf, io_buf, comp_buf);
+			free(io_buf);
+			if (ierr != SMIOL_SUCCESS) {
+				free(comp_buf);
+				return ierr;
+			}
+
+			if (buf != NULL) {
+				transpose_frames(decomp->n_compute_elements, nf,
+				                 plan->element_size, comp_buf, buf);
+			}
+			free(comp_buf);
+		}
+	} else if (bcast_comm != MPI_COMM_NULL) {
+		ierr = bcast_bytes(buf, plan->element_size * nf, bcast_comm);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * resolve_var_handle
+ *
+ * Ensures that a variable handle refers to current variable metadata
+ *
+ * Given a variable handle, applies any journaled definitions in the file, then
+ * checks whether the metadata cached in the file have been dropped since the
+ * handle last looked them up (see free_var_meta), and if so, looks up the
+ * metadata of the variable again.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int resolve_var_handle(struct SMIOL_var *var)
+{
+	int ierr;
+
+	if ((ierr = apply_journal(var->file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	if (var->meta_epoch != var->file->meta_epoch) {
+		ierr = lookup_var(var->file, var->varname, &var->meta);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
+		}
+		var->meta_epoch = var->file->meta_epoch;
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * free_var_handles
+ *
+ * Frees all variable handles of a file
+ *
+ ********************************************************************************/
+void free_var_handles(struct SMIOL_file *file)
+{
+	struct SMIOL_var *h;
+
+	while (file->var_handles != NULL) {
+		h = file->var_handles;
+		file->var_handles = h->next;
+		free(h->varname);
+		free(h);
+	}
+}
+
+
+/********************************************************************************
+ *
+ * add_pending_write
+ *
+ * Records a deferred write to a file
+ *
+ * Given a pointer to a SMIOL file, the library request ID of a posted write,
+ * and the buffer holding the data of the write (or NULL), records the write so
+ * that it may be completed, and the buffer freed, by SMIOL_flush_file.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int add_pending_write(struct SMIOL_file *file, int request, void *buf)
+{
+	int *new_reqs;
+	void **new_bufs;
+	int new_max;
+
+	if (file->n_pending == file->max_pending) {
+		new_max = (file->max_pending > 0) ? 2 * file->max_pending : 16;
+
+		new_reqs = (int *)realloc(file->pending_reqs, sizeof(int) * (size_t)new_max);
+		if (new_reqs == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+		file->pending_reqs = new_reqs;
+
+		new_bufs = (void **)realloc(file->pending_bufs, sizeof(void *) * (size_t)new_max);
+		if (new_bufs == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+		file->pending_bufs = new_bufs;
+
+		file->max_pending = new_max;
+	}
+
+	file->pending_reqs[file->n_pending] = request;
+	file->pending_bufs[file->n_pending] = buf;
+	file->n_pending++;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * batch_small_write
+ *
+ * Posts the write of a small non-decomposed variable from one task
+ *
+ * Given a pointer to a SMIOL file, the cached metadata of a non-decomposed
+ * variable, its plan for writing (see get_plan), and the buffer to be written,
+ * chooses the next I/O task of the last decomp created in the file's context,
+ * in round-robin order, to write the entire variable (or MPI rank 0, if no
+ * decomp with I/O tasks has been created). As for unbatched writes, the value
+ * written is that in buf on MPI rank 0, which is sent to the chosen task; that
+ * task posts the write from a copy of the value, and the write is completed by
+ * SMIOL_flush_file. The result of posting the write is shared by all tasks, so
+ * that all tasks return the same error code. As for other writes, this routine
+ * must be called by all tasks in the file's context.
+ *
+ * Upon success, SMIOL_SUCCESS is returned. If buf is NULL on MPI rank 0 for a
+ * variable with a non-zero size, SMIOL_INVALID_ARGUMENT is returned and nothing
+ * is posted; otherwise, an error code is returned.
+ *
+ ********************************************************************************/
+int batch_small_write(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                      const struct SMIOL_io_plan *plan, const void *buf)
+{
+	struct SMIOL_context *context = file->context;
+	MPI_Comm comm = MPI_Comm_f2c(context->fcomm);
+	MPI_Status mpi_status;
+	int owner;
+	int request = -1;
+	int ierr;
+	int status[3];
+	int n_recv;
+	void *copy;
+	MPI_Offset *count;
+	int i;
+
+	owner = 0;
+	if (context->n_io_ranks > 0) {
+		i = file->next_small_owner % context->n_io_ranks;
+		owner = context->io_ranks[i];
+		file->next_small_owner = (i + 1) % context->n_io_ranks;
+	}
+
+	/*
+	 * Leaving define mode is collective, so all tasks do so before only
+	 * the owner posts its write
+	 */
+	if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * The value on MPI rank 0 is written; a NULL buf on rank 0 is sent to
+	 * the owner as an empty message
+	 */
+	status[0] = SMIOL_SUCCESS;
+	status[1] = 0;
+	status[2] = 0;
+	copy = NULL;
+	if (context->comm_rank == owner) {
+		copy = malloc(plan->element_size + 1);
+		if (copy == NULL) {
+			status[0] = SMIOL_MALLOC_FAILURE;
+		}
+	}
+	if (owner == 0) {
+		if (context->comm_rank == 0 && copy != NULL) {
+			if (buf != NULL) {
+				memcpy(copy, buf, plan->element_size);
+			} else if (plan->element_size > 0) {
+				status[0] = SMIOL_INVALID_ARGUMENT;
+			}
+		}
+	} else if (context->comm_rank == 0) {
+		if (MPI_Send((const void *)buf, (buf != NULL) ? (int)plan->element_size : 0,
+		             MPI_BYTE, owner, 0, comm) != MPI_SUCCESS) {
+			status[0] = SMIOL_MPI_ERROR;
+		}
+	} else if (context->comm_rank == owner) {
+		if (MPI_Recv((copy != NULL) ? copy : (void *)&n_recv,
+		             (copy != NULL) ? (int)plan->element_size : 0,
+		             MPI_BYTE, 0, 0, comm, &mpi_status) != MPI_SUCCESS
+		    || MPI_Get_count(&mpi_status, MPI_BYTE, &n_recv) != MPI_SUCCESS) {
+			status[0] = SMIOL_MPI_ERROR;
+		} else if (status[0] == SMIOL_SUCCESS && (size_t)n_recv != plan->element_size) {
+			status[0] = SMIOL_INVALID_ARGUMENT;
+		}
+	}
+
+	if (context->comm_rank == owner && status[0] == SMIOL_SUCCESS) {
+		/*
+		 * The plan only has non-zero counts on MPI rank 0, so build the
+		 * counts for the entire variable from its dimension sizes
+		 */
+		count = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(plan->ndims + 1));
+		if (count == NULL) {
+			status[0] = SMIOL_MALLOC_FAILURE;
+		} else {
+			for (i = 0; i < plan->ndims; i++) {
+				count[i] = (MPI_Offset)var->dimsizes[i];
+			}
+			if (plan->has_record_dim) {
+				count[0] = 1;
+			}
+
+			if (file->backend == SMIOL_LIBRARY_NATIVE) {
+				ierr = native_iput_vara(file->native, var->varid,
+				                        plan->start, count, copy);
+				if (ierr != NATIVE_NOERR) {
+					status[0] = SMIOL_LIBRARY_ERROR;
+					status[1] = SMIOL_LIBRARY_NATIVE;
+					status[2] = ierr;
+				}
+			}
+#ifdef SMIOL_PNETCDF
+			else {
+				ierr = ncmpi_iput_vara(file->ncidp, var->varid,
+				                       plan->start, count, copy,
+				                       0, MPI_DATATYPE_NULL, &request);
+				if (ierr != NC_NOERR) {
+					status[0] = SMIOL_LIBRARY_ERROR;
+					status[1] = SMIOL_LIBRARY_PNETCDF;
+					status[2] = ierr;
+				}
+			}
+#endif
+			free(count);
+		}
+
+		if (status[0] == SMIOL_SUCCESS) {
+			status[0] = add_pending_write(file, request, copy);
+		}
+		if (status[0] != SMIOL_SUCCESS) {
+			free(copy);
+		}
+	} else {
+		free(copy);
+	}
+
+	/*
+	 * Only the owner knows whether the write was posted, so all tasks
+	 * return the owner's result
+	 */
+	if (MPI_Bcast((void *)status, 3, MPI_INT, owner, comm) != MPI_SUCCESS) {
+		return SMIOL_MPI_ERROR;
+	}
+	if (status[0] == SMIOL_LIBRARY_ERROR) {
+		context->lib_type = status[1];
+		context->lib_ierr = status[2];
+	}
+	if (status[0] != SMIOL_SUCCESS) {
+		return status[0];
+	}
+
+	file->flush_needed = 1;
+	var->pending = 1;
+	var->pending_frame = file->frame;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * start_stage
+ *
+ * Sets up the staging store and drain thread of a file
+ *
+ * Given a pointer to a SMIOL file being opened with SMIOL_FILE_STAGED, creates
+ * the store that holds staged writes to the file, a duplicate of the context's
+ * communicator with which the file library is to open the file, and a thread
+ * that drains the store by writing staged data to the file (see drain_stage).
+ * The drain thread makes MPI calls while the caller makes its own, so if MPI
+ * does not provide MPI_THREAD_MULTIPLE on every task, or if the thread cannot
+ * be started on every task, no store is created, and the file is written as if
+ * it had been opened without SMIOL_FILE_STAGED. This routine must be called by
+ * all tasks in the file's context.
+ *
+ * On return, comm is the communicator with which to open the file.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned. In either case, file->stage is NULL if no store was created.
+ *
+ ********************************************************************************/
+int start_stage(struct SMIOL_file *file, MPI_Comm *comm)
+{
+	struct SMIOL_stage *stage;
+	MPI_Comm stage_comm;
+	int provided;
+	int ok;
+	int all_ok;
+
+	*comm = MPI_Comm_f2c(file->context->fcomm);
+	file->stage = NULL;
+
+	if (MPI_Query_thread(&provided) != MPI_SUCCESS) {
+		return SMIOL_MPI_ERROR;
+	}
+
+	stage = NULL;
+	if (provided == MPI_THREAD_MULTIPLE) {
+		stage = (struct SMIOL_stage *)malloc(sizeof(struct SMIOL_stage));
+	}
+	ok = (stage != NULL);
+	if (ok && pthread_mutex_init(&stage->lock, NULL) != 0) {
+		free(stage);
+		stage = NULL;
+		ok = 0;
+	}
+	if (ok && pthread_cond_init(&stage->work, NULL) != 0) {
+		pthread_mutex_destroy(&stage->lock);
+		free(stage);
+		stage = NULL;
+		ok = 0;
+	}
+	if (ok && pthread_cond_init(&stage->done, NULL) != 0) {
+		pthread_cond_destroy(&stage->work);
+		pthread_mutex_destroy(&stage->lock);
+		free(stage);
+		stage = NULL;
+		ok = 0;
+	}
+
+	if (MPI_Allreduce((const void *)&ok, (void *)&all_ok, 1, MPI_INT, MPI_MIN,
+	                  *comm) != MPI_SUCCESS) {
+		all_ok = -1;
+	}
+	if (all_ok != 1) {
+		if (stage != NULL) {
+			stage->fcomm = MPI_Comm_c2f(MPI_COMM_NULL);
+			stage->head = NULL;
+			free_stage(stage);
+		}
+		return (all_ok == -1) ? SMIOL_MPI_ERROR : SMIOL_SUCCESS;
+	}
+
+	if (MPI_Comm_dup(*comm, &stage_comm) != MPI_SUCCESS) {
+		stage->fcomm = MPI_Comm_c2f(MPI_COMM_NULL);
+		stage->head = NULL;
+		free_stage(stage);
+		return SMIOL_MPI_ERROR;
+	}
+
+	stage->file = file;
+	stage->fcomm = MPI_Comm_c2f(stage_comm);
+	stage->max_bytes = file->context->stage_bytes;
+	stage->bytes = 0;
+	stage->head = NULL;
+	stage->tail = NULL;
+	stage->stop = 0;
+	stage->lib_type = 0;
+	stage->lib_ierr = 0;
+
+	ok = (pthread_create(&stage->thread, NULL, drain_stage, (void *)stage) == 0);
+	if (MPI_Allreduce((const void *)&ok, (void *)&all_ok, 1, MPI_INT, MPI_MIN,
+	                  *comm) != MPI_SUCCESS) {
+		all_ok = -1;
+	}
+	if (all_ok != 1) {
+		if (ok) {
+			pthread_mutex_lock(&stage->lock);
+			stage->stop = 1;
+			pthread_cond_signal(&stage->work);
+			pthread_mutex_unlock(&stage->lock);
+			pthread_join(stage->thread, NULL);
+		}
+		free_stage(stage);
+		return (all_ok == -1) ? SMIOL_MPI_ERROR : SMIOL_SUCCESS;
+	}
+
+	file->stage = stage;
+	*comm = stage_comm;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * stop_stage
+ *
+ * Stops the drain thread of a file and frees its staging store
+ *
+ * Given a pointer to a SMIOL file, stops the drain thread of the file, then
+ * frees the store of staged writes and the communicator with which the file
+ * was opened. Any writes still staged are discarded, so this routine is only
+ * called once the store has been drained (see wait_stage), or when the file
+ * could not be opened, and after the file library has closed the file. If the
+ * file has no staging store, this routine has no effect.
+ *
+ ********************************************************************************/
+void stop_stage(struct SMIOL_file *file)
+{
+	struct SMIOL_stage *stage = file->stage;
+
+	if (stage == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&stage->lock);
+	stage->stop = 1;
+	pthread_cond_signal(&stage->work);
+	pthread_mutex_unlock(&stage->lock);
+	pthread_join(stage->thread, NULL);
+
+	free_stage(stage);
+	file->stage = NULL;
+}
+
+
+/********************************************************************************
+ *
+ * free_stage
+ *
+ * Frees a staging store, any writes left in it, and its communicator
+ *
+ ********************************************************************************/
+void free_stage(struct SMIOL_stage *stage)
+{
+	struct SMIOL_stage_entry *entry;
+	MPI_Comm comm;
+
+	while (stage->head != NULL) {
+		entry = stage->head;
+		stage->head = entry->next;
+		free_stage_entry(entry);
+	}
+
+	comm = MPI_Comm_f2c(stage->fcomm);
+	if (comm != MPI_COMM_NULL) {
+		MPI_Comm_free(&comm);
+	}
+
+	pthread_cond_destroy(&stage->done);
+	pthread_cond_destroy(&stage->work);
+	pthread_mutex_destroy(&stage->lock);
+	free(stage);
+}
+
+
+/********************************************************************************
+ *
+ * free_stage_entry
+ *
+ * Frees a staged write and the data it holds
+ *
+ ********************************************************************************/
+void free_stage_entry(struct SMIOL_stage_entry *entry)
+{
+	free(entry->start);
+	free(entry->count);
+	free(entry->buf);
+	free(entry);
+}
+
+
+/********************************************************************************
+ *
+ * stage_write
+ *
+ * Stages a write of a variable to a file with a staging store
+ *
+ * Given a pointer to a SMIOL file with a staging store (see start_stage), the
+ * cached metadata of a variable, its plan for writing (see get_plan), the
+ * decomp of the variable or NULL, and the buffer to be written, exchanges a
+ * decomposed variable from compute tasks to I/O tasks into memory owned by the
+ * store, or copies a non-decomposed variable on tasks that write part of it,
+ * and adds the write to the end of the store. The drain thread of the file
+ * then writes it to the file in the order in which writes were staged, so that
+ * the caller may reuse buf as soon as this routine returns. If the store
+ * already holds more than its limit (see the stage_bytes option of
+ * SMIOL_set_option), this routine first waits for the drain thread to write
+ * enough of the data in the store. As for other writes, this routine must be
+ * called by all tasks in the file's context.
+ *
+ * Errors in writing staged data to the file are returned by the next call to
+ * SMIOL_flush_file, or by any other routine that waits for the store to be
+ * drained (see wait_stage).
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int stage_write(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                const struct SMIOL_io_plan *plan,
+                const struct SMIOL_decomp *decomp, const void *buf)
+{
+	struct SMIOL_stage *stage = file->stage;
+	struct SMIOL_stage_entry *entry;
+	const struct SMIOL_decomp *io_decomp = plan->io_decomp;
+	size_t size;
+	int empty;
+	int ierr;
+	int j;
+
+	/*
+	 * A read-ahead of this variable may no longer match the file, and is
+	 * dropped once the drain thread has stopped using the file library
+	 */
+	if (var->prefetch_req != -1) {
+		if ((ierr = wait_stage(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+		if ((ierr = drop_prefetch(file, var)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+	}
+
+	/*
+	 * Only tasks with a part of a non-decomposed variable to write keep a
+	 * copy of it
+	 */
+	if (decomp) {
+		size = plan->io_bytes;
+	} else {
+		size = plan->element_size;
+		for (j = 0; j < plan->ndims; j++) {
+			if (plan->count[j] == 0) {
+				size = 0;
+			}
+		}
+	}
+
+	entry = (struct SMIOL_stage_entry *)malloc(sizeof(struct SMIOL_stage_entry));
+	if (entry == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+	entry->start = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(plan->ndims + 1));
+	entry->count = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(plan->ndims + 1));
+	entry->buf = malloc(size + 1);
+	if (entry->start == NULL || entry->count == NULL || entry->buf == NULL) {
+		free_stage_entry(entry);
+		return SMIOL_MALLOC_FAILURE;
+	}
+	for (j = 0; j < plan->ndims; j++) {
+		entry->start[j] = plan->start[j];
+		entry->count[j] = plan->count[j];
+	}
+	entry->varid = var->varid;
+	entry->size = size;
+	entry->next = NULL;
+
+	if (decomp) {
+		if (io_decomp->io_group_size > 1) {
+			ierr = transfer_field_2d(io_decomp, SMIOL_COMP_TO_IO,
+			                         plan->element_size, plan->n_levels,
+			                         buf, entry->buf);
+		} else {
+			ierr = transfer_field(io_decomp, SMIOL_COMP_TO_IO,
+			                      plan->element_size, buf, entry->buf);
+		}
+		if (ierr != SMIOL_SUCCESS) {
+			free_stage_entry(entry);
+			return ierr;
+		}
+
+		if (io_decomp->io_gap_list != NULL && io_decomp->io_gap_list[0] > 0) {
+			fill_io_gaps(io_decomp, var->vartype, plan->io_element_size,
+			             entry->buf);
+		}
+	} else if (buf != NULL) {
+		memcpy(entry->buf, buf, size);
+	} else {
+		/* As for unstaged writes, the file library is given no buffer */
+		free(entry->buf);
+		entry->buf = NULL;
+	}
+
+	/*
+	 * Definitions wait for the store to be drained, so that the file only
+	 * needs to leave define mode when the store is empty, and the drain
+	 * thread is not using the file library
+	 */
+	pthread_mutex_lock(&stage->lock);
+	empty = (stage->head == NULL);
+	pthread_mutex_unlock(&stage->lock);
+	if (empty) {
+		if ((ierr = enddef_file(file)) != SMIOL_SUCCESS) {
+			free_stage_entry(entry);
+			return ierr;
+		}
+	}
+
+	pthread_mutex_lock(&stage->lock);
+	while (stage->head != NULL && stage->bytes + entry->size > stage->max_bytes) {
+		pthread_cond_wait(&stage->done, &stage->lock);
+	}
+	if (stage->tail != NULL) {
+		stage->tail->next = entry;
+	} else {
+		stage->head = entry;
+	}
+	stage->tail = entry;
+	stage->bytes += entry->size;
+	pthread_cond_signal(&stage->work);
+	pthread_mutex_unlock(&stage->lock);
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * wait_stage
+ *
+ * Waits for the staging store of a file to be drained
+ *
+ * Given a pointer to a SMIOL file, waits until the drain thread of the file
+ * has written all staged writes, after which the file library may be used by
+ * the caller until the next write is staged. If the file has no staging
+ * store, this routine has no effect.
+ *
+ * Upon success, SMIOL_SUCCESS is returned. If any staged write failed since
+ * this routine was last called, the error of the first such write is returned.
+ *
+ ********************************************************************************/
+int wait_stage(struct SMIOL_file *file)
+{
+	struct SMIOL_stage *stage = file->stage;
+	int ierr = SMIOL_SUCCESS;
+
+	if (stage == NULL) {
+		return SMIOL_SUCCESS;
+	}
+
+	pthread_mutex_lock(&stage->lock);
+	while (stage->head != NULL) {
+		pthread_cond_wait(&stage->done, &stage->lock);
+	}
+	if (stage->lib_type != 0) {
+		file->context->lib_type = stage->lib_type;
+		file->context->lib_ierr = stage->lib_ierr;
+		stage->lib_type = 0;
+		stage->lib_ierr = 0;
+		ierr = SMIOL_LIBRARY_ERROR;
+	}
+	pthread_mutex_unlock(&stage->lock);
+
+	return ierr;
+}
+
+
+/********************************************************************************
+ *
+ * drain_stage
+ *
+ * Writes staged data to a file
+ *
+ * The body of the drain thread of a file with a staging store (see
+ * start_stage), given a pointer to the store. Staged writes are written to the
+ * file one at a time, in the order in which they were staged, with the
+ * collective write of the file library; since all tasks stage the same writes
+ * in the same order, the drain threads of all tasks take part in each write
+ * together, on the communicator with which the file was opened. Only the first
+ * error is kept, and later writes are still made so that all tasks take part
+ * in the same collective writes. The thread exits once it has been asked to
+ * stop and the store is empty.
+ *
+ * NULL is always returned.
+ *
+ ********************************************************************************/
+void *drain_stage(void *arg)
+{
+	struct SMIOL_stage *stage = (struct SMIOL_stage *)arg;
+	struct SMIOL_file *file = stage->file;
+	struct SMIOL_stage_entry *entry;
+	int lib_type;
+	int lib_ierr;
+	int ierr;
+
+	pthread_mutex_lock(&stage->lock);
+	for (;;) {
+		while (stage->head == NULL && !stage->stop) {
+			pthread_cond_wait(&stage->work, &stage->lock);
+		}
+		if (stage->head == NULL) {
+			break;
+		}
+		entry = stage->head;
+		pthread_mutex_unlock(&stage->lock);
+
+		lib_type = 0;
+		lib_ierr = 0;
+		if (file->backend == SMIOL_LIBRARY_NATIVE) {
+			ierr = native_put_vara_all(file->native, entry->varid,
+			                           entry->start, entry->count, entry->buf);
+			if (ierr != NATIVE_NOERR) {
+				lib_type = SMIOL_LIBRARY_NATIVE;
+				lib_ierr = ierr;
+			}
+		}
+#ifdef SMIOL_PNETCDF
+		else {
+			ierr = ncmpi_put_vara_all(file->ncidp, entry->varid,
+			                          entry->start, entry->count, entry->buf,
+			                          0, MPI_DATATYPE_NULL);
+			if (ierr != NC_NOERR) {
+				lib_type = SMIOL_LIBRARY_PNETCDF;
+				lib_ierr = ierr;
+			}
+		}
+#endif
+
+		pthread_mutex_lock(&stage->lock);
+		if (lib_type != 0 && stage->lib_type == 0) {
+			stage->lib_type = lib_type;
+			stage->lib_ierr = lib_ierr;
+		}
+		stage->head = entry->next;
+		if (stage->head == NULL) {
+			stage->tail = NULL;
+		}
+		stage->bytes -= entry->size;
+		free_stage_entry(entry);
+		pthread_cond_broadcast(&stage->done);
+	}
+	pthread_mutex_unlock(&stage->lock);
+
+	return NULL;
+}
+
+
+/********************************************************************************
+ *
+ * bcast_bytes
+ *
+ * Broadcasts a buffer of any size from rank 0 of a communicator
+ *
+ * Broadcasts size bytes of buf from rank 0 of comm to all other ranks of comm,
+ * in pieces small enough for the int counts of MPI_Bcast.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, SMIOL_MPI_ERROR is
+ * returned.
+ *
+ ********************************************************************************/
+int bcast_bytes(void *buf, size_t size, MPI_Comm comm)
+{
+	const size_t max_piece = (size_t)1 << 30;
+	size_t offset = 0;
+	size_t piece;
+
+	while (offset < size) {
+		piece = size - offset;
+		if (piece > max_piece) {
+			piece = max_piece;
+		}
+		if (MPI_Bcast((char *)buf + offset, (int)piece, MPI_BYTE, 0, comm) != MPI_SUCCESS) {
+			return SMIOL_MPI_ERROR;
+		}
+		offset += piece;
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * prefetch_next_frame
+ *
+ * Starts reading ahead the frame after the current frame of a variable
+ *
+ * Given a pointer to a SMIOL file, the cached metadata of a variable with a
+ * record dimension, the plan just used to read the current frame of the
+ * variable, and the communicator over which non-decomposed values are
+ * broadcast (or MPI_COMM_NULL), posts a non-blocking read of the next frame
+ * into the read-ahead buffer of the variable, reading just as the plan does.
+ * The read is completed by the next read_var call for that frame, or discarded
+ * by drop_prefetch. Nothing is read ahead past the last frame in the file,
+ * nor from native files, which have no non-blocking reads.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int prefetch_next_frame(struct SMIOL_file *file, struct SMIOL_var_meta *var,
+                        struct SMIOL_io_plan *plan, MPI_Comm bcast_comm)
+{
+#ifdef SMIOL_PNETCDF
+	int ierr;
+	int unlimdimid;
+	int bcast_rank = 0;
+	MPI_Offset n_frames;
+	size_t size;
+	void *new_buf;
+
+	if (file->backend != SMIOL_LIBRARY_PNETCDF) {
+		return SMIOL_SUCCESS;
+	}
+
+	/*
+	 * The number of frames in the file is the same on all tasks, so all
+	 * tasks agree on whether a read-ahead is pending
+	 */
+	if ((ierr = ncmpi_inq_unlimdim(file->ncidp, &unlimdimid)) != NC_NOERR
+	    || (ierr = ncmpi_inq_dimlen(file->ncidp, unlimdimid, &n_frames)) != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
 
-		mpi_start = malloc(sizeof(MPI_Offset) * (size_t)ndims);
-		if (mpi_start == NULL) {
-			free(start);
-			free(count);
+	if ((MPI_Offset)file->frame + 1 >= n_frames) {
+		return SMIOL_SUCCESS;
+	}
 
+	size = (plan->io_decomp != NULL) ? plan->io_bytes : plan->element_size;
+	if (var->prefetch_buf == NULL || size > var->prefetch_size) {
+		new_buf = malloc(size + 1);
+		if (new_buf == NULL) {
 			return SMIOL_MALLOC_FAILURE;
 		}
+		free(var->prefetch_buf);
+		var->prefetch_buf = new_buf;
+		var->prefetch_size = size;
+	}
 
-		mpi_count = malloc(sizeof(MPI_Offset) * (size_t)ndims);
-		if (mpi_count == NULL) {
-			free(start);
-			free(count);
-			free(mpi_start);
+	if (bcast_comm != MPI_COMM_NULL) {
+		MPI_Comm_rank(bcast_comm, &bcast_rank);
+	}
 
-			return SMIOL_MALLOC_FAILURE;
-		}
+	plan->start[0] = (MPI_Offset)(file->frame + 1);
+	ierr = ncmpi_iget_vara(file->ncidp, var->varid, plan->start,
+	                       (bcast_rank == 0) ? plan->count : plan->zero_count,
+	                       var->prefetch_buf, 0, MPI_DATATYPE_NULL,
+	                       &var->prefetch_req);
+	plan->start[0] = (MPI_Offset)file->frame;
+	if (ierr != NC_NOERR) {
+		var->prefetch_req = -1;
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
 
-		for (j = 0; j < ndims; j++) {
-			mpi_start[j] = (MPI_Offset)start[j];
-			mpi_count[j] = (MPI_Offset)count[j];
-		}
+	var->prefetch_frame = file->frame + 1;
+	var->prefetch_decomp_id = plan->decomp_id;
+#else
+	(void)file;
+	(void)var;
+	(void)plan;
+	(void)bcast_comm;
+#endif
 
-		ierr = ncmpi_get_vara_all(file->ncidp,
-		                          varidp,
-		                          mpi_start, mpi_count,
-		                          buf_p,
-		                          0, MPI_DATATYPE_NULL);
+	return SMIOL_SUCCESS;
+}
 
-		free(mpi_start);
-		free(mpi_count);
 
-		if (ierr != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
+/********************************************************************************
+ *
+ * drop_prefetch
+ *
+ * Discards any pending read-ahead of a variable
+ *
+ * Given a pointer to a SMIOL file and the cached metadata of a variable,
+ * completes any read-ahead of the variable without using its values. Like
+ * reads, this routine must be called by all tasks in the context of the file.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ ********************************************************************************/
+int drop_prefetch(struct SMIOL_file *file, struct SMIOL_var_meta *var)
+{
+#ifdef SMIOL_PNETCDF
+	int ierr;
+	int status;
 
-			if (decomp) {
-				free(in_buf);
-			}
-			free(start);
-			free(count);
+	if (var->prefetch_req == -1) {
+		return SMIOL_SUCCESS;
+	}
 
-			return SMIOL_LIBRARY_ERROR;
-		}
+	ierr = ncmpi_wait_all(file->ncidp, 1, &var->prefetch_req, &status);
+	var->prefetch_req = -1;
+	if (ierr != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
 	}
+#else
+	(void)file;
+	(void)var;
 #endif
 
-	/*
-	 * Free start/count arrays
-	 */
-	free(start);
-	free(count);
+	return SMIOL_SUCCESS;
+}
 
-	/*
-	 * Communicate elements of this field from MPI ranks that read those
-	 * elements to MPI ranks that compute those elements. This only needs to
-	 * be done for decomposed variables.
-	 */
-	if (decomp) {
-		ierr = transfer_field(decomp, SMIOL_IO_TO_COMP,
-		                      element_size, in_buf, buf);
-		free(in_buf);
 
-		if (ierr != SMIOL_SUCCESS) {
-			return ierr;
+/********************************************************************************
+ *
+ * drop_prefetches
+ *
+ * Discards all pending read-aheads in a file
+ *
+ * Calls drop_prefetch for every variable of a file with cached metadata, as is
+ * needed before the file is closed or switched back to define mode. All
+ * read-aheads are discarded even if one of them fails, in which case the first
+ * error is returned.
+ *
+ ********************************************************************************/
+int drop_prefetches(struct SMIOL_file *file)
+{
+	struct SMIOL_var_meta *v;
+	int ierr;
+	int first_ierr = SMIOL_SUCCESS;
+	int i;
+
+	if (file->var_meta == NULL) {
+		return SMIOL_SUCCESS;
+	}
+
+	for (i = 0; i < SMIOL_VAR_META_BUCKETS; i++) {
+		for (v = file->var_meta[i]; v != NULL; v = v->next) {
+			ierr = drop_prefetch(file, v);
+			if (ierr != SMIOL_SUCCESS && first_ierr == SMIOL_SUCCESS) {
+				first_ierr = ierr;
+			}
 		}
 	}
 
-	return SMIOL_SUCCESS;
+	return first_ierr;
 }
 
 
 /********************************************************************************
  *
- * SMIOL_define_att
+ * enddef_file
  *
- * Defines a new attribute in a file.
+ * Switches a file from define mode to data mode
  *
- * Defines a new attribute for a variable if varname is not NULL,
- * or a global attribute otherwise. The type of the attribute must be one
- * of SMIOL_REAL32, SMIOL_REAL64, SMIOL_INT32, or SMIOL_CHAR.
+ * Given a pointer to a SMIOL file, ends define mode if the file is in define
+ * mode. The first time that a file created by SMIOL leaves define mode, the
+ * header padding and alignment of the file (see SMIOL_set_header_padding and
+ * SMIOL_set_file_option) are applied; later, the layout of the file is kept, so
+ * that a header that still fits in its free space is rewritten without moving
+ * any data.
  *
- * If the attribute has been successfully defined for the variable or file,
- * SMIOL_SUCCESS is returned.
+ * Native files are laid out, and their headers written, whenever anything has
+ * been defined since they were last laid out; their header free space and
+ * variable alignment are always applied.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
  *
  ********************************************************************************/
-int SMIOL_define_att(struct SMIOL_file *file, const char *varname,
-                     const char *att_name, int att_type, const void *att)
+int enddef_file(struct SMIOL_file *file)
 {
-#ifdef SMIOL_PNETCDF
 	int ierr;
-	int varidp;
-	nc_type xtype;
-#endif
-
-	/*
-	 * Check validity of arguments
-	 */
-	if (file == NULL || att_name == NULL || att == NULL) {
-		return SMIOL_INVALID_ARGUMENT;
-	}
-
-	/*
-	 * Checks for valid attribute type are handled in library-specific
-	 * code, below
-	 */
+	struct SMIOL_context *context = file->context;
 
-#ifdef SMIOL_PNETCDF
-	/*
-	 * If varname was provided, get the variable ID; else, the attribute
-	 * is a global attribute not associated with a specific variable
-	 */
-	if (varname != NULL) {
-		ierr = ncmpi_inq_varid(file->ncidp, varname, &varidp);
-		if (ierr != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		ierr = native_enddef(file->native, file->header_free_bytes,
+		                     file->var_align_bytes);
+		if (ierr != NATIVE_NOERR) {
+			context->lib_type = SMIOL_LIBRARY_NATIVE;
+			context->lib_ierr = ierr;
 			return SMIOL_LIBRARY_ERROR;
 		}
-	} else {
-		varidp = NC_GLOBAL;
-	}
-
-	/*
-	 * Translate SMIOL variable type to parallel-netcdf type
-	 */
-	switch (att_type) {
-		case SMIOL_REAL32:
-			xtype = NC_FLOAT;
-			break;
-		case SMIOL_REAL64:
-			xtype = NC_DOUBLE;
-			break;
-		case SMIOL_INT32:
-			xtype = NC_INT;
-			break;
-		case SMIOL_CHAR:
-			xtype = NC_CHAR;
-			break;
-		default:
-			return SMIOL_INVALID_ARGUMENT;
+		return SMIOL_SUCCESS;
 	}
 
-	/*
-	 * If the file is in data mode, then switch it to define mode
-	 */
-	if (file->state == PNETCDF_DATA_MODE) {
-		if ((ierr = ncmpi_redef(file->ncidp)) != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
-			return SMIOL_LIBRARY_ERROR;
-		}
-		file->state = PNETCDF_DEFINE_MODE;
+#ifdef SMIOL_PNETCDF
+	if (file->state != PNETCDF_DEFINE_MODE) {
+		return SMIOL_SUCCESS;
 	}
 
-	/*
-	 * Add the attribute to the file
-	 */
-	if (att_type == SMIOL_CHAR) {
-		ierr = ncmpi_put_att(file->ncidp, varidp, att_name, xtype,
-		                     (MPI_Offset)strlen(att), (const char *)att);
+	if (file->pad_header) {
+		ierr = ncmpi__enddef(file->ncidp,
+		                     (MPI_Offset)file->header_free_bytes,
+		                     (MPI_Offset)file->var_align_bytes,
+		                     (MPI_Offset)file->var_free_bytes,
+		                     (MPI_Offset)file->record_align_bytes);
 	} else {
-		ierr = ncmpi_put_att(file->ncidp, varidp, att_name, xtype,
-		                     (MPI_Offset)1, (const char *)att);
+		ierr = ncmpi_enddef(file->ncidp);
 	}
 	if (ierr != NC_NOERR) {
-		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-		file->context->lib_ierr = ierr;
+		context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		context->lib_ierr = ierr;
 		return SMIOL_LIBRARY_ERROR;
 	}
+
+	file->pad_header = 0;
+	file->state = PNETCDF_DATA_MODE;
 #endif
 
 	return SMIOL_SUCCESS;
@@ -1267,122 +5992,177 @@ int SMIOL_define_att(struct SMIOL_file *file, const char *varname,
 
 /********************************************************************************
  *
- * SMIOL_inquire_att
- *
- * Inquires about an attribute in a file.
- *
- * Inquires about a variable attribute if varname is not NULL, or a global
- * attribute otherwise.
+ * redef_file
  *
- * If the requested attribute is found, SMIOL_SUCCESS is returned and the memory
- * pointed to by the att argument will contain the attribute value.
+ * Switches a file from data mode to define mode
  *
- * For character string attributes, no bytes beyond the length of the attribute
- * in the file will be modified in the att argument, and no '\0' character will
- * be added. Therefore, calling code may benefit from initializing character
- * strings before calling this routine.
+ * Given a pointer to a SMIOL file, completes any deferred writes and drops any
+ * read-aheads, then enters define mode if the file is in data mode. For files
+ * opened with SMIOL_FILE_NOFILL, the fill mode of the file is then set to
+ * no-fill. Native files have no define mode, and are laid out again when next
+ * accessed (see enddef_file).
  *
- * If SMIOL was not compiled with support for any file library, the att_type
- * output argument will always be set to SMIOL_UNKNOWN_VAR_TYPE, and the att_len
- * output argument will always be set to -1; the value of the att output
- * argument will be unchanged.
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
  *
  ********************************************************************************/
-int SMIOL_inquire_att(struct SMIOL_file *file, const char *varname,                                                                  
-                      const char *att_name, int *att_type,
-                      SMIOL_Offset *att_len, void *att)
+int redef_file(struct SMIOL_file *file)
 {
-#ifdef SMIOL_PNETCDF
 	int ierr;
-	int varidp;
-	nc_type xtypep;
-	MPI_Offset lenp;
-#endif
 
-	/*
-	 * Check validity of arguments
-	 */
-	if (file == NULL || att_name == NULL) {
-		return SMIOL_INVALID_ARGUMENT;
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if ((ierr = SMIOL_flush_file(file)) != SMIOL_SUCCESS) {
+			return ierr;
+		}
+		return drop_prefetches(file);
 	}
 
-	/*
-	 * Set output arguments in case no library sets them later
-	 */
-	if (att_len != NULL) {
-		*att_len = (SMIOL_Offset)-1;
+#ifdef SMIOL_PNETCDF
+	if (file->state != PNETCDF_DATA_MODE) {
+		return SMIOL_SUCCESS;
 	}
 
-	if (att_type != NULL) {
-		*att_type = SMIOL_UNKNOWN_VAR_TYPE;
+	if ((ierr = SMIOL_flush_file(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	if ((ierr = drop_prefetches(file)) != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	if ((ierr = ncmpi_redef(file->ncidp)) != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
 	}
+	file->state = PNETCDF_DEFINE_MODE;
 
-#ifdef SMIOL_PNETCDF
 	/*
-	 * If varname was provided, get the variable ID; else, the inquiry is
-	 * is for a global attribute not associated with a specific variable
+	 * The fill mode can only be set in define mode, so for files opened
+	 * with SMIOL_FILE_WRITE it is set here, before any new variables
+	 * are defined
 	 */
-	if (varname != NULL) {
-		ierr = ncmpi_inq_varid(file->ncidp, varname, &varidp);
-		if (ierr != NC_NOERR) {
+	if (file->nofill) {
+		int old_mode;
+
+		if ((ierr = ncmpi_set_fill(file->ncidp, NC_NOFILL, &old_mode)) != NC_NOERR) {
 			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
 			file->context->lib_ierr = ierr;
 			return SMIOL_LIBRARY_ERROR;
 		}
-	} else {
-		varidp = NC_GLOBAL;
 	}
+#endif
 
-	/*
-	 * Inquire about attribute type and length
-	 */
-	if (att_type != NULL || att_len != NULL) {
-		ierr = ncmpi_inq_att(file->ncidp, varidp, att_name,
-		                     &xtypep, &lenp);
-		if (ierr != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
-			return SMIOL_LIBRARY_ERROR;
-		}
+	return SMIOL_SUCCESS;
+}
 
-		if (att_type != NULL) {
-			/* Convert parallel-netCDF type to SMIOL type */
-			switch (xtypep) {
-				case NC_FLOAT:
-					*att_type = SMIOL_REAL32;
-					break;
-				case NC_DOUBLE:
-					*att_type = SMIOL_REAL64;
-					break;
-				case NC_INT:
-					*att_type = SMIOL_INT32;
-					break;
-				case NC_CHAR:
-					*att_type = SMIOL_CHAR;
-					break;
-				default:
-					*att_type = SMIOL_UNKNOWN_VAR_TYPE;
-			}
+
+/********************************************************************************
+ *
+ * journal_definition
+ *
+ * Records a definition in the define-phase journal of a file
+ *
+ * Given a pointer to a SMIOL file opened with SMIOL_FILE_JOURNAL, copies the
+ * arguments of a call to SMIOL_define_dim (kind DEFINE_DIM), SMIOL_define_var
+ * (kind DEFINE_VAR), or SMIOL_define_att (kind DEFINE_ATT) to a new entry at
+ * the end of the journal of the file; arguments not used by a kind of
+ * definition are ignored. Variable and attribute types are checked here, while
+ * all other errors are detected when the journal is applied (see apply_journal).
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned and the journal is unchanged.
+ *
+ ********************************************************************************/
+int journal_definition(struct SMIOL_file *file, int kind, const char *name,
+                       const char *varname, int type, SMIOL_Offset dimsize,
+                       int ndims, const char **dimnames, const void *value)
+{
+	struct SMIOL_define_entry *entry;
+	size_t value_size = 0;
+	int i;
+
+	if (kind != DEFINE_DIM) {
+		switch (type) {
+			case SMIOL_REAL32:
+				value_size = sizeof(float);
+				break;
+			case SMIOL_REAL64:
+				value_size = sizeof(double);
+				break;
+			case SMIOL_INT32:
+				value_size = sizeof(int);
+				break;
+			case SMIOL_CHAR:
+				value_size = sizeof(char);
+				if (kind == DEFINE_ATT) {
+					value_size = strlen((const char *)value) + 1;
+				}
+				break;
+			default:
+				return SMIOL_INVALID_ARGUMENT;
 		}
+	}
 
-		if (att_len != NULL) {
-			*att_len = lenp;
+	entry = (struct SMIOL_define_entry *)malloc(sizeof(struct SMIOL_define_entry));
+	if (entry == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+	entry->kind = kind;
+	entry->name = NULL;
+	entry->varname = NULL;
+	entry->type = type;
+	entry->dimsize = dimsize;
+	entry->ndims = ndims;
+	entry->dimnames = NULL;
+	entry->value = NULL;
+	entry->next = NULL;
+
+	entry->name = (char *)malloc(strlen(name) + 1);
+	if (entry->name == NULL) {
+		free_define_entry(entry);
+		return SMIOL_MALLOC_FAILURE;
+	}
+	strcpy(entry->name, name);
+
+	if (varname != NULL) {
+		entry->varname = (char *)malloc(strlen(varname) + 1);
+		if (entry->varname == NULL) {
+			free_define_entry(entry);
+			return SMIOL_MALLOC_FAILURE;
 		}
+		strcpy(entry->varname, varname);
 	}
 
+	if (kind == DEFINE_VAR && ndims > 0) {
+		entry->dimnames = (char **)calloc((size_t)ndims, sizeof(char *));
+		if (entry->dimnames == NULL) {
+			free_define_entry(entry);
+			return SMIOL_MALLOC_FAILURE;
+		}
+		for (i = 0; i < ndims; i++) {
+			entry->dimnames[i] = (char *)malloc(strlen(dimnames[i]) + 1);
+			if (entry->dimnames[i] == NULL) {
+				free_define_entry(entry);
+				return SMIOL_MALLOC_FAILURE;
+			}
+			strcpy(entry->dimnames[i], dimnames[i]);
+		}
+	}
 
-	/*
-	 * Inquire about attribute value if requested
-	 */
-	if (att != NULL) {
-		ierr = ncmpi_get_att(file->ncidp, varidp, att_name, att);
-		if (ierr != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
-			return SMIOL_LIBRARY_ERROR;
+	if (kind == DEFINE_ATT) {
+		entry->value = malloc(value_size);
+		if (entry->value == NULL) {
+			free_define_entry(entry);
+			return SMIOL_MALLOC_FAILURE;
 		}
+		memcpy(entry->value, value, value_size);
 	}
-#endif
+
+	if (file->journal_tail == NULL) {
+		file->journal_head = entry;
+	} else {
+		file->journal_tail->next = entry;
+	}
+	file->journal_tail = entry;
 
 	return SMIOL_SUCCESS;
 }
@@ -1390,317 +6170,463 @@ int SMIOL_inquire_att(struct SMIOL_file *file, const char *varname,
 
 /********************************************************************************
  *
- * SMIOL_sync_file
+ * apply_journal
  *
- * Forces all in-memory data to be flushed to disk.
+ * Defines in a file all definitions recorded in its define-phase journal
  *
- * Upon success, all in-memory data for the file associatd with the file
- * handle will be flushed to the file system and SMIOL_SUCCESS will be
- * returned; otherwise, an error code is returned.
+ * Given a pointer to a SMIOL file, passes each journaled definition, in the
+ * order in which they were recorded, to the file library, entering define mode
+ * at most once, and empties the journal. Cached variable metadata are dropped
+ * by the first definition, and are looked up again as needed afterward. If
+ * there are no journaled definitions, this routine has no effect.
+ *
+ * Upon success, SMIOL_SUCCESS is returned. Otherwise, the error code of the
+ * first definition that failed is returned, and that definition and all
+ * definitions recorded after it are discarded.
  *
  ********************************************************************************/
-int SMIOL_sync_file(struct SMIOL_file *file)
+int apply_journal(struct SMIOL_file *file)
 {
-#ifdef SMIOL_PNETCDF
-	int ierr;
-#endif
+	struct SMIOL_define_entry *entry;
+	int ierr = SMIOL_SUCCESS;
 
-	/*
-	 * Check that file is valid
-	 */
-	if (file == NULL) {
-		return SMIOL_INVALID_ARGUMENT;
+	if (file->journal_head == NULL) {
+		return SMIOL_SUCCESS;
 	}
 
-#ifdef SMIOL_PNETCDF
 	/*
-	 * If the file is in define mode then switch it into data mode
+	 * With journaling disabled, the define routines below go directly to the
+	 * file library
 	 */
-	if (file->state == PNETCDF_DEFINE_MODE) {
-		if ((ierr = ncmpi_enddef(file->ncidp)) != NC_NOERR) {
-			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-			file->context->lib_ierr = ierr;
-			return SMIOL_LIBRARY_ERROR;
+	file->journal = 0;
+
+	for (entry = file->journal_head; entry != NULL && ierr == SMIOL_SUCCESS;
+	     entry = entry->next) {
+		switch (entry->kind) {
+			case DEFINE_DIM:
+				ierr = SMIOL_define_dim(file, entry->name, entry->dimsize);
+				break;
+			case DEFINE_VAR:
+				ierr = SMIOL_define_var(file, entry->name, entry->type, entry->ndims,
+				                        (const char **)entry->dimnames);
+				break;
+			case DEFINE_ATT:
+				ierr = SMIOL_define_att(file, entry->varname, entry->name,
+				                        entry->type, entry->value);
+				break;
 		}
-		file->state = PNETCDF_DATA_MODE;
 	}
 
-	if ((ierr = ncmpi_sync(file->ncidp)) != NC_NOERR) {
-		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
-		file->context->lib_ierr = ierr;
-		return SMIOL_LIBRARY_ERROR;
-	}
-#endif
+	file->journal = 1;
+	free_journal(file);
 
-	return SMIOL_SUCCESS;
+	return ierr;
 }
 
 
 /********************************************************************************
  *
- * SMIOL_error_string
- *
- * Returns an error string for a specified error code.
+ * free_define_entry
  *
- * Returns an error string corresponding to a SMIOL error code. If the error code is
- * SMIOL_LIBRARY_ERROR and a valid SMIOL context is available, the SMIOL_lib_error_string
- * function should be called instead. The error string is null-terminated, but it
- * does not contain a newline character.
+ * Frees a journaled definition and all memory that it owns
  *
  ********************************************************************************/
-const char *SMIOL_error_string(int errno)
+void free_define_entry(struct SMIOL_define_entry *entry)
 {
-	switch (errno) {
-	case SMIOL_SUCCESS:
-		return "Success!";
-	case SMIOL_MALLOC_FAILURE:
-		return "malloc returned a null pointer";
-	case SMIOL_INVALID_ARGUMENT:
-		return "invalid subroutine argument";
-	case SMIOL_MPI_ERROR:
-		return "internal MPI call failed";
-	case SMIOL_FORTRAN_ERROR:
-		return "Fortran wrapper detected an inconsistency in C return values";
-	case SMIOL_LIBRARY_ERROR:
-		return "bad return code from a library call";
-	case SMIOL_WRONG_ARG_TYPE:
-		return "argument is of the wrong type";
-	case SMIOL_INSUFFICIENT_ARG:
-		return "argument is of insufficient size";
-	default:
-		return "Unknown error";
+	int i;
+
+	if (entry->dimnames != NULL) {
+		for (i = 0; i < entry->ndims; i++) {
+			free(entry->dimnames[i]);
+		}
 	}
+	free(entry->dimnames);
+	free(entry->name);
+	free(entry->varname);
+	free(entry->value);
+	free(entry);
 }
 
 
 /********************************************************************************
  *
- * SMIOL_lib_error_string
- *
- * Returns an error string for a third-party library called by SMIOL.
+ * free_journal
  *
- * Returns an error string corresponding to an error that was generated by
- * a third-party library that was called by SMIOL. The library that was the source
- * of the error, as well as the library-specific error code, are retrieved from
- * a SMIOL context. If successive library calls resulted in errors, only the error
- * string for the last of these errors will be returned. The error string is
- * null-terminated, but it does not contain a newline character.
+ * Discards all journaled definitions of a file
  *
  ********************************************************************************/
-const char *SMIOL_lib_error_string(struct SMIOL_context *context)
+void free_journal(struct SMIOL_file *file)
 {
-	if (context == NULL) {
-		return "SMIOL_context argument is a NULL pointer";
-	}
+	struct SMIOL_define_entry *entry;
 
-	switch (context->lib_type) {
-#ifdef SMIOL_PNETCDF
-	case SMIOL_LIBRARY_PNETCDF:
-		return ncmpi_strerror(context->lib_ierr);
-#endif
-	default:
-		return "Could not find matching library for the source of the error";
+	while (file->journal_head != NULL) {
+		entry = file->journal_head;
+		file->journal_head = entry->next;
+		free_define_entry(entry);
 	}
+	file->journal_tail = NULL;
 }
 
 
 /********************************************************************************
  *
- * SMIOL_set_option
+ * find_option
  *
- * Sets an option for the SMIOL library.
+ * Returns the description of an option, given its name
  *
- * Detailed description.
+ * Given the name of an option, returns a pointer to its entry in
+ * smiol_options, or NULL if there is no option with that name.
  *
  ********************************************************************************/
-int SMIOL_set_option(void)
+const struct SMIOL_option *find_option(const char *name)
 {
-	return SMIOL_SUCCESS;
+	const struct SMIOL_option *option;
+
+	for (option = smiol_options; option->name != NULL; option++) {
+		if (strcmp(option->name, name) == 0) {
+			return option;
+		}
+	}
+
+	return NULL;
 }
 
+
 /********************************************************************************
  *
- * SMIOL_set_frame
+ * parse_option
  *
- * Set the frame for the unlimited dimension for an open file
+ * Checks the value of an option against the type of the option
  *
- * For an open SMIOL file handle, set the frame for the unlimited dimension.
- * After setting the frame for a file, writing to a variable that is
- * dimensioned by the unlimited dimension will write to the last set frame,
- * overwriting any current data that maybe present in that frame.
+ * Given the description of an option and a value as a string, checks that the
+ * value is a positive decimal integer (OPTION_TYPE_INT), a non-negative
+ * decimal integer (OPTION_TYPE_SIZE), or one of the keywords of the option
+ * (OPTION_TYPE_ENUM). Upon success, size_value is set to the value of an
+ * integer option, or to the position of the keyword among the keywords of an
+ * enumerated option, starting from zero.
  *
- * SMIOL_SUCCESS will be returned if the frame is successfully set otherwise an
- * error will return.
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, SMIOL_INVALID_ARGUMENT is
+ * returned and size_value is unchanged.
  *
  ********************************************************************************/
-int SMIOL_set_frame(struct SMIOL_file *file, SMIOL_Offset frame)
+int parse_option(const struct SMIOL_option *option, const char *value,
+                 size_t *size_value)
 {
-	if (file == NULL) {
+	const char *v;
+	const char *end;
+	size_t len;
+	size_t index;
+	size_t n;
+
+	if (option->type == OPTION_TYPE_ENUM) {
+		len = strlen(value);
+		index = 0;
+		for (v = option->values; ; index++) {
+			end = strchr(v, '|');
+			n = (end != NULL) ? (size_t)(end - v) : strlen(v);
+			if (n == len && strncmp(v, value, len) == 0) {
+				*size_value = index;
+				return SMIOL_SUCCESS;
+			}
+			if (end == NULL) {
+				return SMIOL_INVALID_ARGUMENT;
+			}
+			v = end + 1;
+		}
+	}
+
+	/*
+	 * Integer options, checked for overflow digit by digit
+	 */
+	if (*value == '\0') {
 		return SMIOL_INVALID_ARGUMENT;
 	}
-	file->frame = frame;
-	return SMIOL_SUCCESS;
-}
+	n = 0;
+	for (v = value; *v != '\0'; v++) {
+		if (!isdigit((unsigned char)*v)) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		if (n > ((size_t)-1 - (size_t)(*v - '0')) / 10) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		n = n * 10 + (size_t)(*v - '0');
+	}
 
-/********************************************************************************
- *
- * SMIOL_get_frame
- *
- * Return the current frame of an open file
- *
- * Get the current frame of an open file. Upon success, SMIOL_SUCCESS will be
- * returned, otherwise an error will be returned.
- *
- ********************************************************************************/
-int SMIOL_get_frame(struct SMIOL_file *file, SMIOL_Offset *frame)
-{
-	if (file == NULL || frame == NULL) {
+	if (option->type == OPTION_TYPE_INT && (n == 0 || n > (size_t)2147483647)) {
 		return SMIOL_INVALID_ARGUMENT;
 	}
-	*frame = file->frame;
+
+	*size_value = n;
+
 	return SMIOL_SUCCESS;
 }
 
 
-/*******************************************************************************
+/********************************************************************************
  *
- * SMIOL_create_decomp
+ * set_option
  *
- * Creates a mapping between compute elements and I/O elements.
+ * Sets an option for a context or for a single file
  *
- * Given arrays of global element IDs that each task computes, the number of I/O
- * tasks, and the stride between I/O tasks, this routine works out a mapping of
- * elements between compute and I/O tasks.
+ * Given a context, a file in that context or NULL, the description of an
+ * option, and a value for the option, checks the value (see parse_option) and
+ * sets the option for the file if file is not NULL, or otherwise for the
+ * context.
  *
- * If all input arguments are determined to be valid and if the routine is
- * successful in working out a mapping, the decomp pointer is allocated and
- * given valid contents, and SMIOL_SUCCESS is returned; otherwise a non-success
- * error code is returned and the decomp pointer is NULL.
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned and the context and file are unchanged.
  *
- *******************************************************************************/
-int SMIOL_create_decomp(struct SMIOL_context *context,
-                        size_t n_compute_elements, SMIOL_Offset *compute_elements,
-                        int num_io_tasks, int io_stride,
-                        struct SMIOL_decomp **decomp)
+ ********************************************************************************/
+int set_option(struct SMIOL_context *context, struct SMIOL_file *file,
+               const struct SMIOL_option *option, const char *value)
 {
-	size_t i;
-	size_t n_io_elements, n_io_elements_global;
-	size_t io_start, io_count;
-	SMIOL_Offset *io_elements;
-	MPI_Comm comm;
-	MPI_Datatype dtype;
+	const int read_modes[3] = { SMIOL_READ_ALL, SMIOL_READ_BCAST, SMIOL_READ_BCAST_NODE };
+	const int placements[2] = { SMIOL_IO_PLACEMENT_STRIDE, SMIOL_IO_PLACEMENT_NODE };
+	const int partitions[2] = { SMIOL_IO_PARTITION_ELEMENTS, SMIOL_IO_PARTITION_BYTES };
+	MPI_Info info;
+	size_t n;
 	int ierr;
 
+	ierr = parse_option(option, value, &n);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
 
 	/*
-	 * Minimal check on the validity of arguments
+	 * Only file settings may be set for a single file
 	 */
-	if (context == NULL) {
-		return SMIOL_INVALID_ARGUMENT;
-	}
+	if (file != NULL) {
+		switch (option->id) {
+			case OPTION_SMALL_VAR_BYTES:
+				file->small_var_bytes = n;
+				break;
+			case OPTION_READ_MODE:
+				file->read_mode = read_modes[n];
+				break;
+			case OPTION_HEADER_FREE_BYTES:
+				file->header_free_bytes = n;
+				file->pad_header = 1;
+				break;
+			case OPTION_VAR_ALIGN_BYTES:
+				file->var_align_bytes = n;
+				file->pad_header = 1;
+				break;
+			case OPTION_VAR_FREE_BYTES:
+				file->var_free_bytes = n;
+				file->pad_header = 1;
+				break;
+			case OPTION_RECORD_ALIGN_BYTES:
+				file->record_align_bytes = n;
+				file->pad_header = 1;
+				break;
+			default:
+				return SMIOL_INVALID_ARGUMENT;
+		}
 
-	if (compute_elements == NULL && n_compute_elements != 0) {
-		return SMIOL_INVALID_ARGUMENT;
+		return SMIOL_SUCCESS;
 	}
 
-	comm = MPI_Comm_f2c(context->fcomm);
-
-	/*
-	 * Figure out MPI_Datatype for size_t... there must be a better way...
-	 */
-	switch (sizeof(size_t)) {
-		case sizeof(uint64_t):
-			dtype = MPI_UINT64_T;
+	switch (option->id) {
+		case OPTION_HINT:
+			info = MPI_Info_f2c(context->finfo);
+			if (MPI_Info_set(info, option->name, value) != MPI_SUCCESS) {
+				return SMIOL_MPI_ERROR;
+			}
+			break;
+		case OPTION_SMALL_VAR_BYTES:
+			return SMIOL_set_small_var_batching(context, n);
+		case OPTION_READ_MODE:
+			return SMIOL_set_read_mode(context, read_modes[n]);
+		case OPTION_HEADER_FREE_BYTES:
+			context->header_free_bytes = n;
+			break;
+		case OPTION_VAR_ALIGN_BYTES:
+			context->var_align_bytes = n;
+			break;
+		case OPTION_VAR_FREE_BYTES:
+			context->var_free_bytes = n;
+			break;
+		case OPTION_RECORD_ALIGN_BYTES:
+			context->record_align_bytes = n;
+			break;
+		case OPTION_IO_PLACEMENT:
+			return SMIOL_set_io_placement(context, placements[n],
+			                              context->io_tasks_per_node);
+		case OPTION_IO_TASKS_PER_NODE:
+			if (n > (size_t)2147483647) {
+				return SMIOL_INVALID_ARGUMENT;
+			}
+			return SMIOL_set_io_placement(context, context->io_placement, (int)n);
+		case OPTION_IO_PARTITION:
+			return SMIOL_set_io_partition(context, partitions[n]);
+		case OPTION_IO_VERTICAL_BLOCKS:
+			return SMIOL_set_io_vertical_blocks(context, (int)n);
+		case OPTION_IO_ALIGN_BYTES:
+			return SMIOL_set_io_alignment(context, n, context->io_align_element_size);
+		case OPTION_IO_ALIGN_ELEMENT_SIZE:
+			return SMIOL_set_io_alignment(context, context->io_align_bytes, n);
+		case OPTION_FILE_LIBRARY:
+			if (n == 0) {
+#ifdef SMIOL_PNETCDF
+				context->file_library = SMIOL_LIBRARY_PNETCDF;
+#else
+				return SMIOL_INVALID_ARGUMENT;
+#endif
+			} else if (n == 1) {
+				context->file_library = SMIOL_LIBRARY_NATIVE;
+			} else {
+				context->file_library = SMIOL_LIBRARY_NULL;
+			}
 			break;
-		case sizeof(uint32_t):
-			dtype = MPI_UINT32_T;
+		case OPTION_SUBFILES:
+			if (n > (size_t)2147483647) {
+				return SMIOL_INVALID_ARGUMENT;
+			}
+			context->n_subfiles = (int)n;
 			break;
-		case sizeof(uint16_t):
-			dtype = MPI_UINT16_T;
+		case OPTION_STAGE_BYTES:
+			context->stage_bytes = n;
 			break;
 		default:
-			return SMIOL_MPI_ERROR;
+			return SMIOL_INVALID_ARGUMENT;
 	}
 
-	/*
-	 * Based on the number of compute elements for each task, determine
-	 * the total number of elements across all tasks for I/O. The assumption
-	 * is that the number of elements to read/write is equal to the size of
-	 * the set of compute elements.
-	 */
-	n_io_elements = n_compute_elements;
-	if (MPI_SUCCESS != MPI_Allreduce((const void *)&n_io_elements,
-	                                 (void *)&n_io_elements_global,
-	                                 1, dtype, MPI_SUM, comm)) {
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * set_env_options
+ *
+ * Sets the options of a context that are given by environment variables
+ *
+ * For each option in smiol_options, checks for an environment variable named
+ * SMIOL_ followed by the name of the option in upper case, and if it is set,
+ * sets the option for the context to the value of that variable. Variables
+ * with values that are not valid for their option are ignored.
+ *
+ ********************************************************************************/
+void set_env_options(struct SMIOL_context *context)
+{
+	const struct SMIOL_option *option;
+	char env_name[64];
+	const char *value;
+	size_t i;
+
+	for (option = smiol_options; option->name != NULL; option++) {
+		strcpy(env_name, "SMIOL_");
+		for (i = 0; option->name[i] != '\0'; i++) {
+			env_name[6 + i] = (char)toupper((unsigned char)option->name[i]);
+		}
+		env_name[6 + i] = '\0';
+
+		value = getenv(env_name);
+		if (value != NULL) {
+			(void)set_option(context, NULL, option, value);
+		}
+	}
+}
+
+
+#ifdef SMIOL_PNETCDF
+/********************************************************************************
+ *
+ * get_open_info
+ *
+ * Builds the MPI_Info object of hints with which a file is opened
+ *
+ * Given a SMIOL context, returns in info a copy of the hints of the context
+ * (see SMIOL_set_option), to be freed by the caller with MPI_Info_free. If the
+ * nc_in_place_swap hint has not been set for the context, it is set to
+ * "enable" in the copy. On return, in_place_swap is 1 if the file library may
+ * byte-swap write buffers in place -- that is, if this task is little-endian
+ * and in-place swapping was not disabled -- and 0 otherwise.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned and no info object needs to be freed.
+ *
+ ********************************************************************************/
+int get_open_info(struct SMIOL_context *context, MPI_Info *info,
+                  int *in_place_swap)
+{
+	char value[MPI_MAX_INFO_VAL + 1];
+	int flag;
+	union {
+		int i;
+		char c[sizeof(int)];
+	} endian;
+
+	if (MPI_Info_dup(MPI_Info_f2c(context->finfo), info) != MPI_SUCCESS) {
 		return SMIOL_MPI_ERROR;
 	}
 
-	/*
-	 * Determine the contiguous range of elements to be read/written by
-	 * this MPI task
-	 */
-	ierr = get_io_elements(context->comm_rank, num_io_tasks, io_stride,
-	                       n_io_elements_global, &io_start, &io_count);
+	if (MPI_Info_get(*info, "nc_in_place_swap", MPI_MAX_INFO_VAL, value,
+	                 &flag) != MPI_SUCCESS) {
+		MPI_Info_free(info);
+		return SMIOL_MPI_ERROR;
+	}
 
-	/*
-	 * Fill in io_elements from io_start through io_start + io_count - 1
-	 */
-	io_elements = NULL;
-	if (io_count > 0) {
-		io_elements = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset)
-		                                     * n_io_elements_global);
-		if (io_elements == NULL) {
-			return SMIOL_MALLOC_FAILURE;
-		}
-		for (i = 0; i < io_count; i++) {
-			io_elements[i] = (SMIOL_Offset)(io_start + i);
+	if (!flag) {
+		if (MPI_Info_set(*info, "nc_in_place_swap", "enable") != MPI_SUCCESS) {
+			MPI_Info_free(info);
+			return SMIOL_MPI_ERROR;
 		}
 	}
 
 	/*
-	 * Build the mapping between compute tasks and I/O tasks
-	 */
-	ierr = build_exchange(context,
-	                      n_compute_elements, compute_elements,
-	                      io_count, io_elements,
-	                      decomp);
-
-	free(io_elements);
-
-	/*
-	 * If decomp was successfully created, add io_start and io_count values
-	 * to the decomp before returning
+	 * Files are big-endian, so only little-endian tasks swap bytes at all
 	 */
-	if (ierr == SMIOL_SUCCESS) {
-		(*decomp)->io_start = io_start;
-		(*decomp)->io_count = io_count;
-	}
+	endian.i = 1;
+	*in_place_swap = (endian.c[0] == 1) && (!flag || strcmp(value, "disable") != 0);
 
-	return ierr;
+	return SMIOL_SUCCESS;
 }
+#endif
 
 
 /********************************************************************************
  *
- * SMIOL_free_decomp
+ * protect_user_buf
  *
- * Frees a mapping between compute elements and I/O elements.
+ * Returns a buffer from which a non-decomposed variable may be written
  *
- * Free all memory of a SMIOL_decomp and returns SMIOL_SUCCESS. If decomp
- * points to NULL, then do nothing and return SMIOL_SUCCESS. After this routine
- * is called, no other SMIOL routines should use the freed SMIOL_decomp.
+ * Given a pointer to a SMIOL file, the plan for writing a non-decomposed
+ * variable, and a caller buffer of size bytes holding the values to be
+ * written, returns in buf_p a buffer that the file library may modify while
+ * writing. If the file library may byte-swap buffers in place and this task
+ * writes part of the variable, the values are copied to the staging buffer of
+ * the file; otherwise, buf_p is simply buf.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
  *
  ********************************************************************************/
-int SMIOL_free_decomp(struct SMIOL_decomp **decomp)
+int protect_user_buf(struct SMIOL_file *file, const struct SMIOL_io_plan *plan,
+                     const void *buf, size_t size, const void **buf_p)
 {
-	if ((*decomp) == NULL) {
+	void *staging;
+	int ierr;
+	int i;
+
+	*buf_p = buf;
+
+	if (!file->in_place_swap || buf == NULL || size == 0) {
 		return SMIOL_SUCCESS;
 	}
 
-	free((*decomp)->comp_list);
-	free((*decomp)->io_list);
-	free((*decomp));
-	*decomp = NULL;
+	for (i = 0; i < plan->ndims; i++) {
+		if (plan->count[i] == 0) {
+			return SMIOL_SUCCESS;
+		}
+	}
+
+	ierr = get_staging_buf(file, size, &staging);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+	memcpy(staging, buf, size);
+	*buf_p = staging;
 
 	return SMIOL_SUCCESS;
 }
@@ -1708,206 +6634,260 @@ int SMIOL_free_decomp(struct SMIOL_decomp **decomp)
 
 /********************************************************************************
  *
- * build_start_count
- *
- * Constructs start[] and count[] arrays for parallel I/O operations
- *
- * Given a pointer to a SMIOL file that was previously opened, the name of
- * a variable in that file, and a SMIOL decomp, this function returns three
- * items that may be used when reading or writing the variable in parallel:
- *
- * 1) The size of each "element" of the variable, where an element is defined as
- *    a contiguous memory range associated with the slowest-varying, non-record
- *    dimension of the variable; for example, a variable
- *    float foo[nCells][nVertLevels] would have an element size of
- *    sizeof(float) * nVertLevels if nCells were a decomposed dimension.
- *
- *    For non-decomposed variables, the element size is the size of one record
- *    of the entire variable.
+ * put_att
  *
- * 2) The number of dimensions for the variable, including any unlimited/record
- *    dimension.
- *
- * 3) The start[] and count[] arrays (each with size ndims) to be read or written
- *    by an MPI rank using the I/O decomposition described in decomp.
+ * Defines an attribute with any number of values in a file
  *
- * If the decomp argument is NULL, the variable is to be read or written as
- * a non-decomposed variable; typically, only MPI rank 0 will write
- * the non-decomposed variable, and all MPI ranks will read the non-decomposed
- * variable.
+ * Implements SMIOL_define_att once any journal and staged writes have been
+ * dealt with: given a pointer to a SMIOL file, the name of a variable or NULL
+ * for a global attribute, and the name and type of the attribute, defines the
+ * attribute with the file library to hold len values from att.
  *
- * Depending on the value of the write_or_read argument -- either START_COUNT_READ
- * or START_COUNT_WRITE -- the count[] values will be set so that all ranks will
- * read the variable, or only rank 0 will write the variable.
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned.
  *
  ********************************************************************************/
-int build_start_count(struct SMIOL_file *file, const char *varname,
-                      const struct SMIOL_decomp *decomp,
-                      int write_or_read, size_t *element_size, int *ndims,
-                      size_t **start, size_t **count)
+int put_att(struct SMIOL_file *file, const char *varname, const char *att_name,
+            int att_type, size_t len, const void *att)
 {
-	int i;
 	int ierr;
-	int vartype;
-	char **dimnames;
-	SMIOL_Offset *dimsizes;
-	int has_unlimited_dim = 0;
-
-/* TO DO - define maximum string size, currently assumed to be 64 chars */
-
-	/*
-	 * Figure out type of the variable, as well as its dimensions
-	 */
-	ierr = SMIOL_inquire_var(file, varname, &vartype, ndims, NULL);
-	if (ierr != SMIOL_SUCCESS) {
-		return ierr;
-	}
-
-	dimnames = malloc(sizeof(char *) * (size_t)(*ndims));
-        if (dimnames == NULL) {
-		ierr = SMIOL_MALLOC_FAILURE;
-		return ierr;
-	}
+	int varidp;
+#ifdef SMIOL_PNETCDF
+	nc_type xtype;
+#endif
 
-	for (i = 0; i < *ndims; i++) {
-		dimnames[i] = malloc(sizeof(char) * (size_t)64);
-	        if (dimnames[i] == NULL) {
-			int j;
+	if (file->backend == SMIOL_LIBRARY_NATIVE) {
+		if (att_type != SMIOL_REAL32 && att_type != SMIOL_REAL64
+		    && att_type != SMIOL_INT32 && att_type != SMIOL_CHAR) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
 
-			for (j = 0; j < i; j++) {
-				free(dimnames[j]);
+		ierr = NATIVE_NOERR;
+		varidp = NATIVE_GLOBAL;
+		if (varname != NULL) {
+			ierr = native_inq_varid(file->native, varname, &varidp);
+		}
+		if (ierr == NATIVE_NOERR) {
+			if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
+				return ierr;
 			}
-			free(dimnames);
-
-			ierr = SMIOL_MALLOC_FAILURE;
-			return ierr;
+			ierr = native_put_att(file->native, varidp, att_name, att_type,
+			                      len, att);
 		}
-	}
-
-	ierr = SMIOL_inquire_var(file, varname, NULL, NULL, dimnames);
-	if (ierr != SMIOL_SUCCESS) {
-		for (i = 0; i < *ndims; i++) {
-			free(dimnames[i]);
+		if (ierr != NATIVE_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_NATIVE;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
 		}
-		free(dimnames);
-		return ierr;
-	}
-	
-	dimsizes = malloc(sizeof(SMIOL_Offset) * (size_t)(*ndims));
-        if (dimsizes == NULL) {
-		ierr = SMIOL_MALLOC_FAILURE;
-		return ierr;
+		return SMIOL_SUCCESS;
 	}
 
+#ifdef SMIOL_PNETCDF
 	/*
-	 * It is assumed that only the first dimension can be an unlimited
-	 * dimension, so by inquiring about dimensions from last to first, we
-	 * can be guaranteed that has_unlimited_dim will be set correctly at
-	 * the end of the loop over dimensions
+	 * If varname was provided, get the variable ID; else, the attribute
+	 * is a global attribute not associated with a specific variable
 	 */
-	for (i = (*ndims-1); i >= 0; i--) {
-		ierr = SMIOL_inquire_dim(file, dimnames[i], &dimsizes[i],
-		                         &has_unlimited_dim);
-		if (ierr != SMIOL_SUCCESS) {
-			for (i = 0; i < *ndims; i++) {
-				free(dimnames[i]);
-			}
-			free(dimnames);
-			free(dimsizes);
-
-			return ierr;
+	if (varname != NULL) {
+		ierr = ncmpi_inq_varid(file->ncidp, varname, &varidp);
+		if (ierr != NC_NOERR) {
+			file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+			file->context->lib_ierr = ierr;
+			return SMIOL_LIBRARY_ERROR;
 		}
+	} else {
+		varidp = NC_GLOBAL;
 	}
 
-	for (i = 0; i < *ndims; i++) {
-		free(dimnames[i]);
-	}
-	free(dimnames);
-
 	/*
-	 * Set basic size of each element in the field
+	 * Translate SMIOL variable type to parallel-netcdf type
 	 */
-	*element_size = 1;
-	switch (vartype) {
+	switch (att_type) {
 		case SMIOL_REAL32:
-			*element_size = sizeof(float);
+			xtype = NC_FLOAT;
 			break;
 		case SMIOL_REAL64:
-			*element_size = sizeof(double);
+			xtype = NC_DOUBLE;
 			break;
 		case SMIOL_INT32:
-			*element_size = sizeof(int);
+			xtype = NC_INT;
 			break;
 		case SMIOL_CHAR:
-			*element_size = sizeof(char);
+			xtype = NC_CHAR;
 			break;
+		default:
+			return SMIOL_INVALID_ARGUMENT;
 	}
 
-	*start = malloc(sizeof(size_t) * (size_t)(*ndims));
-        if (*start == NULL) {
-		free(dimsizes);
-		ierr = SMIOL_MALLOC_FAILURE;
-		return ierr;
-	}
-
-	*count = malloc(sizeof(size_t) * (size_t)(*ndims));
-        if (*count == NULL) {
-		free(dimsizes);
-		free(start);
-		ierr = SMIOL_MALLOC_FAILURE;
+	/*
+	 * If the file is in data mode, then switch it to define mode
+	 */
+	if ((ierr = redef_file(file)) != SMIOL_SUCCESS) {
 		return ierr;
 	}
 
 	/*
-	 * Build start/count description of the part of the variable to be
-	 * read or written. Simultaneously, compute the product of all
-	 * non-unlimited, non-decomposed dimension sizes, scaled by the basic
-	 * element size to get the effective size of each element to be read or
-	 * written
+	 * Add the attribute to the file
 	 */
-	for (i = 0; i < *ndims; i++) {
-		(*start)[i] = (size_t)0;
-		(*count)[i] = (size_t)dimsizes[i];
+	ierr = ncmpi_put_att(file->ncidp, varidp, att_name, xtype,
+	                     (MPI_Offset)len, (const char *)att);
+	if (ierr != NC_NOERR) {
+		file->context->lib_type = SMIOL_LIBRARY_PNETCDF;
+		file->context->lib_ierr = ierr;
+		return SMIOL_LIBRARY_ERROR;
+	}
+#endif
 
-		/*
-		 * If variable has an unlimited dimension, set start to current
-		 * frame and count to one
-		 */
-		if (has_unlimited_dim && i == 0) {
-			(*start)[i] = (size_t)file->frame;
-			(*count)[i] = (size_t)1;
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * merge_atts
+ *
+ * Defines copies of the attributes of a native file in another file
+ *
+ * Given a file, the name of a variable in that file or NULL for global
+ * attributes, and a list of attributes of a native file, defines each
+ * attribute for the variable with all of its values (see put_att).
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned.
+ *
+ ********************************************************************************/
+int merge_atts(struct SMIOL_file *out, const char *varname, int natts,
+               const struct SMIOL_native_att *atts)
+{
+	int ierr;
+	int i;
+
+	for (i = 0; i < natts; i++) {
+		ierr = put_att(out, varname, atts[i].name, atts[i].type,
+		               atts[i].len, atts[i].value);
+		if (ierr != SMIOL_SUCCESS) {
+			return ierr;
 		}
+	}
 
-		/*
-		 * If variable is decomposed, set the slowest-varying,
-		 * non-record dimension start and count based on values from
-		 * the decomp structure
-		 */
-		if (decomp) {
-			if ((!has_unlimited_dim && i == 0) ||
-			    (has_unlimited_dim && i == 1)) {
-				(*start)[i] = decomp->io_start;
-				(*count)[i] = decomp->io_count;
-			} else {
-				*element_size *= (*count)[i];
-			}
+	return SMIOL_SUCCESS;
+}
+
+
+/********************************************************************************
+ *
+ * merge_var_data
+ *
+ * Copies the data of a variable in a native file to another file
+ *
+ * Given an input native file, an output file in which the variable with ID
+ * varid in the input has been defined, and a decomp with the length of the
+ * dimension it divides (or NULL and 0), copies every frame of the variable. A
+ * variable with a dimension after any unlimited dimension is read and written
+ * with its first such dimension divided evenly among all tasks; the decomp
+ * for that division is kept for the next variable, and replaced if the next
+ * variable needs a different division. Other variables are read by all tasks
+ * and written once.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned.
+ *
+ ********************************************************************************/
+int merge_var_data(struct SMIOL_file *in, struct SMIOL_file *out, int varid,
+                   struct SMIOL_decomp **decomp, SMIOL_Offset *decomp_len)
+{
+	const struct SMIOL_native *nf = in->native;
+	const struct SMIOL_native_var *var = &nf->vars[varid];
+	struct SMIOL_context *context = in->context;
+	SMIOL_Offset *elements;
+	SMIOL_Offset len;
+	SMIOL_Offset first_elem;
+	SMIOL_Offset frame;
+	SMIOL_Offset n_frames;
+	size_t n_elements;
+	size_t size;
+	void *buf;
+	int first;
+	int comm_rank, comm_size;
+	int ierr = SMIOL_SUCCESS;
+	int j;
+
+	first = var->is_record ? 1 : 0;
+	n_elements = 1;
+
+	switch (var->type) {
+		case SMIOL_REAL32:
+			size = sizeof(float);
+			break;
+		case SMIOL_REAL64:
+			size = sizeof(double);
+			break;
+		case SMIOL_INT32:
+			size = sizeof(int);
+			break;
+		default:
+			size = sizeof(char);
+			break;
+	}
+
+	if (first < var->ndims) {
+		MPI_Comm_rank(MPI_Comm_f2c(context->fcomm), &comm_rank);
+		MPI_Comm_size(MPI_Comm_f2c(context->fcomm), &comm_size);
+
+		len = nf->dims[var->dimids[first]].len;
+		n_elements = (size_t)(len / comm_size);
+		first_elem = (SMIOL_Offset)comm_rank * (SMIOL_Offset)n_elements;
+		if ((SMIOL_Offset)comm_rank < len % comm_size) {
+			n_elements++;
+			first_elem += comm_rank;
 		} else {
-			*element_size *= (*count)[i];
+			first_elem += len % comm_size;
 		}
 
-		if (write_or_read == START_COUNT_WRITE) {
-			/*
-			 * If the variable is not decomposed, only MPI rank 0
-			 * will have non-zero count values so that all MPI ranks
-			 * do no try to write the same offsets
-			 */
-			if (!decomp && file->context->comm_rank != 0) {
-				(*count)[i] = 0;
+		if (*decomp == NULL || *decomp_len != len) {
+			if (*decomp != NULL) {
+				SMIOL_free_decomp(decomp);
+			}
+			elements = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (n_elements + 1));
+			if (elements == NULL) {
+				return SMIOL_MALLOC_FAILURE;
+			}
+			for (j = 0; (size_t)j < n_elements; j++) {
+				elements[j] = first_elem + j;
+			}
+			ierr = SMIOL_create_decomp(context, n_elements, elements,
+			                           comm_size, 1, decomp);
+			free(elements);
+			if (ierr != SMIOL_SUCCESS) {
+				*decomp = NULL;
+				return ierr;
 			}
+			*decomp_len = len;
+		}
+
+		for (j = first + 1; j < var->ndims; j++) {
+			size *= (size_t)nf->dims[var->dimids[j]].len;
+		}
+	}
+
+	buf = malloc(size * n_elements + 1);
+	if (buf == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	n_frames = var->is_record ? nf->numrecs : 1;
+	for (frame = 0; frame < n_frames && ierr == SMIOL_SUCCESS; frame++) {
+		ierr = SMIOL_set_frame(in, frame);
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_set_frame(out, frame);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_get_var(in, var->name,
+			                     (first < var->ndims) ? *decomp : NULL, buf);
+		}
+		if (ierr == SMIOL_SUCCESS) {
+			ierr = SMIOL_put_var(out, var->name,
+			                     (first < var->ndims) ? *decomp : NULL, buf);
 		}
 	}
 
-	free(dimsizes);
+	free(buf);
 
-	return SMIOL_SUCCESS;
+	return ierr;
 }
@@ -20,6 +20,8 @@ int SMIOL_inquire(void);
  */
 int SMIOL_open_file(struct SMIOL_context *context, const char *filename, int mode, struct SMIOL_file **file);
 int SMIOL_close_file(struct SMIOL_file **file);
+int SMIOL_merge_subfiles(struct SMIOL_context *context, const char *filename,
+                         const char *out_filename);
 
 /*
  * Dimension methods
@@ -33,10 +35,30 @@ int SMIOL_inquire_dim(struct SMIOL_file *file, const char *dimname,
  */
 int SMIOL_define_var(struct SMIOL_file *file, const char *varname, int vartype, int ndims, const char **dimnames);
 int SMIOL_inquire_var(struct SMIOL_file *file, const char *varname, int *vartype, int *ndims, char **dimnames);
+int SMIOL_define_var_fill(struct SMIOL_file *file, const char *varname,
+                          int fill_mode, const void *fill_value);
 int SMIOL_put_var(struct SMIOL_file *file, const char *varname,
                   const struct SMIOL_decomp *decomp, const void *buf);
 int SMIOL_get_var(struct SMIOL_file *file, const char *varname,
                   const struct SMIOL_decomp *decomp, void *buf);
+int SMIOL_put_var_frames(struct SMIOL_file *file, const char *varname,
+                         const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                         const void *buf);
+int SMIOL_get_var_frames(struct SMIOL_file *file, const char *varname,
+                         const struct SMIOL_decomp *decomp, SMIOL_Offset n_frames,
+                         void *buf);
+int SMIOL_get_var_subset(struct SMIOL_file *file, const char *varname,
+                         const struct SMIOL_decomp *decomp,
+                         SMIOL_Offset first_frame, SMIOL_Offset n_frames,
+                         const SMIOL_Offset *start, const SMIOL_Offset *count,
+                         void *buf);
+int SMIOL_set_prefetch(struct SMIOL_file *file, const char *varname, int enable);
+int SMIOL_inquire_var_handle(struct SMIOL_file *file, const char *varname,
+                             struct SMIOL_var **var);
+int SMIOL_put_var_h(struct SMIOL_var *var, const struct SMIOL_decomp *decomp,
+                    const void *buf);
+int SMIOL_get_var_h(struct SMIOL_var *var, const struct SMIOL_decomp *decomp,
+                    void *buf);
 
 /*
  * Attribute methods
@@ -52,19 +74,43 @@ int SMIOL_inquire_att(struct SMIOL_file *file, const char *varname,
  * Control methods
  */
 int SMIOL_sync_file(struct SMIOL_file *file);
+int SMIOL_flush_file(struct SMIOL_file *file);
 const char *SMIOL_error_string(int errno);
 const char *SMIOL_lib_error_string(struct SMIOL_context *context);
-int SMIOL_set_option(void);
+int SMIOL_set_option(struct SMIOL_context *context, const char *name,
+                     const char *value);
+int SMIOL_set_file_option(struct SMIOL_file *file, const char *name,
+                          const char *value);
 int SMIOL_set_frame(struct SMIOL_file *file, SMIOL_Offset frame);
 int SMIOL_get_frame(struct SMIOL_file *file, SMIOL_Offset *frame);
+int SMIOL_inquire_bytes_written(struct SMIOL_file *file, SMIOL_Offset *bytes);
 
 /*
  * Decomposition methods
  */
+int SMIOL_set_io_placement(struct SMIOL_context *context, int placement,
+                           int io_tasks_per_node);
+int SMIOL_set_io_alignment(struct SMIOL_context *context, size_t align_bytes,
+                           size_t element_size);
+int SMIOL_set_io_partition(struct SMIOL_context *context, int partition);
+int SMIOL_set_io_autotune(struct SMIOL_context *context,
+                          const char *cache_filename, const char *scratch_filename,
+                          size_t calibration_bytes);
+int SMIOL_set_io_vertical_blocks(struct SMIOL_context *context, int n_blocks);
+int SMIOL_set_small_var_batching(struct SMIOL_context *context, size_t max_bytes);
+int SMIOL_set_read_mode(struct SMIOL_context *context, int mode);
+int SMIOL_set_header_padding(struct SMIOL_context *context,
+                             size_t header_free_bytes, size_t var_align_bytes,
+                             size_t var_free_bytes, size_t record_align_bytes);
 int SMIOL_create_decomp(struct SMIOL_context *context,
                         size_t n_compute_elements, SMIOL_Offset *compute_elements,
                         int num_io_tasks, int io_stride,
                         struct SMIOL_decomp **decomp);
+int SMIOL_create_halo_decomp(struct SMIOL_context *context,
+                             size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                             size_t n_owned_elements,
+                             int num_io_tasks, int io_stride,
+                             struct SMIOL_decomp **decomp);
 int SMIOL_free_decomp(struct SMIOL_decomp **decomp);
 
 #endif
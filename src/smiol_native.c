@@ -0,0 +1,3421 @@
+#ifdef SMIOL_IO_URING
+#define _GNU_SOURCE
+#endif
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "smiol_native.h"
+
+#ifdef SMIOL_IO_URING
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#endif
+
+#define NATIVE_MAX_RUN ((MPI_Offset)1 << 30) /* Largest contiguous piece of one MPI-IO access */
+
+/*
+ * A growable buffer into which a header is encoded
+ */
+struct native_buf {
+	unsigned char *data;
+	size_t len;
+	size_t cap;
+	int ierr;
+};
+
+#ifdef SMIOL_IO_URING
+#define NATIVE_URING_ENTRIES 64 /* Number of writes each task may have in its io_uring */
+
+/*
+ * The part of a write in an io_uring that remains to be written
+ */
+struct native_uring_write {
+	const char *p;     /* Next byte to write */
+	size_t len;        /* Number of bytes left to write */
+	MPI_Offset offset; /* Offset in the file of the next byte */
+};
+
+/*
+ * An io_uring through which a task writes independently to a native file, with
+ * the file registered as fixed file 0 of the ring
+ */
+struct native_uring {
+	int ring_fd;       /* io_uring file descriptor */
+	int fd;            /* POSIX file descriptor of the file */
+	void *sq_ring;     /* Mapped submission queue ring */
+	size_t sq_ring_bytes;
+	void *cq_ring;     /* Mapped completion queue ring, which may be sq_ring */
+	size_t cq_ring_bytes;
+	struct io_uring_sqe *sqes; /* Mapped submission queue entries */
+	size_t sqes_bytes;
+	unsigned *sq_tail;
+	unsigned sq_mask;
+	unsigned *sq_array;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe *cqes;
+	unsigned n_queued;   /* Entries added to the submission queue and not yet submitted */
+	int n_inflight;      /* Writes queued or submitted that have not completed */
+	int n_free;          /* Number of free slots in writes */
+	int free_slots[NATIVE_URING_ENTRIES];
+	struct native_uring_write writes[NATIVE_URING_ENTRIES]; /* Write in each slot */
+	int ierr;            /* Error of a write that failed since writes were last finished */
+};
+#endif
+
+/*
+ * Where a variable is laid out, for finding its values in a file or subfile
+ */
+struct native_place {
+	MPI_Offset begin;        /* Offset of the block, or offset within each record */
+	MPI_Offset record_begin; /* Offset of the first record */
+	MPI_Offset record_size;  /* Size in bytes of one record */
+	MPI_Offset split_len;    /* Length of the first dimension after any unlimited dimension */
+};
+
+/*
+ * Prototypes for functions used only internally by the native file format
+ */
+static size_t type_size(int type);
+static int host_is_little_endian(void);
+static void swap_bytes(void *buf, size_t n, size_t size);
+static char *copy_name(const char *name);
+static MPI_Offset round_up(MPI_Offset offset, MPI_Offset align);
+static struct SMIOL_native *new_native(MPI_Comm comm);
+static void free_atts(int natts, struct SMIOL_native_att *atts);
+static void free_native(struct SMIOL_native *nf);
+static int get_atts(const struct SMIOL_native *nf, int varid,
+                    int **natts, struct SMIOL_native_att ***atts);
+static void put_bytes(struct native_buf *b, const void *p, size_t n);
+static void put_u32(struct native_buf *b, uint32_t v);
+static void put_u64(struct native_buf *b, uint64_t v);
+static void put_name(struct native_buf *b, const char *name);
+static void put_atts(struct native_buf *b, int natts,
+                     const struct SMIOL_native_att *atts);
+static int encode_header(const struct SMIOL_native *nf, struct native_buf *b);
+static int get_u32(const unsigned char *data, size_t len, size_t *pos,
+                   uint32_t *v);
+static int get_u64(const unsigned char *data, size_t len, size_t *pos,
+                   uint64_t *v);
+static int get_name(const unsigned char *data, size_t len, size_t *pos,
+                    char **name);
+static int get_atts_from(const unsigned char *data, size_t len, size_t *pos,
+                         int *natts, struct SMIOL_native_att **atts);
+static int decode_header(struct SMIOL_native *nf, const unsigned char *data,
+                         size_t len);
+static int write_numrecs(struct SMIOL_native *nf);
+static int move_bytes(MPI_File fh, MPI_Offset from, MPI_Offset to,
+                      MPI_Offset len);
+static int check_coords(const struct SMIOL_native *nf,
+                        const struct SMIOL_native_var *var,
+                        const MPI_Offset *start, const MPI_Offset *count,
+                        int reading, MPI_Offset *nbytes);
+static int get_runs(const struct SMIOL_native *nf,
+                    const struct SMIOL_native_var *var,
+                    const MPI_Offset *start, const MPI_Offset *count,
+                    const struct native_place *place,
+                    int *n_runs, int **lens, MPI_Aint **offsets);
+static int get_memtype(MPI_Offset nbytes, MPI_Datatype *memtype);
+static int access_all(struct SMIOL_native *nf, int varid,
+                      const MPI_Offset *start, const MPI_Offset *count,
+                      void *buf, int writing);
+static int agree_numrecs(struct SMIOL_native *nf);
+static int reserve_writes(struct SMIOL_native *nf, int n);
+static int test_writes(struct SMIOL_native *nf);
+static int finish_writes(struct SMIOL_native *nf);
+static void get_chunk(MPI_Offset len, int n, int s, MPI_Offset *chunk_start,
+                      MPI_Offset *chunk_len);
+static int init_subfiles(struct SMIOL_native *nf);
+static int layout_subfiles(struct SMIOL_native *nf);
+static int open_subfile(struct SMIOL_native *nf, int s);
+static int sub_access(struct SMIOL_native *nf, int varid,
+                      const MPI_Offset *start, const MPI_Offset *count,
+                      void *buf, MPI_Offset nbytes, int writing, int nonblocking);
+#ifdef SMIOL_IO_URING
+static void uring_setup(struct SMIOL_native *nf);
+static void uring_free(struct native_uring *ring);
+static int uring_write(struct native_uring *ring, MPI_Offset offset,
+                       const char *p, size_t len);
+static void uring_queue(struct native_uring *ring, int slot);
+static int uring_enter(struct native_uring *ring, int wait);
+static int uring_reap(struct native_uring *ring, int wait);
+static int uring_finish(struct native_uring *ring);
+#endif
+
+
+/*******************************************************************************
+ *
+ * native_create
+ *
+ * Creates a native file
+ *
+ * Collectively creates, or truncates if it exists, the file named filename for
+ * all tasks in comm, opened with the MPI-IO hints in info. The file is left in
+ * define mode, and its header is first written by native_enddef.
+ *
+ * If n_subfiles is greater than zero, the data of the file are held by that
+ * many subfiles (see smiol_native.h), which are created or truncated here, and
+ * variables may then only be defined until the file is first laid out.
+ *
+ * Upon success, NATIVE_NOERR is returned and nf points to the new file;
+ * otherwise, an error code is returned and nf is set to NULL.
+ *
+ *******************************************************************************/
+int native_create(MPI_Comm comm, const char *filename, MPI_Info info,
+                  int n_subfiles, struct SMIOL_native **nf)
+{
+	MPI_File fh;
+	int comm_size;
+	int ierr = NATIVE_NOERR;
+	int all_ierr;
+	int i;
+
+	*nf = new_native(comm);
+	if (*nf == NULL) {
+		return NATIVE_ENOMEM;
+	}
+
+	(*nf)->filename = copy_name(filename);
+	(*nf)->n_subfiles = (n_subfiles > 0) ? n_subfiles : 0;
+	if ((*nf)->filename == NULL || init_subfiles(*nf) != NATIVE_NOERR) {
+		free_native(*nf);
+		*nf = NULL;
+		return NATIVE_ENOMEM;
+	}
+
+	if (MPI_File_open(comm, (char *)filename, (MPI_MODE_CREATE | MPI_MODE_RDWR),
+	                  info, &(*nf)->fh) != MPI_SUCCESS) {
+		free_native(*nf);
+		*nf = NULL;
+		return NATIVE_EMPI;
+	}
+
+	if (MPI_File_set_size((*nf)->fh, (MPI_Offset)0) != MPI_SUCCESS) {
+		MPI_File_close(&(*nf)->fh);
+		free_native(*nf);
+		*nf = NULL;
+		return NATIVE_EMPI;
+	}
+
+	/*
+	 * Subfiles are created or truncated by the tasks in turn, so that no
+	 * data remain from an earlier file of the same name
+	 */
+	MPI_Comm_size(comm, &comm_size);
+	for (i = (*nf)->comm_rank; i < (*nf)->n_subfiles && ierr == NATIVE_NOERR; i += comm_size) {
+		char *name = (char *)malloc(strlen(filename) + 16);
+
+		if (name == NULL) {
+			ierr = NATIVE_ENOMEM;
+			break;
+		}
+		sprintf(name, "%s.%04d", filename, i);
+		if (MPI_File_open(MPI_COMM_SELF, name, (MPI_MODE_CREATE | MPI_MODE_WRONLY),
+		                  info, &fh) != MPI_SUCCESS) {
+			ierr = NATIVE_EMPI;
+		} else {
+			if (MPI_File_set_size(fh, (MPI_Offset)0) != MPI_SUCCESS) {
+				ierr = NATIVE_EMPI;
+			}
+			MPI_File_close(&fh);
+		}
+		free(name);
+	}
+	if (MPI_Allreduce(&ierr, &all_ierr, 1, MPI_INT, MPI_MIN, comm) != MPI_SUCCESS) {
+		all_ierr = NATIVE_EMPI;
+	}
+	if (all_ierr != NATIVE_NOERR) {
+		MPI_File_close(&(*nf)->fh);
+		free_native(*nf);
+		*nf = NULL;
+		return all_ierr;
+	}
+
+	(*nf)->writable = 1;
+	(*nf)->define_mode = 1;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_open
+ *
+ * Opens an existing native file
+ *
+ * Collectively opens the file named filename for all tasks in comm, for reading
+ * and writing if writable is non-zero or for reading only otherwise, with the
+ * MPI-IO hints in info. The header is read by the first task in comm and
+ * broadcast to all others.
+ *
+ * Upon success, NATIVE_NOERR is returned and nf points to the file; otherwise,
+ * an error code is returned and nf is set to NULL.
+ *
+ *******************************************************************************/
+int native_open(MPI_Comm comm, const char *filename, int writable,
+                MPI_Info info, struct SMIOL_native **nf)
+{
+	unsigned char fixed[NATIVE_FIXED_HEADER_BYTES];
+	unsigned char *data = NULL;
+	unsigned long long header_len = 0;
+	size_t pos;
+	uint64_t size;
+	MPI_Status status;
+	int amode;
+	int ierr = NATIVE_NOERR;
+
+	*nf = new_native(comm);
+	if (*nf == NULL) {
+		return NATIVE_ENOMEM;
+	}
+
+	(*nf)->filename = copy_name(filename);
+	if ((*nf)->filename == NULL) {
+		free_native(*nf);
+		*nf = NULL;
+		return NATIVE_ENOMEM;
+	}
+
+	amode = writable ? MPI_MODE_RDWR : MPI_MODE_RDONLY;
+	if (MPI_File_open(comm, (char *)filename, amode, info, &(*nf)->fh) != MPI_SUCCESS) {
+		free_native(*nf);
+		*nf = NULL;
+		return NATIVE_EMPI;
+	}
+	(*nf)->writable = (writable != 0);
+
+	/*
+	 * The first task reads the fixed part of the header, which gives the
+	 * space reserved for the whole header, and then the whole header
+	 */
+	if ((*nf)->comm_rank == 0) {
+		memset(fixed, 0, sizeof(fixed));
+		if (MPI_File_read_at((*nf)->fh, (MPI_Offset)0, fixed,
+		                     NATIVE_FIXED_HEADER_BYTES, MPI_BYTE, &status) != MPI_SUCCESS) {
+			ierr = NATIVE_EMPI;
+		} else if (memcmp(fixed, NATIVE_MAGIC, 8) != 0) {
+			ierr = NATIVE_ENOTNATIVE;
+		}
+
+		if (ierr == NATIVE_NOERR) {
+			pos = 24;
+			get_u64(fixed, sizeof(fixed), &pos, &size);
+			if (size < NATIVE_FIXED_HEADER_BYTES || size > (uint64_t)INT_MAX) {
+				ierr = NATIVE_ENOTNATIVE;
+			} else {
+				header_len = (unsigned long long)size;
+			}
+		}
+
+		if (ierr == NATIVE_NOERR) {
+			data = (unsigned char *)calloc((size_t)header_len, 1);
+			if (data == NULL) {
+				ierr = NATIVE_ENOMEM;
+			} else if (MPI_File_read_at((*nf)->fh, (MPI_Offset)0, data,
+			                            (int)header_len, MPI_BYTE, &status) != MPI_SUCCESS) {
+				ierr = NATIVE_EMPI;
+			}
+		}
+	}
+
+	if (MPI_Bcast(&ierr, 1, MPI_INT, 0, comm) != MPI_SUCCESS
+	    || (ierr == NATIVE_NOERR
+	        && MPI_Bcast(&header_len, 1, MPI_UNSIGNED_LONG_LONG, 0, comm) != MPI_SUCCESS)) {
+		ierr = NATIVE_EMPI;
+	}
+
+	if (ierr == NATIVE_NOERR && (*nf)->comm_rank != 0) {
+		data = (unsigned char *)malloc((size_t)header_len);
+		if (data == NULL) {
+			ierr = NATIVE_ENOMEM;
+		}
+	}
+
+	if (ierr == NATIVE_NOERR
+	    && MPI_Bcast(data, (int)header_len, MPI_BYTE, 0, comm) != MPI_SUCCESS) {
+		ierr = NATIVE_EMPI;
+	}
+
+	if (ierr == NATIVE_NOERR) {
+		ierr = decode_header(*nf, data, (size_t)header_len);
+	}
+	free(data);
+
+	if (ierr == NATIVE_NOERR) {
+		ierr = init_subfiles(*nf);
+	}
+	if (ierr == NATIVE_NOERR) {
+		ierr = layout_subfiles(*nf);
+	}
+
+	if (ierr != NATIVE_NOERR) {
+		MPI_File_close(&(*nf)->fh);
+		free_native(*nf);
+		*nf = NULL;
+		return ierr;
+	}
+
+	(*nf)->has_layout = 1;
+	(*nf)->layout_nvars = (*nf)->nvars;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_create_null
+ *
+ * Creates a native file with no file behind it
+ *
+ * Creates a writable native file for all tasks in comm that keeps definitions
+ * and the number of records like any other native file, but that opens no file
+ * and performs no I/O: values written are counted in bytes_written and then
+ * discarded, and values read are zero. The cost of writing to such a file is
+ * therefore only the cost of the work done before the file library is called.
+ *
+ * Upon success, NATIVE_NOERR is returned and nf points to the new file;
+ * otherwise, an error code is returned and nf is set to NULL.
+ *
+ *******************************************************************************/
+int native_create_null(MPI_Comm comm, struct SMIOL_native **nf)
+{
+	*nf = new_native(comm);
+	if (*nf == NULL) {
+		return NATIVE_ENOMEM;
+	}
+
+	(*nf)->writable = 1;
+	(*nf)->define_mode = 1;
+	(*nf)->discard = 1;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_close
+ *
+ * Closes a native file
+ *
+ * Completes the independent writes of the calling task, and collectively
+ * records the number of records in the header of a writable file, then closes
+ * the file and any subfiles opened by the calling task and frees nf, which is
+ * set to NULL. Definitions made since the last call to native_enddef are
+ * discarded.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is returned,
+ * though the file is closed and freed in any case.
+ *
+ *******************************************************************************/
+int native_close(struct SMIOL_native **nf)
+{
+	int ierr;
+	int i;
+
+	ierr = finish_writes(*nf);
+
+	if ((*nf)->writable && (*nf)->has_layout) {
+		int ierr2 = write_numrecs(*nf);
+
+		if (ierr == NATIVE_NOERR) {
+			ierr = ierr2;
+		}
+	}
+
+	for (i = 0; i < (*nf)->n_subfiles; i++) {
+		if ((*nf)->sub_fh[i] != MPI_FILE_NULL
+		    && MPI_File_close(&(*nf)->sub_fh[i]) != MPI_SUCCESS && ierr == NATIVE_NOERR) {
+			ierr = NATIVE_EMPI;
+		}
+	}
+
+	if (!(*nf)->discard
+	    && MPI_File_close(&(*nf)->fh) != MPI_SUCCESS && ierr == NATIVE_NOERR) {
+		ierr = NATIVE_EMPI;
+	}
+
+	free_native(*nf);
+	*nf = NULL;
+
+	return ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * native_enddef
+ *
+ * Lays out a native file and writes its header
+ *
+ * If anything has been defined in the file since it was created or last laid
+ * out, computes the offset of every variable, with header_free_bytes of free
+ * space left after the header and variable blocks and records aligned to
+ * align_bytes (or NATIVE_DEFAULT_ALIGN if zero), and writes the header.
+ *
+ * Once a file has been laid out, the header is given more space only when it
+ * no longer fits, new blocks are placed after existing blocks, and new record
+ * variables after existing record variables within each record, so that data
+ * only ever move towards the end of the file; any data that move are copied by
+ * the first task before the header is written.
+ *
+ * This routine must be called by all tasks that opened the file.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_enddef(struct SMIOL_native *nf, size_t header_free_bytes,
+                  size_t align_bytes)
+{
+	struct native_buf b;
+	MPI_Offset *old_begin = NULL;
+	MPI_Offset old_record_begin;
+	MPI_Offset old_record_size;
+	MPI_Offset header_size;
+	MPI_Offset align;
+	MPI_Offset offset;
+	MPI_Offset r;
+	MPI_Status status;
+	int ierr = NATIVE_NOERR;
+	int i;
+
+	if (!nf->define_mode) {
+		return NATIVE_NOERR;
+	}
+
+	/* Data must be in place before they can be moved */
+	if ((ierr = finish_writes(nf)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	align = (MPI_Offset)((align_bytes > 0) ? align_bytes : NATIVE_DEFAULT_ALIGN);
+
+	/*
+	 * The size of the encoded header does not depend on the offsets in it
+	 */
+	if ((ierr = encode_header(nf, &b)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	header_size = nf->header_size;
+	if (!nf->has_layout || (MPI_Offset)b.len > header_size) {
+		header_size = round_up((MPI_Offset)(b.len + header_free_bytes), align);
+	}
+
+	/*
+	 * Remember where existing variables were, then lay out all variables
+	 * in the order in which they were defined
+	 */
+	if (nf->has_layout && nf->layout_nvars > 0) {
+		old_begin = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)nf->layout_nvars);
+		if (old_begin == NULL) {
+			free(b.data);
+			return NATIVE_ENOMEM;
+		}
+		for (i = 0; i < nf->layout_nvars; i++) {
+			old_begin[i] = nf->vars[i].begin;
+		}
+	}
+	old_record_begin = nf->record_begin;
+	old_record_size = nf->record_size;
+
+	offset = header_size;
+	for (i = 0; i < nf->nvars; i++) {
+		if (!nf->vars[i].is_record) {
+			nf->vars[i].begin = round_up(offset, align);
+			offset = nf->vars[i].begin + nf->vars[i].size;
+		}
+	}
+	nf->record_begin = round_up(offset, align);
+
+	offset = 0;
+	for (i = 0; i < nf->nvars; i++) {
+		if (nf->vars[i].is_record) {
+			nf->vars[i].begin = round_up(offset, (MPI_Offset)8);
+			offset = nf->vars[i].begin + nf->vars[i].size;
+		}
+	}
+	nf->record_size = round_up(offset, (MPI_Offset)8);
+	nf->header_size = header_size;
+
+	/*
+	 * Move existing data, starting with the data nearest the end of the
+	 * file so that nothing is overwritten before it has been moved
+	 */
+	if (nf->comm_rank == 0 && old_begin != NULL && !nf->discard && nf->n_subfiles == 0) {
+		for (r = nf->numrecs - 1; r >= 0 && ierr == NATIVE_NOERR; r--) {
+			for (i = nf->layout_nvars - 1; i >= 0 && ierr == NATIVE_NOERR; i--) {
+				if (nf->vars[i].is_record) {
+					ierr = move_bytes(nf->fh,
+					                  old_record_begin + r * old_record_size + old_begin[i],
+					                  nf->record_begin + r * nf->record_size + nf->vars[i].begin,
+					                  nf->vars[i].size);
+				}
+			}
+		}
+		for (i = nf->layout_nvars - 1; i >= 0 && ierr == NATIVE_NOERR; i--) {
+			if (!nf->vars[i].is_record) {
+				ierr = move_bytes(nf->fh, old_begin[i], nf->vars[i].begin,
+				                  nf->vars[i].size);
+			}
+		}
+	}
+	free(old_begin);
+
+	if (ierr == NATIVE_NOERR) {
+		ierr = layout_subfiles(nf);
+	}
+
+	/*
+	 * Encode the header again with the new offsets, and write it
+	 */
+	free(b.data);
+	b.data = NULL;
+	if (ierr == NATIVE_NOERR) {
+		ierr = encode_header(nf, &b);
+	}
+	if (nf->comm_rank == 0 && ierr == NATIVE_NOERR && !nf->discard) {
+		if (MPI_File_write_at(nf->fh, (MPI_Offset)0, b.data, (int)b.len,
+		                      MPI_BYTE, &status) != MPI_SUCCESS) {
+			ierr = NATIVE_EMPI;
+		}
+	}
+	free(b.data);
+
+	/*
+	 * All tasks learn whether the header was written, and see the data
+	 * moved by the first task before they access the file
+	 */
+	if (MPI_Bcast(&ierr, 1, MPI_INT, 0, nf->comm) != MPI_SUCCESS) {
+		return NATIVE_EMPI;
+	}
+	if (ierr != NATIVE_NOERR) {
+		return ierr;
+	}
+	if (!nf->discard
+	    && (MPI_File_sync(nf->fh) != MPI_SUCCESS
+	        || MPI_Barrier(nf->comm) != MPI_SUCCESS)) {
+		return NATIVE_EMPI;
+	}
+
+	nf->define_mode = 0;
+	nf->has_layout = 1;
+	nf->layout_nvars = nf->nvars;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_sync
+ *
+ * Flushes a native file to storage
+ *
+ * Completes the independent writes of the calling task, collectively records
+ * the number of records in the header of a writable file, and flushes all data
+ * written to the file.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_sync(struct SMIOL_native *nf)
+{
+	int ierr;
+	int i;
+
+	if ((ierr = finish_writes(nf)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	if (nf->writable && nf->has_layout) {
+		if ((ierr = write_numrecs(nf)) != NATIVE_NOERR) {
+			return ierr;
+		}
+	}
+
+	if (!nf->discard && MPI_File_sync(nf->fh) != MPI_SUCCESS) {
+		return NATIVE_EMPI;
+	}
+
+	for (i = 0; i < nf->n_subfiles; i++) {
+		if (nf->sub_fh[i] != MPI_FILE_NULL && MPI_File_sync(nf->sub_fh[i]) != MPI_SUCCESS) {
+			return NATIVE_EMPI;
+		}
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_strerror
+ *
+ * Returns an error string for a native file format error code
+ *
+ *******************************************************************************/
+const char *native_strerror(int ierr)
+{
+	switch (ierr) {
+	case NATIVE_NOERR:
+		return "No error";
+	case NATIVE_ENOMEM:
+		return "Native file: out of memory";
+	case NATIVE_EMPI:
+		return "Native file: an MPI-IO call failed";
+	case NATIVE_ENOTNATIVE:
+		return "Native file: not a SMIOL native file, or the header is corrupt";
+	case NATIVE_EBADDIM:
+		return "Native file: dimension not found";
+	case NATIVE_ENOTVAR:
+		return "Native file: variable not found";
+	case NATIVE_ENOTATT:
+		return "Native file: attribute not found";
+	case NATIVE_ENAMEINUSE:
+		return "Native file: name is already in use";
+	case NATIVE_EBADTYPE:
+		return "Native file: invalid type";
+	case NATIVE_EPERM:
+		return "Native file: file was opened read-only";
+	case NATIVE_EUNLIMIT:
+		return "Native file: only the first dimension of a variable, and only one dimension of a file, may be unlimited";
+	case NATIVE_EINVALCOORDS:
+		return "Native file: start and count exceed the dimensions of the variable";
+	case NATIVE_EDIMSIZE:
+		return "Native file: dimensions may not have zero length";
+	case NATIVE_ESUBFILED:
+		return "Native file: variables may not be defined in a subfiled file once data have been accessed";
+	case NATIVE_EIO:
+		return "Native file: an io_uring write failed";
+	case NATIVE_EBADNAME:
+		return "Native file: names may not be longer than 256 characters";
+	default:
+		return "Native file: unknown error";
+	}
+}
+
+
+/*******************************************************************************
+ *
+ * native_def_dim
+ *
+ * Defines a dimension in a native file
+ *
+ * Defines a dimension with the given name and length, or the unlimited
+ * dimension if len is negative, returning its ID in dimid. Like all
+ * definitions, this only changes the file as seen by the calling task, so it
+ * must be made identically by all tasks, and takes effect in the file at the
+ * next call to native_enddef. As in netCDF, names of dimensions, variables, and
+ * attributes are no longer than NATIVE_MAX_NAME characters.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_def_dim(struct SMIOL_native *nf, const char *name, SMIOL_Offset len,
+                   int *dimid)
+{
+	struct SMIOL_native_dim *dims;
+	int id;
+
+	if (!nf->writable) {
+		return NATIVE_EPERM;
+	}
+
+	if (strlen(name) > NATIVE_MAX_NAME) {
+		return NATIVE_EBADNAME;
+	}
+
+	if (native_inq_dimid(nf, name, &id) == NATIVE_NOERR) {
+		return NATIVE_ENAMEINUSE;
+	}
+
+	if (len == 0) {
+		return NATIVE_EDIMSIZE;
+	}
+
+	if (len < 0 && nf->unlimdimid != -1) {
+		return NATIVE_EUNLIMIT;
+	}
+
+	dims = (struct SMIOL_native_dim *)realloc(nf->dims,
+	                                   sizeof(struct SMIOL_native_dim) * (size_t)(nf->ndims + 1));
+	if (dims == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	nf->dims = dims;
+
+	dims[nf->ndims].name = copy_name(name);
+	if (dims[nf->ndims].name == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	dims[nf->ndims].len = (len < 0) ? (SMIOL_Offset)-1 : len;
+
+	if (len < 0) {
+		nf->unlimdimid = nf->ndims;
+	}
+
+	*dimid = nf->ndims;
+	nf->ndims++;
+	nf->define_mode = 1;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_inq_dimid
+ *
+ * Returns the ID of a dimension in a native file
+ *
+ *******************************************************************************/
+int native_inq_dimid(const struct SMIOL_native *nf, const char *name, int *dimid)
+{
+	int i;
+
+	for (i = 0; i < nf->ndims; i++) {
+		if (strcmp(nf->dims[i].name, name) == 0) {
+			*dimid = i;
+			return NATIVE_NOERR;
+		}
+	}
+
+	return NATIVE_EBADDIM;
+}
+
+
+/*******************************************************************************
+ *
+ * native_inq_dim
+ *
+ * Returns the name and length of a dimension in a native file
+ *
+ * Given the ID of a dimension, copies its name to name if name is not NULL, and
+ * sets len, if not NULL, to its length; the length of the unlimited dimension
+ * is the number of records in the file.
+ *
+ *******************************************************************************/
+int native_inq_dim(const struct SMIOL_native *nf, int dimid, char *name,
+                   SMIOL_Offset *len)
+{
+	if (dimid < 0 || dimid >= nf->ndims) {
+		return NATIVE_EBADDIM;
+	}
+
+	if (name != NULL) {
+		strcpy(name, nf->dims[dimid].name);
+	}
+
+	if (len != NULL) {
+		*len = (dimid == nf->unlimdimid) ? (SMIOL_Offset)nf->numrecs : nf->dims[dimid].len;
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_def_var
+ *
+ * Defines a variable in a native file
+ *
+ * Defines a variable with the given name, SMIOL type, and dimensions, of which
+ * only the first may be the unlimited dimension, returning its ID in varid.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_def_var(struct SMIOL_native *nf, const char *name, int type,
+                   int ndims, const int *dimids, int *varid)
+{
+	struct SMIOL_native_var *vars;
+	struct SMIOL_native_var *var;
+	int id;
+	int i;
+
+	if (!nf->writable) {
+		return NATIVE_EPERM;
+	}
+
+	/* Data in subfiles are never moved */
+	if (nf->n_subfiles > 0 && nf->has_layout) {
+		return NATIVE_ESUBFILED;
+	}
+
+	if (strlen(name) > NATIVE_MAX_NAME) {
+		return NATIVE_EBADNAME;
+	}
+
+	if (native_inq_varid(nf, name, &id) == NATIVE_NOERR) {
+		return NATIVE_ENAMEINUSE;
+	}
+
+	if (type_size(type) == 0) {
+		return NATIVE_EBADTYPE;
+	}
+
+	for (i = 0; i < ndims; i++) {
+		if (dimids[i] < 0 || dimids[i] >= nf->ndims) {
+			return NATIVE_EBADDIM;
+		}
+		if (i > 0 && dimids[i] == nf->unlimdimid) {
+			return NATIVE_EUNLIMIT;
+		}
+	}
+
+	vars = (struct SMIOL_native_var *)realloc(nf->vars,
+	                                   sizeof(struct SMIOL_native_var) * (size_t)(nf->nvars + 1));
+	if (vars == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	nf->vars = vars;
+
+	var = &vars[nf->nvars];
+	var->name = copy_name(name);
+	var->dimids = (int *)malloc(sizeof(int) * (size_t)(ndims + 1));
+	if (var->name == NULL || var->dimids == NULL) {
+		free(var->name);
+		free(var->dimids);
+		return NATIVE_ENOMEM;
+	}
+
+	var->type = type;
+	var->ndims = ndims;
+	var->natts = 0;
+	var->atts = NULL;
+	var->begin = 0;
+	var->is_record = (ndims > 0 && dimids[0] == nf->unlimdimid);
+	var->size = (MPI_Offset)type_size(type);
+	for (i = 0; i < ndims; i++) {
+		var->dimids[i] = dimids[i];
+		if (!(i == 0 && var->is_record)) {
+			var->size *= (MPI_Offset)nf->dims[dimids[i]].len;
+		}
+	}
+
+	*varid = nf->nvars;
+	nf->nvars++;
+	nf->define_mode = 1;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_inq_varid
+ *
+ * Returns the ID of a variable in a native file
+ *
+ *******************************************************************************/
+int native_inq_varid(const struct SMIOL_native *nf, const char *name, int *varid)
+{
+	int i;
+
+	for (i = 0; i < nf->nvars; i++) {
+		if (strcmp(nf->vars[i].name, name) == 0) {
+			*varid = i;
+			return NATIVE_NOERR;
+		}
+	}
+
+	return NATIVE_ENOTVAR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_inq_var
+ *
+ * Returns the type and dimensions of a variable in a native file
+ *
+ * Given the ID of a variable, sets each of type, ndims, and dimids that is not
+ * NULL to the SMIOL type, number of dimensions, and dimension IDs of the
+ * variable.
+ *
+ *******************************************************************************/
+int native_inq_var(const struct SMIOL_native *nf, int varid, int *type,
+                   int *ndims, int *dimids)
+{
+	int i;
+
+	if (varid < 0 || varid >= nf->nvars) {
+		return NATIVE_ENOTVAR;
+	}
+
+	if (type != NULL) {
+		*type = nf->vars[varid].type;
+	}
+	if (ndims != NULL) {
+		*ndims = nf->vars[varid].ndims;
+	}
+	if (dimids != NULL) {
+		for (i = 0; i < nf->vars[varid].ndims; i++) {
+			dimids[i] = nf->vars[varid].dimids[i];
+		}
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_put_att
+ *
+ * Defines an attribute in a native file
+ *
+ * Defines an attribute of the variable with ID varid, or a global attribute if
+ * varid is NATIVE_GLOBAL, holding len values of the given SMIOL type; an
+ * existing attribute of the same name is replaced.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_put_att(struct SMIOL_native *nf, int varid, const char *name,
+                   int type, size_t len, const void *value)
+{
+	int *natts;
+	struct SMIOL_native_att **atts;
+	struct SMIOL_native_att *new_atts;
+	struct SMIOL_native_att *att = NULL;
+	void *new_value;
+	size_t size;
+	int ierr;
+	int i;
+
+	if (!nf->writable) {
+		return NATIVE_EPERM;
+	}
+
+	if (strlen(name) > NATIVE_MAX_NAME) {
+		return NATIVE_EBADNAME;
+	}
+
+	if ((ierr = get_atts(nf, varid, &natts, &atts)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	if ((size = type_size(type)) == 0) {
+		return NATIVE_EBADTYPE;
+	}
+
+	new_value = malloc(size * len + 1);
+	if (new_value == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	memcpy(new_value, value, size * len);
+
+	for (i = 0; i < *natts; i++) {
+		if (strcmp((*atts)[i].name, name) == 0) {
+			att = &(*atts)[i];
+			free(att->value);
+			break;
+		}
+	}
+
+	if (att == NULL) {
+		new_atts = (struct SMIOL_native_att *)realloc(*atts,
+		                  sizeof(struct SMIOL_native_att) * (size_t)(*natts + 1));
+		if (new_atts == NULL) {
+			free(new_value);
+			return NATIVE_ENOMEM;
+		}
+		*atts = new_atts;
+
+		att = &new_atts[*natts];
+		att->name = copy_name(name);
+		if (att->name == NULL) {
+			free(new_value);
+			return NATIVE_ENOMEM;
+		}
+		(*natts)++;
+	}
+
+	att->type = type;
+	att->len = len;
+	att->value = new_value;
+	nf->define_mode = 1;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * native_inq_att
+ *
+ * Returns the type and number of values of an attribute in a native file
+ *
+ *******************************************************************************/
+int native_inq_att(const struct SMIOL_native *nf, int varid, const char *name,
+                   int *type, size_t *len)
+{
+	int *natts;
+	struct SMIOL_native_att **atts;
+	int ierr;
+	int i;
+
+	if ((ierr = get_atts(nf, varid, &natts, &atts)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	for (i = 0; i < *natts; i++) {
+		if (strcmp((*atts)[i].name, name) == 0) {
+			if (type != NULL) {
+				*type = (*atts)[i].type;
+			}
+			if (len != NULL) {
+				*len = (*atts)[i].len;
+			}
+			return NATIVE_NOERR;
+		}
+	}
+
+	return NATIVE_ENOTATT;
+}
+
+
+/*******************************************************************************
+ *
+ * native_get_att
+ *
+ * Returns the values of an attribute in a native file
+ *
+ *******************************************************************************/
+int native_get_att(const struct SMIOL_native *nf, int varid, const char *name,
+                   void *value)
+{
+	int *natts;
+	struct SMIOL_native_att **atts;
+	int ierr;
+	int i;
+
+	if ((ierr = get_atts(nf, varid, &natts, &atts)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	for (i = 0; i < *natts; i++) {
+		if (strcmp((*atts)[i].name, name) == 0) {
+			memcpy(value, (*atts)[i].value,
+			       type_size((*atts)[i].type) * (*atts)[i].len);
+			return NATIVE_NOERR;
+		}
+	}
+
+	return NATIVE_ENOTATT;
+}
+
+
+/*******************************************************************************
+ *
+ * native_put_vara_all
+ *
+ * Collectively writes a hyperslab of a variable to a native file
+ *
+ * Writes the values in buf to the hyperslab of the variable with ID varid
+ * given by start and count, with all tasks that opened the file writing
+ * together in one collective MPI-IO call; tasks with nothing to write take part
+ * with zero counts. Writes to the records of record variables beyond the last
+ * record add records to the file.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_put_vara_all(struct SMIOL_native *nf, int varid,
+                        const MPI_Offset *start, const MPI_Offset *count,
+                        const void *buf)
+{
+	int ierr;
+
+	if (!nf->writable) {
+		return NATIVE_EPERM;
+	}
+
+	ierr = access_all(nf, varid, start, count, (void *)buf, 1);
+	if (ierr != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	return agree_numrecs(nf);
+}
+
+
+/*******************************************************************************
+ *
+ * native_get_vara_all
+ *
+ * Collectively reads a hyperslab of a variable from a native file
+ *
+ * Reads the hyperslab of the variable with ID varid given by start and count
+ * into buf, with all tasks that opened the file reading together in one
+ * collective MPI-IO call. Values never written are read as zero.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_get_vara_all(struct SMIOL_native *nf, int varid,
+                        const MPI_Offset *start, const MPI_Offset *count,
+                        void *buf)
+{
+	return access_all(nf, varid, start, count, buf, 0);
+}
+
+
+/*******************************************************************************
+ *
+ * native_iput_vara
+ *
+ * Starts an independent write of a hyperslab of a variable to a native file
+ *
+ * Like native_put_vara_all, but only the calling task writes, and the write is
+ * only started, with one nonblocking MPI-IO call for each contiguous run of the
+ * hyperslab in the file, so that the data drain to the file while the caller
+ * goes on. Where SMIOL is built with SMIOL_IO_URING and the kernel supports it,
+ * the runs of a file without subfiles are instead queued in an io_uring of the
+ * calling task and submitted with one system call. The buffer must not be
+ * modified or freed until the write has been completed by native_wait_all, and
+ * records added to the file are only seen by other tasks after that call.
+ * Writes started earlier that have completed in the meantime are released
+ * first.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_iput_vara(struct SMIOL_native *nf, int varid,
+                     const MPI_Offset *start, const MPI_Offset *count,
+                     const void *buf)
+{
+	const struct SMIOL_native_var *var;
+	MPI_Offset nbytes;
+	const char *p;
+	void *swapped = NULL;
+	int *lens;
+	MPI_Aint *offsets;
+	int n_runs;
+	int ierr;
+	int i;
+
+	if (!nf->writable) {
+		return NATIVE_EPERM;
+	}
+
+	if (varid < 0 || varid >= nf->nvars) {
+		return NATIVE_ENOTVAR;
+	}
+	var = &nf->vars[varid];
+
+	if ((ierr = check_coords(nf, var, start, count, 0, &nbytes)) != NATIVE_NOERR) {
+		return ierr;
+	}
+	if (nbytes == 0) {
+		return NATIVE_NOERR;
+	}
+
+	if (nf->discard) {
+		nf->bytes_written += nbytes;
+		if (var->is_record && start[0] + count[0] > nf->local_numrecs) {
+			nf->local_numrecs = start[0] + count[0];
+		}
+		return NATIVE_NOERR;
+	}
+
+	if ((ierr = test_writes(nf)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	if (nf->n_subfiles > 0) {
+		ierr = sub_access(nf, varid, start, count, (void *)buf, nbytes, 1, 1);
+		if (ierr == NATIVE_NOERR) {
+			nf->bytes_written += nbytes;
+			if (var->is_record && start[0] + count[0] > nf->local_numrecs) {
+				nf->local_numrecs = start[0] + count[0];
+			}
+		}
+		return ierr;
+	}
+
+	if ((ierr = get_runs(nf, var, start, count, NULL, &n_runs, &lens, &offsets)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	if ((ierr = reserve_writes(nf, n_runs)) != NATIVE_NOERR) {
+		free(lens);
+		free(offsets);
+		return ierr;
+	}
+
+	/*
+	 * A byte-swapped copy is owned by the file, and freed with the first
+	 * of the requests that write it once they have all completed
+	 */
+	p = (const char *)buf;
+	if (!host_is_little_endian() && type_size(var->type) > 1) {
+		swapped = malloc((size_t)nbytes);
+		if (swapped == NULL) {
+			free(lens);
+			free(offsets);
+			return NATIVE_ENOMEM;
+		}
+		memcpy(swapped, buf, (size_t)nbytes);
+		swap_bytes(swapped, (size_t)nbytes / type_size(var->type), type_size(var->type));
+		p = (const char *)swapped;
+	}
+
+#ifdef SMIOL_IO_URING
+	if (nf->uring == NULL && !nf->no_uring) {
+		uring_setup(nf);
+	}
+#endif
+
+	if (nf->uring != NULL) {
+#ifdef SMIOL_IO_URING
+		/*
+		 * The runs are queued in the io_uring of this task and submitted
+		 * together, and a byte-swapped copy is held by a null request
+		 * until the ring has drained
+		 */
+		for (i = 0; i < n_runs && ierr == NATIVE_NOERR; i++) {
+			ierr = uring_write(nf->uring, (MPI_Offset)offsets[i], p, (size_t)lens[i]);
+			p += lens[i];
+		}
+		if (nf->uring->n_queued > 0) {
+			int ierr2 = uring_enter(nf->uring, 0);
+
+			if (ierr == NATIVE_NOERR) {
+				ierr = ierr2;
+			}
+		}
+		if (swapped != NULL) {
+			nf->reqs[nf->n_reqs] = MPI_REQUEST_NULL;
+			nf->req_bufs[nf->n_reqs] = swapped;
+			nf->n_reqs++;
+			swapped = NULL;
+		}
+#endif
+	} else {
+		for (i = 0; i < n_runs && ierr == NATIVE_NOERR; i++) {
+			if (MPI_File_iwrite_at(nf->fh, (MPI_Offset)offsets[i], (void *)p, lens[i],
+			                       MPI_BYTE, &nf->reqs[nf->n_reqs]) != MPI_SUCCESS) {
+				ierr = NATIVE_EMPI;
+			} else {
+				nf->req_bufs[nf->n_reqs] = swapped;
+				nf->n_reqs++;
+				swapped = NULL;
+			}
+			p += lens[i];
+		}
+	}
+
+	/* A copy that no request was started for is freed here */
+	free(swapped);
+	free(lens);
+	free(offsets);
+
+	if (ierr == NATIVE_NOERR) {
+		nf->bytes_written += nbytes;
+	}
+
+	if (ierr == NATIVE_NOERR && var->is_record
+	    && start[0] + count[0] > nf->local_numrecs) {
+		nf->local_numrecs = start[0] + count[0];
+	}
+
+	return ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * native_wait_all
+ *
+ * Completes independent writes to a native file
+ *
+ * Waits for all independent writes started by the calling task (see
+ * native_iput_vara) to complete, then collectively makes the records added by
+ * those writes known to all tasks that opened the file.
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int native_wait_all(struct SMIOL_native *nf)
+{
+	int ierr;
+	int ierr2;
+
+	/* All tasks agree on the records even if this task's writes failed */
+	ierr = finish_writes(nf);
+	ierr2 = agree_numrecs(nf);
+
+	return (ierr != NATIVE_NOERR) ? ierr : ierr2;
+}
+
+
+/*******************************************************************************
+ *
+ * native_inq_writes
+ *
+ * Returns the number of independent writes to a native file in flight
+ *
+ * Sets n_writes to the number of independent writes started by the calling
+ * task (see native_iput_vara), through MPI-IO or an io_uring, that have not
+ * yet been released. Writes are released by native_wait_all, by collective
+ * accesses to the file, and as later writes are started.
+ *
+ * NATIVE_NOERR is always returned.
+ *
+ *******************************************************************************/
+int native_inq_writes(const struct SMIOL_native *nf, int *n_writes)
+{
+	*n_writes = nf->n_reqs;
+
+#ifdef SMIOL_IO_URING
+	if (nf->uring != NULL) {
+		*n_writes += nf->uring->n_inflight;
+	}
+#endif
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * type_size
+ *
+ * Returns the size in bytes of a value of a SMIOL type, or zero if the type is
+ * not valid
+ *
+ *******************************************************************************/
+static size_t type_size(int type)
+{
+	switch (type) {
+	case SMIOL_REAL32:
+		return sizeof(float);
+	case SMIOL_REAL64:
+		return sizeof(double);
+	case SMIOL_INT32:
+		return sizeof(int);
+	case SMIOL_CHAR:
+		return sizeof(char);
+	default:
+		return 0;
+	}
+}
+
+
+/*******************************************************************************
+ *
+ * host_is_little_endian
+ *
+ * Returns non-zero if values are stored in memory in little-endian byte order
+ *
+ *******************************************************************************/
+static int host_is_little_endian(void)
+{
+	int one = 1;
+
+	return (*(char *)&one == 1);
+}
+
+
+/*******************************************************************************
+ *
+ * swap_bytes
+ *
+ * Reverses the order of the bytes of each of n values of size bytes in buf
+ *
+ *******************************************************************************/
+static void swap_bytes(void *buf, size_t n, size_t size)
+{
+	unsigned char *p = (unsigned char *)buf;
+	unsigned char tmp;
+	size_t i, j;
+
+	if (size < 2) {
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < size / 2; j++) {
+			tmp = p[j];
+			p[j] = p[size - 1 - j];
+			p[size - 1 - j] = tmp;
+		}
+		p += size;
+	}
+}
+
+
+/*******************************************************************************
+ *
+ * copy_name
+ *
+ * Returns a newly allocated copy of a string, or NULL if allocation fails
+ *
+ *******************************************************************************/
+static char *copy_name(const char *name)
+{
+	char *copy;
+
+	copy = (char *)malloc(strlen(name) + 1);
+	if (copy != NULL) {
+		strcpy(copy, name);
+	}
+
+	return copy;
+}
+
+
+/*******************************************************************************
+ *
+ * round_up
+ *
+ * Rounds an offset up to a multiple of align
+ *
+ *******************************************************************************/
+static MPI_Offset round_up(MPI_Offset offset, MPI_Offset align)
+{
+	return (offset + align - 1) / align * align;
+}
+
+
+/*******************************************************************************
+ *
+ * new_native
+ *
+ * Allocates a native file with no definitions for the tasks in comm, or returns
+ * NULL if allocation fails
+ *
+ *******************************************************************************/
+static struct SMIOL_native *new_native(MPI_Comm comm)
+{
+	struct SMIOL_native *nf;
+
+	nf = (struct SMIOL_native *)malloc(sizeof(struct SMIOL_native));
+	if (nf == NULL) {
+		return NULL;
+	}
+
+	nf->comm = comm;
+	MPI_Comm_rank(comm, &nf->comm_rank);
+	nf->fh = MPI_FILE_NULL;
+	nf->writable = 0;
+	nf->define_mode = 0;
+	nf->has_layout = 0;
+	nf->layout_nvars = 0;
+	nf->discard = 0;
+	nf->bytes_written = 0;
+	nf->n_reqs = 0;
+	nf->max_reqs = 0;
+	nf->reqs = NULL;
+	nf->req_bufs = NULL;
+	nf->uring = NULL;
+	nf->no_uring = 0;
+	nf->ndims = 0;
+	nf->dims = NULL;
+	nf->nvars = 0;
+	nf->vars = NULL;
+	nf->ngatts = 0;
+	nf->gatts = NULL;
+	nf->unlimdimid = -1;
+	nf->filename = NULL;
+	nf->n_subfiles = 0;
+	nf->sub_fh = NULL;
+	nf->sub_begin = NULL;
+	nf->sub_record_begin = NULL;
+	nf->sub_record_size = NULL;
+	nf->numrecs = 0;
+	nf->local_numrecs = 0;
+	nf->header_size = 0;
+	nf->record_begin = 0;
+	nf->record_size = 0;
+
+	return nf;
+}
+
+
+/*******************************************************************************
+ *
+ * free_atts
+ *
+ * Frees a list of attributes
+ *
+ *******************************************************************************/
+static void free_atts(int natts, struct SMIOL_native_att *atts)
+{
+	int i;
+
+	for (i = 0; i < natts; i++) {
+		free(atts[i].name);
+		free(atts[i].value);
+	}
+	free(atts);
+}
+
+
+/*******************************************************************************
+ *
+ * free_native
+ *
+ * Frees a native file and all of its definitions
+ *
+ *******************************************************************************/
+static void free_native(struct SMIOL_native *nf)
+{
+	int i;
+
+	for (i = 0; i < nf->ndims; i++) {
+		free(nf->dims[i].name);
+	}
+	free(nf->dims);
+
+	for (i = 0; i < nf->nvars; i++) {
+		free(nf->vars[i].name);
+		free(nf->vars[i].dimids);
+		free_atts(nf->vars[i].natts, nf->vars[i].atts);
+	}
+	free(nf->vars);
+
+	free_atts(nf->ngatts, nf->gatts);
+	free(nf->reqs);
+	free(nf->req_bufs);
+#ifdef SMIOL_IO_URING
+	if (nf->uring != NULL) {
+		uring_free(nf->uring);
+	}
+#endif
+	free(nf->filename);
+	free(nf->sub_fh);
+	free(nf->sub_begin);
+	free(nf->sub_record_begin);
+	free(nf->sub_record_size);
+	free(nf);
+}
+
+
+/*******************************************************************************
+ *
+ * get_atts
+ *
+ * Returns the list of attributes of a variable, or the global attributes
+ *
+ * Given the ID of a variable, or NATIVE_GLOBAL, returns pointers to the number
+ * of attributes and to the list of attributes, which may be changed by the
+ * caller.
+ *
+ *******************************************************************************/
+static int get_atts(const struct SMIOL_native *nf, int varid,
+                    int **natts, struct SMIOL_native_att ***atts)
+{
+	struct SMIOL_native *mnf = (struct SMIOL_native *)nf;
+
+	if (varid == NATIVE_GLOBAL) {
+		*natts = &mnf->ngatts;
+		*atts = &mnf->gatts;
+		return NATIVE_NOERR;
+	}
+
+	if (varid < 0 || varid >= nf->nvars) {
+		return NATIVE_ENOTVAR;
+	}
+
+	*natts = &mnf->vars[varid].natts;
+	*atts = &mnf->vars[varid].atts;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * put_bytes, put_u32, put_u64, put_name, put_atts
+ *
+ * Append bytes, little-endian integers, names, and lists of attributes to a
+ * buffer being encoded; if the buffer cannot be grown, the error is recorded in
+ * the buffer and nothing more is appended
+ *
+ *******************************************************************************/
+static void put_bytes(struct native_buf *b, const void *p, size_t n)
+{
+	unsigned char *data;
+	size_t cap;
+
+	if (b->ierr != NATIVE_NOERR) {
+		return;
+	}
+
+	if (b->len + n > b->cap) {
+		cap = (b->cap > 0) ? 2 * b->cap : 1024;
+		while (cap < b->len + n) {
+			cap *= 2;
+		}
+		data = (unsigned char *)realloc(b->data, cap);
+		if (data == NULL) {
+			b->ierr = NATIVE_ENOMEM;
+			return;
+		}
+		b->data = data;
+		b->cap = cap;
+	}
+
+	memcpy(b->data + b->len, p, n);
+	b->len += n;
+}
+
+static void put_u32(struct native_buf *b, uint32_t v)
+{
+	unsigned char bytes[4];
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		bytes[i] = (unsigned char)((v >> (8 * i)) & 0xff);
+	}
+	put_bytes(b, bytes, 4);
+}
+
+static void put_u64(struct native_buf *b, uint64_t v)
+{
+	unsigned char bytes[8];
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		bytes[i] = (unsigned char)((v >> (8 * i)) & 0xff);
+	}
+	put_bytes(b, bytes, 8);
+}
+
+static void put_name(struct native_buf *b, const char *name)
+{
+	put_u32(b, (uint32_t)strlen(name));
+	put_bytes(b, name, strlen(name));
+}
+
+static void put_atts(struct native_buf *b, int natts,
+                     const struct SMIOL_native_att *atts)
+{
+	size_t size;
+	size_t start;
+	int i;
+
+	put_u32(b, (uint32_t)natts);
+	for (i = 0; i < natts; i++) {
+		size = type_size(atts[i].type);
+		put_name(b, atts[i].name);
+		put_u32(b, (uint32_t)atts[i].type);
+		put_u64(b, (uint64_t)atts[i].len);
+		start = b->len;
+		put_bytes(b, atts[i].value, size * atts[i].len);
+		if (b->ierr == NATIVE_NOERR && !host_is_little_endian()) {
+			swap_bytes(b->data + start, atts[i].len, size);
+		}
+	}
+}
+
+
+/*******************************************************************************
+ *
+ * encode_header
+ *
+ * Encodes the header of a native file into a newly allocated buffer, which the
+ * caller must free
+ *
+ *******************************************************************************/
+static int encode_header(const struct SMIOL_native *nf, struct native_buf *b)
+{
+	const struct SMIOL_native_var *var;
+	int i, j;
+
+	b->data = NULL;
+	b->len = 0;
+	b->cap = 0;
+	b->ierr = NATIVE_NOERR;
+
+	put_bytes(b, NATIVE_MAGIC, 8);
+	put_u32(b, (uint32_t)NATIVE_VERSION);
+	put_u32(b, (uint32_t)nf->n_subfiles);
+	put_u64(b, (uint64_t)nf->numrecs);
+	put_u64(b, (uint64_t)nf->header_size);
+	put_u64(b, (uint64_t)nf->record_begin);
+	put_u64(b, (uint64_t)nf->record_size);
+
+	put_u32(b, (uint32_t)nf->ndims);
+	for (i = 0; i < nf->ndims; i++) {
+		put_name(b, nf->dims[i].name);
+		put_u64(b, (uint64_t)nf->dims[i].len);
+	}
+
+	put_atts(b, nf->ngatts, nf->gatts);
+
+	put_u32(b, (uint32_t)nf->nvars);
+	for (i = 0; i < nf->nvars; i++) {
+		var = &nf->vars[i];
+		put_name(b, var->name);
+		put_u32(b, (uint32_t)var->type);
+		put_u32(b, (uint32_t)var->ndims);
+		for (j = 0; j < var->ndims; j++) {
+			put_u32(b, (uint32_t)var->dimids[j]);
+		}
+		put_u64(b, (uint64_t)var->begin);
+		put_atts(b, var->natts, var->atts);
+	}
+
+	if (b->ierr != NATIVE_NOERR) {
+		free(b->data);
+		b->data = NULL;
+	}
+
+	return b->ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * get_u32, get_u64, get_name, get_atts_from
+ *
+ * Decode little-endian integers, names, and lists of attributes at position pos
+ * of a header of len bytes, advancing pos; NATIVE_ENOTNATIVE is returned if
+ * the header ends too soon
+ *
+ *******************************************************************************/
+static int get_u32(const unsigned char *data, size_t len, size_t *pos,
+                   uint32_t *v)
+{
+	int i;
+
+	if (*pos + 4 > len) {
+		return NATIVE_ENOTNATIVE;
+	}
+
+	*v = 0;
+	for (i = 3; i >= 0; i--) {
+		*v = (*v << 8) | (uint32_t)data[*pos + (size_t)i];
+	}
+	*pos += 4;
+
+	return NATIVE_NOERR;
+}
+
+static int get_u64(const unsigned char *data, size_t len, size_t *pos,
+                   uint64_t *v)
+{
+	int i;
+
+	if (*pos + 8 > len) {
+		return NATIVE_ENOTNATIVE;
+	}
+
+	*v = 0;
+	for (i = 7; i >= 0; i--) {
+		*v = (*v << 8) | (uint64_t)data[*pos + (size_t)i];
+	}
+	*pos += 8;
+
+	return NATIVE_NOERR;
+}
+
+static int get_name(const unsigned char *data, size_t len, size_t *pos,
+                    char **name)
+{
+	uint32_t n;
+
+	if (get_u32(data, len, pos, &n) != NATIVE_NOERR || *pos + n > len
+	    || n > NATIVE_MAX_NAME) {
+		return NATIVE_ENOTNATIVE;
+	}
+
+	*name = (char *)malloc((size_t)n + 1);
+	if (*name == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	memcpy(*name, data + *pos, (size_t)n);
+	(*name)[n] = '\0';
+	*pos += n;
+
+	return NATIVE_NOERR;
+}
+
+static int get_atts_from(const unsigned char *data, size_t len, size_t *pos,
+                         int *natts, struct SMIOL_native_att **atts)
+{
+	struct SMIOL_native_att *att;
+	uint32_t n;
+	uint32_t type;
+	uint64_t n_values;
+	size_t size;
+	int ierr;
+	uint32_t i;
+
+	*natts = 0;
+	*atts = NULL;
+
+	if ((ierr = get_u32(data, len, pos, &n)) != NATIVE_NOERR) {
+		return ierr;
+	}
+	if ((size_t)n > len) {
+		return NATIVE_ENOTNATIVE;
+	}
+
+	*atts = (struct SMIOL_native_att *)calloc((size_t)n + 1, sizeof(struct SMIOL_native_att));
+	if (*atts == NULL) {
+		return NATIVE_ENOMEM;
+	}
+
+	for (i = 0; i < n; i++) {
+		att = &(*atts)[i];
+		if ((ierr = get_name(data, len, pos, &att->name)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		(*natts)++;
+
+		if ((ierr = get_u32(data, len, pos, &type)) != NATIVE_NOERR
+		    || (ierr = get_u64(data, len, pos, &n_values)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		att->type = (int)type;
+		size = type_size(att->type);
+		if (size == 0 || n_values > (uint64_t)len || *pos + size * (size_t)n_values > len) {
+			return NATIVE_ENOTNATIVE;
+		}
+		att->len = (size_t)n_values;
+		att->value = malloc(size * att->len + 1);
+		if (att->value == NULL) {
+			return NATIVE_ENOMEM;
+		}
+		memcpy(att->value, data + *pos, size * att->len);
+		if (!host_is_little_endian()) {
+			swap_bytes(att->value, att->len, size);
+		}
+		*pos += size * att->len;
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * decode_header
+ *
+ * Decodes the header of a native file of len bytes into the definitions of a
+ * native file that has none
+ *
+ * Upon success, NATIVE_NOERR is returned; otherwise, an error code is returned,
+ * and any definitions that were decoded are freed with the file.
+ *
+ *******************************************************************************/
+static int decode_header(struct SMIOL_native *nf, const unsigned char *data,
+                         size_t len)
+{
+	struct SMIOL_native_var *var;
+	uint64_t v64;
+	uint32_t v32;
+	uint32_t n;
+	size_t pos;
+	int ierr;
+	int i, j;
+
+	if (len < NATIVE_FIXED_HEADER_BYTES || memcmp(data, NATIVE_MAGIC, 8) != 0) {
+		return NATIVE_ENOTNATIVE;
+	}
+
+	pos = 8;
+	get_u32(data, len, &pos, &v32);
+	if (v32 != NATIVE_VERSION) {
+		return NATIVE_ENOTNATIVE;
+	}
+	get_u32(data, len, &pos, &v32);
+	if (v32 > (uint32_t)INT_MAX) {
+		return NATIVE_ENOTNATIVE;
+	}
+	nf->n_subfiles = (int)v32;
+	get_u64(data, len, &pos, &v64);
+	nf->numrecs = (MPI_Offset)v64;
+	nf->local_numrecs = nf->numrecs;
+	get_u64(data, len, &pos, &v64);
+	nf->header_size = (MPI_Offset)v64;
+	get_u64(data, len, &pos, &v64);
+	nf->record_begin = (MPI_Offset)v64;
+	get_u64(data, len, &pos, &v64);
+	nf->record_size = (MPI_Offset)v64;
+
+	/*
+	 * Dimensions
+	 */
+	if ((ierr = get_u32(data, len, &pos, &n)) != NATIVE_NOERR) {
+		return ierr;
+	}
+	if ((size_t)n > len) {
+		return NATIVE_ENOTNATIVE;
+	}
+	nf->dims = (struct SMIOL_native_dim *)calloc((size_t)n + 1, sizeof(struct SMIOL_native_dim));
+	if (nf->dims == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	for (i = 0; i < (int)n; i++) {
+		if ((ierr = get_name(data, len, &pos, &nf->dims[i].name)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		nf->ndims++;
+		if ((ierr = get_u64(data, len, &pos, &v64)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		nf->dims[i].len = (SMIOL_Offset)(int64_t)v64;
+		if (nf->dims[i].len < 0) {
+			nf->dims[i].len = -1;
+			nf->unlimdimid = i;
+		}
+	}
+
+	/*
+	 * Global attributes
+	 */
+	if ((ierr = get_atts_from(data, len, &pos, &nf->ngatts, &nf->gatts)) != NATIVE_NOERR) {
+		return ierr;
+	}
+
+	/*
+	 * Variables
+	 */
+	if ((ierr = get_u32(data, len, &pos, &n)) != NATIVE_NOERR) {
+		return ierr;
+	}
+	if ((size_t)n > len) {
+		return NATIVE_ENOTNATIVE;
+	}
+	nf->vars = (struct SMIOL_native_var *)calloc((size_t)n + 1, sizeof(struct SMIOL_native_var));
+	if (nf->vars == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	for (i = 0; i < (int)n; i++) {
+		var = &nf->vars[i];
+		if ((ierr = get_name(data, len, &pos, &var->name)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		nf->nvars++;
+
+		if ((ierr = get_u32(data, len, &pos, &v32)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		var->type = (int)v32;
+		if ((ierr = get_u32(data, len, &pos, &v32)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		if ((size_t)v32 > len || type_size(var->type) == 0) {
+			return NATIVE_ENOTNATIVE;
+		}
+		var->ndims = (int)v32;
+
+		var->dimids = (int *)malloc(sizeof(int) * (size_t)(var->ndims + 1));
+		if (var->dimids == NULL) {
+			return NATIVE_ENOMEM;
+		}
+		var->size = (MPI_Offset)type_size(var->type);
+		for (j = 0; j < var->ndims; j++) {
+			if ((ierr = get_u32(data, len, &pos, &v32)) != NATIVE_NOERR) {
+				return ierr;
+			}
+			if ((int)v32 >= nf->ndims) {
+				return NATIVE_ENOTNATIVE;
+			}
+			var->dimids[j] = (int)v32;
+			if (j == 0 && var->dimids[j] == nf->unlimdimid) {
+				var->is_record = 1;
+			} else {
+				var->size *= (MPI_Offset)nf->dims[var->dimids[j]].len;
+			}
+		}
+
+		if ((ierr = get_u64(data, len, &pos, &v64)) != NATIVE_NOERR) {
+			return ierr;
+		}
+		var->begin = (MPI_Offset)v64;
+
+		if ((ierr = get_atts_from(data, len, &pos, &var->natts, &var->atts)) != NATIVE_NOERR) {
+			return ierr;
+		}
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * write_numrecs
+ *
+ * Collectively records the number of records of a native file in its header
+ *
+ *******************************************************************************/
+static int write_numrecs(struct SMIOL_native *nf)
+{
+	struct native_buf b;
+	MPI_Status status;
+	int ierr = NATIVE_NOERR;
+
+	if ((ierr = agree_numrecs(nf)) != NATIVE_NOERR || nf->discard) {
+		return ierr;
+	}
+
+	if (nf->comm_rank == 0) {
+		b.data = NULL;
+		b.len = 0;
+		b.cap = 0;
+		b.ierr = NATIVE_NOERR;
+		put_u64(&b, (uint64_t)nf->numrecs);
+		ierr = b.ierr;
+		if (ierr == NATIVE_NOERR
+		    && MPI_File_write_at(nf->fh, (MPI_Offset)NATIVE_NUMRECS_OFFSET,
+		                         b.data, (int)b.len, MPI_BYTE, &status) != MPI_SUCCESS) {
+			ierr = NATIVE_EMPI;
+		}
+		free(b.data);
+	}
+
+	if (MPI_Bcast(&ierr, 1, MPI_INT, 0, nf->comm) != MPI_SUCCESS) {
+		return NATIVE_EMPI;
+	}
+
+	return ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * move_bytes
+ *
+ * Copies len bytes of a file from offset from to offset to, in pieces of at
+ * most NATIVE_MOVE_BYTES, in an order that is correct even if the two ranges
+ * overlap; bytes beyond the end of the file are copied as zeros
+ *
+ *******************************************************************************/
+static int move_bytes(MPI_File fh, MPI_Offset from, MPI_Offset to,
+                      MPI_Offset len)
+{
+	MPI_Offset piece;
+	MPI_Offset done;
+	MPI_Offset pos;
+	MPI_Status status;
+	void *buf;
+	int ierr = NATIVE_NOERR;
+
+	if (from == to || len == 0) {
+		return NATIVE_NOERR;
+	}
+
+	piece = (len < (MPI_Offset)NATIVE_MOVE_BYTES) ? len : (MPI_Offset)NATIVE_MOVE_BYTES;
+	buf = malloc((size_t)piece);
+	if (buf == NULL) {
+		return NATIVE_ENOMEM;
+	}
+
+	for (done = 0; done < len && ierr == NATIVE_NOERR; done += piece) {
+		if (len - done < piece) {
+			piece = len - done;
+		}
+
+		/*
+		 * Moving towards the end of the file, copy the last piece first
+		 */
+		pos = (to > from) ? (len - done - piece) : done;
+
+		memset(buf, 0, (size_t)piece);
+		if (MPI_File_read_at(fh, from + pos, buf, (int)piece, MPI_BYTE, &status) != MPI_SUCCESS
+		    || MPI_File_write_at(fh, to + pos, buf, (int)piece, MPI_BYTE, &status) != MPI_SUCCESS) {
+			ierr = NATIVE_EMPI;
+		}
+	}
+
+	free(buf);
+
+	return ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * check_coords
+ *
+ * Checks a hyperslab of a variable and returns its size
+ *
+ * Given a variable and the start and count arrays of a hyperslab, checks that
+ * the hyperslab lies within the dimensions of the variable -- and, for reads of
+ * record variables, within the records of the file -- and returns in nbytes the
+ * size in bytes of the hyperslab. Hyperslabs with no values are not checked.
+ *
+ *******************************************************************************/
+static int check_coords(const struct SMIOL_native *nf,
+                        const struct SMIOL_native_var *var,
+                        const MPI_Offset *start, const MPI_Offset *count,
+                        int reading, MPI_Offset *nbytes)
+{
+	MPI_Offset len;
+	int i;
+
+	*nbytes = (MPI_Offset)type_size(var->type);
+	for (i = 0; i < var->ndims; i++) {
+		if (count[i] < 0) {
+			return NATIVE_EINVALCOORDS;
+		}
+		*nbytes *= count[i];
+	}
+
+	if (*nbytes == 0) {
+		return NATIVE_NOERR;
+	}
+
+	for (i = 0; i < var->ndims; i++) {
+		if (i == 0 && var->is_record) {
+			len = reading ? nf->numrecs : start[0] + count[0];
+		} else {
+			len = (MPI_Offset)nf->dims[var->dimids[i]].len;
+		}
+		if (start[i] < 0 || start[i] + count[i] > len) {
+			return NATIVE_EINVALCOORDS;
+		}
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * get_runs
+ *
+ * Returns the contiguous runs of bytes of a hyperslab in a native file
+ *
+ * Given a variable and the start and count arrays of a hyperslab with at least
+ * one value, returns in offsets and lens newly allocated arrays with the file
+ * offset and length in bytes of each of the n_runs contiguous runs that make up
+ * the hyperslab, in increasing order of offset, which is also the order of the
+ * values of the hyperslab in memory. Runs are split into pieces of at most
+ * NATIVE_MAX_RUN bytes.
+ *
+ * Offsets are in the file itself if place is NULL, or otherwise where the
+ * variable is laid out as described by place, as it is in a subfile.
+ *
+ *******************************************************************************/
+static int get_runs(const struct SMIOL_native *nf,
+                    const struct SMIOL_native_var *var,
+                    const MPI_Offset *start, const MPI_Offset *count,
+                    const struct native_place *place,
+                    int *n_runs, int **lens, MPI_Aint **offsets)
+{
+	const MPI_Offset *istart;
+	const MPI_Offset *icount;
+	MPI_Offset *ilen;
+	MPI_Offset *stride;
+	MPI_Offset *idx;
+	MPI_Offset size;
+	MPI_Offset run;
+	MPI_Offset n_pieces;
+	MPI_Offset n_outer;
+	MPI_Offset n_recs;
+	MPI_Offset total;
+	MPI_Offset base;
+	MPI_Offset offset;
+	MPI_Offset rec;
+	MPI_Offset o;
+	MPI_Offset p;
+	int first;
+	int k;
+	int m;
+	int i, j;
+	int n;
+
+	size = (MPI_Offset)type_size(var->type);
+	first = var->is_record ? 1 : 0;
+	k = var->ndims - first;
+	istart = start + first;
+	icount = count + first;
+	n_recs = var->is_record ? count[0] : 1;
+
+	ilen = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(3 * k + 1));
+	if (ilen == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	stride = ilen + k;
+	idx = stride + k;
+
+	for (j = 0; j < k; j++) {
+		ilen[j] = (MPI_Offset)nf->dims[var->dimids[j + first]].len;
+	}
+	if (place != NULL && k > 0) {
+		ilen[0] = place->split_len;
+	}
+	for (j = k - 1; j >= 0; j--) {
+		stride[j] = (j == k - 1) ? 1 : stride[j + 1] * ilen[j + 1];
+	}
+
+	/*
+	 * Runs span dimension m and every following dimension, all of which
+	 * are selected in full
+	 */
+	m = (k > 0) ? k - 1 : 0;
+	while (m > 0 && istart[m] == 0 && icount[m] == ilen[m]) {
+		m--;
+	}
+	run = size;
+	n_outer = 1;
+	if (k > 0) {
+		run = size * icount[m] * stride[m];
+		for (j = 0; j < m; j++) {
+			n_outer *= icount[j];
+		}
+	}
+
+	n_pieces = (run + NATIVE_MAX_RUN - 1) / NATIVE_MAX_RUN;
+	total = n_recs * n_outer * n_pieces;
+	if (total > (MPI_Offset)INT_MAX) {
+		free(ilen);
+		return NATIVE_EINVALCOORDS;
+	}
+
+	*n_runs = (int)total;
+	*lens = (int *)malloc(sizeof(int) * (size_t)(total + 1));
+	*offsets = (MPI_Aint *)malloc(sizeof(MPI_Aint) * (size_t)(total + 1));
+	if (*lens == NULL || *offsets == NULL) {
+		free(*lens);
+		free(*offsets);
+		free(ilen);
+		return NATIVE_ENOMEM;
+	}
+
+	n = 0;
+	for (rec = 0; rec < n_recs; rec++) {
+		if (place != NULL && var->is_record) {
+			base = place->record_begin + (start[0] + rec) * place->record_size + place->begin;
+		} else if (place != NULL) {
+			base = place->begin;
+		} else if (var->is_record) {
+			base = nf->record_begin + (start[0] + rec) * nf->record_size + var->begin;
+		} else {
+			base = var->begin;
+		}
+
+		for (j = 0; j < m; j++) {
+			idx[j] = istart[j];
+		}
+
+		for (o = 0; o < n_outer; o++) {
+			offset = 0;
+			for (j = 0; j < m; j++) {
+				offset += idx[j] * stride[j];
+			}
+			if (k > 0) {
+				offset += istart[m] * stride[m];
+			}
+			offset = base + offset * size;
+
+			for (p = 0; p < run; p += NATIVE_MAX_RUN) {
+				(*offsets)[n] = (MPI_Aint)(offset + p);
+				(*lens)[n] = (int)((run - p < NATIVE_MAX_RUN) ? (run - p) : NATIVE_MAX_RUN);
+				n++;
+			}
+
+			/*
+			 * Advance the indices of the dimensions before m
+			 */
+			for (i = m - 1; i >= 0; i--) {
+				idx[i]++;
+				if (idx[i] < istart[i] + icount[i]) {
+					break;
+				}
+				idx[i] = istart[i];
+			}
+		}
+	}
+
+	free(ilen);
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * get_memtype
+ *
+ * Returns a committed MPI datatype describing nbytes contiguous bytes, for
+ * sizes that may not fit in an int count of bytes
+ *
+ *******************************************************************************/
+static int get_memtype(MPI_Offset nbytes, MPI_Datatype *memtype)
+{
+	MPI_Datatype piece_type;
+	MPI_Datatype types[2];
+	MPI_Aint displs[2];
+	int blocklens[2];
+	MPI_Offset n_pieces;
+	MPI_Offset rest;
+
+	n_pieces = nbytes / NATIVE_MAX_RUN;
+	rest = nbytes % NATIVE_MAX_RUN;
+
+	if (MPI_Type_contiguous((int)NATIVE_MAX_RUN, MPI_BYTE, &piece_type) != MPI_SUCCESS) {
+		return NATIVE_EMPI;
+	}
+
+	types[0] = piece_type;
+	types[1] = MPI_BYTE;
+	displs[0] = 0;
+	displs[1] = (MPI_Aint)(n_pieces * NATIVE_MAX_RUN);
+	blocklens[0] = (int)n_pieces;
+	blocklens[1] = (int)rest;
+
+	if (MPI_Type_create_struct(2, blocklens, displs, types, memtype) != MPI_SUCCESS) {
+		MPI_Type_free(&piece_type);
+		return NATIVE_EMPI;
+	}
+	MPI_Type_free(&piece_type);
+
+	if (MPI_Type_commit(memtype) != MPI_SUCCESS) {
+		MPI_Type_free(memtype);
+		return NATIVE_EMPI;
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * access_all
+ *
+ * Collectively reads or writes a hyperslab of a variable in a native file
+ *
+ * Implements native_put_vara_all (if writing is non-zero) and
+ * native_get_vara_all. Each task sets a file view made of the contiguous runs
+ * of its hyperslab (see get_runs), and all tasks then read or write together in
+ * one collective call before the default view is restored, once any independent
+ * writes of the task have completed. Values are byte-swapped as needed so that
+ * they are little-endian in the file. Files with nothing behind them (see
+ * native_create_null) skip all of this, and only check the hyperslab and count
+ * the bytes written. For subfiled files, each task instead reads or writes its
+ * own hyperslab independently (see sub_access).
+ *
+ * Errors found by any task are returned by all tasks.
+ *
+ *******************************************************************************/
+static int access_all(struct SMIOL_native *nf, int varid,
+                      const MPI_Offset *start, const MPI_Offset *count,
+                      void *buf, int writing)
+{
+	const struct SMIOL_native_var *var = NULL;
+	MPI_Datatype filetype = MPI_BYTE;
+	MPI_Datatype memtype = MPI_BYTE;
+	MPI_Offset nbytes = 0;
+	MPI_Status status;
+	void *io_buf = buf;
+	int *lens = NULL;
+	MPI_Aint *offsets = NULL;
+	int n_runs = 0;
+	int swap;
+	int ierr = NATIVE_NOERR;
+	int mpi_ierr;
+	int all_ierr;
+
+	/*
+	 * Independent writes of this task, including any still in its io_uring,
+	 * must complete before the file view changes and before the collective
+	 * access below, which may overlap them
+	 */
+	ierr = finish_writes(nf);
+
+	if (ierr == NATIVE_NOERR) {
+		if (varid < 0 || varid >= nf->nvars) {
+			ierr = NATIVE_ENOTVAR;
+		} else {
+			var = &nf->vars[varid];
+			ierr = check_coords(nf, var, start, count, !writing, &nbytes);
+		}
+	}
+
+	if (ierr == NATIVE_NOERR && nbytes > 0 && !nf->discard && nf->n_subfiles == 0) {
+		ierr = get_runs(nf, var, start, count, NULL, &n_runs, &lens, &offsets);
+	}
+
+	swap = (ierr == NATIVE_NOERR && nbytes > 0 && !nf->discard && nf->n_subfiles == 0
+	        && !host_is_little_endian()
+	        && type_size(var->type) > 1);
+	if (swap && writing) {
+		io_buf = malloc((size_t)nbytes);
+		if (io_buf == NULL) {
+			ierr = NATIVE_ENOMEM;
+		} else {
+			memcpy(io_buf, buf, (size_t)nbytes);
+			swap_bytes(io_buf, (size_t)nbytes / type_size(var->type), type_size(var->type));
+		}
+	}
+
+	if (ierr == NATIVE_NOERR && n_runs > 0) {
+		if (MPI_Type_create_hindexed(n_runs, lens, offsets, MPI_BYTE, &filetype) != MPI_SUCCESS
+		    || MPI_Type_commit(&filetype) != MPI_SUCCESS) {
+			filetype = MPI_BYTE;
+			ierr = NATIVE_EMPI;
+		} else if (nbytes > (MPI_Offset)INT_MAX) {
+			ierr = get_memtype(nbytes, &memtype);
+		}
+	}
+	free(lens);
+	free(offsets);
+
+	/*
+	 * All tasks must take part in the collective calls below, so an error
+	 * on any task is an error on all tasks
+	 */
+	if (MPI_Allreduce(&ierr, &all_ierr, 1, MPI_INT, MPI_MIN, nf->comm) != MPI_SUCCESS) {
+		all_ierr = NATIVE_EMPI;
+	}
+
+	if (all_ierr == NATIVE_NOERR) {
+		if (ierr != NATIVE_NOERR || nbytes == 0) {
+			nbytes = 0;
+		}
+
+		if (!writing && nbytes > 0) {
+			/* Values beyond the end of the file are read as zero */
+			memset(buf, 0, (size_t)nbytes);
+		}
+	}
+
+	/*
+	 * Subfiles are accessed independently by each task; data written
+	 * through other tasks' handles are made visible before reading
+	 */
+	if (all_ierr == NATIVE_NOERR && nf->n_subfiles > 0) {
+		int i;
+
+		if (!writing && nf->writable) {
+			for (i = 0; i < nf->n_subfiles; i++) {
+				if (nf->sub_fh[i] != MPI_FILE_NULL
+				    && MPI_File_sync(nf->sub_fh[i]) != MPI_SUCCESS) {
+					ierr = NATIVE_EMPI;
+				}
+			}
+			if (MPI_Barrier(nf->comm) != MPI_SUCCESS) {
+				ierr = NATIVE_EMPI;
+			}
+		}
+		if (ierr == NATIVE_NOERR && nbytes > 0) {
+			ierr = sub_access(nf, varid, start, count, buf, nbytes, writing, 0);
+		}
+		if (MPI_Allreduce(&ierr, &all_ierr, 1, MPI_INT, MPI_MIN, nf->comm) != MPI_SUCCESS) {
+			all_ierr = NATIVE_EMPI;
+		}
+	} else if (all_ierr == NATIVE_NOERR && !nf->discard) {
+		mpi_ierr = MPI_File_set_view(nf->fh, (MPI_Offset)0, MPI_BYTE, filetype,
+		                             "native", MPI_INFO_NULL);
+		if (mpi_ierr == MPI_SUCCESS) {
+			int n = (memtype == MPI_BYTE) ? (int)nbytes : 1;
+
+			if (writing) {
+				mpi_ierr = MPI_File_write_all(nf->fh, io_buf, n, memtype, &status);
+			} else {
+				mpi_ierr = MPI_File_read_all(nf->fh, io_buf, n, memtype, &status);
+			}
+		}
+		if (MPI_File_set_view(nf->fh, (MPI_Offset)0, MPI_BYTE, MPI_BYTE,
+		                      "native", MPI_INFO_NULL) != MPI_SUCCESS) {
+			mpi_ierr = MPI_ERR_OTHER;
+		}
+		if (mpi_ierr != MPI_SUCCESS) {
+			all_ierr = NATIVE_EMPI;
+		}
+
+		if (all_ierr == NATIVE_NOERR && swap && !writing) {
+			swap_bytes(buf, (size_t)nbytes / type_size(var->type), type_size(var->type));
+		}
+	}
+
+	if (filetype != MPI_BYTE) {
+		MPI_Type_free(&filetype);
+	}
+	if (memtype != MPI_BYTE) {
+		MPI_Type_free(&memtype);
+	}
+	if (io_buf != buf) {
+		free(io_buf);
+	}
+
+	if (all_ierr == NATIVE_NOERR && writing) {
+		nf->bytes_written += nbytes;
+	}
+
+	if (all_ierr == NATIVE_NOERR && writing && var->is_record && nbytes > 0
+	    && start[0] + count[0] > nf->local_numrecs) {
+		nf->local_numrecs = start[0] + count[0];
+	}
+
+	/*
+	 * Report this task's own error if it had one
+	 */
+	return (ierr != NATIVE_NOERR) ? ierr : all_ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * agree_numrecs
+ *
+ * Collectively sets the number of records of a native file to the largest
+ * number of records written by any task
+ *
+ *******************************************************************************/
+static int agree_numrecs(struct SMIOL_native *nf)
+{
+	long long local;
+	long long global;
+
+	local = (long long)((nf->local_numrecs > nf->numrecs) ? nf->local_numrecs : nf->numrecs);
+	if (MPI_Allreduce(&local, &global, 1, MPI_LONG_LONG, MPI_MAX, nf->comm) != MPI_SUCCESS) {
+		return NATIVE_EMPI;
+	}
+
+	nf->numrecs = (MPI_Offset)global;
+	nf->local_numrecs = nf->numrecs;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * reserve_writes
+ *
+ * Makes room in a native file for n more independent write requests
+ *
+ *******************************************************************************/
+static int reserve_writes(struct SMIOL_native *nf, int n)
+{
+	MPI_Request *new_reqs;
+	void **new_bufs;
+	int new_max;
+
+	if (nf->n_reqs + n <= nf->max_reqs) {
+		return NATIVE_NOERR;
+	}
+
+	new_max = (nf->max_reqs > 0) ? 2 * nf->max_reqs : 16;
+	if (new_max < nf->n_reqs + n) {
+		new_max = nf->n_reqs + n;
+	}
+
+	new_reqs = (MPI_Request *)realloc(nf->reqs, sizeof(MPI_Request) * (size_t)new_max);
+	if (new_reqs == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	nf->reqs = new_reqs;
+
+	new_bufs = (void **)realloc(nf->req_bufs, sizeof(void *) * (size_t)new_max);
+	if (new_bufs == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	nf->req_bufs = new_bufs;
+
+	nf->max_reqs = new_max;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * test_writes
+ *
+ * Lets the independent writes of a native file progress without blocking,
+ * releasing them if they have all completed
+ *
+ *******************************************************************************/
+static int test_writes(struct SMIOL_native *nf)
+{
+	int done;
+	int i;
+
+#ifdef SMIOL_IO_URING
+	if (nf->uring != NULL && uring_reap(nf->uring, 0) != NATIVE_NOERR) {
+		return finish_writes(nf);
+	}
+#endif
+
+	if (nf->n_reqs == 0) {
+		return NATIVE_NOERR;
+	}
+
+	if (MPI_Testall(nf->n_reqs, nf->reqs, &done, MPI_STATUSES_IGNORE) != MPI_SUCCESS) {
+		return finish_writes(nf);
+	}
+
+#ifdef SMIOL_IO_URING
+	/* Buffers may also be in use by writes still in the io_uring */
+	if (nf->uring != NULL && nf->uring->n_inflight > 0) {
+		done = 0;
+	}
+#endif
+
+	if (done) {
+		for (i = 0; i < nf->n_reqs; i++) {
+			free(nf->req_bufs[i]);
+		}
+		nf->n_reqs = 0;
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * finish_writes
+ *
+ * Waits for all independent writes of a native file to complete, and releases
+ * them
+ *
+ *******************************************************************************/
+static int finish_writes(struct SMIOL_native *nf)
+{
+	int ierr = NATIVE_NOERR;
+	int i;
+
+#ifdef SMIOL_IO_URING
+	if (nf->uring != NULL) {
+		ierr = uring_finish(nf->uring);
+	}
+#endif
+
+	if (nf->n_reqs == 0) {
+		return ierr;
+	}
+
+	if (MPI_Waitall(nf->n_reqs, nf->reqs, MPI_STATUSES_IGNORE) != MPI_SUCCESS) {
+		ierr = NATIVE_EMPI;
+	}
+
+	for (i = 0; i < nf->n_reqs; i++) {
+		free(nf->req_bufs[i]);
+	}
+	nf->n_reqs = 0;
+
+	return ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * get_chunk
+ *
+ * Returns the start and length of chunk s of a dimension of length len that is
+ * divided among n subfiles
+ *
+ *******************************************************************************/
+static void get_chunk(MPI_Offset len, int n, int s, MPI_Offset *chunk_start,
+                      MPI_Offset *chunk_len)
+{
+	MPI_Offset per_chunk;
+	MPI_Offset remainder;
+
+	per_chunk = len / (MPI_Offset)n;
+	remainder = len % (MPI_Offset)n;
+
+	*chunk_start = (MPI_Offset)s * per_chunk;
+	if ((MPI_Offset)s < remainder) {
+		*chunk_start += (MPI_Offset)s;
+		*chunk_len = per_chunk + 1;
+	} else {
+		*chunk_start += remainder;
+		*chunk_len = per_chunk;
+	}
+}
+
+
+/*******************************************************************************
+ *
+ * init_subfiles
+ *
+ * Allocates the subfile handles of a native file, none of which are open
+ *
+ *******************************************************************************/
+static int init_subfiles(struct SMIOL_native *nf)
+{
+	int i;
+
+	if (nf->n_subfiles == 0) {
+		return NATIVE_NOERR;
+	}
+
+	nf->sub_fh = (MPI_File *)malloc(sizeof(MPI_File) * (size_t)nf->n_subfiles);
+	if (nf->sub_fh == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	for (i = 0; i < nf->n_subfiles; i++) {
+		nf->sub_fh[i] = MPI_FILE_NULL;
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * layout_subfiles
+ *
+ * Computes where each variable is laid out in each subfile of a native file
+ * (see smiol_native.h)
+ *
+ *******************************************************************************/
+static int layout_subfiles(struct SMIOL_native *nf)
+{
+	const struct SMIOL_native_var *var;
+	MPI_Offset chunk_start;
+	MPI_Offset len;
+	MPI_Offset size;
+	MPI_Offset offset;
+	MPI_Offset *begin;
+	int first;
+	int s, i, j;
+
+	if (nf->n_subfiles == 0) {
+		return NATIVE_NOERR;
+	}
+
+	free(nf->sub_begin);
+	free(nf->sub_record_begin);
+	free(nf->sub_record_size);
+	nf->sub_begin = (MPI_Offset *)malloc(sizeof(MPI_Offset)
+	                                     * (size_t)nf->n_subfiles * (size_t)(nf->nvars + 1));
+	nf->sub_record_begin = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)nf->n_subfiles);
+	nf->sub_record_size = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)nf->n_subfiles);
+	if (nf->sub_begin == NULL || nf->sub_record_begin == NULL || nf->sub_record_size == NULL) {
+		return NATIVE_ENOMEM;
+	}
+
+	for (s = 0; s < nf->n_subfiles; s++) {
+		begin = nf->sub_begin + (size_t)s * (size_t)nf->nvars;
+
+		/*
+		 * The size of each variable within this subfile, kept in begin
+		 * until the variables are laid out below
+		 */
+		for (i = 0; i < nf->nvars; i++) {
+			var = &nf->vars[i];
+			first = var->is_record ? 1 : 0;
+			size = (MPI_Offset)type_size(var->type);
+			if (first == var->ndims) {
+				size = (s == 0) ? size : 0;
+			}
+			for (j = first; j < var->ndims; j++) {
+				len = (MPI_Offset)nf->dims[var->dimids[j]].len;
+				if (j == first) {
+					get_chunk(len, nf->n_subfiles, s, &chunk_start, &len);
+				}
+				size *= len;
+			}
+			begin[i] = size;
+		}
+
+		offset = 0;
+		for (i = 0; i < nf->nvars; i++) {
+			if (!nf->vars[i].is_record) {
+				size = begin[i];
+				begin[i] = round_up(offset, (MPI_Offset)NATIVE_DEFAULT_ALIGN);
+				offset = begin[i] + size;
+			}
+		}
+		nf->sub_record_begin[s] = round_up(offset, (MPI_Offset)NATIVE_DEFAULT_ALIGN);
+
+		offset = 0;
+		for (i = 0; i < nf->nvars; i++) {
+			if (nf->vars[i].is_record) {
+				size = begin[i];
+				begin[i] = round_up(offset, (MPI_Offset)8);
+				offset = begin[i] + size;
+			}
+		}
+		nf->sub_record_size[s] = round_up(offset, (MPI_Offset)8);
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * open_subfile
+ *
+ * Opens subfile s of a native file for the calling task alone, unless it is
+ * already open
+ *
+ *******************************************************************************/
+static int open_subfile(struct SMIOL_native *nf, int s)
+{
+	char *name;
+	int amode;
+	int ierr = NATIVE_NOERR;
+
+	if (nf->sub_fh[s] != MPI_FILE_NULL) {
+		return NATIVE_NOERR;
+	}
+
+	name = (char *)malloc(strlen(nf->filename) + 16);
+	if (name == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	sprintf(name, "%s.%04d", nf->filename, s);
+
+	amode = nf->writable ? (MPI_MODE_CREATE | MPI_MODE_RDWR) : MPI_MODE_RDONLY;
+	if (MPI_File_open(MPI_COMM_SELF, name, amode, MPI_INFO_NULL,
+	                  &nf->sub_fh[s]) != MPI_SUCCESS) {
+		nf->sub_fh[s] = MPI_FILE_NULL;
+		ierr = NATIVE_EMPI;
+	}
+	free(name);
+
+	return ierr;
+}
+
+
+/*******************************************************************************
+ *
+ * sub_access
+ *
+ * Independently reads or writes a hyperslab of a variable in a subfiled file
+ *
+ * Given a hyperslab of nbytes > 0 bytes that has been checked, splits it into
+ * the pieces held by each subfile, and reads or writes (if writing is non-zero)
+ * each piece with one MPI-IO call for each of its contiguous runs, opening
+ * subfiles as needed. Writes are only started if nonblocking is non-zero, and
+ * are then completed by finish_writes. Values never written are read as zero.
+ *
+ *******************************************************************************/
+static int sub_access(struct SMIOL_native *nf, int varid,
+                      const MPI_Offset *start, const MPI_Offset *count,
+                      void *buf, MPI_Offset nbytes, int writing, int nonblocking)
+{
+	const struct SMIOL_native_var *var;
+	struct native_place place;
+	MPI_Offset *sstart;
+	MPI_Offset *scount;
+	MPI_Offset chunk_start;
+	MPI_Offset chunk_len;
+	MPI_Offset lo, hi;
+	MPI_Offset first_index, last_index;
+	MPI_Offset row_bytes;
+	MPI_Offset rec_bytes;
+	MPI_Offset n_recs;
+	MPI_Status status;
+	char *mem;
+	char *p = NULL;
+	void *owned = NULL;
+	int *lens;
+	MPI_Aint *offsets;
+	int n_runs;
+	int runs_per_rec;
+	int first;
+	int ierr = NATIVE_NOERR;
+	int s, i;
+
+	var = &nf->vars[varid];
+	first = var->is_record ? 1 : 0;
+	n_recs = var->is_record ? count[0] : 1;
+	rec_bytes = nbytes / n_recs;
+
+	/*
+	 * The range of the hyperslab along the divided dimension, and the bytes
+	 * of the hyperslab for one index along that dimension
+	 */
+	if (first < var->ndims) {
+		first_index = start[first];
+		last_index = start[first] + count[first];
+		row_bytes = rec_bytes / count[first];
+	} else {
+		first_index = 0;
+		last_index = 1;
+		row_bytes = rec_bytes;
+	}
+
+	sstart = (MPI_Offset *)malloc(sizeof(MPI_Offset) * (size_t)(2 * var->ndims + 1));
+	if (sstart == NULL) {
+		return NATIVE_ENOMEM;
+	}
+	scount = sstart + var->ndims;
+
+	mem = (char *)buf;
+	if (!host_is_little_endian() && type_size(var->type) > 1) {
+		if (writing) {
+			owned = malloc((size_t)nbytes);
+			if (owned == NULL) {
+				free(sstart);
+				return NATIVE_ENOMEM;
+			}
+			memcpy(owned, buf, (size_t)nbytes);
+			swap_bytes(owned, (size_t)nbytes / type_size(var->type), type_size(var->type));
+			mem = (char *)owned;
+		}
+	}
+	if (!writing) {
+		memset(buf, 0, (size_t)nbytes);
+	}
+
+	for (s = 0; s < nf->n_subfiles && ierr == NATIVE_NOERR; s++) {
+		if (first < var->ndims) {
+			get_chunk((MPI_Offset)nf->dims[var->dimids[first]].len, nf->n_subfiles, s,
+			          &chunk_start, &chunk_len);
+		} else {
+			get_chunk((MPI_Offset)1, nf->n_subfiles, s, &chunk_start, &chunk_len);
+		}
+		lo = (first_index > chunk_start) ? first_index : chunk_start;
+		hi = (last_index < chunk_start + chunk_len) ? last_index : chunk_start + chunk_len;
+		if (lo >= hi) {
+			continue;
+		}
+
+		if ((ierr = open_subfile(nf, s)) != NATIVE_NOERR) {
+			break;
+		}
+
+		for (i = 0; i < var->ndims; i++) {
+			sstart[i] = start[i];
+			scount[i] = count[i];
+		}
+		if (first < var->ndims) {
+			sstart[first] = lo - chunk_start;
+			scount[first] = hi - lo;
+		}
+
+		place.begin = nf->sub_begin[(size_t)s * (size_t)nf->nvars + (size_t)varid];
+		place.record_begin = nf->sub_record_begin[s];
+		place.record_size = nf->sub_record_size[s];
+		place.split_len = chunk_len;
+
+		ierr = get_runs(nf, var, sstart, scount, &place, &n_runs, &lens, &offsets);
+		if (ierr != NATIVE_NOERR) {
+			break;
+		}
+		if (nonblocking && (ierr = reserve_writes(nf, n_runs)) != NATIVE_NOERR) {
+			free(lens);
+			free(offsets);
+			break;
+		}
+
+		/*
+		 * The piece of each record is contiguous in memory, and its runs
+		 * are in the same order as its values
+		 */
+		runs_per_rec = n_runs / (int)n_recs;
+		for (i = 0; i < n_runs && ierr == NATIVE_NOERR; i++) {
+			if (i % runs_per_rec == 0) {
+				p = mem + (i / runs_per_rec) * rec_bytes + (lo - first_index) * row_bytes;
+			}
+			if (nonblocking) {
+				if (MPI_File_iwrite_at(nf->sub_fh[s], (MPI_Offset)offsets[i], p, lens[i],
+				                       MPI_BYTE, &nf->reqs[nf->n_reqs]) != MPI_SUCCESS) {
+					ierr = NATIVE_EMPI;
+				} else {
+					nf->req_bufs[nf->n_reqs] = NULL;
+					nf->n_reqs++;
+				}
+			} else if (writing) {
+				if (MPI_File_write_at(nf->sub_fh[s], (MPI_Offset)offsets[i], p, lens[i],
+				                      MPI_BYTE, &status) != MPI_SUCCESS) {
+					ierr = NATIVE_EMPI;
+				}
+			} else {
+				if (MPI_File_read_at(nf->sub_fh[s], (MPI_Offset)offsets[i], p, lens[i],
+				                     MPI_BYTE, &status) != MPI_SUCCESS) {
+					ierr = NATIVE_EMPI;
+				}
+			}
+			p += lens[i];
+		}
+		free(lens);
+		free(offsets);
+	}
+	free(sstart);
+
+	/*
+	 * A byte-swapped copy being written by requests is freed with the last
+	 * of them
+	 */
+	if (owned != NULL && nonblocking && nf->n_reqs > 0 && nf->req_bufs[nf->n_reqs - 1] == NULL) {
+		nf->req_bufs[nf->n_reqs - 1] = owned;
+		owned = NULL;
+	}
+	free(owned);
+
+	if (ierr == NATIVE_NOERR && !writing && !host_is_little_endian() && type_size(var->type) > 1) {
+		swap_bytes(buf, (size_t)nbytes / type_size(var->type), type_size(var->type));
+	}
+
+	return ierr;
+}
+
+
+#ifdef SMIOL_IO_URING
+/*******************************************************************************
+ *
+ * uring_setup
+ *
+ * Sets up an io_uring for the independent writes of a task to a native file
+ *
+ * Opens the file for writing with POSIX I/O and registers it with a new
+ * io_uring of NATIVE_URING_ENTRIES entries. If the file cannot be opened this
+ * way (e.g., its name has an MPI-IO file system prefix), or the kernel does
+ * not provide io_uring writes, the file is marked so that independent writes
+ * use MPI-IO, and setting up is not tried again.
+ *
+ *******************************************************************************/
+static void uring_setup(struct SMIOL_native *nf)
+{
+	struct native_uring *ring;
+	struct io_uring_params params;
+	struct io_uring_probe *probe;
+	unsigned char *sq;
+	unsigned char *cq;
+	long ret;
+	int i;
+
+	nf->no_uring = 1;
+
+	ring = (struct native_uring *)malloc(sizeof(struct native_uring));
+	if (ring == NULL) {
+		return;
+	}
+	ring->ring_fd = -1;
+	ring->sq_ring = NULL;
+	ring->cq_ring = NULL;
+	ring->sqes = NULL;
+	ring->sq_ring_bytes = 0;
+	ring->cq_ring_bytes = 0;
+	ring->sqes_bytes = 0;
+
+	ring->fd = open(nf->filename, O_WRONLY);
+	if (ring->fd < 0) {
+		uring_free(ring);
+		return;
+	}
+
+	memset(&params, 0, sizeof(params));
+	ret = syscall(__NR_io_uring_setup, NATIVE_URING_ENTRIES, &params);
+	if (ret < 0) {
+		uring_free(ring);
+		return;
+	}
+	ring->ring_fd = (int)ret;
+
+	/*
+	 * Map the submission and completion queue rings, which newer kernels
+	 * provide as one mapping, and the submission queue entries
+	 */
+	ring->sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) && ring->cq_ring_bytes > ring->sq_ring_bytes) {
+		ring->sq_ring_bytes = ring->cq_ring_bytes;
+	}
+
+	ring->sq_ring = mmap(NULL, ring->sq_ring_bytes, PROT_READ | PROT_WRITE,
+	                     MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ring == MAP_FAILED) {
+		ring->sq_ring = NULL;
+		uring_free(ring);
+		return;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ring = ring->sq_ring;
+	} else {
+		ring->cq_ring = mmap(NULL, ring->cq_ring_bytes, PROT_READ | PROT_WRITE,
+		                     MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING);
+		if (ring->cq_ring == MAP_FAILED) {
+			ring->cq_ring = NULL;
+			uring_free(ring);
+			return;
+		}
+	}
+
+	ring->sqes_bytes = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_bytes, PROT_READ | PROT_WRITE,
+	                                         MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+	                                         IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		uring_free(ring);
+		return;
+	}
+
+	sq = (unsigned char *)ring->sq_ring;
+	cq = (unsigned char *)ring->cq_ring;
+	ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	ring->sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+	ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	ring->cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+	/*
+	 * Writes at an offset are only provided by kernels since 5.6
+	 */
+	probe = (struct io_uring_probe *)calloc(1, sizeof(struct io_uring_probe)
+	                                        + 256 * sizeof(struct io_uring_probe_op));
+	if (probe == NULL) {
+		uring_free(ring);
+		return;
+	}
+	ret = syscall(__NR_io_uring_register, ring->ring_fd, IORING_REGISTER_PROBE, probe, 256);
+	if (ret < 0 || probe->last_op < IORING_OP_WRITE
+	    || !(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED)) {
+		free(probe);
+		uring_free(ring);
+		return;
+	}
+	free(probe);
+
+	if (syscall(__NR_io_uring_register, ring->ring_fd, IORING_REGISTER_FILES, &ring->fd, 1) < 0) {
+		uring_free(ring);
+		return;
+	}
+
+	ring->n_queued = 0;
+	ring->n_inflight = 0;
+	ring->n_free = NATIVE_URING_ENTRIES;
+	for (i = 0; i < NATIVE_URING_ENTRIES; i++) {
+		ring->free_slots[i] = i;
+	}
+	ring->ierr = NATIVE_NOERR;
+
+	nf->uring = ring;
+	nf->no_uring = 0;
+}
+
+
+/*******************************************************************************
+ *
+ * uring_free
+ *
+ * Frees an io_uring, which may be partly set up, and closes its file
+ *
+ *******************************************************************************/
+static void uring_free(struct native_uring *ring)
+{
+	if (ring->sqes != NULL) {
+		munmap(ring->sqes, ring->sqes_bytes);
+	}
+	if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+		munmap(ring->cq_ring, ring->cq_ring_bytes);
+	}
+	if (ring->sq_ring != NULL) {
+		munmap(ring->sq_ring, ring->sq_ring_bytes);
+	}
+	if (ring->ring_fd >= 0) {
+		close(ring->ring_fd);
+	}
+	if (ring->fd >= 0) {
+		close(ring->fd);
+	}
+	free(ring);
+}
+
+
+/*******************************************************************************
+ *
+ * uring_write
+ *
+ * Queues a write of len bytes at p to offset in the file of an io_uring
+ *
+ * The write is only added to the submission queue, and is started by the next
+ * call to uring_enter. If all NATIVE_URING_ENTRIES writes of the ring are in
+ * use, queued writes are first submitted and this routine waits until one of
+ * them completes.
+ *
+ *******************************************************************************/
+static int uring_write(struct native_uring *ring, MPI_Offset offset,
+                       const char *p, size_t len)
+{
+	int slot;
+	int ierr;
+
+	while (ring->n_free == 0) {
+		if ((ierr = uring_reap(ring, 1)) != NATIVE_NOERR) {
+			return ierr;
+		}
+	}
+
+	slot = ring->free_slots[--ring->n_free];
+	ring->writes[slot].p = p;
+	ring->writes[slot].len = len;
+	ring->writes[slot].offset = offset;
+	ring->n_inflight++;
+
+	uring_queue(ring, slot);
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * uring_queue
+ *
+ * Adds the write in a slot of an io_uring to its submission queue
+ *
+ *******************************************************************************/
+static void uring_queue(struct native_uring *ring, int slot)
+{
+	struct io_uring_sqe *sqe;
+	unsigned tail;
+	unsigned index;
+
+	tail = *ring->sq_tail;
+	index = tail & ring->sq_mask;
+	sqe = &ring->sqes[index];
+
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->flags = IOSQE_FIXED_FILE;
+	sqe->fd = 0;
+	sqe->off = (uint64_t)ring->writes[slot].offset;
+	sqe->addr = (uint64_t)(uintptr_t)ring->writes[slot].p;
+	sqe->len = (uint32_t)ring->writes[slot].len;
+	sqe->user_data = (uint64_t)slot;
+
+	ring->sq_array[index] = index;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->n_queued++;
+}
+
+
+/*******************************************************************************
+ *
+ * uring_enter
+ *
+ * Submits the queued writes of an io_uring, and if wait is non-zero, waits
+ * until at least one write has completed
+ *
+ *******************************************************************************/
+static int uring_enter(struct native_uring *ring, int wait)
+{
+	long ret;
+
+	do {
+		ret = syscall(__NR_io_uring_enter, ring->ring_fd, ring->n_queued,
+		              wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0) {
+		return NATIVE_EIO;
+	}
+	ring->n_queued -= (unsigned)ret;
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * uring_reap
+ *
+ * Releases the completed writes of an io_uring
+ *
+ * If wait is non-zero and writes are in flight, first waits until at least one
+ * write has completed. The remainder of a write that was only partly carried
+ * out is queued and submitted again, and the first write that failed is
+ * recorded in the ring, to be returned by uring_finish.
+ *
+ * An error code is only returned if the ring itself could not be entered.
+ *
+ *******************************************************************************/
+static int uring_reap(struct native_uring *ring, int wait)
+{
+	struct io_uring_cqe *cqe;
+	struct native_uring_write *w;
+	unsigned head;
+	unsigned tail;
+	int slot;
+	int res;
+	int ierr;
+
+	if (wait && ring->n_inflight > 0) {
+		if ((ierr = uring_enter(ring, 1)) != NATIVE_NOERR) {
+			return ierr;
+		}
+	}
+
+	head = *ring->cq_head;
+	tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+	while (head != tail) {
+		cqe = &ring->cqes[head & ring->cq_mask];
+		slot = (int)cqe->user_data;
+		res = cqe->res;
+		head++;
+
+		w = &ring->writes[slot];
+		if (res == -EINTR || res == -EAGAIN) {
+			uring_queue(ring, slot);
+		} else if (res > 0 && (size_t)res < w->len) {
+			w->p += res;
+			w->len -= (size_t)res;
+			w->offset += (MPI_Offset)res;
+			uring_queue(ring, slot);
+		} else {
+			if (res <= 0 && ring->ierr == NATIVE_NOERR) {
+				ring->ierr = NATIVE_EIO;
+			}
+			ring->free_slots[ring->n_free++] = slot;
+			ring->n_inflight--;
+		}
+	}
+	__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+	if (ring->n_queued > 0) {
+		return uring_enter(ring, 0);
+	}
+
+	return NATIVE_NOERR;
+}
+
+
+/*******************************************************************************
+ *
+ * uring_finish
+ *
+ * Waits for all writes in an io_uring to complete, returning the error of the
+ * first write that failed since this routine was last called, if any
+ *
+ *******************************************************************************/
+static int uring_finish(struct native_uring *ring)
+{
+	int ierr;
+
+	while (ring->n_inflight > 0) {
+		if ((ierr = uring_reap(ring, 1)) != NATIVE_NOERR) {
+			return ierr;
+		}
+	}
+
+	ierr = ring->ierr;
+	ring->ierr = NATIVE_NOERR;
+
+	return ierr;
+}
+#endif
@@ -0,0 +1,193 @@
+/*******************************************************************************
+ * Native MPI-IO file format for SMIOL
+ *******************************************************************************/
+#ifndef SMIOL_NATIVE_H
+#define SMIOL_NATIVE_H
+
+#include "smiol_types.h"
+
+/*
+ * A native file begins with a header, written in little-endian byte order:
+ *
+ *   magic        8 bytes, "SMIOLNAT"
+ *   version      u32
+ *   nsubfiles    u32, number of subfiles holding the data, or 0
+ *   numrecs      u64, number of records written
+ *   header_size  u64, bytes reserved for the header, where data begin
+ *   record_begin u64, offset of the first record
+ *   record_size  u64, size in bytes of one record of all record variables
+ *   dims         u32 count, then for each: name, i64 length (-1 if unlimited)
+ *   global atts  u32 count, then for each att (see below)
+ *   vars         u32 count, then for each: name, u32 type, u32 ndims,
+ *                u32 dimid for each dimension, u64 begin, u32 natts, atts
+ *
+ * where names are a u32 length followed by that many characters, and each
+ * attribute is a name, u32 type, u64 number of values, and the values.
+ *
+ * Each variable with no record dimension is stored as one block, in row-major
+ * order, at its begin offset; blocks are aligned and follow the header. Records
+ * are appended after the last block, each record holding the values of every
+ * record variable for one index of the unlimited dimension, with the begin
+ * offset of a record variable giving its offset within each record. All values
+ * are stored in little-endian byte order.
+ *
+ * In a subfiled file (nsubfiles > 0) the file itself holds only the header,
+ * and the data are held by nsubfiles subfiles named after the file with a
+ * suffix of "." and the four-digit subfile number. The first dimension of each
+ * variable after any unlimited dimension is divided into nsubfiles balanced
+ * chunks, the first subfiles taking one extra index each when the length does
+ * not divide evenly (as SMIOL divides elements among I/O tasks), and subfile s
+ * holds chunk s of every variable, laid out as above as though the dimension
+ * had the length of the chunk, with no header and NATIVE_DEFAULT_ALIGN
+ * alignment. Variables with no such dimension are held by the first subfile.
+ * Nothing but this rule is needed to find any value, and each subfile is only
+ * opened by the tasks that access it.
+ */
+#define NATIVE_MAGIC "SMIOLNAT"
+#define NATIVE_VERSION 1
+#define NATIVE_FIXED_HEADER_BYTES 48       /* Size of the header up to the list of dimensions */
+#define NATIVE_NUMRECS_OFFSET 16           /* Offset of numrecs in the header */
+#define NATIVE_DEFAULT_ALIGN ((size_t)512) /* Default alignment of variable blocks and records */
+#define NATIVE_MOVE_BYTES ((size_t)4194304) /* Largest piece in which data are moved on redefinition */
+#define NATIVE_MAX_NAME 256                /* Longest name of a dimension, variable, or attribute */
+
+#define NATIVE_GLOBAL (-1) /* Variable ID for global attributes */
+
+/*
+ * Error codes
+ */
+#define NATIVE_NOERR         (0)
+#define NATIVE_ENOMEM       (-1)
+#define NATIVE_EMPI         (-2)
+#define NATIVE_ENOTNATIVE   (-3)
+#define NATIVE_EBADDIM      (-4)
+#define NATIVE_ENOTVAR      (-5)
+#define NATIVE_ENOTATT      (-6)
+#define NATIVE_ENAMEINUSE   (-7)
+#define NATIVE_EBADTYPE     (-8)
+#define NATIVE_EPERM        (-9)
+#define NATIVE_EUNLIMIT    (-10)
+#define NATIVE_EINVALCOORDS (-11)
+#define NATIVE_EDIMSIZE    (-12)
+#define NATIVE_ESUBFILED   (-13)
+#define NATIVE_EIO         (-14)
+#define NATIVE_EBADNAME    (-15)
+
+
+struct native_uring;  /* io_uring of a task's independent writes (SMIOL_IO_URING only) */
+
+struct SMIOL_native_att {
+	char *name;   /* Name of the attribute */
+	int type;     /* Type of the attribute (SMIOL_REAL32, etc.) */
+	size_t len;   /* Number of values */
+	void *value;  /* Values, in native byte order */
+};
+
+struct SMIOL_native_dim {
+	char *name;       /* Name of the dimension */
+	SMIOL_Offset len; /* Length of the dimension, or -1 for the unlimited dimension */
+};
+
+struct SMIOL_native_var {
+	char *name;          /* Name of the variable */
+	int type;            /* Type of the variable (SMIOL_REAL32, etc.) */
+	int ndims;           /* Number of dimensions */
+	int *dimids;         /* ID of each dimension */
+	int natts;           /* Number of attributes */
+	struct SMIOL_native_att *atts; /* Attributes of the variable */
+	MPI_Offset begin;    /* Offset of the block, or offset within each record */
+	MPI_Offset size;     /* Size in bytes of the block, or of one record */
+	int is_record;       /* Whether the first dimension is the unlimited dimension */
+};
+
+struct SMIOL_native {
+	MPI_Comm comm;      /* Communicator of the tasks that opened the file */
+	int comm_rank;      /* Rank within comm */
+	MPI_File fh;        /* MPI-IO file handle */
+	int writable;       /* Whether the file was opened for writing */
+	int define_mode;    /* Whether definitions have changed since the layout was computed */
+	int has_layout;     /* Whether the layout has been computed and the header written */
+	int layout_nvars;   /* Number of variables when the layout was last computed */
+	int discard;        /* Whether there is no file, and all data are discarded */
+	MPI_Offset bytes_written; /* Bytes of values written, or discarded, by this task */
+
+	int n_reqs;         /* Number of independent writes started and not yet completed */
+	int max_reqs;       /* Allocated size of reqs and req_bufs */
+	MPI_Request *reqs;  /* MPI-IO requests of independent writes */
+	void **req_bufs;    /* Buffer owned by the file to free when each request completes, or NULL */
+	struct native_uring *uring; /* io_uring of independent writes, set up by this task when first needed */
+	int no_uring;       /* Whether io_uring is unavailable, so that independent writes use MPI-IO */
+
+	int ndims;          /* Number of dimensions */
+	struct SMIOL_native_dim *dims;
+	int nvars;          /* Number of variables */
+	struct SMIOL_native_var *vars;
+	int ngatts;         /* Number of global attributes */
+	struct SMIOL_native_att *gatts;
+	int unlimdimid;     /* ID of the unlimited dimension, or -1 */
+
+	char *filename;     /* Name of the file, from which subfile names are formed */
+	int n_subfiles;     /* Number of subfiles, or 0 */
+	MPI_File *sub_fh;   /* MPI-IO handle of each subfile, opened by this task when first accessed */
+	MPI_Offset *sub_begin;        /* Offset of each variable in each subfile (subfile-major) */
+	MPI_Offset *sub_record_begin; /* Offset of the first record in each subfile */
+	MPI_Offset *sub_record_size;  /* Size in bytes of one record in each subfile */
+
+	MPI_Offset numrecs;      /* Number of records, agreed on by all tasks */
+	MPI_Offset local_numrecs; /* Number of records written independently by this task */
+	MPI_Offset header_size;  /* Bytes reserved for the header */
+	MPI_Offset record_begin; /* Offset of the first record */
+	MPI_Offset record_size;  /* Size in bytes of one record */
+};
+
+
+/*
+ * Files
+ */
+int native_create(MPI_Comm comm, const char *filename, MPI_Info info,
+                  int n_subfiles, struct SMIOL_native **nf);
+int native_open(MPI_Comm comm, const char *filename, int writable,
+                MPI_Info info, struct SMIOL_native **nf);
+int native_create_null(MPI_Comm comm, struct SMIOL_native **nf);
+int native_close(struct SMIOL_native **nf);
+int native_enddef(struct SMIOL_native *nf, size_t header_free_bytes,
+                  size_t align_bytes);
+int native_sync(struct SMIOL_native *nf);
+const char *native_strerror(int ierr);
+
+/*
+ * Definitions and inquiries
+ */
+int native_def_dim(struct SMIOL_native *nf, const char *name, SMIOL_Offset len,
+                   int *dimid);
+int native_inq_dimid(const struct SMIOL_native *nf, const char *name, int *dimid);
+int native_inq_dim(const struct SMIOL_native *nf, int dimid, char *name,
+                   SMIOL_Offset *len);
+int native_def_var(struct SMIOL_native *nf, const char *name, int type,
+                   int ndims, const int *dimids, int *varid);
+int native_inq_varid(const struct SMIOL_native *nf, const char *name, int *varid);
+int native_inq_var(const struct SMIOL_native *nf, int varid, int *type,
+                   int *ndims, int *dimids);
+int native_put_att(struct SMIOL_native *nf, int varid, const char *name,
+                   int type, size_t len, const void *value);
+int native_inq_att(const struct SMIOL_native *nf, int varid, const char *name,
+                   int *type, size_t *len);
+int native_get_att(const struct SMIOL_native *nf, int varid, const char *name,
+                   void *value);
+
+/*
+ * Data access
+ */
+int native_put_vara_all(struct SMIOL_native *nf, int varid,
+                        const MPI_Offset *start, const MPI_Offset *count,
+                        const void *buf);
+int native_get_vara_all(struct SMIOL_native *nf, int varid,
+                        const MPI_Offset *start, const MPI_Offset *count,
+                        void *buf);
+int native_iput_vara(struct SMIOL_native *nf, int varid,
+                     const MPI_Offset *start, const MPI_Offset *count,
+                     const void *buf);
+int native_wait_all(struct SMIOL_native *nf);
+int native_inq_writes(const struct SMIOL_native *nf, int *n_writes);
+
+#endif
@@ -5,6 +5,7 @@
 #define SMIOL_TYPES_H
 
 #include <stdint.h>
+#include <pthread.h>
 #include "mpi.h"
 
 
@@ -25,11 +26,165 @@ struct SMIOL_context {
 
 	int lib_ierr;   /* Library-specific error code */
 	int lib_type;   /* From which library the error code originated */
+
+	MPI_Fint node_fcomm; /* Fortran handle to MPI communicator of tasks sharing a node */
+	int node_size;       /* Number of tasks on this task's node */
+	int node_rank;       /* Rank within the node communicator */
+	int num_nodes;       /* Number of nodes spanned by the context communicator */
+	int node_id;         /* Index of this task's node, ordered by lowest rank on each node */
+
+	int io_placement;      /* How I/O tasks are chosen (SMIOL_IO_PLACEMENT_*) */
+	int io_tasks_per_node; /* Fixed number of I/O tasks per node, or 0 to spread num_io_tasks */
+
+	size_t io_align_bytes;        /* Alignment in bytes for I/O range boundaries, or 0 for none */
+	size_t io_align_element_size; /* Size in bytes of one decomposed element, for alignment */
+	int io_partition;             /* How elements are divided among I/O tasks (SMIOL_IO_PARTITION_*) */
+	int io_vertical_blocks;       /* Number of I/O tasks splitting the first inner dimension */
+
+	char *autotune_cache;         /* File recording auto-tuned I/O settings across runs, or NULL */
+	char *autotune_scratch;       /* Scratch file for calibration writes, or NULL */
+	size_t autotune_bytes;        /* Total size in bytes of each calibration write */
+	int auto_io_tasks_per_node;   /* Auto-tuned I/O tasks per node, or 0 if not yet determined */
+	int auto_num_io_tasks;        /* Number of I/O tasks chosen by the last auto-tuned decomp */
+	int auto_io_stride;           /* Stride between I/O tasks chosen by the last auto-tuned decomp */
+	double auto_bandwidth;        /* Measured calibration bandwidth in bytes/s, or 0 if not measured */
+
+	int n_decomps;                /* Number of decomps built, used to give each decomp a unique ID */
+	int n_io_ranks;               /* Number of I/O tasks of the last decomp created */
+	int *io_ranks;                /* Ranks of the I/O tasks of the last decomp created, or NULL */
+	size_t small_var_bytes;       /* Largest non-decomposed variable whose writes are batched, or 0 */
+	int read_mode;                /* How non-decomposed variables are read (SMIOL_READ_*) */
+
+	size_t header_free_bytes;     /* Free space in bytes left after the header of created files */
+	size_t var_align_bytes;       /* Alignment in bytes of the fixed-size variable section, or 0 for default */
+	size_t var_free_bytes;        /* Free space in bytes left after the fixed-size variable section */
+	size_t record_align_bytes;    /* Alignment in bytes of the record variable section, or 0 for default */
+
+	MPI_Fint finfo;               /* Fortran handle to MPI info object of hints for files opened in the context */
+	int file_library;             /* Library used for files opened in the context (SMIOL_LIBRARY_*) */
+	int n_subfiles;               /* Number of subfiles of native files created in the context, or 0 */
+	size_t stage_bytes;           /* Most bytes of staged writes held by a task for each file */
+};
+
+struct SMIOL_option {
+	const char *name;   /* Name of the option, also giving the environment variable SMIOL_<NAME> */
+	int id;             /* Which setting the option changes (OPTION_HINT, etc.) */
+	int type;           /* Type of the value of the option (OPTION_TYPE_*) */
+	const char *values; /* For OPTION_TYPE_ENUM, valid values separated by '|', or NULL */
+};
+
+#define SMIOL_VAR_META_BUCKETS 64  /* Number of hash buckets for cached variable metadata */
+
+struct SMIOL_io_plan {
+	int decomp_id;          /* ID of the decomp for which the plan was built, or 0 for none */
+	int write_or_read;      /* Whether the plan is for writing or for reading */
+	int ndims;              /* Number of dimensions of the variable */
+	int has_record_dim;     /* Whether start[0] is the record index */
+	size_t element_size;    /* Size in bytes of each element on compute tasks */
+	size_t io_element_size; /* Size in bytes of each element on this I/O task */
+	size_t n_levels;        /* Size of the first dimension inside the decomposed dimension */
+	size_t io_bytes;        /* Size in bytes of the staging buffer on this task */
+	const struct SMIOL_decomp *io_decomp; /* Decomp used to transfer the variable, or NULL */
+	MPI_Offset *start;      /* Start of the part of the variable read or written by this task */
+	MPI_Offset *count;      /* Count of the part of the variable read or written by this task */
+	MPI_Offset *zero_count; /* All-zero counts, for taking part in a collective without data */
+	struct SMIOL_io_plan *next; /* Next plan for the same variable */
+};
+
+struct SMIOL_var_meta {
+	char *varname;           /* Name of the variable */
+	int varid;               /* Library-specific variable ID, or -1 */
+	int vartype;             /* Type of the variable (SMIOL_REAL32, etc.) */
+	int ndims;               /* Number of dimensions of the variable */
+	int has_unlimited_dim;   /* Whether the first dimension is the unlimited dimension */
+	SMIOL_Offset *dimsizes;  /* Size of each dimension when the metadata were cached */
+	struct SMIOL_io_plan *plans; /* Plans for reading or writing the variable */
+	int pending;                 /* Whether a write of the variable is pending */
+	SMIOL_Offset pending_frame;  /* Frame of the pending write */
+	int prefetch;                /* Whether the next frame is read ahead after each read */
+	int prefetch_req;            /* Library request ID of a read-ahead, or -1 if none */
+	int prefetch_decomp_id;      /* ID of the decomp of the plan used by the read-ahead */
+	SMIOL_Offset prefetch_frame; /* Frame being read ahead */
+	void *prefetch_buf;          /* Buffer into which the next frame is read ahead, or NULL */
+	size_t prefetch_size;        /* Size in bytes of prefetch_buf */
+	struct SMIOL_var_meta *next; /* Next variable in the same hash bucket */
+};
+
+struct SMIOL_var {
+	struct SMIOL_file *file;     /* File containing the variable */
+	char *varname;               /* Name of the variable */
+	struct SMIOL_var_meta *meta; /* Cached metadata of the variable */
+	int meta_epoch;              /* Value of meta_epoch in the file when meta was looked up */
+	struct SMIOL_var *next;      /* Next handle for the same file */
+};
+
+struct SMIOL_define_entry {
+	int kind;                /* What is defined (DEFINE_DIM, DEFINE_VAR, or DEFINE_ATT) */
+	char *name;              /* Name of the dimension, variable, or attribute */
+	char *varname;           /* Variable of an attribute, or NULL for a global attribute */
+	int type;                /* Type of a variable or attribute */
+	SMIOL_Offset dimsize;    /* Size of a dimension, or negative for the unlimited dimension */
+	int ndims;               /* Number of dimensions of a variable */
+	char **dimnames;         /* Names of the dimensions of a variable */
+	void *value;             /* Value of an attribute */
+	struct SMIOL_define_entry *next; /* Next definition, in the order of definition */
+};
+
+struct SMIOL_stage_entry {
+	int varid;          /* Library-specific ID of the variable written */
+	MPI_Offset *start;  /* Start of the part of the variable written by this task */
+	MPI_Offset *count;  /* Count of the part of the variable written by this task */
+	void *buf;          /* Staged data written by this task, or NULL */
+	size_t size;        /* Size in bytes of buf */
+	struct SMIOL_stage_entry *next; /* Next write to drain, in the order staged */
+};
+
+struct SMIOL_stage {
+	struct SMIOL_file *file;  /* File to which staged writes are drained */
+	MPI_Fint fcomm;           /* Fortran handle to the communicator with which the file was opened */
+	size_t max_bytes;         /* Most bytes of staged data held before a write waits for the drain */
+	size_t bytes;             /* Bytes of staged data not yet written */
+	struct SMIOL_stage_entry *head; /* Oldest write not yet written, or NULL */
+	struct SMIOL_stage_entry *tail; /* Newest staged write, or NULL */
+	int stop;                 /* Whether the drain thread should exit */
+	int lib_type;             /* Library of the first write that failed, or 0 */
+	int lib_ierr;             /* Library-specific error code of the first write that failed */
+	pthread_t thread;         /* Drain thread */
+	pthread_mutex_t lock;     /* Protects the members above that change while draining */
+	pthread_cond_t work;      /* Signalled when a write is staged or stop is set */
+	pthread_cond_t done;      /* Signalled when a staged write has been written */
 };
 
 struct SMIOL_file {
 	struct SMIOL_context *context; /* Context for this file */
 	SMIOL_Offset frame; /* Current frame of the file */
+	struct SMIOL_var_meta **var_meta; /* Hash table of cached variable metadata, or NULL */
+	void *staging_buf;   /* Buffer reused for decomposed reads and writes, or NULL */
+	size_t staging_size; /* Size in bytes of staging_buf */
+	int meta_epoch;      /* Incremented each time cached variable metadata are dropped */
+	struct SMIOL_var *var_handles; /* Variable handles returned for the file */
+	int deferred;        /* Whether writes are deferred until the file is flushed */
+	int n_pending;       /* Number of deferred writes not yet completed */
+	int max_pending;     /* Capacity of pending_reqs and pending_bufs */
+	int *pending_reqs;   /* Library request IDs of deferred writes */
+	void **pending_bufs; /* Buffers holding the data of deferred writes */
+	int flush_needed;     /* Whether any task has posted writes since the last flush */
+	int next_small_owner; /* Index in the context's io_ranks of the task to write the next batched small variable */
+	int pad_header;       /* Whether header padding is applied when next leaving define mode */
+	int journal;          /* Whether definitions are journaled until the next data access */
+	struct SMIOL_define_entry *journal_head; /* First journaled definition, or NULL */
+	struct SMIOL_define_entry *journal_tail; /* Last journaled definition, or NULL */
+	size_t small_var_bytes;    /* Largest batched non-decomposed variable, or (size_t)-1 to use the context setting */
+	int read_mode;             /* How non-decomposed variables are read (SMIOL_READ_*), or 0 to use the context setting */
+	size_t header_free_bytes;  /* Free space in bytes left after the header when padding is applied */
+	size_t var_align_bytes;    /* Alignment in bytes of the fixed-size variable section, or 0 for default */
+	size_t var_free_bytes;     /* Free space in bytes left after the fixed-size variable section */
+	size_t record_align_bytes; /* Alignment in bytes of the record variable section, or 0 for default */
+	int in_place_swap;         /* Whether the file library may byte-swap write buffers in place */
+	int nofill;                /* Whether variables are not pre-filled with fill values */
+	int backend;               /* Library used for the file (SMIOL_LIBRARY_*) */
+	struct SMIOL_native *native; /* Native file handle, or NULL */
+	struct SMIOL_stage *stage;   /* Store of staged writes drained to the file, or NULL */
 #ifdef SMIOL_PNETCDF
 	int state; /* parallel-netCDF file state (i.e. Define or data mode) */
 	int ncidp; /* parallel-netCDF file handle */
@@ -50,9 +205,48 @@ struct SMIOL_decomp {
 	SMIOL_Offset *io_list;     /* Elements to be sent/received from/on an I/O task */
 
 	struct SMIOL_context *context; /* Context for this decomp */
+	int id;                        /* Unique ID of this decomp within its context */
 
 	size_t io_start;  /* The starting offset on disk for I/O by a task */
 	size_t io_count;  /* The number of elements for I/O by a task */
+
+	double io_imbalance; /* Largest io_count over the mean io_count of all I/O tasks */
+
+	/*
+	 * When I/O ranges depend on the size of an element (for aligned,
+	 * byte-balanced partitioning), the information below is retained so
+	 * that ranges for other element sizes can be built when first needed
+	 */
+	int io_partition;       /* How elements are divided among I/O tasks (SMIOL_IO_PARTITION_*) */
+	int io_rank;            /* Index of this task among I/O tasks, or -1 */
+	int n_io_tasks;         /* Total number of I/O tasks */
+	size_t io_align_bytes;  /* Alignment in bytes for I/O range boundaries, or 0 for none */
+	size_t element_size;    /* Element size in bytes for which I/O ranges were built, or 0 for any */
+	size_t n_compute_elements;      /* Number of compute elements on this task */
+	SMIOL_Offset *compute_elements; /* Copy of global IDs of compute elements, or NULL */
+	struct SMIOL_decomp *next_size; /* List of decomps for other element sizes */
+
+	/*
+	 * When I/O tasks are gathered into groups that split the first dimension
+	 * inside the decomposed dimension (e.g., vertical levels), every member
+	 * of a group has the same io_start, io_count, and io_list, and handles
+	 * its own block of that dimension
+	 */
+	int io_group_size;  /* Number of I/O tasks in each group */
+	int io_group_rank;  /* Position of this task within its group, or -1 */
+	int *io_task_ranks; /* Rank in the context communicator of each I/O rank, or NULL */
+	int *rank_io;       /* I/O rank of each rank in the context communicator, or NULL */
+
+	/*
+	 * For decomps whose compute elements may include halo copies of
+	 * elements owned by other tasks, and whose global IDs may leave gaps,
+	 * only owned elements are written, while reads fill every copy
+	 */
+	int halo;                       /* Whether compute elements may include halo copies and gaps */
+	size_t n_owned_elements;        /* Number of leading compute elements owned by this task */
+	SMIOL_Offset *fill_comp_list;   /* comp_list for reads that fill every copy, or NULL */
+	SMIOL_Offset *fill_io_list;     /* io_list for reads that fill every copy, or NULL */
+	SMIOL_Offset *io_gap_list;      /* [n, local IDs] of I/O elements owned by no task, or NULL */
 };
 
 
@@ -1,5 +1,7 @@
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "smiol_utils.h"
 
 /*
@@ -11,6 +13,13 @@ static int comp_sort_2(const void *a, const void *b);
 static int comp_search_0(const void *a, const void *b);
 static int comp_search_1(const void *a, const void *b);
 static int comp_search_2(const void *a, const void *b);
+static int get_io_gaps(size_t io_count, const SMIOL_Offset *io_list,
+                       SMIOL_Offset **io_gap_list);
+static int share_group_list(const struct SMIOL_decomp *decomp, int group,
+                            SMIOL_Offset **list, int is_gap_list);
+static void discard_decomp(struct SMIOL_decomp **decomp);
+static int calibrate_io_tasks(struct SMIOL_context *context, int max_node_size,
+                              int *io_tasks_per_node, double *bandwidth);
 
 
 /*******************************************************************************
@@ -117,6 +126,10 @@ SMIOL_Offset *search_triplet_array(SMIOL_Offset key,
  * The caller must have already allocated the out_field argument with sufficient
  * space to contain the field.
  *
+ * For decomps with halos (see SMIOL_create_halo_decomp), only owned elements
+ * are transferred from compute tasks to I/O tasks, while every copy of an
+ * element is filled when transferring from I/O tasks to compute tasks.
+ *
  * If no errors are detected in the input arguments or in the transfer of
  * the input field to the output field, SMIOL_SUCCESS is returned.
  *
@@ -173,6 +186,9 @@ int transfer_field(const struct SMIOL_decomp *decomp, int dir,
 	if (dir == SMIOL_COMP_TO_IO) {
 		sendlist = decomp->comp_list;
 		recvlist = decomp->io_list;
+	} else if (dir == SMIOL_IO_TO_COMP && decomp->fill_io_list != NULL) {
+		sendlist = decomp->fill_io_list;
+		recvlist = decomp->fill_comp_list;
 	} else if (dir == SMIOL_IO_TO_COMP) {
 		sendlist = decomp->io_list;
 		recvlist = decomp->comp_list;
@@ -370,252 +386,1208 @@ int transfer_field(const struct SMIOL_decomp *decomp, int dir,
 
 /*******************************************************************************
  *
- * get_io_elements
- *
- * Returns a contiguous range of I/O elements for an MPI task
+ * get_vertical_block
  *
- * Given the rank of a task, a description of the I/O task arrangement --
- * the number of I/O tasks and the stride between I/O tasks -- as well as the
- * total number of elements to read or write, compute the offset of the first
- * I/O element as well as the number of elements to read or write for the task.
+ * Returns the block of levels handled by a member of a group of I/O tasks
  *
- * If this routine is successful in producing a valid io_start and io_count,
- * a value of 0 is returned; otherwise, a non-zero value is returned.
+ * Given the position of an I/O task within its group, the number of I/O tasks
+ * in the group, and the number of levels -- the size of the first dimension
+ * inside the decomposed dimension of a variable, or one if there is no such
+ * dimension -- returns the first level and the number of levels handled by the
+ * I/O task. Levels are divided as evenly as possible, with later members
+ * taking any extra levels; a member may be given no levels if there are fewer
+ * levels than members.
  *
  *******************************************************************************/
-int get_io_elements(int comm_rank, int num_io_tasks, int io_stride,
-                    size_t n_io_elements, size_t *io_start, size_t *io_count)
+void get_vertical_block(int group_rank, int group_size, size_t n_levels,
+                        size_t *level_start, size_t *level_count)
 {
-	if (io_start == NULL || io_count == NULL) {
-		return 1;
-	}
-
-	*io_start = 0;
-	*io_count = 0;
-
-	if (comm_rank % io_stride == 0) {
-		size_t io_rank = (size_t)(comm_rank / io_stride);
-		size_t elems_per_task = (n_io_elements / (size_t)num_io_tasks);
-
-		if (io_rank >= num_io_tasks) {
-			return 0;
-		}
-
-		*io_start = io_rank * elems_per_task;
-		*io_count = elems_per_task;
+	size_t first, last;
 
-		if (io_rank + 1 == (size_t)num_io_tasks) {
-			size_t remainder = n_io_elements
-			                   - (size_t)num_io_tasks * elems_per_task;
-			*io_count += remainder;
-		}
+	if (group_rank < 0 || group_size < 1 || group_rank >= group_size) {
+		*level_start = 0;
+		*level_count = 0;
+		return;
 	}
 
-	return 0;
+	first = (size_t)group_rank * n_levels / (size_t)group_size;
+	last = ((size_t)group_rank + 1) * n_levels / (size_t)group_size;
+
+	*level_start = first;
+	*level_count = last - first;
 }
 
 
 /*******************************************************************************
  *
- * build_exchange
+ * transfer_field_2d
  *
- * Builds a mapping between compute elements and I/O elements.
+ * Transfers a field between compute and I/O tasks for a decomp whose I/O tasks
+ * are gathered into groups
  *
- * Given arrays of global element IDs that each task computes and global element
- * IDs that each task reads/writes, this routine works out a mapping of elements
- * between compute and I/O tasks.
+ * Like transfer_field, but for a decomp built with an io_group_size greater
+ * than one, in which each member of a group of I/O tasks handles one block of
+ * the n_levels levels of each element (see get_vertical_block). The
+ * element_size argument gives the size in bytes of a whole element, i.e., of
+ * n_levels levels, on compute tasks; on I/O tasks, each element in the field
+ * holds only the block of levels for that I/O task.
  *
- * If all input arguments are determined to be valid and if the routine is
- * successful in working out a mapping, the decomp pointer is allocated and
- * given valid contents, and SMIOL_SUCCESS is returned; otherwise a non-success
- * error code is returned and the decomp pointer is NULL.
+ * Each compute task exchanges with every member of the groups of I/O tasks in
+ * its comp_list, and each member of a group exchanges with the compute tasks in
+ * the io_list that it shares with the other members of its group. For a decomp
+ * without groups of I/O tasks, the field is simply transferred with
+ * transfer_field.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
  *
  *******************************************************************************/
-int build_exchange(struct SMIOL_context *context,
-                   size_t n_compute_elements, SMIOL_Offset *compute_elements,
-                   size_t n_io_elements, SMIOL_Offset *io_elements,
-                   struct SMIOL_decomp **decomp)
+int transfer_field_2d(const struct SMIOL_decomp *decomp, int dir,
+                      size_t element_size, size_t n_levels,
+                      const void *in_field, void *out_field)
 {
 	MPI_Comm comm;
-	int comm_size;
 	int comm_rank;
-	int ierr;
-	int i, j;
-	int count;
-	int nbuf_in, nbuf_out;
-	SMIOL_Offset *compute_ids;
-	SMIOL_Offset *io_ids;
-	SMIOL_Offset *buf_in, *buf_out;
-	SMIOL_Offset *io_list, *comp_list;
-	SMIOL_Offset neighbor;
-	MPI_Request req_in, req_out;
-	size_t ii;
-	size_t idx;
-	size_t n_neighbors;
-	size_t n_xfer;
-	size_t n_xfer_total;
-	size_t n_list;
-
-	const SMIOL_Offset UNKNOWN_TASK = (SMIOL_Offset)(-1);
+	int group_size;
+
+	SMIOL_Offset *comp_list;
+	SMIOL_Offset *io_list;
+	const uint8_t *comp_bytes;
+	uint8_t *comp_bytes_out;
+	const uint8_t *io_bytes;
+	uint8_t *io_bytes_out;
+
+	MPI_Request *reqs = NULL;
+	uint8_t **bufs = NULL;
+	int n_reqs;
+	int max_reqs;
+
+	size_t level_size;
+	size_t my_start, my_count, my_size;
+	size_t n_comp_neighbors, n_io_neighbors;
+	size_t ii, kk;
+	int64_t pos;
+	int s;
+	int j;
+	int n;
+	int taskid;
 
 
-	if (context == NULL) {
+	if (decomp == NULL || n_levels == 0) {
 		return SMIOL_INVALID_ARGUMENT;
 	}
 
-	if (compute_elements == NULL && n_compute_elements != 0) {
+	if (dir != SMIOL_COMP_TO_IO && dir != SMIOL_IO_TO_COMP) {
 		return SMIOL_INVALID_ARGUMENT;
 	}
 
-	if (io_elements == NULL && n_io_elements != 0) {
-		return SMIOL_INVALID_ARGUMENT;
+	/*
+	 * Without groups of I/O tasks, each I/O task handles all levels
+	 */
+	if (decomp->io_group_size <= 1 || decomp->rank_io == NULL) {
+		return transfer_field(decomp, dir, element_size, in_field, out_field);
 	}
 
+	comm = MPI_Comm_f2c(decomp->context->fcomm);
+	comm_rank = decomp->context->comm_rank;
+	group_size = decomp->io_group_size;
 
-	comm = MPI_Comm_f2c(context->fcomm);
-	comm_size = context->comm_size;
-	comm_rank = context->comm_rank;
-
+	comp_list = decomp->comp_list;
+	io_list = decomp->io_list;
+	if (dir == SMIOL_IO_TO_COMP && decomp->fill_io_list != NULL) {
+		comp_list = decomp->fill_comp_list;
+		io_list = decomp->fill_io_list;
+	}
+	n_comp_neighbors = (size_t)comp_list[0];
+	n_io_neighbors = (size_t)io_list[0];
 
 	/*
-	 * Because the count argument to MPI_Isend and MPI_Irecv is an int, at
-	 * most 2^31-1 elements can be transmitted at a time. In this routine,
-	 * arrays of pairs of SMIOL_Offset values will be transmitted as arrays
-	 * of bytes, so n_compute_elements and n_io_elements can be at most
-	 * 2^31-1 / sizeof(SMIOL_Offset) / 2.
+	 * Check that we have non-NULL in_field and out_field arguments
+	 * in agreement with the number of neighbors to send/recv to/from
 	 */
-	i = 0;
-	if (n_compute_elements > (((size_t)1 << 31) - 1)
-	                         / sizeof(SMIOL_Offset)
-	                         / (size_t)2) {
-		i = 1;
-	}
-	if (n_io_elements > (((size_t)1 << 31) - 1)
-	                    / sizeof(SMIOL_Offset)
-	                    / (size_t)2) {
-		i = 1;
+	if (dir == SMIOL_COMP_TO_IO) {
+		if ((in_field == NULL && n_comp_neighbors != 0)
+		    || (out_field == NULL && n_io_neighbors != 0)) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+	} else {
+		if ((in_field == NULL && n_io_neighbors != 0)
+		    || (out_field == NULL && n_comp_neighbors != 0)) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
 	}
 
-	ierr = MPI_Allreduce((const void *)&i, (void *)&j, 1, MPI_INT, MPI_MAX,
-	                     comm);
-	if (j > 0) {
-		return SMIOL_INVALID_ARGUMENT;
-	} else if (ierr != MPI_SUCCESS) {
-		return SMIOL_MPI_ERROR;
-	}
+	level_size = element_size / n_levels;
+	get_vertical_block(decomp->io_group_rank, group_size, n_levels,
+	                   &my_start, &my_count);
+	my_size = my_count * level_size;
 
+	if (dir == SMIOL_COMP_TO_IO) {
+		comp_bytes = (const uint8_t *)in_field;
+		comp_bytes_out = NULL;
+		io_bytes = NULL;
+		io_bytes_out = (uint8_t *)out_field;
+	} else {
+		comp_bytes = NULL;
+		comp_bytes_out = (uint8_t *)out_field;
+		io_bytes = (const uint8_t *)in_field;
+		io_bytes_out = NULL;
+	}
 
 	/*
-	 * Allocate an array, compute_ids, with three entries for each compute
-	 * element
-	 *    [0] - element global ID
-	 *    [1] - element local ID
-	 *    [2] - I/O task that reads/writes this element
+	 * At most one message per member of each neighboring group, plus one
+	 * message per neighbor of this I/O task
 	 */
-	compute_ids = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * TRIPLET_SIZE
-	                                     * n_compute_elements);
-	if (compute_ids == NULL) {
+	max_reqs = (int)(n_comp_neighbors * (size_t)group_size + n_io_neighbors);
+	reqs = (MPI_Request *)malloc(sizeof(MPI_Request) * (size_t)(max_reqs + 1));
+	bufs = (uint8_t **)malloc(sizeof(uint8_t *) * (size_t)(max_reqs + 1));
+	if (reqs == NULL || bufs == NULL) {
+		free(reqs);
+		free(bufs);
 		return SMIOL_MALLOC_FAILURE;
 	}
+	n_reqs = 0;
 
 	/*
-	 * Fill in compute_ids array with global and local IDs; rank of I/O task
-	 * is not yet known
+	 * Post receives: on I/O tasks when moving compute to I/O, or on compute
+	 * tasks when moving I/O to compute
 	 */
-	for (ii = 0; ii < n_compute_elements; ii++) {
-		compute_ids[TRIPLET_SIZE*ii] = compute_elements[ii]; /* global ID */
-		compute_ids[TRIPLET_SIZE*ii+1] = (SMIOL_Offset)ii;   /* local ID */
-		compute_ids[TRIPLET_SIZE*ii+2] = UNKNOWN_TASK;       /* I/O task rank */
+	if (dir == SMIOL_COMP_TO_IO) {
+		pos = 1;
+		for (ii = 0; ii < n_io_neighbors; ii++) {
+			taskid = (int)io_list[pos++];
+			n = (int)io_list[pos++];
+			if (taskid != comm_rank && my_size > 0) {
+				bufs[n_reqs] = (uint8_t *)malloc(my_size * (size_t)n);
+				MPI_Irecv((void *)bufs[n_reqs], n * (int)my_size, MPI_BYTE,
+				          taskid, comm_rank, comm, &reqs[n_reqs]);
+				n_reqs++;
+			}
+			pos += n;
+		}
+	} else {
+		pos = 1;
+		for (ii = 0; ii < n_comp_neighbors; ii++) {
+			int leader = (int)comp_list[pos++];
+			int leader_io = decomp->rank_io[leader];
+			size_t lstart, lcount;
+
+			n = (int)comp_list[pos++];
+			for (s = 0; s < group_size; s++) {
+				taskid = decomp->io_task_ranks[leader_io + s];
+				get_vertical_block(s, group_size, n_levels, &lstart, &lcount);
+				if (taskid >= 0 && taskid != comm_rank && lcount > 0) {
+					bufs[n_reqs] = (uint8_t *)malloc(lcount * level_size * (size_t)n);
+					MPI_Irecv((void *)bufs[n_reqs], n * (int)(lcount * level_size),
+					          MPI_BYTE, taskid, comm_rank, comm, &reqs[n_reqs]);
+					n_reqs++;
+				}
+			}
+			pos += n;
+		}
 	}
 
 	/*
-	 * Sort the compute_ids array on global element ID
-	 * (first entry for each element)
+	 * Pack and post sends, copying directly where a task sends to itself
 	 */
-	sort_triplet_array(n_compute_elements, compute_ids, 0);
+	if (dir == SMIOL_COMP_TO_IO) {
+		pos = 1;
+		for (ii = 0; ii < n_comp_neighbors; ii++) {
+			int leader = (int)comp_list[pos++];
+			int leader_io = decomp->rank_io[leader];
+			size_t lstart, lcount, lsize;
+
+			n = (int)comp_list[pos++];
+			for (s = 0; s < group_size; s++) {
+				taskid = decomp->io_task_ranks[leader_io + s];
+				get_vertical_block(s, group_size, n_levels, &lstart, &lcount);
+				lsize = lcount * level_size;
+				if (taskid < 0 || lsize == 0) {
+					continue;
+				}
+				if (taskid == comm_rank) {
+					/* Local copy: this task's io_list lists the same elements */
+					int64_t ipos = 1;
+					size_t nn;
+
+					for (nn = 0; nn < n_io_neighbors; nn++) {
+						int src = (int)io_list[ipos++];
+						int m = (int)io_list[ipos++];
+
+						if (src == comm_rank) {
+							for (j = 0; j < m; j++) {
+								size_t out_idx = (size_t)io_list[ipos + j] * lsize;
+								size_t in_idx = (size_t)comp_list[pos + j] * element_size
+								                + lstart * level_size;
+
+								for (kk = 0; kk < lsize; kk++) {
+									io_bytes_out[out_idx + kk] = comp_bytes[in_idx + kk];
+								}
+							}
+						}
+						ipos += m;
+					}
+					continue;
+				}
+				bufs[n_reqs] = (uint8_t *)malloc(lsize * (size_t)n);
+				for (j = 0; j < n; j++) {
+					size_t in_idx = (size_t)comp_list[pos + j] * element_size
+					                + lstart * level_size;
+
+					for (kk = 0; kk < lsize; kk++) {
+						bufs[n_reqs][(size_t)j * lsize + kk] = comp_bytes[in_idx + kk];
+					}
+				}
+				MPI_Isend((void *)bufs[n_reqs], n * (int)lsize, MPI_BYTE,
+				          taskid, taskid, comm, &reqs[n_reqs]);
+				n_reqs++;
+			}
+			pos += n;
+		}
+	} else {
+		pos = 1;
+		for (ii = 0; ii < n_io_neighbors; ii++) {
+			taskid = (int)io_list[pos++];
+			n = (int)io_list[pos++];
+			if (my_size == 0) {
+				pos += n;
+				continue;
+			}
+			if (taskid == comm_rank) {
+				/* Local copy: this task's comp_list lists the same elements */
+				int64_t cpos = 1;
+				size_t nn;
+
+				for (nn = 0; nn < n_comp_neighbors; nn++) {
+					int leader = (int)comp_list[cpos++];
+					int m = (int)comp_list[cpos++];
+					int leader_io = decomp->rank_io[leader];
+
+					if (decomp->io_task_ranks[leader_io + decomp->io_group_rank] == comm_rank) {
+						for (j = 0; j < m; j++) {
+							size_t in_idx = (size_t)io_list[pos + j] * my_size;
+							size_t out_idx = (size_t)comp_list[cpos + j] * element_size
+							                 + my_start * level_size;
+
+							for (kk = 0; kk < my_size; kk++) {
+								comp_bytes_out[out_idx + kk] = io_bytes[in_idx + kk];
+							}
+						}
+					}
+					cpos += m;
+				}
+				pos += n;
+				continue;
+			}
+			bufs[n_reqs] = (uint8_t *)malloc(my_size * (size_t)n);
+			for (j = 0; j < n; j++) {
+				size_t in_idx = (size_t)io_list[pos + j] * my_size;
 
-	/*
-	 * Allocate buffer with two entries for each I/O element
-	 *    [0] - I/O element global ID
-	 *    [1] - task that computes this element
-	 */
-	nbuf_out = (int)n_io_elements;
-	buf_out = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (size_t)2
-	                                 * (size_t)nbuf_out);
-	if (buf_out == NULL) {
-		free(compute_ids);
-		return SMIOL_MALLOC_FAILURE;
+				for (kk = 0; kk < my_size; kk++) {
+					bufs[n_reqs][(size_t)j * my_size + kk] = io_bytes[in_idx + kk];
+				}
+			}
+			MPI_Isend((void *)bufs[n_reqs], n * (int)my_size, MPI_BYTE,
+			          taskid, taskid, comm, &reqs[n_reqs]);
+			n_reqs++;
+			pos += n;
+		}
 	}
 
 	/*
-	 * Fill buffer with I/O element IDs; compute task is not yet known
+	 * Wait on all messages
 	 */
-	for (ii = 0; ii < n_io_elements; ii++) {
-		buf_out[2*ii] = io_elements[ii];
-		buf_out[2*ii+1] = UNKNOWN_TASK;
-	}
+	max_reqs = n_reqs;
+	MPI_Waitall(n_reqs, reqs, MPI_STATUSES_IGNORE);
 
 	/*
-	 * Iterate through all ranks in the communicator, receiving from "left"
-	 * neighbor and sending to "right" neighbor in each iteration.
-	 * The objective is to identify, for each I/O element, which MPI rank
-	 * computes that element. At the end of iteration, each rank will have
-	 * seen the I/O element list from all other ranks.
+	 * Unpack receive buffers, visiting neighbors in the order in which
+	 * receives were posted
 	 */
-	for (i = 0; i < comm_size; i++) {
-		/*
-		 * Compute the rank whose buffer will be received this iteration
-		 */
-		SMIOL_Offset src_rank = (comm_rank - 1 - i + comm_size)
-		                        % comm_size;
+	n_reqs = 0;
+	if (dir == SMIOL_COMP_TO_IO) {
+		pos = 1;
+		for (ii = 0; ii < n_io_neighbors; ii++) {
+			taskid = (int)io_list[pos++];
+			n = (int)io_list[pos++];
+			if (taskid != comm_rank && my_size > 0) {
+				for (j = 0; j < n; j++) {
+					size_t out_idx = (size_t)io_list[pos + j] * my_size;
+
+					for (kk = 0; kk < my_size; kk++) {
+						io_bytes_out[out_idx + kk] = bufs[n_reqs][(size_t)j * my_size + kk];
+					}
+				}
+				n_reqs++;
+			}
+			pos += n;
+		}
+	} else {
+		pos = 1;
+		for (ii = 0; ii < n_comp_neighbors; ii++) {
+			int leader = (int)comp_list[pos++];
+			int leader_io = decomp->rank_io[leader];
+			size_t lstart, lcount, lsize;
+
+			n = (int)comp_list[pos++];
+			for (s = 0; s < group_size; s++) {
+				taskid = decomp->io_task_ranks[leader_io + s];
+				get_vertical_block(s, group_size, n_levels, &lstart, &lcount);
+				lsize = lcount * level_size;
+				if (taskid >= 0 && taskid != comm_rank && lsize > 0) {
+					for (j = 0; j < n; j++) {
+						size_t out_idx = (size_t)comp_list[pos + j] * element_size
+						                 + lstart * level_size;
+
+						for (kk = 0; kk < lsize; kk++) {
+							comp_bytes_out[out_idx + kk] = bufs[n_reqs][(size_t)j * lsize + kk];
+						}
+					}
+					n_reqs++;
+				}
+			}
+			pos += n;
+		}
+	}
 
-		/*
-		 * Initiate send of outgoing buffer size and receive of incoming
-		 * buffer size
-		 */
-		ierr = MPI_Irecv((void *)&nbuf_in, 1, MPI_INT,
-		                 (comm_rank - 1 + comm_size) % comm_size,
-		                 (comm_rank + i), comm, &req_in);
+	for (j = 0; j < max_reqs; j++) {
+		free(bufs[j]);
+	}
 
-		ierr = MPI_Isend((const void *)&nbuf_out, 1, MPI_INT,
-		                 (comm_rank + 1) % comm_size,
-		                 ((comm_rank + 1) % comm_size + i), comm,
-		                 &req_out);
+	free(reqs);
+	free(bufs);
 
-		/*
-		 * Wait until the incoming buffer size has been received
-		 */
-		ierr = MPI_Wait(&req_in, MPI_STATUS_IGNORE);
+	return SMIOL_SUCCESS;
+}
 
-		/*
-		 * Allocate incoming buffer
-		 */
-		buf_in = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (size_t)2
-		                                * (size_t)nbuf_in);
 
-		/*
-		 * Initiate receive of incoming buffer
-		 */
-		count = 2 * nbuf_in;
-		count *= (int)sizeof(SMIOL_Offset);
-		ierr = MPI_Irecv((void *)buf_in, count, MPI_BYTE,
-		                 (comm_rank - 1 + comm_size) % comm_size,
-		                 (comm_rank + i), comm, &req_in);
+/*******************************************************************************
+ *
+ * transpose_frames
+ *
+ * Swaps the two outermost dimensions of an array of elements
+ *
+ * Given an array, in, of n_outer by n_inner elements of element_size bytes
+ * each, with the inner index varying fastest, stores in out the same elements
+ * as an array of n_inner by n_outer elements. Multi-frame reads and writes use
+ * this routine to move between a field that is stored frame by frame and one
+ * in which all frames of each element are adjacent, so that every frame may
+ * be transferred between compute and I/O tasks in a single exchange.
+ *
+ *******************************************************************************/
+void transpose_frames(size_t n_outer, size_t n_inner, size_t element_size,
+                      const void *in, void *out)
+{
+	size_t i, j;
+	const char *in_p = (const char *)in;
+	char *out_p = (char *)out;
+
+	for (i = 0; i < n_outer; i++) {
+		for (j = 0; j < n_inner; j++) {
+			memcpy(&out_p[(j * n_outer + i) * element_size],
+			       &in_p[(i * n_inner + j) * element_size],
+			       element_size);
+		}
+	}
+}
 
-		/*
-		 * Wait until the outgoing buffer size has been sent
-		 */
-		ierr = MPI_Wait(&req_out, MPI_STATUS_IGNORE);
 
-		/*
-		 * Initiate send of outgoing buffer
-		 */
-		count = 2 * nbuf_out;
-		count *= (int)sizeof(SMIOL_Offset);
-		ierr = MPI_Isend((const void *)buf_out, count, MPI_BYTE,
-		                 (comm_rank + 1) % comm_size,
-		                 ((comm_rank + 1) % comm_size + i), comm,
-		                 &req_out);
+/*******************************************************************************
+ *
+ * get_io_elements
+ *
+ * Returns a contiguous range of I/O elements for an MPI task
+ *
+ * Given the rank of a task, a description of the I/O task arrangement --
+ * the number of I/O tasks and the stride between I/O tasks -- as well as the
+ * total number of elements to read or write, compute the offset of the first
+ * I/O element as well as the number of elements to read or write for the task.
+ *
+ * If this routine is successful in producing a valid io_start and io_count,
+ * a value of 0 is returned; otherwise, a non-zero value is returned.
+ *
+ *******************************************************************************/
+int get_io_elements(int comm_rank, int num_io_tasks, int io_stride,
+                    size_t n_io_elements, size_t *io_start, size_t *io_count)
+{
+	if (io_start == NULL || io_count == NULL) {
+		return 1;
+	}
+
+	*io_start = 0;
+	*io_count = 0;
+
+	if (comm_rank % io_stride == 0) {
+		return get_io_range(comm_rank / io_stride, num_io_tasks,
+		                    n_io_elements, io_start, io_count);
+	}
+
+	return 0;
+}
+
+
+/*******************************************************************************
+ *
+ * get_io_range
+ *
+ * Returns a contiguous range of I/O elements for an I/O task
+ *
+ * Given the index of an I/O task among all I/O tasks (its I/O rank), the
+ * number of I/O tasks, and the total number of elements to read or write,
+ * compute the offset of the first I/O element as well as the number of
+ * elements to read or write for the I/O task. The elements are divided evenly,
+ * with any remainder assigned to the last I/O task. An I/O rank that is
+ * negative or not less than num_io_tasks is given an empty range.
+ *
+ * If this routine is successful in producing a valid io_start and io_count,
+ * a value of 0 is returned; otherwise, a non-zero value is returned.
+ *
+ *******************************************************************************/
+int get_io_range(int io_rank, int num_io_tasks,
+                 size_t n_io_elements, size_t *io_start, size_t *io_count)
+{
+	size_t elems_per_task;
+
+	if (io_start == NULL || io_count == NULL) {
+		return 1;
+	}
+
+	*io_start = 0;
+	*io_count = 0;
+
+	if (io_rank < 0 || io_rank >= num_io_tasks) {
+		return 0;
+	}
+
+	elems_per_task = (n_io_elements / (size_t)num_io_tasks);
+
+	*io_start = (size_t)io_rank * elems_per_task;
+	*io_count = elems_per_task;
+
+	if (io_rank + 1 == num_io_tasks) {
+		size_t remainder = n_io_elements
+		                   - (size_t)num_io_tasks * elems_per_task;
+		*io_count += remainder;
+	}
+
+	return 0;
+}
+
+
+/*******************************************************************************
+ *
+ * get_io_range_balanced
+ *
+ * Returns a contiguous range of I/O elements for an I/O task, spreading any
+ * remainder over I/O tasks
+ *
+ * Like get_io_range, but rather than assigning the remainder of dividing
+ * n_io_elements by num_io_tasks to the last I/O task, the first I/O tasks are
+ * each assigned one extra element, so that the io_count of any two I/O tasks
+ * differs by at most one.
+ *
+ * If this routine is successful in producing a valid io_start and io_count,
+ * a value of 0 is returned; otherwise, a non-zero value is returned.
+ *
+ *******************************************************************************/
+int get_io_range_balanced(int io_rank, int num_io_tasks,
+                          size_t n_io_elements, size_t *io_start, size_t *io_count)
+{
+	size_t elems_per_task;
+	size_t remainder;
+
+	if (io_start == NULL || io_count == NULL) {
+		return 1;
+	}
+
+	*io_start = 0;
+	*io_count = 0;
+
+	if (io_rank < 0 || io_rank >= num_io_tasks) {
+		return 0;
+	}
+
+	elems_per_task = n_io_elements / (size_t)num_io_tasks;
+	remainder = n_io_elements % (size_t)num_io_tasks;
+
+	*io_start = (size_t)io_rank * elems_per_task;
+	if ((size_t)io_rank < remainder) {
+		*io_start += (size_t)io_rank;
+		*io_count = elems_per_task + 1;
+	} else {
+		*io_start += remainder;
+		*io_count = elems_per_task;
+	}
+
+	return 0;
+}
+
+
+/*******************************************************************************
+ *
+ * get_io_range_partitioned
+ *
+ * Returns a contiguous range of I/O elements for an I/O task according to
+ * a partitioning method
+ *
+ * If align_bytes and element_size are both non-zero, the range is computed by
+ * get_io_range_aligned. Otherwise, for the SMIOL_IO_PARTITION_BYTES method the
+ * range is computed by get_io_range_balanced, and for any other method by
+ * get_io_range.
+ *
+ * If this routine is successful in producing a valid io_start and io_count,
+ * a value of 0 is returned; otherwise, a non-zero value is returned.
+ *
+ *******************************************************************************/
+int get_io_range_partitioned(int partition, int io_rank, int num_io_tasks,
+                             size_t n_io_elements, size_t element_size,
+                             size_t align_bytes,
+                             size_t *io_start, size_t *io_count)
+{
+	if (align_bytes > 0 && element_size > 0) {
+		return get_io_range_aligned(io_rank, num_io_tasks, n_io_elements,
+		                            element_size, align_bytes,
+		                            io_start, io_count);
+	}
+
+	if (partition == SMIOL_IO_PARTITION_BYTES) {
+		return get_io_range_balanced(io_rank, num_io_tasks, n_io_elements,
+		                             io_start, io_count);
+	}
+
+	return get_io_range(io_rank, num_io_tasks, n_io_elements,
+	                    io_start, io_count);
+}
+
+
+/*******************************************************************************
+ *
+ * get_io_range_aligned
+ *
+ * Returns a contiguous, aligned range of I/O elements for an I/O task
+ *
+ * Like get_io_range, but every boundary between the ranges of consecutive
+ * I/O tasks falls at a byte offset from the start of the variable that is a
+ * multiple of align_bytes, given that each element occupies element_size
+ * bytes. Elements are grouped into aligned units of the smallest number of
+ * elements whose size is a multiple of align_bytes, and the units are divided
+ * as evenly as possible among I/O tasks. The final I/O task ends at
+ * n_io_elements, so that only its last write may be unaligned.
+ *
+ * When an aligned unit is large compared with the number of elements per I/O
+ * task, some I/O tasks may be given an empty range. An align_bytes or
+ * element_size of zero gives the same ranges as get_io_range.
+ *
+ * If this routine is successful in producing a valid io_start and io_count,
+ * a value of 0 is returned; otherwise, a non-zero value is returned.
+ *
+ *******************************************************************************/
+int get_io_range_aligned(int io_rank, int num_io_tasks, size_t n_io_elements,
+                         size_t element_size, size_t align_bytes,
+                         size_t *io_start, size_t *io_count)
+{
+	size_t a, b, t;
+	size_t unit;
+	size_t n_units;
+	size_t first, last;
+
+	if (align_bytes == 0 || element_size == 0) {
+		return get_io_range(io_rank, num_io_tasks, n_io_elements,
+		                    io_start, io_count);
+	}
+
+	if (io_start == NULL || io_count == NULL) {
+		return 1;
+	}
+
+	*io_start = 0;
+	*io_count = 0;
+
+	if (io_rank < 0 || io_rank >= num_io_tasks) {
+		return 0;
+	}
+
+	/* Elements per aligned unit is align_bytes / gcd(align_bytes, element_size) */
+	a = align_bytes;
+	b = element_size;
+	while (b != 0) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	unit = align_bytes / a;
+
+	n_units = (n_io_elements + unit - 1) / unit;
+
+	first = (size_t)io_rank * n_units / (size_t)num_io_tasks * unit;
+	last = ((size_t)io_rank + 1) * n_units / (size_t)num_io_tasks * unit;
+
+	if (first > n_io_elements) {
+		first = n_io_elements;
+	}
+	if (last > n_io_elements || io_rank + 1 == num_io_tasks) {
+		last = n_io_elements;
+	}
+
+	*io_start = first;
+	*io_count = last - first;
+
+	return 0;
+}
+
+
+/*******************************************************************************
+ *
+ * get_node_io_tasks
+ *
+ * Returns the number of I/O tasks to be placed on a node
+ *
+ * Given the index of a node, the number of nodes, the number of tasks on the
+ * node, and either a fixed number of I/O tasks per node (io_tasks_per_node > 0)
+ * or a total number of I/O tasks to be divided among all nodes, returns the
+ * number of I/O tasks on the node. When dividing num_io_tasks among nodes, the
+ * first nodes take one extra I/O task each until the remainder is exhausted.
+ * No node is given more I/O tasks than it has tasks.
+ *
+ *******************************************************************************/
+int get_node_io_tasks(int node_id, int num_nodes, int node_size,
+                      int num_io_tasks, int io_tasks_per_node)
+{
+	int n;
+
+	if (num_nodes <= 0 || node_id < 0 || node_id >= num_nodes) {
+		return 0;
+	}
+
+	if (io_tasks_per_node > 0) {
+		n = io_tasks_per_node;
+	} else {
+		n = num_io_tasks / num_nodes;
+		if (node_id < num_io_tasks % num_nodes) {
+			n++;
+		}
+	}
+
+	if (n > node_size) {
+		n = node_size;
+	}
+
+	return (n > 0) ? n : 0;
+}
+
+
+/*******************************************************************************
+ *
+ * get_node_io_slot
+ *
+ * Returns the position of a task among the I/O tasks on its node
+ *
+ * Given the rank of a task within its node, the number of tasks on the node,
+ * and the number of I/O tasks on the node, returns the index of the task among
+ * the I/O tasks on the node, or -1 if the task is not an I/O task. The I/O
+ * tasks on a node are spread evenly over the node-local ranks, with the I/O
+ * task in slot s having node rank floor(s * node_size / node_io_tasks), so that
+ * node rank 0 is always the first I/O task on a node with any I/O tasks.
+ *
+ *******************************************************************************/
+int get_node_io_slot(int node_rank, int node_size, int node_io_tasks)
+{
+	long slot;
+
+	if (node_io_tasks <= 0 || node_rank < 0 || node_rank >= node_size) {
+		return -1;
+	}
+
+	/* Smallest slot whose node rank is not less than node_rank */
+	slot = ((long)node_rank * (long)node_io_tasks + (long)node_size - 1)
+	       / (long)node_size;
+
+	if (slot < (long)node_io_tasks
+	    && (slot * (long)node_size) / (long)node_io_tasks == (long)node_rank) {
+		return (int)slot;
+	}
+
+	return -1;
+}
+
+
+/*******************************************************************************
+ *
+ * get_node_io_rank
+ *
+ * Determines the I/O rank of a task when I/O tasks are placed by node
+ *
+ * Given a SMIOL context and a total number of I/O tasks, this collective
+ * routine places I/O tasks on each node as described for get_node_io_tasks and
+ * get_node_io_slot, using the node layout and the io_tasks_per_node setting
+ * recorded in the context. I/O ranks are numbered first by node and then by
+ * slot within a node, so that the I/O ranges of all I/O tasks on a node are
+ * adjacent.
+ *
+ * On return, io_rank is the I/O rank of the calling task (or -1 if it is not an
+ * I/O task), and n_io_tasks is the total number of I/O tasks across all nodes.
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int get_node_io_rank(struct SMIOL_context *context, int num_io_tasks,
+                     int *io_rank, int *n_io_tasks)
+{
+	MPI_Comm comm;
+	int node_io_tasks;
+	int slot;
+	int i;
+	int local[2];
+	int *all;
+
+	if (context == NULL || io_rank == NULL || n_io_tasks == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	comm = MPI_Comm_f2c(context->fcomm);
+
+	node_io_tasks = get_node_io_tasks(context->node_id, context->num_nodes,
+	                                  context->node_size, num_io_tasks,
+	                                  context->io_tasks_per_node);
+	slot = get_node_io_slot(context->node_rank, context->node_size,
+	                        node_io_tasks);
+
+	/*
+	 * Gather (node ID, number of I/O tasks on node) from all tasks, with
+	 * only the first task on each node reporting a non-zero count
+	 */
+	local[0] = context->node_id;
+	local[1] = (context->node_rank == 0) ? node_io_tasks : 0;
+
+	all = (int *)malloc(sizeof(int) * (size_t)2 * (size_t)context->comm_size);
+	if (all == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	if (MPI_Allgather((const void *)local, 2, MPI_INT,
+	                  (void *)all, 2, MPI_INT, comm) != MPI_SUCCESS) {
+		free(all);
+		return SMIOL_MPI_ERROR;
+	}
+
+	*n_io_tasks = 0;
+	*io_rank = -1;
+	if (slot >= 0) {
+		*io_rank = slot;
+	}
+	for (i = 0; i < context->comm_size; i++) {
+		*n_io_tasks += all[2*i+1];
+		if (slot >= 0 && all[2*i] < context->node_id) {
+			*io_rank += all[2*i+1];
+		}
+	}
+
+	free(all);
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * autotune_io_tasks
+ *
+ * Chooses the number of I/O tasks and the stride between them automatically
+ *
+ * Given a SMIOL context and the compute elements of the calling task for a
+ * decomp, and whether those elements may include halo copies (see
+ * build_io_decomp), this collective routine chooses a number of I/O tasks per
+ * node and, from that, a number of I/O tasks and a stride between I/O tasks
+ * for use in the decomp.
+ *
+ * The number of I/O tasks per node is determined once per context, as follows:
+ * if a cache file has been set with SMIOL_set_io_autotune and contains an entry
+ * for the same communicator size, number of nodes, and largest node size, the
+ * entry is used; otherwise, if a scratch file has been set, a short
+ * calibration write is made with several numbers of I/O tasks per node and the
+ * number giving the highest bandwidth is chosen, and the result is appended to
+ * the cache file (if one has been set); otherwise, one I/O task per node is
+ * used.
+ *
+ * The number of I/O tasks is then the number of I/O tasks per node times the
+ * number of nodes, limited so that each I/O task reads or writes at least
+ * SMIOL_AUTO_MIN_IO_BYTES bytes (assuming elements of the nominal size set
+ * by SMIOL_set_io_alignment, or of sizeof(double)). The stride is chosen to
+ * spread I/O tasks evenly over the communicator.
+ *
+ * The chosen values and the measured bandwidth are recorded in the context.
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+int autotune_io_tasks(struct SMIOL_context *context, size_t n_compute_elements,
+                      const SMIOL_Offset *compute_elements, int halo,
+                      int *num_io_tasks, int *io_stride)
+{
+	MPI_Comm comm;
+	int ierr;
+	int max_node_size;
+	int n_io;
+	size_t element_size;
+	size_t max_io;
+	uint64_t n_local, n_io_elements;
+
+	if (context == NULL || num_io_tasks == NULL || io_stride == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	comm = MPI_Comm_f2c(context->fcomm);
+
+	/*
+	 * As in build_io_decomp, the number of elements for I/O is the number
+	 * of compute elements, or for decomps with halos, which would count
+	 * copies of elements more than once, one more than the largest global
+	 * ID
+	 */
+	if (halo) {
+		SMIOL_Offset max_id = -1;
+		SMIOL_Offset max_id_global;
+		size_t i;
+
+		for (i = 0; i < n_compute_elements; i++) {
+			if (compute_elements[i] > max_id) {
+				max_id = compute_elements[i];
+			}
+		}
+		if (MPI_Allreduce((const void *)&max_id, (void *)&max_id_global, 1,
+		                  MPI_INT64_T, MPI_MAX, comm) != MPI_SUCCESS) {
+			return SMIOL_MPI_ERROR;
+		}
+		n_io_elements = (uint64_t)(max_id_global + 1);
+	} else {
+		n_local = (uint64_t)n_compute_elements;
+		if (MPI_Allreduce((const void *)&n_local, (void *)&n_io_elements, 1,
+		                  MPI_UINT64_T, MPI_SUM, comm) != MPI_SUCCESS) {
+			return SMIOL_MPI_ERROR;
+		}
+	}
+
+	if (context->auto_io_tasks_per_node == 0) {
+		int found = 0;
+		int k = 1;
+		double bandwidth = 0.0;
+
+		if (MPI_Allreduce((const void *)&context->node_size,
+		                  (void *)&max_node_size, 1, MPI_INT, MPI_MAX,
+		                  comm) != MPI_SUCCESS) {
+			return SMIOL_MPI_ERROR;
+		}
+
+		/*
+		 * Look for settings recorded for this node layout by an
+		 * earlier run
+		 */
+		if (context->autotune_cache != NULL && context->comm_rank == 0) {
+			FILE *cache;
+			char line[256];
+			int c_comm_size, c_num_nodes, c_node_size, c_k;
+			double c_bandwidth;
+
+			cache = fopen(context->autotune_cache, "r");
+			if (cache != NULL) {
+				while (fgets(line, (int)sizeof(line), cache) != NULL) {
+					if (line[0] == '#') {
+						continue;
+					}
+					if (sscanf(line, "%d %d %d %d %lf", &c_comm_size,
+					           &c_num_nodes, &c_node_size, &c_k,
+					           &c_bandwidth) == 5
+					    && c_comm_size == context->comm_size
+					    && c_num_nodes == context->num_nodes
+					    && c_node_size == max_node_size
+					    && c_k > 0) {
+						found = 1;
+						k = c_k;
+						bandwidth = c_bandwidth;
+					}
+				}
+				fclose(cache);
+			}
+		}
+
+		if (context->autotune_cache != NULL) {
+			int ibuf[2];
+
+			ibuf[0] = found;
+			ibuf[1] = k;
+			if (MPI_Bcast((void *)ibuf, 2, MPI_INT, 0, comm) != MPI_SUCCESS
+			    || MPI_Bcast((void *)&bandwidth, 1, MPI_DOUBLE, 0, comm)
+			       != MPI_SUCCESS) {
+				return SMIOL_MPI_ERROR;
+			}
+			found = ibuf[0];
+			k = ibuf[1];
+		}
+
+		if (!found && context->autotune_scratch != NULL) {
+			ierr = calibrate_io_tasks(context, max_node_size, &k, &bandwidth);
+			if (ierr != SMIOL_SUCCESS) {
+				return ierr;
+			}
+
+			if (context->autotune_cache != NULL && context->comm_rank == 0) {
+				FILE *cache;
+				long pos;
+
+				cache = fopen(context->autotune_cache, "a");
+				if (cache != NULL) {
+					fseek(cache, 0L, SEEK_END);
+					pos = ftell(cache);
+					if (pos == 0) {
+						fprintf(cache, "# comm_size num_nodes node_size"
+						               " io_tasks_per_node bandwidth(bytes/s)\n");
+					}
+					fprintf(cache, "%d %d %d %d %.17g\n", context->comm_size,
+					        context->num_nodes, max_node_size, k, bandwidth);
+					fclose(cache);
+				}
+			}
+		}
+
+		context->auto_io_tasks_per_node = k;
+		context->auto_bandwidth = bandwidth;
+	}
+
+	/*
+	 * Limit the number of I/O tasks so that each has a useful amount of
+	 * data to read or write
+	 */
+	element_size = context->io_align_element_size;
+	if (element_size == 0) {
+		element_size = sizeof(double);
+	}
+	max_io = (size_t)n_io_elements * element_size / SMIOL_AUTO_MIN_IO_BYTES;
+	if (max_io < 1) {
+		max_io = 1;
+	}
+
+	n_io = context->auto_io_tasks_per_node * context->num_nodes;
+	if (n_io > context->comm_size) {
+		n_io = context->comm_size;
+	}
+	if ((size_t)n_io > max_io) {
+		n_io = (int)max_io;
+	}
+	if (n_io < 1) {
+		n_io = 1;
+	}
+
+	*num_io_tasks = n_io;
+	*io_stride = context->comm_size / n_io;
+
+	context->auto_num_io_tasks = *num_io_tasks;
+	context->auto_io_stride = *io_stride;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * build_exchange
+ *
+ * Builds a mapping between compute elements and I/O elements.
+ *
+ * Given arrays of global element IDs that each task computes and global element
+ * IDs that each task reads/writes, this routine works out a mapping of elements
+ * between compute and I/O tasks.
+ *
+ * If all input arguments are determined to be valid and if the routine is
+ * successful in working out a mapping, the decomp pointer is allocated and
+ * given valid contents, and SMIOL_SUCCESS is returned; otherwise a non-success
+ * error code is returned and the decomp pointer is NULL.
+ *
+ *******************************************************************************/
+int build_exchange(struct SMIOL_context *context,
+                   size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                   size_t n_io_elements, SMIOL_Offset *io_elements,
+                   struct SMIOL_decomp **decomp)
+{
+	MPI_Comm comm;
+	int comm_size;
+	int comm_rank;
+	int ierr;
+	int i, j;
+	int count;
+	int nbuf_in, nbuf_out;
+	SMIOL_Offset *compute_ids;
+	SMIOL_Offset *io_ids;
+	SMIOL_Offset *buf_in, *buf_out;
+	SMIOL_Offset *io_list, *comp_list;
+	SMIOL_Offset neighbor;
+	MPI_Request req_in, req_out;
+	size_t ii;
+	size_t idx;
+	size_t n_neighbors;
+	size_t n_xfer;
+	size_t n_xfer_total;
+	size_t n_list;
+
+	const SMIOL_Offset UNKNOWN_TASK = (SMIOL_Offset)(-1);
+
+
+	if (context == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (compute_elements == NULL && n_compute_elements != 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (io_elements == NULL && n_io_elements != 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+
+	comm = MPI_Comm_f2c(context->fcomm);
+	comm_size = context->comm_size;
+	comm_rank = context->comm_rank;
+
+
+	/*
+	 * Because the count argument to MPI_Isend and MPI_Irecv is an int, at
+	 * most 2^31-1 elements can be transmitted at a time. In this routine,
+	 * arrays of pairs of SMIOL_Offset values will be transmitted as arrays
+	 * of bytes, so n_compute_elements and n_io_elements can be at most
+	 * 2^31-1 / sizeof(SMIOL_Offset) / 2.
+	 */
+	i = 0;
+	if (n_compute_elements > (((size_t)1 << 31) - 1)
+	                         / sizeof(SMIOL_Offset)
+	                         / (size_t)2) {
+		i = 1;
+	}
+	if (n_io_elements > (((size_t)1 << 31) - 1)
+	                    / sizeof(SMIOL_Offset)
+	                    / (size_t)2) {
+		i = 1;
+	}
+
+	ierr = MPI_Allreduce((const void *)&i, (void *)&j, 1, MPI_INT, MPI_MAX,
+	                     comm);
+	if (j > 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	} else if (ierr != MPI_SUCCESS) {
+		return SMIOL_MPI_ERROR;
+	}
+
+
+	/*
+	 * Allocate an array, compute_ids, with three entries for each compute
+	 * element
+	 *    [0] - element global ID
+	 *    [1] - element local ID
+	 *    [2] - I/O task that reads/writes this element
+	 */
+	compute_ids = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * TRIPLET_SIZE
+	                                     * n_compute_elements);
+	if (compute_ids == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	/*
+	 * Fill in compute_ids array with global and local IDs; rank of I/O task
+	 * is not yet known
+	 */
+	for (ii = 0; ii < n_compute_elements; ii++) {
+		compute_ids[TRIPLET_SIZE*ii] = compute_elements[ii]; /* global ID */
+		compute_ids[TRIPLET_SIZE*ii+1] = (SMIOL_Offset)ii;   /* local ID */
+		compute_ids[TRIPLET_SIZE*ii+2] = UNKNOWN_TASK;       /* I/O task rank */
+	}
+
+	/*
+	 * Sort the compute_ids array on global element ID
+	 * (first entry for each element)
+	 */
+	sort_triplet_array(n_compute_elements, compute_ids, 0);
+
+	/*
+	 * Allocate buffer with two entries for each I/O element
+	 *    [0] - I/O element global ID
+	 *    [1] - task that computes this element
+	 */
+	nbuf_out = (int)n_io_elements;
+	buf_out = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (size_t)2
+	                                 * (size_t)nbuf_out);
+	if (buf_out == NULL) {
+		free(compute_ids);
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	/*
+	 * Fill buffer with I/O element IDs; compute task is not yet known
+	 */
+	for (ii = 0; ii < n_io_elements; ii++) {
+		buf_out[2*ii] = io_elements[ii];
+		buf_out[2*ii+1] = UNKNOWN_TASK;
+	}
+
+	/*
+	 * Iterate through all ranks in the communicator, receiving from "left"
+	 * neighbor and sending to "right" neighbor in each iteration.
+	 * The objective is to identify, for each I/O element, which MPI rank
+	 * computes that element. At the end of iteration, each rank will have
+	 * seen the I/O element list from all other ranks.
+	 */
+	for (i = 0; i < comm_size; i++) {
+		/*
+		 * Compute the rank whose buffer will be received this iteration
+		 */
+		SMIOL_Offset src_rank = (comm_rank - 1 - i + comm_size)
+		                        % comm_size;
+
+		/*
+		 * Initiate send of outgoing buffer size and receive of incoming
+		 * buffer size
+		 */
+		ierr = MPI_Irecv((void *)&nbuf_in, 1, MPI_INT,
+		                 (comm_rank - 1 + comm_size) % comm_size,
+		                 (comm_rank + i), comm, &req_in);
+
+		ierr = MPI_Isend((const void *)&nbuf_out, 1, MPI_INT,
+		                 (comm_rank + 1) % comm_size,
+		                 ((comm_rank + 1) % comm_size + i), comm,
+		                 &req_out);
+
+		/*
+		 * Wait until the incoming buffer size has been received
+		 */
+		ierr = MPI_Wait(&req_in, MPI_STATUS_IGNORE);
+
+		/*
+		 * Allocate incoming buffer
+		 */
+		buf_in = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (size_t)2
+		                                * (size_t)nbuf_in);
+
+		/*
+		 * Initiate receive of incoming buffer
+		 */
+		count = 2 * nbuf_in;
+		count *= (int)sizeof(SMIOL_Offset);
+		ierr = MPI_Irecv((void *)buf_in, count, MPI_BYTE,
+		                 (comm_rank - 1 + comm_size) % comm_size,
+		                 (comm_rank + i), comm, &req_in);
+
+		/*
+		 * Wait until the outgoing buffer size has been sent
+		 */
+		ierr = MPI_Wait(&req_out, MPI_STATUS_IGNORE);
+
+		/*
+		 * Initiate send of outgoing buffer
+		 */
+		count = 2 * nbuf_out;
+		count *= (int)sizeof(SMIOL_Offset);
+		ierr = MPI_Isend((const void *)buf_out, count, MPI_BYTE,
+		                 (comm_rank + 1) % comm_size,
+		                 ((comm_rank + 1) % comm_size + i), comm,
+		                 &req_out);
 
 		/*
 		 * Wait until the incoming buffer has been received
@@ -713,37 +1685,146 @@ int build_exchange(struct SMIOL_context *context,
 	}
 
 	/*
-	 * Initialize the SMIOL_decomp struct
+	 * Initialize the SMIOL_decomp struct
+	 */
+	(*decomp)->context = context;
+	(*decomp)->id = ++context->n_decomps;
+	(*decomp)->comp_list = NULL;
+	(*decomp)->io_list = NULL;
+	(*decomp)->io_start = 0;
+	(*decomp)->io_count = 0;
+	(*decomp)->io_imbalance = 1.0;
+	(*decomp)->io_partition = SMIOL_IO_PARTITION_ELEMENTS;
+	(*decomp)->io_rank = -1;
+	(*decomp)->n_io_tasks = 0;
+	(*decomp)->io_align_bytes = 0;
+	(*decomp)->element_size = 0;
+	(*decomp)->n_compute_elements = 0;
+	(*decomp)->compute_elements = NULL;
+	(*decomp)->next_size = NULL;
+	(*decomp)->io_group_size = 1;
+	(*decomp)->io_group_rank = -1;
+	(*decomp)->io_task_ranks = NULL;
+	(*decomp)->rank_io = NULL;
+	(*decomp)->halo = 0;
+	(*decomp)->n_owned_elements = n_compute_elements;
+	(*decomp)->fill_comp_list = NULL;
+	(*decomp)->fill_io_list = NULL;
+	(*decomp)->io_gap_list = NULL;
+
+
+	/*
+	 * Scan through io_ids to determine number of unique neighbors that
+	 * compute elements read/written on this task, and also determine
+	 * the total number of elements
+	 * computed on other tasks that are read/written on this task
+	 */
+	ii = 0;
+	n_neighbors = 0;
+	n_xfer_total = 0;
+	while (ii < n_io_elements) {
+		/* Task that computes this element */
+		neighbor = io_ids[TRIPLET_SIZE*ii + 2];
+
+		/* Number of elements to read/write for neighbor */
+		n_xfer = 0;
+
+		/*
+		 * Since io_ids is sorted on task, as long as task is unchanged,
+		 * increment n_xfer
+		 */
+		while (ii < n_io_elements
+		       && io_ids[TRIPLET_SIZE*ii+2] == neighbor) {
+			n_xfer++;
+			ii++;
+		}
+		if (neighbor != UNKNOWN_TASK) {
+			n_neighbors++;
+			n_xfer_total += n_xfer;
+		}
+	}
+
+	/*
+	 * Based on number of neighbors and total number of elements to transfer
+	 * allocate the io_list
+	 */
+	n_list = sizeof(SMIOL_Offset) * ((size_t)1
+	                                 + (size_t)2 * n_neighbors
+	                                 + n_xfer_total);
+	(*decomp)->io_list = (SMIOL_Offset *)malloc(n_list);
+	if ((*decomp)->io_list == NULL) {
+		free(compute_ids);
+		free(io_ids);
+		free(*decomp);
+		*decomp = NULL;
+		return SMIOL_MALLOC_FAILURE;
+	}
+	io_list = (*decomp)->io_list;
+
+	/*
+	 * Scan through io_ids a second time, filling in the io_list
+	 */
+	io_list[0] = (SMIOL_Offset)n_neighbors;
+	idx = 1; /* Index in io_list where neighbor ID will be written, followed
+	            by number of elements and element local IDs */
+
+	ii = 0;
+	while (ii < n_io_elements) {
+		/* Task that computes this element */
+		neighbor = io_ids[TRIPLET_SIZE*ii + 2];
+
+		/* Number of elements to read/write for neighbor */
+		n_xfer = 0;
+
+		/*
+		 * Since io_ids is sorted on task, as long as task is unchanged,
+		 * increment n_xfer
+		 */
+		while (ii < n_io_elements
+		       && io_ids[TRIPLET_SIZE*ii+2] == neighbor) {
+			if (neighbor != UNKNOWN_TASK) {
+				/* Save local element ID in list */
+				io_list[idx+2+n_xfer] = io_ids[TRIPLET_SIZE*ii+1];
+				n_xfer++;
+			}
+			ii++;
+		}
+		if (neighbor != UNKNOWN_TASK) {
+			io_list[idx] = neighbor;
+			io_list[idx+1] = (SMIOL_Offset)n_xfer;
+			idx += (2 + n_xfer);
+		}
+	}
+
+	free(io_ids);
+
+	/*
+	 * Sort compute_ids array on task ID (third entry for each element)
 	 */
-	(*decomp)->context = context;
-	(*decomp)->comp_list = NULL;
-	(*decomp)->io_list = NULL;
-	(*decomp)->io_start = 0;
-	(*decomp)->io_count = 0;
-
+	sort_triplet_array(n_compute_elements, compute_ids, 2);
 
 	/*
-	 * Scan through io_ids to determine number of unique neighbors that
-	 * compute elements read/written on this task, and also determine
-	 * the total number of elements
-	 * computed on other tasks that are read/written on this task
+	 * Scan through compute_ids to determine number of unique neighbors that
+	 * read/write elements computed on this task, and also determine
+	 * the total number of elements read/written on other tasks that are
+	 * computed on this task
 	 */
 	ii = 0;
 	n_neighbors = 0;
 	n_xfer_total = 0;
-	while (ii < n_io_elements) {
-		/* Task that computes this element */
-		neighbor = io_ids[TRIPLET_SIZE*ii + 2];
+	while (ii < n_compute_elements) {
+		/* Task that reads/writes this element */
+		neighbor = compute_ids[TRIPLET_SIZE*ii + 2];
 
-		/* Number of elements to read/write for neighbor */
+		/* Number of elements to compute for neighbor */
 		n_xfer = 0;
 
 		/*
-		 * Since io_ids is sorted on task, as long as task is unchanged,
-		 * increment n_xfer
+		 * Since compute_ids is sorted on task, as long as task is
+		 * unchanged, increment n_xfer
 		 */
-		while (ii < n_io_elements
-		       && io_ids[TRIPLET_SIZE*ii+2] == neighbor) {
+		while (ii < n_compute_elements
+		       && compute_ids[TRIPLET_SIZE*ii+2] == neighbor) {
 			n_xfer++;
 			ii++;
 		}
@@ -755,147 +1836,776 @@ int build_exchange(struct SMIOL_context *context,
 
 	/*
 	 * Based on number of neighbors and total number of elements to transfer
-	 * allocate the io_list
+	 * allocate the comp_list
 	 */
 	n_list = sizeof(SMIOL_Offset) * ((size_t)1
 	                                 + (size_t)2 * n_neighbors
 	                                 + n_xfer_total);
-	(*decomp)->io_list = (SMIOL_Offset *)malloc(n_list);
-	if ((*decomp)->io_list == NULL) {
+	(*decomp)->comp_list = (SMIOL_Offset *)malloc(n_list);
+	if ((*decomp)->comp_list == NULL) {
 		free(compute_ids);
-		free(io_ids);
+		free((*decomp)->io_list);
 		free(*decomp);
 		*decomp = NULL;
 		return SMIOL_MALLOC_FAILURE;
 	}
-	io_list = (*decomp)->io_list;
+	comp_list = (*decomp)->comp_list;
 
 	/*
-	 * Scan through io_ids a second time, filling in the io_list
+	 * Scan through compute_ids a second time, filling in the comp_list
 	 */
-	io_list[0] = (SMIOL_Offset)n_neighbors;
-	idx = 1; /* Index in io_list where neighbor ID will be written, followed
-	            by number of elements and element local IDs */
+	comp_list[0] = (SMIOL_Offset)n_neighbors;
+	idx = 1; /* Index in compute_list where neighbor ID will be written,
+	            followed by number of elements and element local IDs */
 
 	ii = 0;
-	while (ii < n_io_elements) {
-		/* Task that computes this element */
-		neighbor = io_ids[TRIPLET_SIZE*ii + 2];
+	while (ii < n_compute_elements) {
+		/* Task that reads/writes this element */
+		neighbor = compute_ids[TRIPLET_SIZE*ii + 2];
 
-		/* Number of elements to read/write for neighbor */
+		/* Number of elements to compute for neighbor */
 		n_xfer = 0;
 
 		/*
-		 * Since io_ids is sorted on task, as long as task is unchanged,
-		 * increment n_xfer
+		 * Since compute_ids is sorted on task, as long as task is
+		 * unchanged, increment n_xfer
 		 */
-		while (ii < n_io_elements
-		       && io_ids[TRIPLET_SIZE*ii+2] == neighbor) {
+		while (ii < n_compute_elements
+		       && compute_ids[TRIPLET_SIZE*ii+2] == neighbor) {
 			if (neighbor != UNKNOWN_TASK) {
 				/* Save local element ID in list */
-				io_list[idx+2+n_xfer] = io_ids[TRIPLET_SIZE*ii+1];
+				comp_list[idx+2+n_xfer] = compute_ids[TRIPLET_SIZE*ii+1];
 				n_xfer++;
 			}
 			ii++;
 		}
 		if (neighbor != UNKNOWN_TASK) {
-			io_list[idx] = neighbor;
-			io_list[idx+1] = (SMIOL_Offset)n_xfer;
+			comp_list[idx] = neighbor;
+			comp_list[idx+1] = (SMIOL_Offset)n_xfer;
 			idx += (2 + n_xfer);
 		}
 	}
 
-	free(io_ids);
+	free(compute_ids);
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * build_fill_exchange
+ *
+ * Builds exchange lists that deliver each I/O element to every task holding it
+ *
+ * Given arrays of global element IDs that each task computes -- which may
+ * include any number of copies of the same global ID on any number of tasks,
+ * e.g., for halo elements -- and the contiguous range of elements read by each
+ * task, this collective routine builds a comp_list and an io_list for which
+ * transferring from I/O tasks to compute tasks fills every copy of every
+ * element. Compute elements that lie in no task's range are not filled.
+ *
+ * Because ranges of I/O elements are contiguous, each task first gathers the
+ * ranges of all tasks and locates the I/O task for each of its compute
+ * elements; the global IDs of compute elements are then sent to their I/O
+ * tasks. For each neighbor, the local IDs in comp_list and io_list are listed
+ * in the same order.
+ *
+ * Upon success, SMIOL_SUCCESS is returned and comp_list and io_list point to
+ * newly allocated lists; otherwise, an error code is returned.
+ *
+ *******************************************************************************/
+int build_fill_exchange(struct SMIOL_context *context,
+                        size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                        size_t io_start, size_t io_count,
+                        SMIOL_Offset **comp_list, SMIOL_Offset **io_list)
+{
+	MPI_Comm comm;
+	int comm_size;
+	int i;
+	int n_ranges;
+	int n_neighbors;
+	int n_send;
+	int n_recv;
+	size_t ii;
+	size_t idx;
+	SMIOL_Offset my_range[2];
+	SMIOL_Offset *ranges;
+	SMIOL_Offset *sorted_ranges;
+	SMIOL_Offset *compute_ids;
+	SMIOL_Offset *send_ids;
+	SMIOL_Offset *recv_ids;
+	int *counts;
+	int *send_counts, *recv_counts;
+	int *send_displs, *recv_displs;
+	int ierr;
+
+	const SMIOL_Offset UNKNOWN_TASK = (SMIOL_Offset)(-1);
+
+
+	if (context == NULL || comp_list == NULL || io_list == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (compute_elements == NULL && n_compute_elements != 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	comm = MPI_Comm_f2c(context->fcomm);
+	comm_size = context->comm_size;
+
+	*io_list = NULL;
+
+	/*
+	 * Allocate arrays whose sizes are known before any communication; the
+	 * comp_list has at most one neighbor for each task
+	 */
+	ranges = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (size_t)2
+	                                * (size_t)comm_size);
+	sorted_ranges = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * TRIPLET_SIZE
+	                                       * (size_t)comm_size);
+	counts = (int *)malloc(sizeof(int) * (size_t)comm_size * (size_t)4);
+	compute_ids = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * TRIPLET_SIZE
+	                                     * (n_compute_elements + 1));
+	send_ids = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset)
+	                                  * (n_compute_elements + 1));
+	*comp_list = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset)
+	                                    * ((size_t)1 + (size_t)2 * (size_t)comm_size
+	                                       + n_compute_elements));
+	if (ranges == NULL || sorted_ranges == NULL || counts == NULL
+	    || compute_ids == NULL || send_ids == NULL || *comp_list == NULL) {
+		free(ranges);
+		free(sorted_ranges);
+		free(counts);
+		free(compute_ids);
+		free(send_ids);
+		free(*comp_list);
+		*comp_list = NULL;
+		return SMIOL_MALLOC_FAILURE;
+	}
+	send_counts = counts;
+	recv_counts = counts + comm_size;
+	send_displs = counts + 2 * comm_size;
+	recv_displs = counts + 3 * comm_size;
+
+	/*
+	 * Gather the range of I/O elements of every task, then keep the
+	 * non-empty ranges as triplets of (first element, count, task) sorted
+	 * on the first element
+	 */
+	my_range[0] = (SMIOL_Offset)io_start;
+	my_range[1] = (SMIOL_Offset)io_count;
+	ierr = MPI_Allgather((const void *)my_range, (int)sizeof(my_range), MPI_BYTE,
+	                     (void *)ranges, (int)sizeof(my_range), MPI_BYTE, comm);
+	if (ierr != MPI_SUCCESS) {
+		free(ranges);
+		free(sorted_ranges);
+		free(counts);
+		free(compute_ids);
+		free(send_ids);
+		free(*comp_list);
+		*comp_list = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+
+	n_ranges = 0;
+	for (i = 0; i < comm_size; i++) {
+		if (ranges[2*i+1] > 0) {
+			sorted_ranges[TRIPLET_SIZE*n_ranges] = ranges[2*i];
+			sorted_ranges[TRIPLET_SIZE*n_ranges+1] = ranges[2*i+1];
+			sorted_ranges[TRIPLET_SIZE*n_ranges+2] = (SMIOL_Offset)i;
+			n_ranges++;
+		}
+	}
+	sort_triplet_array((size_t)n_ranges, sorted_ranges, 0);
+	free(ranges);
+
+	/*
+	 * For each compute element, find the task whose range contains it with
+	 * a binary search for the last range starting at or before the element
+	 *    [0] - element global ID
+	 *    [1] - element local ID
+	 *    [2] - I/O task that reads this element
+	 */
+	for (ii = 0; ii < n_compute_elements; ii++) {
+		SMIOL_Offset id = compute_elements[ii];
+		int lo = 0;
+		int hi = n_ranges - 1;
+		int found = -1;
+
+		while (lo <= hi) {
+			int mid = (lo + hi) / 2;
+
+			if (sorted_ranges[TRIPLET_SIZE*mid] <= id) {
+				found = mid;
+				lo = mid + 1;
+			} else {
+				hi = mid - 1;
+			}
+		}
+
+		compute_ids[TRIPLET_SIZE*ii] = id;
+		compute_ids[TRIPLET_SIZE*ii+1] = (SMIOL_Offset)ii;
+		compute_ids[TRIPLET_SIZE*ii+2] = UNKNOWN_TASK;
+		if (found >= 0 && id < sorted_ranges[TRIPLET_SIZE*found]
+		                       + sorted_ranges[TRIPLET_SIZE*found+1]) {
+			compute_ids[TRIPLET_SIZE*ii+2] = sorted_ranges[TRIPLET_SIZE*found+2];
+		}
+	}
+
+	free(sorted_ranges);
+
+	/*
+	 * Sort compute_ids on I/O task, and build the comp_list along with the
+	 * global IDs to be sent to each I/O task in the same order
+	 */
+	sort_triplet_array(n_compute_elements, compute_ids, 2);
+
+	for (i = 0; i < comm_size; i++) {
+		send_counts[i] = 0;
+	}
+	n_neighbors = 0;
+	for (ii = 0; ii < n_compute_elements; ii++) {
+		SMIOL_Offset task = compute_ids[TRIPLET_SIZE*ii+2];
+
+		if (task != UNKNOWN_TASK) {
+			if (send_counts[task] == 0) {
+				n_neighbors++;
+			}
+			send_counts[task]++;
+		}
+	}
+
+	(*comp_list)[0] = (SMIOL_Offset)n_neighbors;
+	idx = 1;
+	n_send = 0;
+	ii = 0;
+	while (ii < n_compute_elements) {
+		SMIOL_Offset task = compute_ids[TRIPLET_SIZE*ii+2];
+
+		if (task == UNKNOWN_TASK) {
+			ii++;
+			continue;
+		}
+		(*comp_list)[idx++] = task;
+		(*comp_list)[idx++] = (SMIOL_Offset)send_counts[task];
+		for (i = 0; i < send_counts[task]; i++) {
+			(*comp_list)[idx++] = compute_ids[TRIPLET_SIZE*ii+1];
+			send_ids[n_send++] = compute_ids[TRIPLET_SIZE*ii];
+			ii++;
+		}
+	}
+
+	free(compute_ids);
+
+	/*
+	 * Send global IDs to I/O tasks, with counts and displacements in bytes
+	 */
+	ierr = MPI_Alltoall((const void *)send_counts, 1, MPI_INT,
+	                    (void *)recv_counts, 1, MPI_INT, comm);
+	if (ierr != MPI_SUCCESS) {
+		free(counts);
+		free(send_ids);
+		free(*comp_list);
+		*comp_list = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+
+	n_recv = 0;
+	n_neighbors = 0;
+	for (i = 0; i < comm_size; i++) {
+		if (recv_counts[i] > 0) {
+			n_neighbors++;
+		}
+		n_recv += recv_counts[i];
+	}
+
+	recv_ids = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset)
+	                                  * ((size_t)n_recv + 1));
+	*io_list = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset)
+	                                  * ((size_t)1 + (size_t)2 * (size_t)n_neighbors
+	                                     + (size_t)n_recv));
+	if (recv_ids == NULL || *io_list == NULL) {
+		free(counts);
+		free(send_ids);
+		free(recv_ids);
+		free(*comp_list);
+		free(*io_list);
+		*comp_list = NULL;
+		*io_list = NULL;
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	send_displs[0] = 0;
+	recv_displs[0] = 0;
+	for (i = 1; i < comm_size; i++) {
+		send_displs[i] = send_displs[i-1] + send_counts[i-1];
+		recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
+	}
+	for (i = 0; i < comm_size; i++) {
+		send_counts[i] *= (int)sizeof(SMIOL_Offset);
+		recv_counts[i] *= (int)sizeof(SMIOL_Offset);
+		send_displs[i] *= (int)sizeof(SMIOL_Offset);
+		recv_displs[i] *= (int)sizeof(SMIOL_Offset);
+	}
+
+	ierr = MPI_Alltoallv((const void *)send_ids, send_counts, send_displs, MPI_BYTE,
+	                     (void *)recv_ids, recv_counts, recv_displs, MPI_BYTE,
+	                     comm);
+	free(send_ids);
+	if (ierr != MPI_SUCCESS) {
+		free(counts);
+		free(recv_ids);
+		free(*comp_list);
+		free(*io_list);
+		*comp_list = NULL;
+		*io_list = NULL;
+		return SMIOL_MPI_ERROR;
+	}
+
+	/*
+	 * Build the io_list from the received global IDs, in the order in which
+	 * they were sent
+	 */
+	(*io_list)[0] = (SMIOL_Offset)n_neighbors;
+	idx = 1;
+	for (i = 0; i < comm_size; i++) {
+		int n = recv_counts[i] / (int)sizeof(SMIOL_Offset);
+		int offset = recv_displs[i] / (int)sizeof(SMIOL_Offset);
+		int j;
+
+		if (n == 0) {
+			continue;
+		}
+		(*io_list)[idx++] = (SMIOL_Offset)i;
+		(*io_list)[idx++] = (SMIOL_Offset)n;
+		for (j = 0; j < n; j++) {
+			(*io_list)[idx++] = recv_ids[offset + j] - (SMIOL_Offset)io_start;
+		}
+	}
+
+	free(counts);
+	free(recv_ids);
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * fill_io_gaps
+ *
+ * Sets I/O elements that are owned by no task to a fill value
+ *
+ * Given a decomp with a list of I/O elements owned by no compute task (see
+ * SMIOL_create_halo_decomp), the type of a variable, and the size in bytes of
+ * each element of the variable in buf, sets every basic value of each listed
+ * element in buf to the default netCDF fill value for the type. For decomps
+ * without gaps, buf is unchanged.
+ *
+ *******************************************************************************/
+void fill_io_gaps(const struct SMIOL_decomp *decomp, int vartype,
+                  size_t element_size, void *buf)
+{
+	SMIOL_Offset n_gaps;
+	SMIOL_Offset i;
+	size_t k;
+	size_t n_vals;
+	uint8_t *elem;
+
+	if (decomp == NULL || decomp->io_gap_list == NULL || buf == NULL) {
+		return;
+	}
+
+	n_gaps = decomp->io_gap_list[0];
+	for (i = 0; i < n_gaps; i++) {
+		elem = (uint8_t *)buf + (size_t)decomp->io_gap_list[i+1] * element_size;
+
+		switch (vartype) {
+			case SMIOL_REAL32:
+				n_vals = element_size / sizeof(float);
+				for (k = 0; k < n_vals; k++) {
+					((float *)elem)[k] = SMIOL_FILL_REAL32;
+				}
+				break;
+			case SMIOL_REAL64:
+				n_vals = element_size / sizeof(double);
+				for (k = 0; k < n_vals; k++) {
+					((double *)elem)[k] = SMIOL_FILL_REAL64;
+				}
+				break;
+			case SMIOL_INT32:
+				n_vals = element_size / sizeof(int);
+				for (k = 0; k < n_vals; k++) {
+					((int *)elem)[k] = SMIOL_FILL_INT32;
+				}
+				break;
+			default:
+				for (k = 0; k < element_size; k++) {
+					elem[k] = (uint8_t)SMIOL_FILL_CHAR;
+				}
+				break;
+		}
+	}
+}
+
+
+/*******************************************************************************
+ *
+ * build_io_decomp
+ *
+ * Builds a decomp for a given placement and partitioning of I/O elements
+ *
+ * Given arrays of global element IDs that each task computes, the I/O rank of
+ * the calling task and the total number of I/O tasks, and a description of how
+ * elements are to be divided among I/O tasks (see get_io_range_partitioned),
+ * this collective routine computes the range of I/O elements for each I/O task
+ * and builds the mapping between compute and I/O elements with build_exchange.
+ *
+ * If io_group_size is greater than one, consecutive I/O ranks are gathered into
+ * groups of io_group_size I/O tasks (any I/O tasks beyond the last full group
+ * are left idle). Elements are divided among groups rather than among I/O
+ * tasks, and every member of a group shares the group's io_start, io_count, and
+ * io_list; at read/write time, each member handles its own block of the
+ * first dimension inside the decomposed dimension (see get_vertical_block).
+ * The exchange lists are built against the first member of each group, and the
+ * io_task_ranks and rank_io arrays of the decomp record the mapping between
+ * I/O ranks and ranks in the context communicator so that the other members
+ * can be found by transfer_field_2d.
+ *
+ * If halo is non-zero, only the first n_owned_elements compute elements of each
+ * task are owned by the task, and the remaining elements are copies of elements
+ * owned by any task; the number of I/O elements is one more than the largest
+ * global ID, so that global IDs may leave gaps. The exchange lists used for
+ * writing are built from owned elements only, while separate lists that fill
+ * every copy of an element are built for reading with build_fill_exchange, and
+ * I/O elements owned by no task are recorded in the io_gap_list of the decomp.
+ *
+ * In addition to the exchange lists, the returned decomp records its io_start,
+ * io_count, and io_imbalance, along with the placement and partitioning
+ * information. If the ranges depend on the element size -- that is, for the
+ * SMIOL_IO_PARTITION_BYTES method with a non-zero align_bytes -- the element
+ * size is also recorded, so that get_decomp_for_size can later build ranges for
+ * other element sizes; otherwise, the element_size member is zero.
+ *
+ * Upon success, SMIOL_SUCCESS is returned and decomp points to a new decomp;
+ * otherwise, an error code is returned.
+ *
+ *******************************************************************************/
+int build_io_decomp(struct SMIOL_context *context,
+                    size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                    size_t n_owned_elements, int halo,
+                    int partition, int io_rank, int n_io_tasks,
+                    int io_group_size,
+                    size_t element_size, size_t align_bytes,
+                    struct SMIOL_decomp **decomp)
+{
+	size_t i;
+	size_t n_io_elements_global;
+	size_t io_start, io_count;
+	size_t max_io_count;
+	SMIOL_Offset *io_elements;
+	MPI_Comm comm;
+	MPI_Datatype dtype;
+	int ierr;
+	int n_groups;
+	int group;
+	int group_rank;
+	int *rank_io = NULL;
+	int *io_task_ranks = NULL;
+
+
+	if (context == NULL || decomp == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	comm = MPI_Comm_f2c(context->fcomm);
+
+	/*
+	 * Figure out MPI_Datatype for size_t... there must be a better way...
+	 */
+	switch (sizeof(size_t)) {
+		case sizeof(uint64_t):
+			dtype = MPI_UINT64_T;
+			break;
+		case sizeof(uint32_t):
+			dtype = MPI_UINT32_T;
+			break;
+		case sizeof(uint16_t):
+			dtype = MPI_UINT16_T;
+			break;
+		default:
+			return SMIOL_MPI_ERROR;
+	}
+
+	/*
+	 * Based on the number of compute elements for each task, determine
+	 * the total number of elements across all tasks for I/O. The assumption
+	 * is that the number of elements to read/write is equal to the size of
+	 * the set of compute elements. For decomps with halos, the number of
+	 * elements is instead one more than the largest global ID.
+	 */
+	if (halo) {
+		SMIOL_Offset max_id = -1;
+		SMIOL_Offset max_id_global;
+
+		if (n_owned_elements > n_compute_elements) {
+			return SMIOL_INVALID_ARGUMENT;
+		}
+		for (i = 0; i < n_compute_elements; i++) {
+			if (compute_elements[i] > max_id) {
+				max_id = compute_elements[i];
+			}
+		}
+		if (MPI_SUCCESS != MPI_Allreduce((const void *)&max_id,
+		                                 (void *)&max_id_global,
+		                                 1, MPI_INT64_T, MPI_MAX, comm)) {
+			return SMIOL_MPI_ERROR;
+		}
+		n_io_elements_global = (size_t)(max_id_global + 1);
+	} else {
+		n_owned_elements = n_compute_elements;
+		if (MPI_SUCCESS != MPI_Allreduce((const void *)&n_compute_elements,
+		                                 (void *)&n_io_elements_global,
+		                                 1, dtype, MPI_SUM, comm)) {
+			return SMIOL_MPI_ERROR;
+		}
+	}
+
+	/*
+	 * Gather I/O tasks into groups, with elements divided among groups
+	 */
+	if (io_group_size < 1) {
+		io_group_size = 1;
+	}
+	if (io_group_size > n_io_tasks && n_io_tasks > 0) {
+		io_group_size = n_io_tasks;
+	}
+	n_groups = (n_io_tasks > 0) ? n_io_tasks / io_group_size : 0;
+	group = -1;
+	group_rank = -1;
+	if (io_rank >= 0 && io_rank < n_groups * io_group_size) {
+		group = io_rank / io_group_size;
+		group_rank = io_rank % io_group_size;
+	}
 
 	/*
-	 * Sort compute_ids array on task ID (third entry for each element)
+	 * Determine the contiguous range of elements to be read/written by
+	 * this MPI task
 	 */
-	sort_triplet_array(n_compute_elements, compute_ids, 2);
+	ierr = get_io_range_partitioned(partition, group, n_groups,
+	                                n_io_elements_global, element_size,
+	                                align_bytes, &io_start, &io_count);
+	if (ierr != 0) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
 
 	/*
-	 * Scan through compute_ids to determine number of unique neighbors that
-	 * read/write elements computed on this task, and also determine
-	 * the total number of elements read/written on other tasks that are
-	 * computed on this task
+	 * Report the imbalance of the I/O ranges as the largest io_count
+	 * relative to the mean io_count over all I/O groups
 	 */
-	ii = 0;
-	n_neighbors = 0;
-	n_xfer_total = 0;
-	while (ii < n_compute_elements) {
-		/* Task that reads/writes this element */
-		neighbor = compute_ids[TRIPLET_SIZE*ii + 2];
+	if (MPI_SUCCESS != MPI_Allreduce((const void *)&io_count,
+	                                 (void *)&max_io_count,
+	                                 1, dtype, MPI_MAX, comm)) {
+		return SMIOL_MPI_ERROR;
+	}
 
-		/* Number of elements to compute for neighbor */
-		n_xfer = 0;
+	/*
+	 * For groups of more than one I/O task, record the I/O rank of every
+	 * task, and the task of every I/O rank
+	 */
+	if (io_group_size > 1) {
+		int my_io_rank = (group >= 0) ? io_rank : -1;
+
+		rank_io = (int *)malloc(sizeof(int) * (size_t)context->comm_size);
+		io_task_ranks = (int *)malloc(sizeof(int) * (size_t)n_io_tasks);
+		if (rank_io == NULL || io_task_ranks == NULL) {
+			free(rank_io);
+			free(io_task_ranks);
+			return SMIOL_MALLOC_FAILURE;
+		}
 
-		/*
-		 * Since compute_ids is sorted on task, as long as task is
-		 * unchanged, increment n_xfer
-		 */
-		while (ii < n_compute_elements
-		       && compute_ids[TRIPLET_SIZE*ii+2] == neighbor) {
-			n_xfer++;
-			ii++;
+		if (MPI_Allgather((const void *)&my_io_rank, 1, MPI_INT,
+		                  (void *)rank_io, 1, MPI_INT, comm) != MPI_SUCCESS) {
+			free(rank_io);
+			free(io_task_ranks);
+			return SMIOL_MPI_ERROR;
 		}
-		if (neighbor != UNKNOWN_TASK) {
-			n_neighbors++;
-			n_xfer_total += n_xfer;
+
+		for (i = 0; i < (size_t)n_io_tasks; i++) {
+			io_task_ranks[i] = -1;
+		}
+		for (i = 0; i < (size_t)context->comm_size; i++) {
+			if (rank_io[i] >= 0) {
+				io_task_ranks[rank_io[i]] = (int)i;
+			}
 		}
 	}
 
 	/*
-	 * Based on number of neighbors and total number of elements to transfer
-	 * allocate the comp_list
+	 * Fill in io_elements from io_start through io_start + io_count - 1;
+	 * only the first member of each group of I/O tasks takes part in
+	 * building the exchange
 	 */
-	n_list = sizeof(SMIOL_Offset) * ((size_t)1
-	                                 + (size_t)2 * n_neighbors
-	                                 + n_xfer_total);
-	(*decomp)->comp_list = (SMIOL_Offset *)malloc(n_list);
-	if ((*decomp)->comp_list == NULL) {
-		free(compute_ids);
-		free((*decomp)->io_list);
-		free(*decomp);
-		*decomp = NULL;
-		return SMIOL_MALLOC_FAILURE;
+	io_elements = NULL;
+	if (io_count > 0 && group_rank == 0) {
+		io_elements = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset)
+		                                     * io_count);
+		if (io_elements == NULL) {
+			free(rank_io);
+			free(io_task_ranks);
+			return SMIOL_MALLOC_FAILURE;
+		}
+		for (i = 0; i < io_count; i++) {
+			io_elements[i] = (SMIOL_Offset)(io_start + i);
+		}
 	}
-	comp_list = (*decomp)->comp_list;
 
 	/*
-	 * Scan through compute_ids a second time, filling in the comp_list
+	 * Build the mapping between compute tasks and I/O tasks
 	 */
-	comp_list[0] = (SMIOL_Offset)n_neighbors;
-	idx = 1; /* Index in compute_list where neighbor ID will be written,
-	            followed by number of elements and element local IDs */
+	ierr = build_exchange(context,
+	                      n_owned_elements, compute_elements,
+	                      (group_rank == 0) ? io_count : 0, io_elements,
+	                      decomp);
 
-	ii = 0;
-	while (ii < n_compute_elements) {
-		/* Task that reads/writes this element */
-		neighbor = compute_ids[TRIPLET_SIZE*ii + 2];
+	free(io_elements);
 
-		/* Number of elements to compute for neighbor */
-		n_xfer = 0;
+	if (ierr != SMIOL_SUCCESS) {
+		free(rank_io);
+		free(io_task_ranks);
+		return ierr;
+	}
 
-		/*
-		 * Since compute_ids is sorted on task, as long as task is
-		 * unchanged, increment n_xfer
-		 */
-		while (ii < n_compute_elements
-		       && compute_ids[TRIPLET_SIZE*ii+2] == neighbor) {
-			if (neighbor != UNKNOWN_TASK) {
-				/* Save local element ID in list */
-				comp_list[idx+2+n_xfer] = compute_ids[TRIPLET_SIZE*ii+1];
-				n_xfer++;
-			}
-			ii++;
+	(*decomp)->rank_io = rank_io;
+	(*decomp)->io_task_ranks = io_task_ranks;
+
+	/*
+	 * For decomps with halos, build the lists for reads that fill every
+	 * copy of each element, and list the I/O elements owned by no task
+	 */
+	if (halo) {
+		(*decomp)->halo = 1;
+		(*decomp)->n_owned_elements = n_owned_elements;
+
+		ierr = build_fill_exchange(context,
+		                           n_compute_elements, compute_elements,
+		                           io_start, (group_rank == 0) ? io_count : 0,
+		                           &(*decomp)->fill_comp_list,
+		                           &(*decomp)->fill_io_list);
+		if (ierr == SMIOL_SUCCESS && group_rank == 0) {
+			ierr = get_io_gaps(io_count, (*decomp)->io_list,
+			                   &(*decomp)->io_gap_list);
 		}
-		if (neighbor != UNKNOWN_TASK) {
-			comp_list[idx] = neighbor;
-			comp_list[idx+1] = (SMIOL_Offset)n_xfer;
-			idx += (2 + n_xfer);
+		if (ierr != SMIOL_SUCCESS) {
+			discard_decomp(decomp);
+			return ierr;
 		}
 	}
 
-	free(compute_ids);
+	(*decomp)->io_start = io_start;
+	(*decomp)->io_count = io_count;
+	if (n_io_elements_global > 0 && n_groups > 0) {
+		(*decomp)->io_imbalance = (double)max_io_count * (double)n_groups
+		                          / (double)n_io_elements_global;
+	}
+	(*decomp)->io_partition = partition;
+	(*decomp)->io_rank = io_rank;
+	(*decomp)->n_io_tasks = n_io_tasks;
+	(*decomp)->io_align_bytes = align_bytes;
+	if (partition == SMIOL_IO_PARTITION_BYTES && align_bytes > 0) {
+		(*decomp)->element_size = element_size;
+	}
+	(*decomp)->io_group_size = io_group_size;
+	(*decomp)->io_group_rank = group_rank;
+
+	/*
+	 * The first member of each group sends its io_list, along with any
+	 * lists for decomps with halos, to the other members of the group
+	 */
+	if (io_group_size > 1 && group >= 0) {
+		ierr = share_group_list(*decomp, group, &(*decomp)->io_list, 0);
+		if (ierr == SMIOL_SUCCESS && halo) {
+			ierr = share_group_list(*decomp, group, &(*decomp)->fill_io_list, 0);
+		}
+		if (ierr == SMIOL_SUCCESS && halo) {
+			ierr = share_group_list(*decomp, group, &(*decomp)->io_gap_list, 1);
+		}
+		if (ierr != SMIOL_SUCCESS) {
+			discard_decomp(decomp);
+			return ierr;
+		}
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * get_decomp_for_size
+ *
+ * Returns a decomp whose I/O ranges suit a given element size
+ *
+ * For a decomp whose I/O ranges do not depend on the element size (i.e., whose
+ * element_size member is zero), or whose ranges were built for element_size,
+ * the decomp itself is returned in sized_decomp. Otherwise, the list of decomps
+ * for other element sizes that is kept with the decomp is searched, and if no
+ * decomp for element_size is found, one is built with build_io_decomp from the
+ * compute elements and I/O task information retained in the decomp and added
+ * to the list.
+ *
+ * Because a new decomp may be built, this routine must be called collectively
+ * with the same element_size by all tasks using the decomp. Decomps added to
+ * the list are freed along with the decomp by SMIOL_free_decomp.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is returned
+ * and sized_decomp is unchanged.
+ *
+ *******************************************************************************/
+int get_decomp_for_size(const struct SMIOL_decomp *decomp, size_t element_size,
+                        const struct SMIOL_decomp **sized_decomp)
+{
+	struct SMIOL_decomp *d;
+	struct SMIOL_decomp *head;
+	int ierr;
+
+	if (decomp == NULL || sized_decomp == NULL) {
+		return SMIOL_INVALID_ARGUMENT;
+	}
+
+	if (decomp->element_size == 0 || decomp->element_size == element_size
+	    || element_size == 0) {
+		*sized_decomp = decomp;
+		return SMIOL_SUCCESS;
+	}
+
+	for (d = decomp->next_size; d != NULL; d = d->next_size) {
+		if (d->element_size == element_size) {
+			*sized_decomp = d;
+			return SMIOL_SUCCESS;
+		}
+	}
+
+	ierr = build_io_decomp(decomp->context,
+	                       decomp->n_compute_elements, decomp->compute_elements,
+	                       decomp->n_owned_elements, decomp->halo,
+	                       decomp->io_partition, decomp->io_rank,
+	                       decomp->n_io_tasks, decomp->io_group_size,
+	                       element_size, decomp->io_align_bytes, &d);
+	if (ierr != SMIOL_SUCCESS) {
+		return ierr;
+	}
+
+	/*
+	 * The list of decomps for other element sizes is a cache, and adding
+	 * to it does not change the mapping described by the decomp itself
+	 */
+	head = (struct SMIOL_decomp *)decomp;
+	d->next_size = head->next_size;
+	head->next_size = d;
+
+	*sized_decomp = d;
 
 	return SMIOL_SUCCESS;
 }
@@ -985,6 +2695,329 @@ void print_lists(int comm_rank, SMIOL_Offset *comp_list, SMIOL_Offset *io_list)
 }
 
 
+/*******************************************************************************
+ *
+ * get_io_gaps
+ *
+ * Lists the I/O elements of a task that are not computed by any task
+ *
+ * Given the number of I/O elements of a task and the io_list built for those
+ * elements, allocates and returns in io_gap_list an array whose first entry is
+ * the number of I/O elements that appear in no neighbor's list in io_list,
+ * followed by the local IDs of those elements.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned and io_gap_list is unchanged.
+ *
+ *******************************************************************************/
+static int get_io_gaps(size_t io_count, const SMIOL_Offset *io_list,
+                       SMIOL_Offset **io_gap_list)
+{
+	uint8_t *covered;
+	SMIOL_Offset *gaps;
+	SMIOL_Offset n_neighbors;
+	SMIOL_Offset i, n;
+	size_t ii;
+	size_t pos;
+	size_t n_gaps;
+
+	covered = (uint8_t *)calloc(io_count + 1, sizeof(uint8_t));
+	if (covered == NULL) {
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	pos = 0;
+	n_neighbors = io_list[pos++];
+	for (i = 0; i < n_neighbors; i++) {
+		pos++;  /* Skip neighbor task ID */
+		n = io_list[pos++];
+		for (; n > 0; n--) {
+			covered[io_list[pos++]] = 1;
+		}
+	}
+
+	n_gaps = 0;
+	for (ii = 0; ii < io_count; ii++) {
+		if (!covered[ii]) {
+			n_gaps++;
+		}
+	}
+
+	gaps = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (n_gaps + 1));
+	if (gaps == NULL) {
+		free(covered);
+		return SMIOL_MALLOC_FAILURE;
+	}
+
+	gaps[0] = (SMIOL_Offset)n_gaps;
+	pos = 1;
+	for (ii = 0; ii < io_count; ii++) {
+		if (!covered[ii]) {
+			gaps[pos++] = (SMIOL_Offset)ii;
+		}
+	}
+
+	free(covered);
+	*io_gap_list = gaps;
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * share_group_list
+ *
+ * Copies a list from the first member of a group of I/O tasks to the others
+ *
+ * Given a decomp whose I/O tasks are gathered into groups (see
+ * build_io_decomp), the index of the group of the calling task, and a list
+ * that is either a neighbor list in the format of io_list or, if is_gap_list
+ * is non-zero, a count followed by that many entries, sends the list from the
+ * first member of the group to the other members, which replace their own
+ * list with the received copy.
+ *
+ * Upon success, SMIOL_SUCCESS is returned; otherwise, an error code is
+ * returned.
+ *
+ *******************************************************************************/
+static int share_group_list(const struct SMIOL_decomp *decomp, int group,
+                            SMIOL_Offset **list, int is_gap_list)
+{
+	MPI_Comm comm;
+	SMIOL_Offset n_list;
+	int ierr;
+	int j;
+
+	comm = MPI_Comm_f2c(decomp->context->fcomm);
+
+	if (decomp->io_group_rank == 0) {
+		if (is_gap_list) {
+			n_list = 1 + (*list)[0];
+		} else {
+			n_list = 1;
+			for (j = 0; j < (int)(*list)[0]; j++) {
+				n_list += 2 + (*list)[n_list + 1];
+			}
+		}
+		for (j = 1; j < decomp->io_group_size; j++) {
+			int member = decomp->io_task_ranks[group * decomp->io_group_size + j];
+
+			if (member < 0) {
+				continue;
+			}
+
+			ierr = MPI_Send((const void *)&n_list, (int)sizeof(SMIOL_Offset),
+			                MPI_BYTE, member, 0, comm);
+			if (ierr == MPI_SUCCESS) {
+				ierr = MPI_Send((const void *)(*list),
+				                (int)((size_t)n_list * sizeof(SMIOL_Offset)),
+				                MPI_BYTE, member, 1, comm);
+			}
+			if (ierr != MPI_SUCCESS) {
+				return SMIOL_MPI_ERROR;
+			}
+		}
+	} else {
+		int leader = decomp->io_task_ranks[group * decomp->io_group_size];
+
+		ierr = MPI_Recv((void *)&n_list, (int)sizeof(SMIOL_Offset),
+		                MPI_BYTE, leader, 0, comm, MPI_STATUS_IGNORE);
+		if (ierr != MPI_SUCCESS) {
+			return SMIOL_MPI_ERROR;
+		}
+
+		free(*list);
+		*list = (SMIOL_Offset *)malloc(sizeof(SMIOL_Offset) * (size_t)n_list);
+		if (*list == NULL) {
+			return SMIOL_MALLOC_FAILURE;
+		}
+
+		ierr = MPI_Recv((void *)(*list),
+		                (int)((size_t)n_list * sizeof(SMIOL_Offset)),
+		                MPI_BYTE, leader, 1, comm, MPI_STATUS_IGNORE);
+		if (ierr != MPI_SUCCESS) {
+			return SMIOL_MPI_ERROR;
+		}
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
+/*******************************************************************************
+ *
+ * discard_decomp
+ *
+ * Frees a partially built decomp
+ *
+ * Frees the lists and arrays of a decomp that is being built by
+ * build_io_decomp, along with the decomp itself, and sets decomp to NULL.
+ *
+ *******************************************************************************/
+static void discard_decomp(struct SMIOL_decomp **decomp)
+{
+	free((*decomp)->comp_list);
+	free((*decomp)->io_list);
+	free((*decomp)->io_task_ranks);
+	free((*decomp)->rank_io);
+	free((*decomp)->fill_comp_list);
+	free((*decomp)->fill_io_list);
+	free((*decomp)->io_gap_list);
+	free(*decomp);
+	*decomp = NULL;
+}
+
+
+/*******************************************************************************
+ *
+ * calibrate_io_tasks
+ *
+ * Measures write bandwidth for several numbers of I/O tasks per node
+ *
+ * Given a SMIOL context whose autotune_scratch member names a scratch file,
+ * and the largest number of tasks on any node, this collective routine writes
+ * autotune_bytes bytes to the scratch file with MPI-IO using 1, 2, 4, ... I/O
+ * tasks per node (at most SMIOL_AUTO_MAX_CANDIDATES candidates, and no more
+ * than max_node_size), placed as the context's io_placement will place the I/O
+ * tasks of a decomp. Each writer writes at most INT_MAX bytes. The scratch file
+ * is opened with the context's MPI-IO hints and is deleted when the calibration
+ * is complete.
+ *
+ * On return, io_tasks_per_node is the number of I/O tasks per node that gave
+ * the highest bandwidth, and bandwidth is that bandwidth in bytes/s. Upon
+ * success, SMIOL_SUCCESS is returned; otherwise, an error code is returned.
+ *
+ *******************************************************************************/
+static int calibrate_io_tasks(struct SMIOL_context *context, int max_node_size,
+                              int *io_tasks_per_node, double *bandwidth)
+{
+	MPI_Comm comm;
+	MPI_File fh;
+	MPI_Status status;
+	MPI_Offset offset;
+	int ierr;
+	int k;
+	int n_candidates;
+	int node_io_tasks;
+	int n_io;
+	int io_stride;
+	int is_writer;
+	int n_writers;
+	int writer_index;
+	size_t total_bytes;
+	size_t per_writer;
+	size_t nbytes;
+	double t0, t_local, t_max;
+	double bw;
+	char *buf;
+
+	comm = MPI_Comm_f2c(context->fcomm);
+
+	total_bytes = context->autotune_bytes;
+
+	ierr = MPI_File_open(comm, context->autotune_scratch,
+	                     MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_DELETE_ON_CLOSE,
+	                     MPI_Info_f2c(context->finfo), &fh);
+	if (ierr != MPI_SUCCESS) {
+		return SMIOL_MPI_ERROR;
+	}
+
+	*io_tasks_per_node = 1;
+	*bandwidth = 0.0;
+
+	n_candidates = 0;
+	for (k = 1; k <= max_node_size && n_candidates < SMIOL_AUTO_MAX_CANDIDATES; k *= 2) {
+		n_candidates++;
+
+		if (context->io_placement == SMIOL_IO_PLACEMENT_NODE) {
+			node_io_tasks = get_node_io_tasks(context->node_id, context->num_nodes,
+			                                  context->node_size, 0, k);
+			is_writer = (get_node_io_slot(context->node_rank, context->node_size,
+			                              node_io_tasks) >= 0) ? 1 : 0;
+		} else {
+			/*
+			 * Place writers as autotune_io_tasks will for the decomp:
+			 * k * num_nodes tasks at a stride of comm_size / n_io
+			 */
+			n_io = k * context->num_nodes;
+			if (n_io > context->comm_size) {
+				n_io = context->comm_size;
+			}
+			io_stride = context->comm_size / n_io;
+			is_writer = (context->comm_rank % io_stride == 0
+			             && context->comm_rank / io_stride < n_io) ? 1 : 0;
+		}
+
+		if (MPI_Allreduce((const void *)&is_writer, (void *)&n_writers, 1,
+		                  MPI_INT, MPI_SUM, comm) != MPI_SUCCESS) {
+			MPI_File_close(&fh);
+			return SMIOL_MPI_ERROR;
+		}
+
+		writer_index = 0;
+		if (MPI_Exscan((const void *)&is_writer, (void *)&writer_index, 1,
+		               MPI_INT, MPI_SUM, comm) != MPI_SUCCESS) {
+			MPI_File_close(&fh);
+			return SMIOL_MPI_ERROR;
+		}
+		if (context->comm_rank == 0) {
+			writer_index = 0;
+		}
+
+		per_writer = total_bytes / (size_t)n_writers;
+		if (per_writer > (size_t)INT_MAX) {
+			per_writer = (size_t)INT_MAX;
+		}
+		nbytes = is_writer ? per_writer : 0;
+		offset = (MPI_Offset)((size_t)writer_index * per_writer);
+
+		buf = NULL;
+		if (nbytes > 0) {
+			buf = (char *)calloc(nbytes, sizeof(char));
+			if (buf == NULL) {
+				MPI_File_close(&fh);
+				return SMIOL_MALLOC_FAILURE;
+			}
+		}
+
+		MPI_Barrier(comm);
+		t0 = MPI_Wtime();
+		ierr = MPI_File_write_at_all(fh, offset, (void *)buf, (int)nbytes,
+		                             MPI_BYTE, &status);
+		if (ierr == MPI_SUCCESS) {
+			ierr = MPI_File_sync(fh);
+		}
+		t_local = MPI_Wtime() - t0;
+
+		free(buf);
+
+		if (ierr != MPI_SUCCESS) {
+			MPI_File_close(&fh);
+			return SMIOL_MPI_ERROR;
+		}
+
+		if (MPI_Allreduce((const void *)&t_local, (void *)&t_max, 1,
+		                  MPI_DOUBLE, MPI_MAX, comm) != MPI_SUCCESS) {
+			MPI_File_close(&fh);
+			return SMIOL_MPI_ERROR;
+		}
+
+		bw = (t_max > 0.0) ? (double)(per_writer * (size_t)n_writers) / t_max : 0.0;
+		if (bw > *bandwidth) {
+			*bandwidth = bw;
+			*io_tasks_per_node = k;
+		}
+	}
+
+	if (MPI_File_close(&fh) != MPI_SUCCESS) {
+		return SMIOL_MPI_ERROR;
+	}
+
+	return SMIOL_SUCCESS;
+}
+
+
 /*******************************************************************************
  *
  * comp_sort_0
@@ -9,6 +9,18 @@
 #define SMIOL_COMP_TO_IO 1
 #define SMIOL_IO_TO_COMP 2
 
+#define SMIOL_AUTO_MIN_IO_BYTES ((size_t)1048576)   /* Smallest useful amount of data per auto-tuned I/O task */
+#define SMIOL_AUTO_MAX_CANDIDATES 4                 /* Most I/O tasks per node values to calibrate */
+#define SMIOL_AUTO_DEFAULT_BYTES ((size_t)8388608)  /* Default size of each calibration write */
+#define SMIOL_SMALL_VAR_DEFAULT_BYTES ((size_t)4096) /* Default largest batched non-decomposed variable */
+#define SMIOL_HEADER_DEFAULT_FREE_BYTES ((size_t)65536) /* Default free space after the header of created files */
+#define SMIOL_STAGE_DEFAULT_BYTES ((size_t)268435456) /* Default most bytes of staged writes held by a task */
+
+#define SMIOL_FILL_REAL32 (9.9692099683868690e+36f)  /* Default netCDF fill values */
+#define SMIOL_FILL_REAL64 (9.9692099683868690e+36)
+#define SMIOL_FILL_INT32  (-2147483647)
+#define SMIOL_FILL_CHAR   ((char)0)
+
 
 /*
  * Searching and sorting
@@ -23,18 +35,61 @@ SMIOL_Offset *search_triplet_array(SMIOL_Offset key,
  */
 int transfer_field(const struct SMIOL_decomp *decomp, int dir,
                    size_t element_size, const void *in_field, void *out_field);
+int transfer_field_2d(const struct SMIOL_decomp *decomp, int dir,
+                      size_t element_size, size_t n_levels,
+                      const void *in_field, void *out_field);
+void transpose_frames(size_t n_outer, size_t n_inner, size_t element_size,
+                      const void *in, void *out);
 
 /*
  * Field decomposition
  */
 int get_io_elements(int comm_rank, int num_io_tasks, int io_stride,
                     size_t n_io_elements, size_t *io_start, size_t *io_count);
+int get_io_range(int io_rank, int num_io_tasks,
+                 size_t n_io_elements, size_t *io_start, size_t *io_count);
+int get_io_range_aligned(int io_rank, int num_io_tasks, size_t n_io_elements,
+                         size_t element_size, size_t align_bytes,
+                         size_t *io_start, size_t *io_count);
+int get_io_range_balanced(int io_rank, int num_io_tasks,
+                          size_t n_io_elements, size_t *io_start, size_t *io_count);
+int get_io_range_partitioned(int partition, int io_rank, int num_io_tasks,
+                             size_t n_io_elements, size_t element_size,
+                             size_t align_bytes,
+                             size_t *io_start, size_t *io_count);
+void get_vertical_block(int group_rank, int group_size, size_t n_levels,
+                        size_t *level_start, size_t *level_count);
+int get_node_io_tasks(int node_id, int num_nodes, int node_size,
+                      int num_io_tasks, int io_tasks_per_node);
+int get_node_io_slot(int node_rank, int node_size, int node_io_tasks);
+int get_node_io_rank(struct SMIOL_context *context, int num_io_tasks,
+                     int *io_rank, int *n_io_tasks);
+int autotune_io_tasks(struct SMIOL_context *context, size_t n_compute_elements,
+                      const SMIOL_Offset *compute_elements, int halo,
+                      int *num_io_tasks, int *io_stride);
 
 int build_exchange(struct SMIOL_context *context,
                    size_t n_compute_elements, SMIOL_Offset *compute_elements,
                    size_t n_io_elements, SMIOL_Offset *io_elements,
                    struct SMIOL_decomp **decomp);
 
+int build_fill_exchange(struct SMIOL_context *context,
+                        size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                        size_t io_start, size_t io_count,
+                        SMIOL_Offset **comp_list, SMIOL_Offset **io_list);
+void fill_io_gaps(const struct SMIOL_decomp *decomp, int vartype,
+                  size_t element_size, void *buf);
+
+int build_io_decomp(struct SMIOL_context *context,
+                    size_t n_compute_elements, SMIOL_Offset *compute_elements,
+                    size_t n_owned_elements, int halo,
+                    int partition, int io_rank, int n_io_tasks,
+                    int io_group_size,
+                    size_t element_size, size_t align_bytes,
+                    struct SMIOL_decomp **decomp);
+int get_decomp_for_size(const struct SMIOL_decomp *decomp, size_t element_size,
+                        const struct SMIOL_decomp **sized_decomp);
+
 /*
  * Debugging
  */